@@ -1,10 +1,15 @@
-
-#define MAX_LIGHTS_PER_CLUSTER 32
+// entries of the light index list with this bit are spot lights, the other bits are the light's index
+#define CLUSTER_SPOT_LIGHT_BIT 0x80000000u
 
 struct Cluster
 {
     vec4 minPoint;
     vec4 maxPoint;
-    uint lightCount;
-    uint lightIndices[MAX_LIGHTS_PER_CLUSTER];
+};
+
+// a cluster's lights are count entries of the light index list starting at offset
+struct LightRange
+{
+    uint offset;
+    uint count;
 };
@@ -5,6 +5,7 @@
 #include "cluster.glsl"
 
 #define MAX_SHADOW_MAPS_PER_TYPE 50
+#define MAX_MATERIAL_TEXTURES 1024
 #define PI 3.1415926535897932384626433832795
 
 layout (early_fragment_tests) in;
@@ -27,6 +28,7 @@ layout (push_constant) uniform PushConstants
     uint clusterGridY;
     uint clusterGridZ;
     uint enableIblLighting;
+    uint materialIndex;
 };
 
 layout (set = 0, binding = 0) uniform CameraUBO
@@ -41,11 +43,16 @@ layout (set = 0, binding = 0) uniform CameraUBO
 };
 
 layout (set = 1, binding = 0) uniform sampler2D ssaoTexture;
-layout (set = 1, binding = 1) buffer readonly ClustersSSBO { Cluster clusters[]; };
+layout (set = 1, binding = 1) buffer readonly LightGridSSBO { LightRange lightGrid[]; };
 layout (set = 1, binding = 2) uniform sampler2D viewPosTexture;
 layout (set = 1, binding = 3) uniform samplerCube irradianceMap;
 layout (set = 1, binding = 4) uniform samplerCube prefilterMap;
 layout (set = 1, binding = 5) uniform sampler2D brdfLut;
+layout (set = 1, binding = 6) buffer readonly LightIndexSSBO
+{
+    uint lightIndexCount;
+    uint lightIndices[];
+};
 
 layout (set = 2, binding = 0) buffer readonly DirLightsSSBO { DirectionalLight dirLights[]; };
 layout (set = 2, binding = 1) buffer readonly PointLightsSSBO { PointLight pointLights[]; };
@@ -57,16 +64,10 @@ layout (set = 2, binding = 6) uniform sampler dirLightSampler;
 layout (set = 2, binding = 7) uniform sampler pointShadowSampler;
 layout (set = 2, binding = 8) uniform sampler spotShadowMapSampler;
 layout (set = 2, binding = 9) uniform texture2DArray dirShadowMaps[MAX_SHADOW_MAPS_PER_TYPE];
-layout (set = 2, binding = 10) uniform textureCube pointShadowMaps[MAX_SHADOW_MAPS_PER_TYPE];
-layout (set = 2, binding = 11) uniform texture2D spotShadowMaps[MAX_SHADOW_MAPS_PER_TYPE];
+layout (set = 2, binding = 10) uniform texture2DArray shadowAtlas;
 
-layout (set = 3, binding = 0) uniform MaterialsUBO { Material material; };
-layout (set = 3, binding = 1) uniform sampler2D baseColorTex;
-layout (set = 3, binding = 2) uniform sampler2D metallicTex;
-layout (set = 3, binding = 3) uniform sampler2D roughnessTex;
-layout (set = 3, binding = 4) uniform sampler2D normalTex;
-layout (set = 3, binding = 5) uniform sampler2D aoTex;
-layout (set = 3, binding = 6) uniform sampler2D emissionTex;
+layout (set = 3, binding = 0) buffer readonly MaterialsSSBO { Material materials[]; };
+layout (set = 3, binding = 1) uniform sampler2D materialTextures[MAX_MATERIAL_TEXTURES];
 
 const float MAX_REFLECTION_LOD = 5.0;
 
@@ -197,25 +198,71 @@ float dirShadowCalculation(uint index, vec3 viewPos, vec3 normal, vec3 lightDir)
     return shadow;
 }
 
+// must match PointShadowNearPlane
+const float pointShadowNearPlane = 0.1;
+
+// the point faces hold hardware depth, this turns it back into the distance along the face's axis
+float linearPointShadowDepth(float depth, float farPlane)
+{
+    return farPlane * pointShadowNearPlane / (farPlane - depth * (farPlane - pointShadowNearPlane));
+}
+
+// atlasRect is the tile's uv offset (xy), uv size (z) and page (w). the sample is kept half a texel inside the
+// tile so filtering never reads the neighbouring one
+vec3 shadowAtlasCoords(vec4 atlasRect, vec2 uv, float atlasTexelSize)
+{
+    vec2 tileMin = atlasRect.xy + 0.5 * atlasTexelSize;
+    vec2 tileMax = atlasRect.xy + atlasRect.z - 0.5 * atlasTexelSize;
+
+    return vec3(clamp(atlasRect.xy + uv * atlasRect.z, tileMin, tileMax), atlasRect.w);
+}
+
+// faces are ordered +X, -X, +Y, -Y, +Z, -Z like in calcMatrices
+float pointShadowSample(uint index, vec3 sampleDir, float atlasTexelSize)
+{
+    vec3 absDir = abs(sampleDir);
+    uint face;
+    if (absDir.x >= absDir.y && absDir.x >= absDir.z)
+        face = sampleDir.x > 0.0? 0 : 1;
+    else if (absDir.y >= absDir.z)
+        face = sampleDir.y > 0.0? 2 : 3;
+    else
+        face = sampleDir.z > 0.0? 4 : 5;
+
+    vec4 clipPos = pointShadowData[index].viewProj[face] * vec4(pointLights[index].position.xyz + sampleDir, 1.0);
+    vec2 uv = clipPos.xy / clipPos.w * 0.5 + 0.5;
+
+    vec3 atlasCoords = shadowAtlasCoords(pointShadowData[index].atlasRects[face], uv, atlasTexelSize);
+    float depth = texture(sampler2DArray(shadowAtlas, pointShadowSampler), atlasCoords).r;
+
+    return linearPointShadowDepth(depth, pointLights[index].range);
+}
+
 float pointShadowCalculation(uint index, vec3 normal, vec3 lightDir)
 {
+    // the light didn't get a tile this frame
+    if (pointShadowData[index].atlasRects[0].z == 0.0)
+        return 0.0;
+
     vec3 lightToFrag = vFragWorldPos - pointLights[index].position.xyz;
-    float currentDepth = length(lightToFrag);
+    vec3 absLightToFrag = abs(lightToFrag);
+    // the face a direction lands on is picked by its largest component, that's also the depth the face stored
+    float currentDepth = max(absLightToFrag.x, max(absLightToFrag.y, absLightToFrag.z));
     float bias = max(pointShadowData[index].biasSlope * (1.0 - dot(normal, lightDir)), pointShadowData[index].biasConstant);
-    float shadow;
+    float atlasTexelSize = 1.0 / textureSize(sampler2DArray(shadowAtlas, pointShadowSampler), 0).x;
+    float shadow = 0.0;
 
     if (pointShadowData[index].shadowType == SoftShadow)
     {
         int range = 2;
-        float texelSize = 1.0 / pointShadowData[index].resolution;
+        float texelSize = atlasTexelSize / pointShadowData[index].atlasRects[0].z;
 
         for (int x = -range; x <= range; ++x)
         for (int y = -range; y <= range; ++y)
         for (int z = -range; z <= range; ++z)
         {
             vec3 sampleDir = lightToFrag + vec3(x, y, z) * (texelSize * pointShadowData[index].pcfRadius);
-            float sampleDepth = texture(samplerCube(pointShadowMaps[index], pointShadowSampler), sampleDir).r;
-            sampleDepth *= pointLights[index].range;
+            float sampleDepth = pointShadowSample(index, sampleDir, atlasTexelSize);
             shadow += currentDepth - bias > sampleDepth? 1.0 : 0.0;
         }
 
@@ -223,8 +270,7 @@ float pointShadowCalculation(uint index, vec3 normal, vec3 lightDir)
     }
     else
     {
-        float sampleDepth = texture(samplerCube(pointShadowMaps[index], pointShadowSampler), lightToFrag).r;
-        sampleDepth *= pointLights[index].range;
+        float sampleDepth = pointShadowSample(index, lightToFrag, atlasTexelSize);
         shadow = currentDepth - bias > sampleDepth? 1.0 : 0.0;
     }
 
@@ -233,6 +279,12 @@ float pointShadowCalculation(uint index, vec3 normal, vec3 lightDir)
 
 float spotShadowCalculation(uint index, vec3 normal, vec3 lightDir)
 {
+    vec4 atlasRect = spotShadowData[index].atlasRect;
+
+    // the light didn't get a tile this frame
+    if (atlasRect.z == 0.0)
+        return 0.0;
+
     // calculate the frag position in light space
     vec4 fragPosLightSpace = spotShadowData[index].viewProj * vec4(vFragWorldPos, 1.0); // light space
     fragPosLightSpace /= fragPosLightSpace.w; // NDC
@@ -240,19 +292,21 @@ float spotShadowCalculation(uint index, vec3 normal, vec3 lightDir)
     vec2 sampleCoords = fragPosLightSpace.xy * 0.5 + 0.5; // to range [0, 1]
     float currentDepth = fragPosLightSpace.z;
     float bias = max(spotShadowData[index].biasSlope * (1.0 - dot(normal, lightDir)), spotShadowData[index].biasConstant);
+    float atlasTexelSize = 1.0 / textureSize(sampler2DArray(shadowAtlas, spotShadowMapSampler), 0).x;
     float shadow = 0.0;
 
     if (spotShadowData[index].shadowType == SoftShadow)
     {
         int pcfRange = spotShadowData[index].pcfRange;
-        float texelSize = 1.0 / spotShadowData[index].resolution;
+        // one texel of the tile in the tile's own [0, 1] range
+        float texelSize = atlasTexelSize / atlasRect.z;
 
         for (int x = -pcfRange; x <= pcfRange; ++x)
         {
             for (int y = -pcfRange; y <= pcfRange; ++y)
             {
                 vec2 uv = sampleCoords + vec2(x, y) * texelSize;
-                float pcfDepth = texture(sampler2D(spotShadowMaps[index], spotShadowMapSampler), uv).r;
+                float pcfDepth = texture(sampler2DArray(shadowAtlas, spotShadowMapSampler), shadowAtlasCoords(atlasRect, uv, atlasTexelSize)).r;
                 shadow += currentDepth - bias > pcfDepth ? 1.0 : 0.0;
             }
         }
@@ -261,28 +315,36 @@ float spotShadowCalculation(uint index, vec3 normal, vec3 lightDir)
     }
     else
     {
-        float sampleDepth = texture(sampler2D(spotShadowMaps[index], spotShadowMapSampler), sampleCoords).r;
+        float sampleDepth = texture(sampler2DArray(shadowAtlas, spotShadowMapSampler), shadowAtlasCoords(atlasRect, sampleCoords, atlasTexelSize)).r;
         shadow = currentDepth - bias > sampleDepth? 1.0 : 0.0;
     }
 
     return shadow;
 }
 
+// the material index comes from a push constant, so the texture index is the same for the whole draw
+vec4 sampleMaterialTexture(int texIndex, uint defaultTex, vec2 texCoords)
+{
+    return texture(materialTextures[texIndex == -1? defaultTex : uint(texIndex)], texCoords);
+}
+
 void main()
 {
+    Material material = materials[materialIndex];
+
     vec2 texCoords = vTexCoords * material.tiling + material.offset;
     vec2 screenSpaceTexCoords = gl_FragCoord.xy / vec2(float(screenWidth), float(screenHeight));
 
-    vec4 baseColor = texture(baseColorTex, texCoords) * material.baseColorFactor;
+    vec4 baseColor = sampleMaterialTexture(material.baseColorTexIndex, DefaultBaseColorTex, texCoords) * material.baseColorFactor;
 
     if (material.alphaMode == AlphaModeMask && baseColor.a < material.alphaCutoff)
         discard;
 
-    float metallic = texture(metallicTex, texCoords).b * material.metallicFactor;
-    float roughness = texture(roughnessTex, texCoords).g * material.roughnessFactor;
-    vec3 normalSample = normalize(texture(normalTex, texCoords).xyz * 2.0 - 1.0);
-    float ao = 1.0 + material.occlusionStrength * (texture(aoTex, texCoords).r - 1.0);
-    vec3 emission = texture(emissionTex, texCoords).rgb * material.emissionColor.rgb * material.emissionFactor;
+    float metallic = sampleMaterialTexture(material.metallicTexIndex, DefaultMetallicTex, texCoords).b * material.metallicFactor;
+    float roughness = sampleMaterialTexture(material.roughnessTexIndex, DefaultRoughnessTex, texCoords).g * material.roughnessFactor;
+    vec3 normalSample = normalize(sampleMaterialTexture(material.normalTexIndex, DefaultNormalTex, texCoords).xyz * 2.0 - 1.0);
+    float ao = 1.0 + material.occlusionStrength * (sampleMaterialTexture(material.aoTexIndex, DefaultAoTex, texCoords).r - 1.0);
+    vec3 emission = sampleMaterialTexture(material.emissionTexIndex, DefaultEmissionTex, texCoords).rgb * material.emissionColor.rgb * material.emissionFactor;
     float occlusionFactor = texture(ssaoTexture, screenSpaceTexCoords).r;
     vec3 viewPos = texture(viewPosTexture, screenSpaceTexCoords).xyz;
 
@@ -312,52 +374,57 @@ void main()
     }
 
     uint clusterIndex = getClusterIndex(viewPos);
-    Cluster cluster = clusters[clusterIndex];
-    for (uint i = 0; i < cluster.lightCount; ++i)
+    LightRange lightList = lightGrid[clusterIndex];
+    for (uint i = lightList.offset; i < lightList.offset + lightList.count; ++i)
     {
-        uint clusterLightIndex = cluster.lightIndices[i];
-        PointLight pointLight = pointLights[clusterLightIndex];
-
-        vec3 lightToPosVec = pointLight.position.xyz - vFragWorldPos;
-        float dist = length(lightToPosVec);
-        float attenuation = calcAttenuation(dist, pointLight.range);
-        vec3 lightVec = normalize(lightToPosVec);
-        vec3 lightRadiance = pointLight.color.rgb * (pointLight.intensity * attenuation);
-        vec3 halfwayVec = normalize(viewVec + lightVec);
-        vec3 lightContribution = renderingEquation(lightVec, viewVec, normal, F_0, lightRadiance, baseColor.xyz, metallic, roughness);
+        uint clusterLightIndex = lightIndices[i] & ~CLUSTER_SPOT_LIGHT_BIT;
 
-        if (pointShadowData[clusterLightIndex].shadowType != NoShadow)
+        if ((lightIndices[i] & CLUSTER_SPOT_LIGHT_BIT) == 0)
         {
-            float shadow = pointShadowCalculation(clusterLightIndex, normal, lightVec);
-            lightContribution *= 1 - (shadow * pointShadowData[clusterLightIndex].strength);
-        }
+            PointLight pointLight = pointLights[clusterLightIndex];
 
-        L_0 += lightContribution;
-    }
+            vec3 lightToPosVec = pointLight.position.xyz - vFragWorldPos;
+            float dist = length(lightToPosVec);
+            float attenuation = calcAttenuation(dist, pointLight.range);
+            vec3 lightVec = normalize(lightToPosVec);
+            vec3 lightRadiance = pointLight.color.rgb * (pointLight.intensity * attenuation);
+            vec3 halfwayVec = normalize(viewVec + lightVec);
+            vec3 lightContribution = renderingEquation(lightVec, viewVec, normal, F_0, lightRadiance, baseColor.xyz, metallic, roughness);
 
-    for (uint i = 0; i < spotLightCount; ++i)
-    {
-        float innerCutoff = cos((spotLights[i].innerCutoff / 2.0) * PI / 180.0);
-        float outerCutoff = cos((spotLights[i].outerCutoff / 2.0) * PI / 180.0);
-
-        vec3 posToLightVec = spotLights[i].position.xyz - vFragWorldPos;
-        vec3 lightVec = normalize(posToLightVec);
-        float dist = length(posToLightVec);
-        float cosTheta = dot(normalize(-spotLights[i].direction.xyz), lightVec);
-        float epsilon = innerCutoff - outerCutoff;
-        float intensity = clamp((cosTheta - outerCutoff) / epsilon, 0.0, 1.0);
-        float attenuation = calcAttenuation(dist, spotLights[i].range);
-        vec3 lightRadiance = spotLights[i].color.rgb * (spotLights[i].intensity * intensity * attenuation);
-        vec3 halfwayVec = normalize(lightVec + viewVec);
-        vec3 lightContribution = renderingEquation(lightVec, viewVec, normal, F_0, lightRadiance, baseColor.xyz, metallic, roughness);
+            if (pointShadowData[clusterLightIndex].shadowType != NoShadow)
+            {
+                float shadow = pointShadowCalculation(clusterLightIndex, normal, lightVec);
+                lightContribution *= 1 - (shadow * pointShadowData[clusterLightIndex].strength);
+            }
 
-        if (spotShadowData[i].shadowType != NoShadow)
-        {
-            float shadow = spotShadowCalculation(i, normal, lightVec);
-            lightContribution *= 1 - (shadow * spotShadowData[i].strength);
+            L_0 += lightContribution;
         }
+        else
+        {
+            SpotLight spotLight = spotLights[clusterLightIndex];
+
+            float innerCutoff = cos((spotLight.innerCutoff / 2.0) * PI / 180.0);
+            float outerCutoff = cos((spotLight.outerCutoff / 2.0) * PI / 180.0);
+
+            vec3 posToLightVec = spotLight.position.xyz - vFragWorldPos;
+            vec3 lightVec = normalize(posToLightVec);
+            float dist = length(posToLightVec);
+            float cosTheta = dot(normalize(-spotLight.direction.xyz), lightVec);
+            float epsilon = innerCutoff - outerCutoff;
+            float intensity = clamp((cosTheta - outerCutoff) / epsilon, 0.0, 1.0);
+            float attenuation = calcAttenuation(dist, spotLight.range);
+            vec3 lightRadiance = spotLight.color.rgb * (spotLight.intensity * intensity * attenuation);
+            vec3 halfwayVec = normalize(lightVec + viewVec);
+            vec3 lightContribution = renderingEquation(lightVec, viewVec, normal, F_0, lightRadiance, baseColor.xyz, metallic, roughness);
+
+            if (spotShadowData[clusterLightIndex].shadowType != NoShadow)
+            {
+                float shadow = spotShadowCalculation(clusterLightIndex, normal, lightVec);
+                lightContribution *= 1 - (shadow * spotShadowData[clusterLightIndex].strength);
+            }
 
-        L_0 += lightContribution;
+            L_0 += lightContribution;
+        }
     }
 
     vec3 ambient;
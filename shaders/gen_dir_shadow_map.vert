@@ -1,13 +1,17 @@
 #version 460 core
 
+#extension GL_ARB_shader_viewport_layer_array : require
+
 #include "vertex_input_instanced.glsl"
 
 layout (push_constant) uniform PushConstants
 {
     mat4 viewProj;
+    uint cascade;
 };
 
 void main()
 {
     gl_Position = viewProj * modelMat * vec4(position, 1.0);
+    gl_Layer = int(cascade);
 }
@@ -1,16 +1,17 @@
 #version 460 core
 
-#include "vertex_input_instanced.glsl"
+#extension GL_ARB_shader_viewport_layer_array : require
 
-layout (location = 0) out vec3 vFragPosWorldSpace;
+#include "vertex_input_instanced.glsl"
 
 layout (push_constant) uniform PushConstants
 {
     mat4 lightSpaceMatrix;
+    uint page;
 };
 
 void main()
 {
-    vFragPosWorldSpace = vec3(modelMat * vec4(position, 1.0));
-    gl_Position = lightSpaceMatrix * vec4(vFragPosWorldSpace, 1.0);
+    gl_Position = lightSpaceMatrix * modelMat * vec4(position, 1.0);
+    gl_Layer = int(page);
 }
@@ -1,13 +1,17 @@
 #version 460 core
 
+#extension GL_ARB_shader_viewport_layer_array : require
+
 #include "vertex_input_instanced.glsl"
 
 layout (push_constant) uniform PushConstants
 {
     mat4 lightSpaceMatrix;
+    uint page;
 };
 
 void main()
 {
     gl_Position = lightSpaceMatrix * modelMat * vec4(position, 1.0);
+    gl_Layer = int(page);
 }
@@ -47,6 +47,7 @@ struct DirShadowData
 struct PointShadowData
 {
     mat4 viewProj[6];
+    vec4 atlasRects[6];
     uint shadowType;
     uint resolution;
     float strength;
@@ -59,6 +60,7 @@ struct PointShadowData
 struct SpotShadowData
 {
     mat4 viewProj;
+    vec4 atlasRect;
     uint shadowType;
     uint resolution;
     float strength;
@@ -3,6 +3,14 @@ const uint AlphaModeOpaque = 0;
 const uint AlphaModeMask = 1;
 const uint AlphaModeBlend = 2;
 
+// slots of the default textures in the material table, used for texture indices of -1
+const uint DefaultBaseColorTex = 0;
+const uint DefaultMetallicTex = 1;
+const uint DefaultRoughnessTex = 2;
+const uint DefaultNormalTex = 3;
+const uint DefaultAoTex = 4;
+const uint DefaultEmissionTex = 5;
+
 struct Material
 {
     int baseColorTexIndex;
@@ -7,16 +7,25 @@
 static constexpr int sInitialWindowWidth = 1920;
 static constexpr int sInitialWindowHeight = 1080;
 
+static uint32_t framesInFlightCount(const SaveData& saveData)
+{
+    return saveData.value("framesInFlight", DefaultFramesInFlight);
+}
+
 Application::Application()
     : mSaveData()
     , mWindow(sInitialWindowWidth, sInitialWindowHeight)
     , mInstance()
-    , mRenderDevice(mInstance)
+    , mRenderDevice(mInstance, framesInFlightCount(mSaveData))
     , mSwapchain(mInstance, mRenderDevice)
     , mVulkanImGui(mWindow, mInstance, mRenderDevice, mSwapchain)
     , mRenderer(mRenderDevice, mSaveData)
     , mEditor(mRenderer, mSaveData)
+    , mFrameIndex()
+    , mCpuTimer(false)
+    , mCpuFrameMs()
 {
+    CpuProfiler::setThreadName("Main");
 }
 
 Application::~Application() = default;
@@ -30,11 +39,19 @@ void Application::run()
         float dt = glfwGetTime() - currentTime;
         currentTime = glfwGetTime();
 
-        handleEvents();
-        update(dt);
-        render();
+        {
+            PROFILE_ZONE("Frame");
+
+            handleEvents();
+            beginFrame();
+            update(dt);
+            render();
+        }
+
+        CpuProfiler::collect();
     }
 
+    mRenderDevice.uploadManager->waitIdle();
     vkDeviceWaitIdle(mRenderDevice.device);
 }
 
@@ -51,6 +68,8 @@ void Application::recreateSwapchain()
 
 void Application::handleEvents()
 {
+    PROFILE_ZONE("Application::handleEvents");
+
     mWindow.pollEvents();
 
     for (const Event& event : mWindow.events())
@@ -58,6 +77,23 @@ void Application::handleEvents()
     }
 }
 
+void Application::beginFrame()
+{
+    VkFence inFlightFence = mSwapchain.inFlightFences.at(mFrameIndex);
+
+    // only block once this slot's previous frame is still on the gpu
+    Timer waitTimer;
+    {
+        PROFILE_ZONE("Wait For Frame Fence");
+        vkWaitForFences(mRenderDevice.device, 1, &inFlightFence, VK_TRUE, UINT64_MAX);
+    }
+    waitTimer.end();
+
+    mRenderDevice.gpuProfiler->collect(mFrameIndex);
+    mRenderer.beginFrame(mFrameIndex, mCpuFrameMs, waitTimer.ellapsedMicro() / 1000.0);
+    mCpuTimer.begin();
+}
+
 void Application::update(float dt)
 {
     mVulkanImGui.begin();
@@ -65,34 +101,49 @@ void Application::update(float dt)
     mEditor.update(dt);
     mRenderer.update();
 
-    mVulkanImGui.end();
+    {
+        PROFILE_ZONE("ImGui Render");
+        mVulkanImGui.end();
+    }
 }
 
 void Application::fillCommandBuffer(uint32_t imageIndex)
 {
+    PROFILE_ZONE("Application::fillCommandBuffer");
+
     VkCommandBufferBeginInfo commandBufferBeginInfo {
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
         .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
     };
 
-    VkResult result = vkBeginCommandBuffer(mSwapchain.commandBuffer, &commandBufferBeginInfo);
+    VkCommandBuffer commandBuffer = mSwapchain.commandBuffers.at(mFrameIndex);
+
+    vkResetCommandBuffer(commandBuffer, 0);
+
+    VkResult result = vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo);
     vulkanCheck(result, "Failed to begin command buffer.");
 
-    mRenderer.render(mSwapchain.commandBuffer);
-    mVulkanImGui.render(mSwapchain.commandBuffer, imageIndex);
+    mRenderDevice.gpuProfiler->beginFrame(commandBuffer, mFrameIndex);
+    mRenderer.render(commandBuffer);
+    mVulkanImGui.render(commandBuffer, imageIndex);
+    mRenderDevice.gpuProfiler->endFrame();
 
-    vkEndCommandBuffer(mSwapchain.commandBuffer);
+    vkEndCommandBuffer(commandBuffer);
 }
 
 void Application::render()
 {
-    vkResetFences(mRenderDevice.device, 1, &mSwapchain.inFlightFence);
+    PROFILE_ZONE("Application::render");
+
+    VkFence inFlightFence = mSwapchain.inFlightFences.at(mFrameIndex);
+    VkSemaphore imageReadySemaphore = mSwapchain.imageReadySemaphores.at(mFrameIndex);
+    VkSemaphore renderCompleteSemaphore = mSwapchain.renderCompleteSemaphores.at(mFrameIndex);
 
     uint32_t swapchainImageIndex;
     VkResult result = vkAcquireNextImageKHR(mRenderDevice.device,
                                             mSwapchain.swapchain,
                                            UINT64_MAX,
-                                           mSwapchain.imageReadySemaphore,
+                                           imageReadySemaphore,
                                            VK_NULL_HANDLE,
                                            &swapchainImageIndex);
 
@@ -104,43 +155,51 @@ void Application::render()
     else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
         check(false, "Failed to acquire swapchain image.");
 
+    // reset only once work is guaranteed to be submitted, otherwise the next wait on this slot never returns
+    vkResetFences(mRenderDevice.device, 1, &inFlightFence);
+
     fillCommandBuffer(swapchainImageIndex);
 
+    // submit this frame's uploads ahead of the frame that uses them
+    mRenderDevice.uploadManager->flush();
+
+    VkCommandBuffer commandBuffer = mSwapchain.commandBuffers.at(mFrameIndex);
     VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
     VkSubmitInfo submitInfo {
         .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
         .waitSemaphoreCount = 1,
-        .pWaitSemaphores = &mSwapchain.imageReadySemaphore,
+        .pWaitSemaphores = &imageReadySemaphore,
         .pWaitDstStageMask = &waitStage,
         .commandBufferCount = 1,
-        .pCommandBuffers = &mSwapchain.commandBuffer,
+        .pCommandBuffers = &commandBuffer,
         .signalSemaphoreCount = 1,
-        .pSignalSemaphores = &mSwapchain.renderCompleteSemaphore
+        .pSignalSemaphores = &renderCompleteSemaphore
     };
 
-    result = vkQueueSubmit(mRenderDevice.graphicsQueue, 1, &submitInfo, mSwapchain.inFlightFence);
+    result = vkQueueSubmit(mRenderDevice.graphicsQueue, 1, &submitInfo, inFlightFence);
     vulkanCheck(result, "Failed queue submit.");
 
+    mCpuTimer.end();
+    mCpuFrameMs = mCpuTimer.ellapsedMicro() / 1000.0;
+    mFrameIndex = (mFrameIndex + 1) % mRenderDevice.framesInFlight;
+
     VkPresentInfoKHR presentInfo {
         .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
         .waitSemaphoreCount = 1,
-        .pWaitSemaphores = &mSwapchain.renderCompleteSemaphore,
+        .pWaitSemaphores = &renderCompleteSemaphore,
         .swapchainCount = 1,
         .pSwapchains = &mSwapchain.swapchain,
         .pImageIndices = &swapchainImageIndex,
         .pResults = nullptr
     };
 
-    result = vkQueuePresentKHR(mRenderDevice.graphicsQueue, &presentInfo);
+    {
+        PROFILE_ZONE("Present");
+        result = vkQueuePresentKHR(mRenderDevice.graphicsQueue, &presentInfo);
+    }
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
-    {
         recreateSwapchain();
-        return;
-    }
     else if (result != VK_SUCCESS)
         check(false, "Failed to present swapchain image");
-
-    vkWaitForFences(mRenderDevice.device, 1, &mSwapchain.inFlightFence, VK_TRUE, UINT64_MAX);
-    vkResetCommandBuffer(mSwapchain.commandBuffer, 0);
 }
@@ -9,9 +9,13 @@
 #include "../renderer/renderer.hpp"
 #include "../vk/vulkan_instance.hpp"
 #include "../vk/vulkan_render_device.hpp"
+#include "../vk/vulkan_upload_manager.hpp"
+#include "../vk/vulkan_gpu_profiler.hpp"
 #include "../vk/vulkan_swapchain.hpp"
 #include "../vk/vulkan_imgui.hpp"
 #include "../utils/utils.hpp"
+#include "../utils/timer.hpp"
+#include "../utils/cpu_profiler.hpp"
 #include "save_data.hpp"
 #include "editor.hpp"
 
@@ -25,6 +29,7 @@ public:
 private:
     void recreateSwapchain();
     void handleEvents();
+    void beginFrame();
     void update(float dt);
     void fillCommandBuffer(uint32_t imageIndex);
     void render();
@@ -38,6 +43,10 @@ private:
     VulkanImGui mVulkanImGui;
     Renderer mRenderer;
     Editor mEditor;
+
+    uint32_t mFrameIndex;
+    Timer mCpuTimer;
+    float mCpuFrameMs;
 };
 
 #endif //VULKANRENDERINGENGINE_APPLICATION_HPP
@@ -0,0 +1,855 @@
+//
+// Created by Gianni on 16/10/2026.
+//
+
+#include "benchmark.hpp"
+
+static glm::vec3 toVec3(const nlohmann::json& json)
+{
+    return {json.at(0).get<float>(), json.at(1).get<float>(), json.at(2).get<float>()};
+}
+
+static BenchmarkLights loadLights(const nlohmann::json& json, const char* key)
+{
+    if (!json.contains(key))
+        return {};
+
+    return {
+        .count = json[key].value("count", 0u),
+        .shadows = json[key].value("shadows", false)
+    };
+}
+
+static BenchmarkUploads loadUploads(const nlohmann::json& json)
+{
+    if (!json.contains("uploads"))
+        return {};
+
+    const nlohmann::json& uploads = json["uploads"];
+
+    return {
+        .bufferCount = uploads.value("buffers", 0u),
+        .bufferSize = uploads.value("bufferSize", 256u * 1024u),
+        .textureCount = uploads.value("textures", 0u),
+        .textureSize = uploads.value("textureSize", 1024u)
+    };
+}
+
+static TextureSpecification uploadTextureSpecification(uint32_t size)
+{
+    return {
+        .format = VK_FORMAT_R8G8B8A8_UNORM,
+        .width = size,
+        .height = size,
+        .layerCount = 1,
+        .imageViewType = VK_IMAGE_VIEW_TYPE_2D,
+        .imageUsage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        .imageAspect = VK_IMAGE_ASPECT_COLOR_BIT,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .magFilter = TextureMagFilter::Linear,
+        .minFilter = TextureMinFilter::Linear,
+        .wrapS = TextureWrap::Repeat,
+        .wrapT = TextureWrap::Repeat,
+        .wrapR = TextureWrap::Repeat,
+        .generateMipMaps = false
+    };
+}
+
+static BenchmarkScene loadScene(const std::filesystem::path& path)
+{
+    std::ifstream file(path);
+    check(file.is_open(), std::format("Failed to open benchmark scene {}.", path.string()).c_str());
+
+    nlohmann::json json = nlohmann::json::parse(file);
+    BenchmarkScene scene;
+
+    scene.width = json.value("width", scene.width);
+    scene.height = json.value("height", scene.height);
+    scene.framesInFlight = json.value("framesInFlight", scene.framesInFlight);
+    scene.warmupFrames = json.value("warmupFrames", scene.warmupFrames);
+    scene.frameCount = json.value("frames", scene.frameCount);
+    scene.instanceSpacing = json.value("instanceSpacing", scene.instanceSpacing);
+    scene.gpuCulling = json.value("gpuCulling", scene.gpuCulling);
+    scene.validateCulling = json.value("validateCulling", scene.validateCulling);
+    scene.importThreads = json.value("importThreads", scene.importThreads);
+    scene.outputImage = json.value("outputImage", "");
+    scene.resultsFile = json.value("results", "");
+    scene.cpuTrace = json.value("cpuTrace", "");
+    scene.gpuTrace = json.value("gpuTrace", "");
+
+    for (const auto& model : json.value("models", nlohmann::json::array()))
+    {
+        scene.models.push_back({
+            .importData {
+                .path = model.at("path").get<std::string>(),
+                .normalize = model.value("normalize", false),
+                .flipUVs = model.value("flipUVs", true)
+            },
+            .instanceCount = model.value("instances", 1u)
+        });
+    }
+
+    if (json.contains("lights"))
+    {
+        const nlohmann::json& lights = json["lights"];
+
+        scene.lightRadius = lights.value("radius", scene.lightRadius);
+        scene.lightHeight = lights.value("height", scene.lightHeight);
+        scene.dirLights = loadLights(lights, "directional");
+        scene.pointLights = loadLights(lights, "point");
+        scene.spotLights = loadLights(lights, "spot");
+    }
+
+    scene.uploads = loadUploads(json);
+
+    for (const auto& key : json.value("cameraPath", nlohmann::json::array()))
+        scene.cameraPath.push_back({toVec3(key.at("position")), toVec3(key.at("target"))});
+
+    if (scene.cameraPath.empty())
+        scene.cameraPath.push_back({glm::vec3(0.f, 2.f, 10.f), glm::vec3(0.f)});
+
+    check(scene.width && scene.height, "Benchmark resolution can't be zero.");
+    check(scene.frameCount, "Benchmark frame count can't be zero.");
+    check(scene.dirLights.count <= MaxDirLights &&
+          scene.pointLights.count <= MaxPointLights &&
+          scene.spotLights.count <= MaxSpotLights,
+          "Benchmark light count exceeds the renderer's limits.");
+
+    return scene;
+}
+
+static FrameTimeStats calcFrameTimeStats(std::vector<float> samples)
+{
+    if (samples.empty())
+        return {};
+
+    std::sort(samples.begin(), samples.end());
+
+    // nearest rank
+    auto percentile = [&samples] (float p) {
+        size_t rank = static_cast<size_t>(std::ceil(p / 100.f * static_cast<float>(samples.size())));
+        return samples.at(std::clamp<size_t>(rank, 1, samples.size()) - 1);
+    };
+
+    return {
+        .minMs = samples.front(),
+        .avgMs = std::accumulate(samples.begin(), samples.end(), 0.f) / static_cast<float>(samples.size()),
+        .p50Ms = percentile(50.f),
+        .p90Ms = percentile(90.f),
+        .p99Ms = percentile(99.f),
+        .maxMs = samples.back()
+    };
+}
+
+static nlohmann::json toJson(const FrameTimeStats& stats)
+{
+    return {
+        {"min", stats.minMs},
+        {"avg", stats.avgMs},
+        {"p50", stats.p50Ms},
+        {"p90", stats.p90Ms},
+        {"p99", stats.p99Ms},
+        {"max", stats.maxMs}
+    };
+}
+
+Benchmark::Benchmark(const std::filesystem::path& scenePath)
+    : mScene(loadScene(scenePath))
+    , mSaveData()
+    , mInstance(true)
+    , mRenderDevice(mInstance, mScene.framesInFlight)
+    , mRenderer(mRenderDevice, mSaveData)
+    , mCommandBuffers(mScene.framesInFlight)
+    , mInFlightFences(mScene.framesInFlight)
+    , mMeasuredFrames(mScene.framesInFlight)
+    , mFrameIndex()
+    , mCpuFrameMs()
+    , mTotalMs()
+{
+    CpuProfiler::setThreadName("Main");
+    CpuProfiler::setEnabled(!mScene.cpuTrace.empty());
+
+    mRenderer.resize(mScene.width, mScene.height);
+    mRenderer.mGpuCulling = mScene.gpuCulling;
+    mRenderer.mValidateGpuCulling = mScene.validateCulling;
+
+    for (const BenchmarkModel& model : mScene.models)
+        mRenderer.importModel(model.importData);
+
+    waitForImports();
+    createModelInstances();
+    addLights();
+    createFrameResources();
+
+    // upload everything the scene setup staged before the first timed frame
+    mRenderDevice.uploadManager->waitIdle();
+}
+
+Benchmark::~Benchmark()
+{
+    mRenderDevice.uploadManager->waitIdle();
+    vkDeviceWaitIdle(mRenderDevice.device);
+
+    for (uint32_t i = 0; i < mRenderDevice.framesInFlight; ++i)
+        vkDestroyFence(mRenderDevice.device, mInFlightFences.at(i), nullptr);
+
+    vkFreeCommandBuffers(mRenderDevice.device, mRenderDevice.commandPool, mRenderDevice.framesInFlight, mCommandBuffers.data());
+}
+
+void Benchmark::run()
+{
+    uint32_t totalFrames = mScene.warmupFrames + mScene.frameCount;
+
+    mCpuSamples.reserve(mScene.frameCount);
+    mGpuSamples.reserve(mScene.frameCount);
+
+    if (mScene.importThreads)
+        benchmarkImports();
+
+    if (mScene.uploads.bufferCount || mScene.uploads.textureCount)
+        benchmarkUploads();
+
+    Timer totalTimer(false);
+
+    for (uint32_t frame = 0; frame < totalFrames; ++frame)
+    {
+        if (frame == mScene.warmupFrames)
+            totalTimer.begin();
+
+        {
+            PROFILE_ZONE("Frame");
+            renderFrame(frame);
+        }
+
+        CpuProfiler::collect();
+    }
+
+    vkDeviceWaitIdle(mRenderDevice.device);
+    totalTimer.end();
+    mTotalMs = totalTimer.ellapsedMicro() / 1000.0;
+
+    // the last frames in flight haven't been read back yet
+    for (uint32_t i = 0; i < mRenderDevice.framesInFlight; ++i)
+    {
+        collectGpuTime(mFrameIndex);
+        mFrameIndex = (mFrameIndex + 1) % mRenderDevice.framesInFlight;
+    }
+
+    report();
+
+    if (!mScene.outputImage.empty())
+        saveImage(mScene.outputImage);
+
+    if (!mScene.cpuTrace.empty())
+        CpuProfiler::exportChromeTrace(mScene.cpuTrace);
+
+    if (!mScene.gpuTrace.empty())
+        mRenderDevice.gpuProfiler->exportChromeTrace(mScene.gpuTrace);
+}
+
+void Benchmark::waitForImports()
+{
+    while (!mRenderer.mModelDataFutures.empty())
+    {
+        mRenderer.updateImports();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+// ModelLoader only, the same work Renderer::importModel hands to its pool. model loading and texture decoding share
+// one pool, so the thread count bounds all of the import work
+void Benchmark::benchmarkImports()
+{
+    for (uint32_t threadCount = 1; threadCount <= mScene.importThreads; ++threadCount)
+    {
+        ThreadPool threadPool(threadCount, "Benchmark Import");
+        std::vector<std::future<bool>> futures;
+
+        Timer timer;
+
+        for (const BenchmarkModel& model : mScene.models)
+        {
+            futures.push_back(threadPool.submit([&threadPool, importData = model.importData] () {
+                return ModelLoader(importData, &threadPool).success();
+            }));
+        }
+
+        bool success = true;
+        for (std::future<bool>& future : futures)
+            success &= future.get();
+
+        timer.end();
+
+        check(success, "Failed to import a benchmark model.");
+
+        mImportTimes.push_back({threadCount, timer.ellapsedMicro() / 1000.0});
+    }
+}
+
+void Benchmark::benchmarkUploads()
+{
+    const BenchmarkUploads& uploads = mScene.uploads;
+    VulkanUploadManager& uploadManager = *mRenderDevice.uploadManager;
+
+    // the largest resource, every upload reads from the start of it
+    size_t textureBytes = static_cast<size_t>(uploads.textureSize) * uploads.textureSize * 4;
+    std::vector<uint8_t> data(std::max<size_t>(uploads.bufferSize, textureBytes));
+
+    std::mt19937 randomEngine(1);
+    std::generate(data.begin(), data.end(), [&randomEngine] () { return static_cast<uint8_t>(randomEngine()); });
+
+    uploadManager.waitIdle();
+    vkDeviceWaitIdle(mRenderDevice.device);
+
+    uint32_t submitCount = uploadManager.stats().submitCount;
+
+    Timer batchedTimer;
+    uploadBatched(data);
+    batchedTimer.end();
+
+    mUploadTimes.push_back({"upload manager", batchedTimer.ellapsedMicro() / 1000.0, uploadManager.stats().submitCount - submitCount});
+
+    Timer singleTimeTimer;
+    uint32_t singleTimeSubmits = uploadSingleTime(data);
+    singleTimeTimer.end();
+
+    mUploadTimes.push_back({"single time", singleTimeTimer.ellapsedMicro() / 1000.0, singleTimeSubmits});
+}
+
+// timed until the last batch's fence signals, the resources outlive the wait
+void Benchmark::uploadBatched(const std::vector<uint8_t>& data)
+{
+    const BenchmarkUploads& uploads = mScene.uploads;
+    std::vector<VulkanBuffer> buffers;
+    std::vector<VulkanTexture> textures;
+
+    for (uint32_t i = 0; i < uploads.bufferCount; ++i)
+        buffers.emplace_back(mRenderDevice, uploads.bufferSize, BufferType::Vertex, MemoryType::Device, data.data());
+
+    for (uint32_t i = 0; i < uploads.textureCount; ++i)
+        textures.emplace_back(mRenderDevice, uploadTextureSpecification(uploads.textureSize), data.data());
+
+    mRenderDevice.uploadManager->waitIdle();
+}
+
+// the path the upload manager replaced, a staging buffer and a submit that is waited on per resource
+uint32_t Benchmark::uploadSingleTime(const std::vector<uint8_t>& data)
+{
+    const BenchmarkUploads& uploads = mScene.uploads;
+    uint32_t submitCount = 0;
+
+    for (uint32_t i = 0; i < uploads.bufferCount; ++i)
+    {
+        VulkanBuffer buffer(mRenderDevice, uploads.bufferSize, BufferType::Vertex, MemoryType::Device);
+        VulkanBuffer stagingBuffer(mRenderDevice, uploads.bufferSize, BufferType::Staging, MemoryType::Host, data.data());
+
+        VkCommandBuffer commandBuffer = beginSingleTimeCommands(mRenderDevice);
+        buffer.copyBuffer(commandBuffer, stagingBuffer, 0, 0, uploads.bufferSize);
+        endSingleTimeCommands(mRenderDevice, commandBuffer);
+
+        ++submitCount;
+    }
+
+    for (uint32_t i = 0; i < uploads.textureCount; ++i)
+    {
+        VulkanTexture texture(mRenderDevice, uploadTextureSpecification(uploads.textureSize));
+
+        VkDeviceSize size = imageMemoryDeviceSize(texture.width, texture.height, texture.format);
+        VulkanBuffer stagingBuffer(mRenderDevice, size, BufferType::Staging, MemoryType::HostCached, data.data());
+
+        VkCommandBuffer commandBuffer = beginSingleTimeCommands(mRenderDevice);
+
+        texture.transitionLayout(commandBuffer,
+                                 VK_IMAGE_LAYOUT_UNDEFINED,
+                                 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                 VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                                 VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                 0, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+        texture.uploadImageData(commandBuffer, stagingBuffer);
+
+        texture.transitionLayout(commandBuffer,
+                                 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                 VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                 VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                                 VK_ACCESS_TRANSFER_WRITE_BIT,
+                                 VK_ACCESS_SHADER_READ_BIT);
+
+        endSingleTimeCommands(mRenderDevice, commandBuffer);
+
+        ++submitCount;
+    }
+
+    return submitCount;
+}
+
+void Benchmark::createModelInstances()
+{
+    // lay the instances out on a square grid centered on the origin
+    uint32_t gridSize = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(instanceCount()))));
+    float gridOffset = (static_cast<float>(gridSize) - 1.f) * mScene.instanceSpacing * 0.5f;
+    uint32_t instanceIndex = 0;
+
+    for (const BenchmarkModel& benchmarkModel : mScene.models)
+    {
+        auto itr = std::find_if(mRenderer.mModels.begin(), mRenderer.mModels.end(), [&benchmarkModel] (const auto& pair) {
+            return pair.second.path == benchmarkModel.importData.path;
+        });
+
+        check(itr != mRenderer.mModels.end(),
+              std::format("Failed to import {}.", benchmarkModel.importData.path).c_str());
+
+        Model& model = itr->second;
+
+        for (uint32_t i = 0; i < benchmarkModel.instanceCount; ++i, ++instanceIndex)
+        {
+            GraphNode* graphNode = createModelGraphRecursive(model, model.root, nullptr);
+
+            graphNode->localT = {
+                static_cast<float>(instanceIndex % gridSize) * mScene.instanceSpacing - gridOffset,
+                0.f,
+                static_cast<float>(instanceIndex / gridSize) * mScene.instanceSpacing - gridOffset
+            };
+
+            mRenderer.mSceneGraph->addNode(graphNode);
+        }
+    }
+}
+
+GraphNode *Benchmark::createModelGraphRecursive(Model &model, const SceneNode &sceneNode, GraphNode *parent)
+{
+    std::vector<uuid32_t> meshIDs;
+
+    for (unsigned int meshIndex : sceneNode.meshIndices)
+        meshIDs.push_back(model.meshes.at(meshIndex).meshID);
+
+    GraphNode* graphNode = new GraphNode(meshIDs.empty()? NodeType::Empty : NodeType::Mesh,
+                                         sceneNode.name,
+                                         sceneNode.translation,
+                                         sceneNode.rotation,
+                                         sceneNode.scale,
+                                         parent,
+                                         model.id,
+                                         meshIDs);
+
+    for (uuid32_t meshID : meshIDs)
+        model.getMesh(meshID)->mesh.addInstance(graphNode->id());
+
+    for (const auto& child : sceneNode.children)
+        graphNode->addChild(createModelGraphRecursive(model, child, graphNode));
+
+    return graphNode;
+}
+
+void Benchmark::addLights()
+{
+    std::shared_ptr<SceneGraph> sceneGraph = mRenderer.mSceneGraph;
+
+    // deterministic placement so runs are comparable
+    auto ringAngle = [] (uint32_t index, uint32_t count) {
+        return glm::radians(360.f * static_cast<float>(index) / static_cast<float>(count));
+    };
+
+    for (uint32_t i = 0; i < mScene.dirLights.count; ++i)
+    {
+        glm::vec3 orientation(-50.f, glm::degrees(ringAngle(i, mScene.dirLights.count)), 0.f);
+
+        DirectionalLight dirLight {
+            .color = glm::vec4(1.f),
+            .direction = glm::vec4(calcLightDir(orientation), 0.f),
+            .intensity = 1.f
+        };
+
+        DirShadowData shadowData {};
+        if (mScene.dirLights.shadows)
+            shadowData.shadowType = ShadowType::HardShadow;
+
+        GraphNode* lightNode = new GraphNode(NodeType::DirectionalLight,
+                                             std::format("Directional Light {}", i),
+                                             glm::vec3(0.f, mScene.lightHeight, 0.f),
+                                             orientation,
+                                             glm::vec3(1.f),
+                                             nullptr);
+
+        sceneGraph->addNode(lightNode);
+        mRenderer.addDirLight(lightNode->id(), dirLight, shadowData);
+    }
+
+    for (uint32_t i = 0; i < mScene.pointLights.count; ++i)
+    {
+        float angle = ringAngle(i, mScene.pointLights.count);
+        glm::vec3 position(glm::cos(angle) * mScene.lightRadius, mScene.lightHeight, glm::sin(angle) * mScene.lightRadius);
+
+        PointLight pointLight {
+            .color = glm::vec4(1.f),
+            .position = glm::vec4(position, 1.f),
+            .intensity = 1.f,
+            .range = mScene.lightRadius
+        };
+
+        PointShadowData shadowData {};
+        if (mScene.pointLights.shadows)
+            shadowData.shadowType = ShadowType::HardShadow;
+
+        GraphNode* lightNode = new GraphNode(NodeType::PointLight,
+                                             std::format("Point Light {}", i),
+                                             position,
+                                             {},
+                                             glm::vec3(1.f),
+                                             nullptr);
+
+        sceneGraph->addNode(lightNode);
+        mRenderer.addPointLight(lightNode->id(), pointLight, shadowData);
+    }
+
+    for (uint32_t i = 0; i < mScene.spotLights.count; ++i)
+    {
+        float angle = ringAngle(i, mScene.spotLights.count);
+        glm::vec3 position(glm::cos(angle) * mScene.lightRadius, mScene.lightHeight, glm::sin(angle) * mScene.lightRadius);
+
+        // tilt down, then yaw towards the origin
+        glm::vec3 orientation(-30.f, 90.f - glm::degrees(angle), 0.f);
+
+        SpotLight spotLight {
+            .color = glm::vec4(1.f),
+            .position = glm::vec4(position, 1.f),
+            .direction = glm::vec4(calcLightDir(orientation), 0.f),
+            .intensity = 1.f,
+            .range = mScene.lightRadius * 2.f,
+            .innerAngle = 45.f,
+            .outerAngle = 60.f
+        };
+
+        SpotShadowData shadowData {};
+        if (mScene.spotLights.shadows)
+            shadowData.shadowType = ShadowType::HardShadow;
+
+        GraphNode* lightNode = new GraphNode(NodeType::SpotLight,
+                                             std::format("Spot Light {}", i),
+                                             position,
+                                             orientation,
+                                             glm::vec3(1.f),
+                                             nullptr);
+
+        sceneGraph->addNode(lightNode);
+        mRenderer.addSpotLight(lightNode->id(), spotLight, shadowData);
+    }
+}
+
+void Benchmark::createFrameResources()
+{
+    VkCommandBufferAllocateInfo commandBufferAllocateInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool = mRenderDevice.commandPool,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = mRenderDevice.framesInFlight
+    };
+
+    VkResult result = vkAllocateCommandBuffers(mRenderDevice.device, &commandBufferAllocateInfo, mCommandBuffers.data());
+    vulkanCheck(result, "Failed to allocate command buffers.");
+
+    for (uint32_t i = 0; i < mRenderDevice.framesInFlight; ++i)
+    {
+        setVulkanObjectDebugName(mRenderDevice,
+                                 VK_OBJECT_TYPE_COMMAND_BUFFER,
+                                 std::format("Benchmark::mCommandBuffers.at({})", i),
+                                 mCommandBuffers.at(i));
+
+        mInFlightFences.at(i) = createFence(mRenderDevice, true, std::format("Benchmark::mInFlightFences.at({})", i).c_str());
+    }
+}
+
+void Benchmark::renderFrame(uint32_t frame)
+{
+    VkFence inFlightFence = mInFlightFences.at(mFrameIndex);
+    VkCommandBuffer commandBuffer = mCommandBuffers.at(mFrameIndex);
+
+    Timer waitTimer;
+    {
+        PROFILE_ZONE("Wait For Frame Fence");
+        vkWaitForFences(mRenderDevice.device, 1, &inFlightFence, VK_TRUE, UINT64_MAX);
+    }
+    waitTimer.end();
+
+    collectGpuTime(mFrameIndex);
+    mRenderer.beginFrame(mFrameIndex, mCpuFrameMs, waitTimer.ellapsedMicro() / 1000.0);
+
+    Timer cpuTimer;
+
+    updateCamera(frame);
+    mRenderer.update();
+
+    VkCommandBufferBeginInfo commandBufferBeginInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+    };
+
+    vkResetCommandBuffer(commandBuffer, 0);
+
+    VkResult result = vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo);
+    vulkanCheck(result, "Failed to begin command buffer.");
+
+    mRenderDevice.gpuProfiler->beginFrame(commandBuffer, mFrameIndex);
+    mRenderer.render(commandBuffer);
+    mRenderDevice.gpuProfiler->endFrame();
+
+    vkEndCommandBuffer(commandBuffer);
+
+    vkResetFences(mRenderDevice.device, 1, &inFlightFence);
+
+    mRenderDevice.uploadManager->flush();
+
+    VkSubmitInfo submitInfo {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &commandBuffer
+    };
+
+    result = vkQueueSubmit(mRenderDevice.graphicsQueue, 1, &submitInfo, inFlightFence);
+    vulkanCheck(result, "Failed queue submit.");
+
+    cpuTimer.end();
+    mCpuFrameMs = cpuTimer.ellapsedMicro() / 1000.0;
+
+    bool measured = frame >= mScene.warmupFrames;
+    mMeasuredFrames.at(mFrameIndex) = measured;
+
+    if (measured)
+        mCpuSamples.push_back(mCpuFrameMs);
+
+    mFrameIndex = (mFrameIndex + 1) % mRenderDevice.framesInFlight;
+}
+
+void Benchmark::updateCamera(uint32_t frame)
+{
+    const std::vector<BenchmarkCameraKey>& path = mScene.cameraPath;
+
+    // warmup frames hold the first key, the timed frames sweep the whole path
+    uint32_t timedFrame = frame < mScene.warmupFrames? 0 : frame - mScene.warmupFrames;
+    float t = mScene.frameCount > 1? static_cast<float>(timedFrame) / static_cast<float>(mScene.frameCount - 1) : 0.f;
+
+    float segment = t * static_cast<float>(path.size() - 1);
+    size_t keyIndex = std::min(static_cast<size_t>(segment), path.size() - 1);
+    size_t nextKeyIndex = std::min(keyIndex + 1, path.size() - 1);
+    float alpha = segment - static_cast<float>(keyIndex);
+
+    const BenchmarkCameraKey& key = path.at(keyIndex);
+    const BenchmarkCameraKey& nextKey = path.at(nextKeyIndex);
+
+    mRenderer.mCamera.lookAt(glm::mix(key.position, nextKey.position, alpha),
+                             glm::mix(key.target, nextKey.target, alpha));
+}
+
+void Benchmark::collectGpuTime(uint32_t frameIndex)
+{
+    VulkanGpuProfiler& gpuProfiler = *mRenderDevice.gpuProfiler;
+
+    gpuProfiler.collect(frameIndex);
+
+    if (mMeasuredFrames.at(frameIndex))
+        mGpuSamples.push_back(gpuProfiler.frameMs());
+
+    mMeasuredFrames.at(frameIndex) = false;
+}
+
+uint32_t Benchmark::instanceCount() const
+{
+    uint32_t count = 0;
+    for (const BenchmarkModel& benchmarkModel : mScene.models)
+        count += benchmarkModel.instanceCount;
+
+    return count;
+}
+
+void Benchmark::report()
+{
+    FrameTimeStats cpuStats = calcFrameTimeStats(mCpuSamples);
+    FrameTimeStats gpuStats = calcFrameTimeStats(mGpuSamples);
+    double avgFrameMs = mTotalMs / static_cast<double>(mScene.frameCount);
+
+    auto printStats = [] (const char* name, const FrameTimeStats& stats) {
+        std::cout << std::format("{:<4} min {:8.3f} | avg {:8.3f} | p50 {:8.3f} | p90 {:8.3f} | p99 {:8.3f} | max {:8.3f} ms\n",
+                                 name,
+                                 stats.minMs,
+                                 stats.avgMs,
+                                 stats.p50Ms,
+                                 stats.p90Ms,
+                                 stats.p99Ms,
+                                 stats.maxMs);
+    };
+
+    std::cout << std::format("Benchmark: {}x{}, {} instance(s), {} dir / {} point / {} spot light(s), {} frame(s) after {} warmup\n",
+                             mScene.width,
+                             mScene.height,
+                             instanceCount(),
+                             mScene.dirLights.count,
+                             mScene.pointLights.count,
+                             mScene.spotLights.count,
+                             mScene.frameCount,
+                             mScene.warmupFrames);
+
+    if (!mImportTimes.empty())
+    {
+        std::cout << std::format("Import of {} model(s)\n", mScene.models.size());
+        std::cout << std::format("{:>8} | {:>10} | {:>8}\n", "threads", "wall ms", "speedup");
+
+        for (const ImportTime& importTime : mImportTimes)
+        {
+            std::cout << std::format("{:>8} | {:>10.3f} | {:>7.2f}x\n",
+                                     importTime.threadCount,
+                                     importTime.ms,
+                                     mImportTimes.front().ms / importTime.ms);
+        }
+    }
+
+    if (!mUploadTimes.empty())
+    {
+        const BenchmarkUploads& uploads = mScene.uploads;
+        double uploadMB = (static_cast<double>(uploads.bufferCount) * uploads.bufferSize +
+                           static_cast<double>(uploads.textureCount) * uploads.textureSize * uploads.textureSize * 4) / (1024.0 * 1024.0);
+
+        std::cout << std::format("Upload of {} buffer(s) of {} KB and {} {}x{} texture(s), {:.2f} MB\n",
+                                 uploads.bufferCount,
+                                 uploads.bufferSize / 1024,
+                                 uploads.textureCount,
+                                 uploads.textureSize,
+                                 uploads.textureSize,
+                                 uploadMB);
+        std::cout << std::format("{:>16} | {:>10} | {:>10} | {:>8}\n", "path", "wall ms", "MB/s", "submits");
+
+        for (const UploadTime& uploadTime : mUploadTimes)
+        {
+            std::cout << std::format("{:>16} | {:>10.3f} | {:>10.1f} | {:>8}\n",
+                                     uploadTime.path,
+                                     uploadTime.ms,
+                                     uploadMB / (uploadTime.ms / 1000.0),
+                                     uploadTime.submitCount);
+        }
+    }
+
+    printStats("CPU", cpuStats);
+    printStats("GPU", gpuStats);
+
+    std::cout << std::format("Wall {:.3f} ms/frame ({:.1f} fps)\n", avgFrameMs, 1000.0 / avgFrameMs);
+
+    const CullingStats& cullingStats = mRenderer.mCullingStats;
+
+    if (mScene.gpuCulling && mScene.validateCulling)
+    {
+        std::cout << std::format("GPU culling: {} of {} mesh draws differ from the CPU\n",
+                                 cullingStats.mismatchedMeshes,
+                                 cullingStats.validatedMeshes);
+    }
+
+    if (mScene.resultsFile.empty())
+        return;
+
+    nlohmann::json results {
+        {"width", mScene.width},
+        {"height", mScene.height},
+        {"frames", mScene.frameCount},
+        {"framesInFlight", mScene.framesInFlight},
+        {"instances", instanceCount()},
+        {"dirLights", mScene.dirLights.count},
+        {"pointLights", mScene.pointLights.count},
+        {"spotLights", mScene.spotLights.count},
+        {"device", mRenderDevice.getDeviceProperties().deviceName},
+        {"cpuMs", toJson(cpuStats)},
+        {"gpuMs", toJson(gpuStats)},
+        {"wallMsPerFrame", avgFrameMs},
+        {"gpuCulling", mScene.gpuCulling}
+    };
+
+    if (mScene.gpuCulling && mScene.validateCulling)
+    {
+        results["validatedMeshDraws"] = cullingStats.validatedMeshes;
+        results["mismatchedMeshDraws"] = cullingStats.mismatchedMeshes;
+    }
+
+    for (const ImportTime& importTime : mImportTimes)
+        results["importMs"].push_back({{"threads", importTime.threadCount}, {"ms", importTime.ms}});
+
+    for (const UploadTime& uploadTime : mUploadTimes)
+        results["uploads"].push_back({{"path", uploadTime.path}, {"ms", uploadTime.ms}, {"submits", uploadTime.submitCount}});
+
+    std::ofstream file(mScene.resultsFile);
+    file << results.dump(4);
+}
+
+void Benchmark::saveImage(const std::filesystem::path &path)
+{
+    VulkanTexture& colorTexture = mRenderer.mColorTexture8U;
+    uint32_t width = colorTexture.width;
+    uint32_t height = colorTexture.height;
+
+    VulkanBuffer readbackBuffer(mRenderDevice,
+                                width * height * 4,
+                                BufferType::Staging,
+                                MemoryType::HostCached);
+
+    VkCommandBuffer commandBuffer = beginSingleTimeCommands(mRenderDevice);
+
+    colorTexture.transitionLayout(commandBuffer,
+                                  VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                  VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                  VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                  VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                  VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                                  VK_ACCESS_TRANSFER_READ_BIT);
+
+    VkBufferImageCopy copyRegion {
+        .bufferOffset = 0,
+        .bufferRowLength = width,
+        .bufferImageHeight = height,
+        .imageSubresource {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .mipLevel = 0,
+            .baseArrayLayer = 0,
+            .layerCount = 1
+        },
+        .imageOffset {0, 0, 0},
+        .imageExtent {width, height, 1}
+    };
+
+    vkCmdCopyImageToBuffer(commandBuffer,
+                           colorTexture.image,
+                           VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                           readbackBuffer.getBuffer(),
+                           1, &copyRegion);
+
+    colorTexture.transitionLayout(commandBuffer,
+                                  VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                  VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                  VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                  VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                                  VK_ACCESS_TRANSFER_READ_BIT,
+                                  VK_ACCESS_SHADER_READ_BIT);
+
+    VkMemoryBarrier hostBarrier {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_HOST_READ_BIT
+    };
+
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_HOST_BIT,
+                         0, 1, &hostBarrier, 0, nullptr, 0, nullptr);
+
+    endSingleTimeCommands(mRenderDevice, commandBuffer);
+
+    readbackBuffer.invalidate(0, readbackBuffer.getSize());
+
+    // binary ppm, no extra dependency and every image diff tool reads it
+    std::ofstream file(path, std::ios::binary);
+    check(file.is_open(), std::format("Failed to open {}.", path.string()).c_str());
+
+    file << std::format("P6\n{} {}\n255\n", width, height);
+
+    const uint8_t* pixels = readbackBuffer.mapped<uint8_t>();
+    for (uint32_t i = 0; i < width * height; ++i)
+        file.write(reinterpret_cast<const char*>(pixels + i * 4), 3);
+
+    debugLog(std::format("Saved benchmark image to {}", path.string()));
+}
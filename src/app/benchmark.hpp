@@ -0,0 +1,145 @@
+//
+// Created by Gianni on 16/10/2026.
+//
+
+#ifndef VULKANRENDERINGENGINE_BENCHMARK_HPP
+#define VULKANRENDERINGENGINE_BENCHMARK_HPP
+
+#include "../renderer/renderer.hpp"
+#include "../vk/vulkan_instance.hpp"
+#include "../vk/vulkan_render_device.hpp"
+#include "../vk/vulkan_upload_manager.hpp"
+#include "../vk/vulkan_gpu_profiler.hpp"
+#include "../utils/utils.hpp"
+#include "../utils/timer.hpp"
+#include "../utils/cpu_profiler.hpp"
+#include "save_data.hpp"
+
+struct BenchmarkModel
+{
+    ModelImportData importData;
+    uint32_t instanceCount;
+};
+
+struct BenchmarkLights
+{
+    uint32_t count;
+    bool shadows;
+};
+
+// a fixed set of device local buffers and textures, uploaded once through the upload manager and once with a
+// blocking submit per resource
+struct BenchmarkUploads
+{
+    uint32_t bufferCount;
+    uint32_t bufferSize;
+    uint32_t textureCount;
+    uint32_t textureSize;
+};
+
+struct BenchmarkCameraKey
+{
+    glm::vec3 position;
+    glm::vec3 target;
+};
+
+struct BenchmarkScene
+{
+    uint32_t width = 1920;
+    uint32_t height = 1080;
+    uint32_t framesInFlight = DefaultFramesInFlight;
+    uint32_t warmupFrames = 30;
+    uint32_t frameCount = 300;
+    float instanceSpacing = 3.f;
+    bool gpuCulling = true;
+    // compares the gpu culled instance counts with the cpu culling, costs cpu time
+    bool validateCulling = false;
+    // imports the models again with 1..importThreads threads and reports the wall clock time of each, 0 skips it
+    uint32_t importThreads = 0;
+    float lightRadius = 10.f;
+    float lightHeight = 3.f;
+    std::vector<BenchmarkModel> models;
+    BenchmarkLights dirLights {};
+    BenchmarkLights pointLights {};
+    BenchmarkLights spotLights {};
+    BenchmarkUploads uploads {};
+    std::vector<BenchmarkCameraKey> cameraPath;
+    std::string outputImage;
+    std::string resultsFile;
+    std::string cpuTrace;
+    std::string gpuTrace;
+};
+
+struct ImportTime
+{
+    uint32_t threadCount;
+    double ms;
+};
+
+struct UploadTime
+{
+    const char* path;
+    double ms;
+    uint32_t submitCount;
+};
+
+struct FrameTimeStats
+{
+    float minMs;
+    float avgMs;
+    float p50Ms;
+    float p90Ms;
+    float p99Ms;
+    float maxMs;
+};
+
+// Renders a scene description offscreen for a fixed number of frames, no window, swapchain or editor.
+// The renderer's final color target is the output, it can be dumped to a ppm for regression comparison.
+class Benchmark
+{
+public:
+    Benchmark(const std::filesystem::path& scenePath);
+    ~Benchmark();
+
+    void run();
+
+private:
+    void waitForImports();
+    void benchmarkImports();
+    void benchmarkUploads();
+    void uploadBatched(const std::vector<uint8_t>& data);
+    uint32_t uploadSingleTime(const std::vector<uint8_t>& data);
+    void createModelInstances();
+    GraphNode* createModelGraphRecursive(Model& model, const SceneNode& sceneNode, GraphNode* parent);
+    void addLights();
+    void createFrameResources();
+
+    void renderFrame(uint32_t frame);
+    void updateCamera(uint32_t frame);
+    void collectGpuTime(uint32_t frameIndex);
+
+    uint32_t instanceCount() const;
+    void report();
+    void saveImage(const std::filesystem::path& path);
+
+private:
+    BenchmarkScene mScene;
+    SaveData mSaveData;
+    VulkanInstance mInstance;
+    VulkanRenderDevice mRenderDevice;
+    Renderer mRenderer;
+
+    std::vector<VkCommandBuffer> mCommandBuffers;
+    std::vector<VkFence> mInFlightFences;
+    std::vector<bool> mMeasuredFrames;
+    uint32_t mFrameIndex;
+    float mCpuFrameMs;
+
+    std::vector<float> mCpuSamples;
+    std::vector<float> mGpuSamples;
+    std::vector<ImportTime> mImportTimes;
+    std::vector<UploadTime> mUploadTimes;
+    double mTotalMs;
+};
+
+#endif //VULKANRENDERINGENGINE_BENCHMARK_HPP
@@ -0,0 +1,952 @@
+//
+// Created by Gianni on 16/10/2026.
+//
+
+#include "cpu_benchmarks.hpp"
+
+struct CpuBenchmark
+{
+    const char* name;
+    void (*function)();
+};
+
+// parent indices always point backwards, entry 0 is the hierarchy's root
+struct SyntheticHierarchy
+{
+    std::vector<index_t> parents;
+    std::vector<glm::vec3> translations;
+    std::vector<glm::vec3> rotations;
+    std::vector<glm::vec3> scales;
+};
+
+static SyntheticHierarchy createSyntheticHierarchy(uint32_t nodeCount, uint32_t seed = 1)
+{
+    std::mt19937 randomEngine(seed);
+    std::uniform_real_distribution<float> translation(-10.f, 10.f);
+    std::uniform_real_distribution<float> rotation(-180.f, 180.f);
+    std::uniform_real_distribution<float> scale(0.5f, 1.5f);
+
+    SyntheticHierarchy hierarchy;
+    hierarchy.parents.reserve(nodeCount);
+
+    for (uint32_t i = 0; i < nodeCount; ++i)
+    {
+        // random recursive tree, wide and shallow like imported scenes
+        index_t parent = i? std::uniform_int_distribution<index_t>(0, i - 1)(randomEngine) : InvalidTransformIndex;
+
+        hierarchy.parents.push_back(parent);
+        hierarchy.translations.emplace_back(translation(randomEngine), translation(randomEngine), translation(randomEngine));
+        hierarchy.rotations.emplace_back(rotation(randomEngine), rotation(randomEngine), rotation(randomEngine));
+        hierarchy.scales.emplace_back(scale(randomEngine));
+    }
+
+    return hierarchy;
+}
+
+// meshes without geometry, enough for lookups and instance data
+static Model createSyntheticModel(uint32_t meshCount)
+{
+    Model model;
+    model.id = UUIDRegistry::generateModelID();
+
+    for (uint32_t i = 0; i < meshCount; ++i)
+    {
+        model.addMesh({
+            .meshID = UUIDRegistry::generateMeshID(),
+            .name = std::format("Mesh {}", i),
+            .mesh {},
+            .materialIndex = 0,
+            .center = {}
+        });
+    }
+
+    return model;
+}
+
+// the first node owns the rest. With a model every node is a mesh node instancing one of its meshes
+static std::vector<GraphNode*> createGraphNodes(const SyntheticHierarchy& hierarchy, const Model* model = nullptr)
+{
+    std::vector<GraphNode*> nodes;
+    nodes.reserve(hierarchy.parents.size());
+
+    for (size_t i = 0; i < hierarchy.parents.size(); ++i)
+    {
+        index_t parent = hierarchy.parents.at(i);
+
+        GraphNode* node;
+
+        if (model)
+        {
+            node = new GraphNode(NodeType::Mesh,
+                                 std::format("Node {}", i),
+                                 hierarchy.translations.at(i),
+                                 hierarchy.rotations.at(i),
+                                 hierarchy.scales.at(i),
+                                 nullptr,
+                                 model->id,
+                                 {model->meshes.at(i % model->meshes.size()).meshID});
+        }
+        else
+        {
+            node = new GraphNode(NodeType::Empty,
+                                 std::format("Node {}", i),
+                                 hierarchy.translations.at(i),
+                                 hierarchy.rotations.at(i),
+                                 hierarchy.scales.at(i),
+                                 nullptr);
+        }
+
+        if (parent != InvalidTransformIndex)
+            nodes.at(parent)->addChild(node);
+
+        nodes.push_back(node);
+    }
+
+    return nodes;
+}
+
+template<typename F>
+static double measureMs(uint32_t iterations, F&& function)
+{
+    Timer timer;
+
+    for (uint32_t i = 0; i < iterations; ++i)
+        function();
+
+    timer.end();
+
+    return timer.ellapsedNano() / 1000000.0 / static_cast<double>(iterations);
+}
+
+// the recursive pointer walk the renderer did before the transform store
+static void updateTreeRecursive(GraphNode* node)
+{
+    node->updateGlobalTransform();
+
+    for (GraphNode* child : node->children())
+        updateTreeRecursive(child);
+}
+
+// largest element difference, relative to the element once it's above 1
+template<glm::length_t C, glm::length_t R>
+static float maxError(const glm::mat<C, R, float>& matrix, const glm::mat<C, R, float>& reference)
+{
+    float error = 0.f;
+
+    for (glm::length_t column = 0; column < C; ++column)
+        for (glm::length_t row = 0; row < R; ++row)
+            error = std::max(error, glm::abs(matrix[column][row] - reference[column][row]) / std::max(1.f, glm::abs(reference[column][row])));
+
+    return error;
+}
+
+// the store goes through the batch kernels, the tree through glm
+static bool sameGlobalTransforms(const std::vector<GraphNode*>& nodes, const std::vector<GraphNode*>& otherNodes)
+{
+    for (size_t i = 0; i < nodes.size(); ++i)
+        if (maxError(nodes.at(i)->globalTransform(), otherNodes.at(i)->globalTransform()) > 1e-4f)
+            return false;
+
+    return true;
+}
+
+static void benchmarkTransformUpdate()
+{
+    std::cout << "Transform update, ms per update. full: the hierarchy's root moved, idle: nothing changed\n";
+    std::cout << std::format("{:>8} | {:>10} | {:>10} | {:>10} | {:>10} | {:>11}\n",
+                             "nodes", "tree full", "store full", "tree idle", "store idle", "store build");
+
+    for (uint32_t nodeCount : {1000u, 10000u, 100000u})
+    {
+        SyntheticHierarchy hierarchy = createSyntheticHierarchy(nodeCount);
+        uint32_t iterations = std::max(10u, 1000000u / nodeCount);
+
+        std::vector<GraphNode*> treeNodes = createGraphNodes(hierarchy);
+        std::unique_ptr<GraphNode> treeRoot(treeNodes.front());
+
+        double treeFullMs = measureMs(iterations, [&] () {
+            treeRoot->markDirty();
+            updateTreeRecursive(treeRoot.get());
+        });
+
+        double treeIdleMs = measureMs(iterations, [&] () {
+            updateTreeRecursive(treeRoot.get());
+        });
+
+        SceneGraph sceneGraph;
+        std::vector<GraphNode*> storeNodes = createGraphNodes(hierarchy);
+        sceneGraph.addNode(storeNodes.front());
+
+        double storeBuildMs = measureMs(1, [&] () {
+            sceneGraph.updateTransforms();
+        });
+
+        double storeFullMs = measureMs(iterations, [&] () {
+            storeNodes.front()->markDirty();
+            sceneGraph.updateTransforms();
+        });
+
+        double storeIdleMs = measureMs(iterations, [&] () {
+            sceneGraph.updateTransforms();
+        });
+
+        check(sameGlobalTransforms(treeNodes, storeNodes), "Transform store disagrees with the recursive tree update.");
+
+        std::cout << std::format("{:>8} | {:>10.4f} | {:>10.4f} | {:>10.4f} | {:>10.4f} | {:>11.4f}\n",
+                                 nodeCount,
+                                 treeFullMs,
+                                 storeFullMs,
+                                 treeIdleMs,
+                                 storeIdleMs,
+                                 storeBuildMs);
+    }
+}
+
+// the lookups the renderer did before the uuid maps
+static GraphNode* searchNodeRecursive(GraphNode* node, uuid32_t nodeID)
+{
+    if (node->id() == nodeID)
+        return node;
+
+    for (GraphNode* child : node->children())
+        if (GraphNode* found = searchNodeRecursive(child, nodeID))
+            return found;
+
+    return nullptr;
+}
+
+static Mesh* searchMeshLinear(Model& model, uuid32_t meshID)
+{
+    for (Mesh& mesh : model.meshes)
+        if (mesh.meshID == meshID)
+            return &mesh;
+
+    return nullptr;
+}
+
+static void benchmarkLookups()
+{
+    constexpr uint32_t NodeCount = 10000;
+    constexpr uint32_t MeshCount = 1000;
+    constexpr uint32_t LightCount = 64;
+
+    Model model = createSyntheticModel(MeshCount);
+
+    SceneGraph sceneGraph;
+    std::vector<GraphNode*> nodes = createGraphNodes(createSyntheticHierarchy(NodeCount), &model);
+    sceneGraph.addNode(nodes.front());
+    sceneGraph.updateTransforms();
+
+    // light icons look their node up by id, spread the lights over the graph
+    std::vector<uuid32_t> lightIDs;
+    for (uint32_t i = 0; i < LightCount; ++i)
+        lightIDs.push_back(nodes.at(i * NodeCount / LightCount)->id());
+
+    // a frame where everything moved: every mesh node is updated and sorted, every light icon is placed
+    uint64_t checksum[2] {};
+    uint32_t iterations = 20;
+
+    double beforeMs = measureMs(iterations, [&] () {
+        std::vector<GraphNode*> stack(1, sceneGraph.root());
+
+        while (!stack.empty())
+        {
+            GraphNode* node = stack.back();
+            stack.pop_back();
+
+            for (auto child : node->children())
+                stack.push_back(child);
+
+            for (uuid32_t meshID : node->meshIDs())
+                checksum[0] += searchMeshLinear(model, meshID)->meshID;
+        }
+
+        for (uuid32_t lightID : lightIDs)
+            checksum[0] += searchNodeRecursive(sceneGraph.root(), lightID)->id();
+    });
+
+    double afterMs = measureMs(iterations, [&] () {
+        for (GraphNode* node : sceneGraph.transforms().nodes())
+            for (uuid32_t meshID : node->meshIDs())
+                checksum[1] += model.getMesh(meshID)->meshID;
+
+        for (uuid32_t lightID : lightIDs)
+            checksum[1] += sceneGraph.searchNode(lightID)->id();
+    });
+
+    std::cout << std::format("Per frame lookups, {} mesh nodes over {} meshes, {} light nodes\n", NodeCount, MeshCount, LightCount);
+    std::cout << std::format("{:>16} | {:>10}\n", "", "ms");
+    std::cout << std::format("{:>16} | {:>10.4f}\n", "search", beforeMs);
+    std::cout << std::format("{:>16} | {:>10.4f}\n", "uuid map", afterMs);
+
+    check(checksum[0] == checksum[1], "Uuid map lookups disagree with the search.");
+}
+
+static void benchmarkParallelSceneUpdate()
+{
+    constexpr uint32_t NodeCount = 100000;
+    constexpr uint32_t MeshCount = 1000;
+
+    SyntheticHierarchy hierarchy = createSyntheticHierarchy(NodeCount);
+    std::vector<glm::mat4> serialTransforms;
+    double serialMs = 0.0;
+
+    std::cout << std::format("Scene update across threads, {} mesh nodes all moving, transforms and instance data\n", NodeCount);
+    std::cout << std::format("{:>8} | {:>10} | {:>8}\n", "threads", "ms", "speedup");
+
+    for (uint32_t threadCount : {1u, 2u, 4u, 8u, 16u})
+    {
+        // the calling thread takes a batch too
+        std::unique_ptr<ThreadPool> threadPool;
+        if (threadCount > 1)
+            threadPool = std::make_unique<ThreadPool>(threadCount - 1, "Benchmark");
+
+        Model model = createSyntheticModel(MeshCount);
+        SceneGraph sceneGraph;
+        std::vector<GraphNode*> nodes = createGraphNodes(hierarchy, &model);
+
+        for (GraphNode* node : nodes)
+            for (uuid32_t meshID : node->meshIDs())
+                model.getMesh(meshID)->mesh.addInstance(node->id());
+
+        sceneGraph.addNode(nodes.front());
+        sceneGraph.updateTransforms(threadPool.get());
+
+        double ms = measureMs(20, [&] () {
+            nodes.front()->markDirty();
+
+            const std::vector<GraphNode*>& updatedNodes = sceneGraph.updateTransforms(threadPool.get());
+
+            parallelFor(threadPool.get(), updatedNodes.size(), 256, [&model, &updatedNodes] (uint32_t begin, uint32_t end) {
+                glm::mat4 transforms[64];
+                glm::mat3 normalMatrices[64];
+
+                for (uint32_t i = begin; i < end; i += 64)
+                {
+                    uint32_t count = std::min(end - i, 64u);
+
+                    for (uint32_t j = 0; j < count; ++j)
+                        transforms[j] = updatedNodes[i + j]->globalTransform();
+
+                    calcNormalMatrices(transforms, normalMatrices, count);
+
+                    for (uint32_t j = 0; j < count; ++j)
+                        for (uuid32_t meshID : updatedNodes[i + j]->meshIDs())
+                            model.getMesh(meshID)->mesh.setInstanceTransform(updatedNodes[i + j]->id(), transforms[j], normalMatrices[j]);
+                }
+            });
+        });
+
+        std::vector<glm::mat4> transforms;
+        for (GraphNode* node : nodes)
+            transforms.push_back(node->globalTransform());
+
+        if (threadCount == 1)
+        {
+            serialTransforms = transforms;
+            serialMs = ms;
+        }
+
+        check(transforms == serialTransforms, "Parallel scene update disagrees with the serial one.");
+
+        std::cout << std::format("{:>8} | {:>10.4f} | {:>7.2f}x\n",
+                                 threadCount,
+                                 ms,
+                                 serialMs / ms);
+    }
+}
+
+template<typename F>
+static double millionsPerSecond(uint32_t count, F&& function)
+{
+    return count / measureMs(10, function) / 1000.0;
+}
+
+// doubles as the kernels' test, fails when a kernel drifts from glm
+static void benchmarkTransformKernels()
+{
+    constexpr uint32_t Count = 100000;
+
+    SyntheticHierarchy hierarchy = createSyntheticHierarchy(Count);
+    std::vector<glm::mat4> parents(Count);
+    std::vector<glm::mat4> locals(Count);
+    std::vector<glm::mat4> results(Count);
+    std::vector<glm::mat4> references(Count);
+    std::vector<glm::mat3> normalMatrices(Count);
+    std::vector<glm::mat3> normalReferences(Count);
+
+    for (uint32_t i = 0; i < Count; ++i)
+        parents.at(i) = composeTransform(hierarchy.translations.at(Count - 1 - i), hierarchy.rotations.at(Count - 1 - i), hierarchy.scales.at(Count - 1 - i));
+
+    std::cout << std::format("Transform kernels ({}), millions of matrices per second over {} nodes\n", transformKernelsPath(), Count);
+    std::cout << std::format("{:>14} | {:>8} | {:>8} | {:>10}\n", "", "glm", "batch", "max error");
+
+    auto report = [] (const char* name, double glmRate, double batchRate, float error, float tolerance) {
+        std::cout << std::format("{:>14} | {:>8.2f} | {:>8.2f} | {:>10.2e}\n", name, glmRate, batchRate, error);
+        check(error <= tolerance, std::format("{} kernel differs from glm by {}.", name, error).c_str());
+    };
+
+    float error = 0.f;
+
+    double glmRate = millionsPerSecond(Count, [&] () {
+        for (uint32_t i = 0; i < Count; ++i)
+            references[i] = composeTransform(hierarchy.translations[i], hierarchy.rotations[i], hierarchy.scales[i]);
+    });
+
+    double batchRate = millionsPerSecond(Count, [&] () {
+        composeTransforms(hierarchy.translations.data(), hierarchy.rotations.data(), hierarchy.scales.data(), locals.data(), Count);
+    });
+
+    for (uint32_t i = 0; i < Count; ++i)
+        error = std::max(error, maxError(locals[i], references[i]));
+
+    report("compose", glmRate, batchRate, error, 1e-5f);
+
+    glmRate = millionsPerSecond(Count, [&] () {
+        for (uint32_t i = 0; i < Count; ++i)
+            references[i] = parents[i] * locals[i];
+    });
+
+    batchRate = millionsPerSecond(Count, [&] () {
+        multiplyTransforms(parents.data(), locals.data(), results.data(), Count);
+    });
+
+    error = 0.f;
+    for (uint32_t i = 0; i < Count; ++i)
+        error = std::max(error, maxError(results[i], references[i]));
+
+    report("multiply", glmRate, batchRate, error, 1e-5f);
+
+    glmRate = millionsPerSecond(Count, [&] () {
+        for (uint32_t i = 0; i < Count; ++i)
+            normalReferences[i] = glm::inverseTranspose(glm::mat3(results[i]));
+    });
+
+    batchRate = millionsPerSecond(Count, [&] () {
+        calcNormalMatrices(results.data(), normalMatrices.data(), Count);
+    });
+
+    error = 0.f;
+    for (uint32_t i = 0; i < Count; ++i)
+        error = std::max(error, maxError(normalMatrices[i], normalReferences[i]));
+
+    report("normal matrix", glmRate, batchRate, error, 1e-5f);
+}
+
+// the kernel has to keep exactly the boxes the scalar test keeps
+static void benchmarkFrustumCulling()
+{
+    constexpr uint32_t Count = 100000;
+
+    SyntheticHierarchy hierarchy = createSyntheticHierarchy(Count);
+    Aabb localBounds {glm::vec3(-0.5f), glm::vec3(0.5f)};
+
+    std::vector<Aabb> worldBounds;
+    BoundsArray boundsArray;
+
+    for (uint32_t i = 0; i < Count; ++i)
+    {
+        glm::mat4 transform = composeTransform(hierarchy.translations[i], hierarchy.rotations[i], hierarchy.scales[i]);
+
+        worldBounds.push_back(transformAabb(localBounds, transform));
+        boundsArray.add(worldBounds.back());
+    }
+
+    glm::mat4 view = glm::lookAt(glm::vec3(0.f), glm::vec3(0.f, 0.f, -1.f), glm::vec3(0.f, 1.f, 0.f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.f), 16.f / 9.f, 0.1f, 100.f);
+    Frustum frustum = extractFrustum(projection * view);
+
+    std::vector<uint32_t> scalarIndices(Count);
+    std::vector<uint32_t> kernelIndices(Count);
+    uint32_t scalarCount = 0;
+    uint32_t kernelCount = 0;
+
+    double scalarRate = millionsPerSecond(Count, [&] () {
+        scalarCount = 0;
+        for (uint32_t i = 0; i < Count; ++i)
+            if (isVisible(frustum, worldBounds[i]))
+                scalarIndices[scalarCount++] = i;
+    });
+
+    double kernelRate = millionsPerSecond(Count, [&] () {
+        kernelCount = cullBoxes(frustum, boundsArray, kernelIndices.data());
+    });
+
+    bool same = scalarCount == kernelCount && std::equal(scalarIndices.begin(), scalarIndices.begin() + scalarCount, kernelIndices.begin());
+
+    std::cout << std::format("Frustum culling, millions of boxes per second over {} boxes ({} visible)\n", Count, kernelCount);
+    std::cout << std::format("{:>8} | {:>8}\n", "scalar", "kernel");
+    std::cout << std::format("{:>8.2f} | {:>8.2f}\n", scalarRate, kernelRate);
+
+    check(same, "Culling kernel disagrees with the scalar test.");
+}
+
+// the binned assignment has to write exactly the lists testing every light against every cluster writes
+static void benchmarkLightClustering()
+{
+    const glm::uvec3 gridSize(16, 16, 24);
+    const glm::uvec2 screenSize(1600, 900);
+
+    glm::mat4 view = glm::lookAt(glm::vec3(0.f, 2.f, 0.f), glm::vec3(0.f, 2.f, -1.f), glm::vec3(0.f, 1.f, 0.f));
+    glm::mat4 projection = glm::perspective(glm::radians(40.f), 16.f / 9.f, 0.1f, 100.f);
+    std::vector<Aabb> clusters = clusterBounds(projection, gridSize, screenSize, 0.1f, 100.f);
+
+    std::mt19937 randomEngine(1);
+    std::uniform_real_distribution<float> position(-60.f, 60.f);
+    std::uniform_real_distribution<float> range(1.f, 8.f);
+    std::uniform_real_distribution<float> angle(10.f, 120.f);
+    std::uniform_real_distribution<float> direction(-1.f, 1.f);
+
+    std::cout << std::format("Light clustering, {}x{}x{} clusters, half point and half spot lights\n", gridSize.x, gridSize.y, gridSize.z);
+    std::cout << std::format("{:>8} | {:>10} | {:>10} | {:>10} | {:>12}\n", "lights", "bin ms", "binned ms", "brute ms", "per cluster");
+
+    bool same = true;
+
+    for (uint32_t lightCount : {1000u, 10000u, 64000u})
+    {
+        std::vector<ClusterLight> lights;
+
+        for (uint32_t i = 0; i < lightCount; ++i)
+        {
+            glm::vec4 lightPosition(position(randomEngine), position(randomEngine) * 0.1f, position(randomEngine) - 40.f, 1.f);
+
+            if (i % 2)
+            {
+                PointLight pointLight {.position = lightPosition, .range = range(randomEngine)};
+                lights.push_back(clusterLight(pointLight, i / 2, view));
+            }
+            else
+            {
+                glm::vec3 lightDirection(direction(randomEngine), direction(randomEngine), direction(randomEngine));
+
+                SpotLight spotLight {
+                    .position = lightPosition,
+                    .direction = glm::vec4(glm::normalize(lightDirection), 0.f),
+                    .range = range(randomEngine) * 2.f,
+                    .outerAngle = angle(randomEngine)
+                };
+
+                lights.push_back(clusterLight(spotLight, i / 2, view));
+            }
+        }
+
+        ClusterLightBins bins;
+        ClusterLightGrid binnedGrid;
+        ClusterLightGrid bruteGrid;
+
+        double binMs = measureMs(1, [&] () {
+            binClusterLights(lights, clusters, gridSize, bins);
+        });
+
+        double binnedMs = measureMs(1, [&] () {
+            assignLightsToClusters(lights, bins, gridSize, clusters, binnedGrid);
+        });
+
+        double bruteMs = measureMs(1, [&] () {
+            assignLightsToClusters(lights, clusters, bruteGrid);
+        });
+
+        same &= binnedGrid.lightLists == bruteGrid.lightLists && binnedGrid.lightIndices == bruteGrid.lightIndices;
+
+        std::cout << std::format("{:>8} | {:>10.3f} | {:>10.3f} | {:>10.3f} | {:>12.2f}\n",
+                                 lightCount, binMs, binnedMs, bruteMs,
+                                 static_cast<double>(binnedGrid.lightIndices.size()) / static_cast<double>(clusters.size()));
+    }
+
+    check(same, "Binned light assignment disagrees with the brute force one.");
+}
+
+// bytes of the 64 byte lines a read of [begin, end) touches
+static uint64_t touchedBytes(uint64_t begin, uint64_t end)
+{
+    return end > begin? ((end - 1) / 64 - begin / 64 + 1) * 64 : 0;
+}
+
+// marks the 64 byte lines of [begin, end), lines read by more than one cluster only count once
+static void touchLines(std::vector<bool>& lines, uint64_t begin, uint64_t end)
+{
+    for (uint64_t line = begin / 64; end > begin && line <= (end - 1) / 64; ++line)
+    {
+        if (line >= lines.size())
+            lines.resize(line + 1);
+        lines[line] = true;
+    }
+}
+
+// The cluster light lists as they were, a fixed array in every cluster, against an offset and count per cluster
+// into one shared list. Traffic is counted in whole cache lines, the shading pass reads every cluster's list once and
+// a line shared by neighbouring clusters is only fetched once. The shared list is counted at the size the frame needs.
+static void benchmarkClusterLightLists()
+{
+    // the old Cluster struct
+    struct FixedCluster
+    {
+        alignas(16) glm::vec4 minPoint;
+        alignas(16) glm::vec4 maxPoint;
+        alignas(4) uint32_t lightCount;
+        alignas(16) uint32_t lightIndices[32];
+    };
+
+    constexpr uint32_t FixedCapacity = 32;
+    constexpr uint64_t FixedListBegin = offsetof(FixedCluster, lightCount);
+    constexpr uint64_t FixedIndicesBegin = offsetof(FixedCluster, lightIndices);
+    constexpr uint64_t BoundsSize = offsetof(FixedCluster, lightCount);
+
+    const glm::uvec3 gridSize(16, 16, 24);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.f, 2.f, 0.f), glm::vec3(0.f, 2.f, -1.f), glm::vec3(0.f, 1.f, 0.f));
+    glm::mat4 projection = glm::perspective(glm::radians(40.f), 16.f / 9.f, 0.1f, 100.f);
+    std::vector<Aabb> clusters = clusterBounds(projection, gridSize, glm::uvec2(1600, 900), 0.1f, 100.f);
+    uint64_t clusterCount = clusters.size();
+
+    std::mt19937 randomEngine(1);
+    std::uniform_real_distribution<float> position(-30.f, 30.f);
+    std::uniform_real_distribution<float> range(2.f, 12.f);
+
+    std::cout << std::format("Cluster light lists, {} clusters, KB per frame\n", clusterCount);
+    std::cout << std::format("{:>8} | {:>8} | {:>10} | {:>10} | {:>10} | {:>8}\n", "lights", "layout", "buffers", "assign", "shading", "dropped");
+
+    for (uint32_t lightCount : {32u, 256u, 1024u})
+    {
+        std::vector<ClusterLight> lights;
+        for (uint32_t i = 0; i < lightCount; ++i)
+        {
+            PointLight pointLight {
+                .position = glm::vec4(position(randomEngine), position(randomEngine) * 0.2f, position(randomEngine) - 30.f, 1.f),
+                .range = range(randomEngine)
+            };
+
+            lights.push_back(clusterLight(pointLight, i, view));
+        }
+
+        ClusterLightGrid grid;
+        assignLightsToClusters(lights, clusters, grid);
+
+        uint64_t fixedAssign = 0;
+        uint64_t dropped = 0;
+        std::vector<bool> fixedLines;
+        std::vector<bool> gridLines;
+        std::vector<bool> indexLines;
+
+        for (uint64_t cluster = 0; cluster < clusterCount; ++cluster)
+        {
+            const LightRange& lightList = grid.lightLists[cluster];
+            uint64_t kept = std::min(lightList.count, FixedCapacity);
+            uint64_t fixedBase = cluster * sizeof(FixedCluster);
+            uint64_t compactBase = sizeof(uint32_t) + lightList.offset * sizeof(uint32_t);
+
+            // the assignment pass read and wrote back the whole struct
+            fixedAssign += 2 * touchedBytes(fixedBase, fixedBase + sizeof(FixedCluster));
+            touchLines(fixedLines, fixedBase + FixedListBegin, fixedBase + FixedIndicesBegin + kept * sizeof(uint32_t));
+            dropped += lightList.count - kept;
+
+            touchLines(gridLines, cluster * sizeof(LightRange), (cluster + 1) * sizeof(LightRange));
+            touchLines(indexLines, compactBase, compactBase + lightList.count * sizeof(uint32_t));
+        }
+
+        auto lineBytes = [] (const std::vector<bool>& lines) {
+            return static_cast<uint64_t>(std::count(lines.begin(), lines.end(), true)) * 64;
+        };
+
+        uint64_t fixedShading = lineBytes(fixedLines);
+        uint64_t compactShading = lineBytes(gridLines) + lineBytes(indexLines);
+
+        uint64_t lightIndexBytes = sizeof(uint32_t) + grid.lightIndices.size() * sizeof(uint32_t);
+        uint64_t fixedBuffers = clusterCount * sizeof(FixedCluster);
+        uint64_t compactBuffers = clusterCount * (BoundsSize + sizeof(LightRange)) + lightIndexBytes;
+
+        // bounds are read, the range and the list written
+        uint64_t compactAssign = touchedBytes(0, clusterCount * BoundsSize) +
+                                 touchedBytes(0, clusterCount * sizeof(LightRange)) +
+                                 touchedBytes(0, lightIndexBytes);
+
+        auto kb = [] (uint64_t bytes) { return static_cast<double>(bytes) / 1024.0; };
+
+        std::cout << std::format("{:>8} | {:>8} | {:>10.1f} | {:>10.1f} | {:>10.1f} | {:>8}\n",
+                                 lightCount, "fixed", kb(fixedBuffers), kb(fixedAssign), kb(fixedShading), dropped);
+        std::cout << std::format("{:>8} | {:>8} | {:>10.1f} | {:>10.1f} | {:>10.1f} | {:>8}\n",
+                                 "", "compact", kb(compactBuffers), kb(compactAssign), kb(compactShading), 0);
+    }
+}
+
+// keys built like buildRenderQueues does over meshes spread across models the way the unordered model map hands
+// them out. the prepass keys are only raster state and a coarse depth, so many of them tie and comparing the items
+// against std::stable_sort checks that the radix sort keeps the order equal keys were added in
+static void benchmarkRenderQueue()
+{
+    constexpr uint32_t MaterialCount = 512;
+    constexpr uint32_t DepthCount = 256;
+
+    std::mt19937 randomEngine(1);
+    std::uniform_int_distribution<uint32_t> rasterState(0, 5);
+    std::uniform_int_distribution<uint32_t> material(0, MaterialCount - 1);
+    std::uniform_int_distribution<uint32_t> depth(0, DepthCount - 1);
+
+    std::cout << std::format("Render queue, {} materials, prepass depths in {} steps\n", MaterialCount, DepthCount);
+    std::cout << std::format("{:>8} | {:>8} | {:>10} | {:>10} | {:>8} | {:>16} | {:>16}\n",
+                             "pass", "draws", "radix ms", "std ms", "ties", "raster changes", "material changes");
+
+    bool same = true;
+    uint32_t tiedPackets = 0;
+
+    for (uint32_t drawCount : {1000u, 10000u, 100000u})
+    {
+        for (RenderQueuePass pass : {RenderQueuePass::Prepass, RenderQueuePass::ForwardOpaque})
+        {
+            RenderQueue renderQueue;
+            std::vector<DrawPacket> reference;
+
+            for (uint32_t i = 0; i < drawCount; ++i)
+            {
+                DrawKey key {
+                    .pass = static_cast<uint32_t>(pass),
+                    .rasterState = rasterState(randomEngine)
+                };
+
+                if (pass == RenderQueuePass::Prepass)
+                {
+                    key.depth = depth(randomEngine) * ((1u << DrawKeyDepthBits) / DepthCount);
+                }
+                else
+                {
+                    key.material = material(randomEngine);
+                    key.mesh = i;
+                }
+
+                renderQueue.add(key, i);
+                reference.push_back({packDrawKey(key), i});
+            }
+
+            uint32_t unsortedRasterChanges = renderQueue.keyChanges(DrawKeyRasterStateMask);
+            uint32_t unsortedMaterialChanges = renderQueue.keyChanges(DrawKeyMaterialMask);
+
+            double radixMs = measureMs(1, [&] () {
+                renderQueue.sort();
+            });
+
+            double stdMs = measureMs(1, [&] () {
+                std::stable_sort(reference.begin(), reference.end(), [] (const DrawPacket& a, const DrawPacket& b) {
+                    return a.key < b.key;
+                });
+            });
+
+            const std::vector<DrawPacket>& sorted = renderQueue.packets();
+            same &= std::equal(sorted.begin(), sorted.end(), reference.begin(), reference.end(), [] (const DrawPacket& a, const DrawPacket& b) {
+                return a.key == b.key && a.item == b.item;
+            });
+
+            uint32_t ties = drawCount - renderQueue.keyChanges(~0ull);
+            tiedPackets += ties;
+
+            std::cout << std::format("{:>8} | {:>8} | {:>10.3f} | {:>10.3f} | {:>8} | {:>7} -> {:>5} | {:>7} -> {:>5}\n",
+                                     pass == RenderQueuePass::Prepass? "prepass" : "forward",
+                                     drawCount, radixMs, stdMs, ties,
+                                     unsortedRasterChanges, renderQueue.keyChanges(DrawKeyRasterStateMask),
+                                     unsortedMaterialChanges, renderQueue.keyChanges(DrawKeyMaterialMask));
+        }
+    }
+
+    check(tiedPackets > 0, "Render queue keys never tie, the sort's stability isn't checked.");
+    check(same, "Render queue sort disagrees with std::stable_sort.");
+}
+
+// where FreeListAllocator should put an allocation, from a byte per byte map of the block. the free runs are what the
+// free list should hold after coalescing
+struct ReferenceBlock
+{
+    std::vector<bool> used;
+
+    std::vector<std::pair<uint64_t, uint64_t>> freeRuns() const
+    {
+        std::vector<std::pair<uint64_t, uint64_t>> runs;
+
+        for (uint64_t i = 0; i < used.size();)
+        {
+            if (used[i])
+            {
+                ++i;
+                continue;
+            }
+
+            uint64_t begin = i;
+            while (i < used.size() && !used[i])
+                ++i;
+
+            runs.emplace_back(begin, i - begin);
+        }
+
+        return runs;
+    }
+
+    // best fit, ties go to the lowest offset
+    std::optional<uint64_t> bestFit(uint64_t size, uint64_t alignment) const
+    {
+        std::optional<std::pair<uint64_t, uint64_t>> best;
+
+        for (const auto& run : freeRuns())
+        {
+            uint64_t offset = (run.first + alignment - 1) / alignment * alignment;
+
+            if (offset + size <= run.first + run.second && (!best || run.second < best->second))
+                best = run;
+        }
+
+        if (!best)
+            return std::nullopt;
+
+        return best->first;
+    }
+
+    void mark(uint64_t offset, uint64_t size, bool value)
+    {
+        std::fill(used.begin() + offset, used.begin() + offset + size, value);
+    }
+};
+
+// random allocations and frees checked against the byte map, then the linear strategy's reset
+static void benchmarkMemoryAllocator()
+{
+    constexpr VkDeviceSize BlockSize = 16 * 1024;
+    constexpr uint32_t OperationCount = 20000;
+
+    std::mt19937 randomEngine(1);
+    std::uniform_int_distribution<uint32_t> size(1, 1024);
+    std::uniform_int_distribution<uint32_t> alignmentShift(0, 8);
+    std::uniform_int_distribution<uint32_t> operation(0, 99);
+
+    FreeListAllocator freeList(BlockSize);
+    ReferenceBlock reference {std::vector<bool>(BlockSize, false)};
+    std::vector<FreeListAllocator::Range> live;
+
+    uint32_t allocations = 0;
+    uint32_t failedAllocations = 0;
+    uint32_t maxFreeRanges = 1;
+    bool correct = true;
+
+    auto checkFreeRanges = [&] () {
+        std::vector<std::pair<uint64_t, uint64_t>> runs = reference.freeRuns();
+
+        VkDeviceSize freeBytes = 0;
+        VkDeviceSize largest = 0;
+        for (const auto& [offset, runSize] : runs)
+        {
+            freeBytes += runSize;
+            largest = std::max<VkDeviceSize>(largest, runSize);
+        }
+
+        // neighbouring free ranges have to be merged, so the counts match the maximal runs
+        correct &= freeList.freeRangeCount() == runs.size();
+        correct &= freeList.freeBytes() == freeBytes;
+        correct &= freeList.largestFreeRange() == largest;
+        maxFreeRanges = std::max(maxFreeRanges, freeList.freeRangeCount());
+    };
+
+    for (uint32_t i = 0; i < OperationCount; ++i)
+    {
+        // mostly allocations while the block is empty, mostly frees once it's filling up
+        bool allocate = live.empty() || operation(randomEngine) < (live.size() < 32? 70 : 40);
+
+        if (allocate)
+        {
+            VkDeviceSize allocationSize = size(randomEngine);
+            VkDeviceSize alignment = VkDeviceSize(1) << alignmentShift(randomEngine);
+
+            std::optional<uint64_t> expectedRange = reference.bestFit(allocationSize, alignment);
+            std::optional<FreeListAllocator::Range> range = freeList.allocate(allocationSize, alignment);
+
+            correct &= range.has_value() == expectedRange.has_value();
+
+            if (!range)
+            {
+                ++failedAllocations;
+                continue;
+            }
+
+            correct &= expectedRange && range->rangeOffset == *expectedRange;
+            correct &= range->offset % alignment == 0;
+            correct &= range->offset >= range->rangeOffset && range->offset + allocationSize == range->rangeOffset + range->rangeSize;
+            correct &= std::none_of(reference.used.begin() + range->rangeOffset,
+                                    reference.used.begin() + range->rangeOffset + range->rangeSize,
+                                    [] (bool used) { return used; });
+
+            reference.mark(range->rangeOffset, range->rangeSize, true);
+            live.push_back(*range);
+            ++allocations;
+        }
+        else
+        {
+            std::uniform_int_distribution<size_t> pick(0, live.size() - 1);
+            size_t index = pick(randomEngine);
+            FreeListAllocator::Range range = live.at(index);
+
+            live.at(index) = live.back();
+            live.pop_back();
+
+            freeList.free(range.rangeOffset, range.rangeSize);
+            reference.mark(range.rangeOffset, range.rangeSize, false);
+        }
+
+        checkFreeRanges();
+    }
+
+    for (const FreeListAllocator::Range& range : live)
+        freeList.free(range.rangeOffset, range.rangeSize);
+
+    correct &= freeList.freeRangeCount() == 1 && freeList.largestFreeRange() == BlockSize;
+
+    // linear blocks only hand space back once the last allocation is gone
+    LinearAllocator linear(BlockSize);
+    std::vector<FreeListAllocator::Range> linearRanges;
+    VkDeviceSize previousEnd = 0;
+
+    while (auto range = linear.allocate(size(randomEngine), VkDeviceSize(1) << alignmentShift(randomEngine)))
+    {
+        correct &= range->rangeOffset == previousEnd;
+        previousEnd = range->rangeOffset + range->rangeSize;
+        linearRanges.push_back(*range);
+    }
+
+    for (size_t i = 1; i < linearRanges.size(); ++i)
+    {
+        linear.free();
+        correct &= linear.head() == previousEnd;
+    }
+
+    linear.free();
+    correct &= linear.head() == 0;
+    correct &= linear.allocate(BlockSize, 1).has_value();
+
+    std::cout << std::format("Memory allocator, {} random operations on a {} byte block\n", OperationCount, BlockSize);
+    std::cout << std::format("{:>12} | {:>8} | {:>16} | {:>14}\n", "allocations", "failed", "max free ranges", "linear filled");
+    std::cout << std::format("{:>12} | {:>8} | {:>16} | {:>14}\n", allocations, failedAllocations, maxFreeRanges, linearRanges.size());
+
+    check(correct, "Free list allocator disagrees with the reference block.");
+}
+
+static const std::array sCpuBenchmarks {
+    CpuBenchmark {"transforms", benchmarkTransformUpdate},
+    CpuBenchmark {"lookups", benchmarkLookups},
+    CpuBenchmark {"parallel", benchmarkParallelSceneUpdate},
+    CpuBenchmark {"kernels", benchmarkTransformKernels},
+    CpuBenchmark {"culling", benchmarkFrustumCulling},
+    CpuBenchmark {"clusters", benchmarkLightClustering},
+    CpuBenchmark {"lightlists", benchmarkClusterLightLists},
+    CpuBenchmark {"renderqueue", benchmarkRenderQueue},
+    CpuBenchmark {"allocator", benchmarkMemoryAllocator}
+};
+
+void runCpuBenchmarks(const std::string& name)
+{
+    bool found = false;
+
+    for (const CpuBenchmark& benchmark : sCpuBenchmarks)
+    {
+        if (name == "all" || name == benchmark.name)
+        {
+            benchmark.function();
+            std::cout << '\n';
+            found = true;
+        }
+    }
+
+    check(found, std::format("Unknown cpu benchmark {}.", name).c_str());
+}
@@ -0,0 +1,22 @@
+//
+// Created by Gianni on 16/10/2026.
+//
+
+#ifndef VULKANRENDERINGENGINE_CPU_BENCHMARKS_HPP
+#define VULKANRENDERINGENGINE_CPU_BENCHMARKS_HPP
+
+#include "../scene_graph/scene_graph.hpp"
+#include "../scene_graph/transform_kernels.hpp"
+#include "../renderer/model.hpp"
+#include "../renderer/frustum_culling.hpp"
+#include "../renderer/light_clustering.hpp"
+#include "../renderer/render_queue.hpp"
+#include "../vk/vulkan_memory_allocator.hpp"
+#include "../utils/utils.hpp"
+#include "../utils/timer.hpp"
+
+// Micro-benchmarks of the cpu side scene update, they don't need a window or a vulkan device.
+// name is a single benchmark or "all", results go to stdout.
+void runCpuBenchmarks(const std::string& name);
+
+#endif //VULKANRENDERINGENGINE_CPU_BENCHMARKS_HPP
@@ -24,6 +24,8 @@ Editor::~Editor()
 
 void Editor::update(float dt)
 {
+    PROFILE_ZONE("Editor::update");
+
     mDt = dt;
 
     countFPS();
@@ -38,6 +40,8 @@ void Editor::update(float dt)
     inspectorPanel();
     rendererPanel();
     debugPanel();
+    gpuProfilerPanel();
+    cpuProfilerPanel();
 
     if (mShowSSAOOutputTexture)
         ssaoTextureDebugWin();
@@ -280,6 +284,67 @@ void Editor::rendererPanel()
                          ImGuiSliderFlags_AlwaysClamp);
     }
 
+    if (ImGui::CollapsingHeader("Culling", ImGuiTreeNodeFlags_DefaultOpen))
+    {
+        ImGui::Checkbox("GPU Culling", &mRenderer.mGpuCulling);
+        ImGui::Checkbox("Validate Against CPU", &mRenderer.mValidateGpuCulling);
+    }
+
+    if (ImGui::CollapsingHeader("Shadows", ImGuiTreeNodeFlags_DefaultOpen))
+    {
+        ImGui::Checkbox("Cache Shadow Maps", &mRenderer.mCacheShadowMaps);
+
+        int shadowViewBudget = static_cast<int>(mRenderer.mShadowViewBudget);
+        if (ImGui::SliderInt("View Budget (0 = unlimited)", &shadowViewBudget, 0, 256))
+            mRenderer.mShadowViewBudget = static_cast<uint32_t>(shadowViewBudget);
+
+        const ShadowScheduleStats& scheduleStats = mRenderer.mShadowScheduleStats;
+        ImGui::Text("Views redrawn: %u of %u, put off: %u", scheduleStats.scheduledViews, scheduleStats.requestedViews, scheduleStats.deferredViews);
+        ImGui::Text("Longest wait: %u frames", scheduleStats.longestWait);
+        ImGui::Separator();
+
+        std::string atlasResolution = std::format("{}px", mRenderer.mShadowAtlasResolution);
+        if (ImGui::BeginCombo("Atlas Resolution", atlasResolution.data()))
+        {
+            for (uint32_t i = 1024; i <= 8192; i *= 2)
+            {
+                std::string res = std::format("{}px", i);
+                if (ImGui::Selectable(res.data(), i == mRenderer.mShadowAtlasResolution) &&
+                    i != mRenderer.mShadowAtlasResolution)
+                {
+                    mRenderer.mShadowAtlasResolution = i;
+                    mRenderer.updateShadowAtlasImage();
+                }
+            }
+
+            ImGui::EndCombo();
+        }
+
+        std::string atlasPages = std::to_string(mRenderer.mShadowAtlasPages);
+        if (ImGui::BeginCombo("Atlas Pages", atlasPages.data()))
+        {
+            for (uint32_t i = 1; i <= MaxShadowAtlasPages; ++i)
+            {
+                if (ImGui::Selectable(std::to_string(i).data(), i == mRenderer.mShadowAtlasPages) &&
+                    i != mRenderer.mShadowAtlasPages)
+                {
+                    mRenderer.mShadowAtlasPages = i;
+                    mRenderer.updateShadowAtlasImage();
+                }
+            }
+
+            ImGui::EndCombo();
+        }
+
+        const ShadowAtlasStats& atlasStats = mRenderer.mShadowAtlasStats;
+        uint64_t atlasTexels = static_cast<uint64_t>(mRenderer.mShadowAtlasResolution) * mRenderer.mShadowAtlasResolution * mRenderer.mShadowAtlasPages;
+
+        ImGui::Text("Atlas tiles: %u, lights without a tile: %u", atlasStats.tiles, atlasStats.droppedLights);
+        ImGui::Text("Atlas used: %.1f%%", 100.0 * static_cast<double>(atlasStats.usedTexels) / static_cast<double>(atlasTexels));
+        // the atlas and its static copy, 4 bytes per texel
+        ImGui::Text("Atlas memory: %.2f MB", static_cast<double>(atlasTexels * 4 * 2) / (1024.0 * 1024.0));
+    }
+
     if (ImGui::CollapsingHeader("Wireframe", ImGuiTreeNodeFlags_DefaultOpen))
     {
         ImGui::Checkbox("Enable##wireframe", &mRenderer.mWireframeOn);
@@ -377,12 +442,133 @@ void Editor::debugPanel()
 
     ImGui::Separator();
 
+    UploadStats uploadStats = mRenderer.mRenderDevice.uploadManager->stats();
+    ImGui::Text("Uploaded: %.2f MB in %lu submits",
+                static_cast<float>(uploadStats.bytesUploaded) / (1024.f * 1024.f),
+                uploadStats.submitCount);
+    ImGui::Text("Staging ring: %.2f / %.2f MB, %lu batches in flight",
+                static_cast<float>(uploadStats.ringUsed) / (1024.f * 1024.f),
+                static_cast<float>(uploadStats.ringSize) / (1024.f * 1024.f),
+                uploadStats.pendingBatches);
+
+    ImGui::Separator();
+
+    MemoryStats memoryStats = mRenderer.mRenderDevice.memoryAllocator->stats();
+    ImGui::Text("GPU memory: %.2f MB used, %.2f MB wasted, %.2f MB reserved",
+                static_cast<float>(memoryStats.bytesUsed) / (1024.f * 1024.f),
+                static_cast<float>(memoryStats.bytesWasted) / (1024.f * 1024.f),
+                static_cast<float>(memoryStats.bytesReserved) / (1024.f * 1024.f));
+    ImGui::Text("Blocks: %lu (%lu dedicated), allocations: %lu",
+                memoryStats.blockCount,
+                memoryStats.dedicatedBlockCount,
+                memoryStats.allocationCount);
+
+    if (ImGui::Button("Release Empty Blocks"))
+        mRenderer.mRenderDevice.memoryAllocator->defragment();
+
+    ImGui::Separator();
+
     ImGui::Checkbox("Debug normals", &mRenderer.mDebugNormals);
     ImGui::Checkbox("Show SSAO output texture", &mShowSSAOOutputTexture);
 
     ImGui::End();
 }
 
+void Editor::gpuProfilerPanel()
+{
+    VulkanGpuProfiler& gpuProfiler = *mRenderer.mRenderDevice.gpuProfiler;
+
+    ImGui::Begin("GPU Profiler", nullptr);
+
+    bool enabled = gpuProfiler.enabled();
+    if (ImGui::Checkbox("Enabled##GpuProfiler", &enabled))
+        gpuProfiler.setEnabled(enabled);
+
+    ImGui::SameLine();
+    if (ImGui::Button("Export CSV"))
+    {
+        bool exported = gpuProfiler.exportCsv("gpu_profile.csv");
+        debugLog(exported? "Exported gpu_profile.csv" : "Failed to export gpu_profile.csv");
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Button("Export Chrome Trace"))
+    {
+        bool exported = gpuProfiler.exportChromeTrace("gpu_trace.json");
+        debugLog(exported? "Exported gpu_trace.json" : "Failed to export gpu_trace.json");
+    }
+
+    ImGui::Text("GPU frame: %.3f ms", gpuProfiler.frameMs());
+    ImGui::Separator();
+
+    static constexpr ImGuiTableFlags sTableFlags {
+        ImGuiTableFlags_RowBg |
+        ImGuiTableFlags_BordersInnerV |
+        ImGuiTableFlags_SizingStretchProp
+    };
+
+    if (ImGui::BeginTable("##GpuZones", 5, sTableFlags))
+    {
+        ImGui::TableSetupColumn("Pass", ImGuiTableColumnFlags_WidthStretch, 3.f);
+        ImGui::TableSetupColumn("Last");
+        ImGui::TableSetupColumn("Min");
+        ImGui::TableSetupColumn("Avg");
+        ImGui::TableSetupColumn("Max");
+        ImGui::TableHeadersRow();
+
+        for (const GpuZoneStats& stats : gpuProfiler.zoneStats())
+        {
+            if (!stats.active)
+                continue;
+
+            ImGui::TableNextRow();
+
+            ImGui::TableNextColumn();
+            ImGui::SetCursorPosX(ImGui::GetCursorPosX() + stats.depth * ImGui::GetStyle().IndentSpacing);
+            ImGui::TextUnformatted(stats.name.c_str());
+
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.lastMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.minMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.avgMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.maxMs);
+        }
+
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+
+void Editor::cpuProfilerPanel()
+{
+    ImGui::Begin("CPU Profiler", nullptr);
+
+    bool recording = CpuProfiler::enabled();
+    if (ImGui::Checkbox("Record##CpuProfiler", &recording))
+        CpuProfiler::setEnabled(recording);
+
+    ImGui::SameLine();
+    if (ImGui::Button("Clear##CpuProfiler"))
+        CpuProfiler::clear();
+
+    ImGui::SameLine();
+    if (ImGui::Button("Export Chrome Trace##CpuProfiler"))
+    {
+        bool exported = CpuProfiler::exportChromeTrace("cpu_trace.json");
+        debugLog(exported? "Exported cpu_trace.json" : "Failed to export cpu_trace.json");
+    }
+
+    ImGui::Text("Captured events: %llu, dropped: %llu",
+                static_cast<unsigned long long>(CpuProfiler::capturedEventCount()),
+                static_cast<unsigned long long>(CpuProfiler::droppedEventCount()));
+
+    ImGui::End();
+}
+
 void Editor::ssaoTextureDebugWin()
 {
     ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0, 0));
@@ -943,6 +1129,8 @@ void Editor::dirLightInspector(GraphNode *node)
             {
                 ImGui::SliderInt("PCF Range (Smoothing)##dirLight", &options.pcfRange, 1, 10);
             }
+
+            shadowUpdateInspector("Cascades", shadowMap.caches);
         }
 
         if (modifiedShadowMapResolution) mRenderer.updateDirShadowMapImage(node->id());
@@ -979,7 +1167,6 @@ void Editor::pointLightInspector(GraphNode *node)
     if (ImGui::CollapsingHeader("Shadows##pointLight", ImGuiTreeNodeFlags_DefaultOpen))
     {
         bool modifiedShadowData = false;
-        bool modifiedShadowMapResolution = false;
 
         PointShadowData& options = mRenderer.getPointShadowData(node->id());
         PointShadowMap& shadowMap = mRenderer.getPointShadowMap(node->id());
@@ -1011,7 +1198,7 @@ void Editor::pointLightInspector(GraphNode *node)
         if (options.shadowType != ShadowType::NoShadow)
         {
             std::string resolution = std::format("{}px", std::to_string(options.resolution));
-            if (ImGui::BeginCombo("Resolution##pointLight", resolution.data()))
+            if (ImGui::BeginCombo("Max Tile Size##pointLight", resolution.data()))
             {
                 for (uint32_t i = 256; i <= 4096; i *= 2)
                 {
@@ -1021,13 +1208,20 @@ void Editor::pointLightInspector(GraphNode *node)
                     {
                         options.resolution = i;
                         modifiedShadowData = true;
-                        modifiedShadowMapResolution = true;
                     }
                 }
 
                 ImGui::EndCombo();
             }
 
+            const ShadowAtlasTile& tile = shadowMap.tiles[0];
+            if (tile.size)
+                ImGui::Text("Atlas Tile: %upx x6, page %u", tile.size, tile.page);
+            else
+                ImGui::Text("Atlas Tile: none");
+            ImGui::Text("Importance: %.3f", shadowMap.importance);
+            shadowUpdateInspector("Faces", shadowMap.caches);
+
             if (ImGui::SliderFloat("Strength##pointLight", &options.strength, 0.f, 1.f))
                 modifiedShadowData = true;
 
@@ -1045,7 +1239,6 @@ void Editor::pointLightInspector(GraphNode *node)
         }
 
         if (modifiedShadowData) mRenderer.updatePointShadowMapData(node->id());
-        if (modifiedShadowMapResolution) mRenderer.updatePointShadowMapImage(node->id());
     }
 
     if (modified) mRenderer.updatePointLight(node->id());
@@ -1084,7 +1277,6 @@ void Editor::spotLightInspector(GraphNode *node)
     if (ImGui::CollapsingHeader("Shadows##spotLight", ImGuiTreeNodeFlags_DefaultOpen))
     {
         bool modifiedShadowData = false;
-        bool modifiedShadowMapResolution = false;
 
         SpotShadowData& options = mRenderer.getSpotShadowData(node->id());
         SpotShadowMap& shadowMap = mRenderer.getSpotShadowMap(node->id());
@@ -1116,7 +1308,7 @@ void Editor::spotLightInspector(GraphNode *node)
         if (options.shadowType != ShadowType::NoShadow)
         {
             std::string resolution = std::format("{}px", std::to_string(options.resolution));
-            if (ImGui::BeginCombo("Resolution##spotLight", resolution.data()))
+            if (ImGui::BeginCombo("Max Tile Size##spotLight", resolution.data()))
             {
                 for (uint32_t i = 256; i <= 4096; i *= 2)
                 {
@@ -1126,13 +1318,19 @@ void Editor::spotLightInspector(GraphNode *node)
                     {
                         options.resolution = i;
                         modifiedShadowData = true;
-                        modifiedShadowMapResolution = true;
                     }
                 }
 
                 ImGui::EndCombo();
             }
 
+            if (shadowMap.tile.size)
+                ImGui::Text("Atlas Tile: %upx, page %u", shadowMap.tile.size, shadowMap.tile.page);
+            else
+                ImGui::Text("Atlas Tile: none");
+            ImGui::Text("Importance: %.3f", shadowMap.importance);
+            shadowUpdateInspector("Shadow Map", {&shadowMap.cache, 1});
+
             if (ImGui::SliderFloat("Strength##spotLight", &options.strength, 0.f, 1.f))
                 modifiedShadowData = true;
 
@@ -1150,12 +1348,21 @@ void Editor::spotLightInspector(GraphNode *node)
         }
         
         if (modifiedShadowData) mRenderer.updateSpotShadowMapData(node->id());
-        if (modifiedShadowMapResolution) mRenderer.updateSpotShadowMapImage(node->id());
     }
 
     if (modified) mRenderer.updateSpotLight(node->id());
 }
 
+// frames since each face was last drawn, a dash for faces that haven't been yet
+void Editor::shadowUpdateInspector(const char *label, std::span<const ShadowCache> caches)
+{
+    std::string ages;
+    for (const ShadowCache& cache : caches)
+        ages += cache.drawn? std::format("{} ", cache.age) : "- ";
+
+    ImGui::Text("%s last updated (frames ago): %s", label, ages.c_str());
+}
+
 bool Editor::nodeTransform(GraphNode *node)
 {
     bool modified = false;
@@ -1221,6 +1428,8 @@ void Editor::deleteSelectedModel()
             nodes.push_back(child);
     }
 
+    // the frames in flight may still draw the model's meshes
+    vkDeviceWaitIdle(mRenderer.mRenderDevice.device);
     mRenderer.mModels.erase(mSelectedObjectID);
     mSelectedObjectID = 0;
 }
@@ -2121,6 +2330,9 @@ void Editor::plotPerformanceGraphs()
     static constexpr uint32_t maxSamples = 200;
     static std::vector<float> fpsValues(maxSamples, 0.f);
     static std::vector<float> dtValues(maxSamples, 0.f);
+    static std::vector<float> cpuValues(maxSamples, 0.f);
+    static std::vector<float> gpuValues(maxSamples, 0.f);
+    static std::vector<float> waitValues(maxSamples, 0.f);
 
     float dt = mDt * 1000.0f;
     float fps = 1.0f / mDt;
@@ -2137,6 +2349,16 @@ void Editor::plotPerformanceGraphs()
     dtValues.push_back(dt);
     fpsValues.push_back(fps);
 
+    const FrameTimings& frameTimings = mRenderer.mFrameTimings;
+
+    cpuValues.erase(cpuValues.begin());
+    gpuValues.erase(gpuValues.begin());
+    waitValues.erase(waitValues.begin());
+
+    cpuValues.push_back(frameTimings.cpuMs);
+    gpuValues.push_back(frameTimings.gpuMs);
+    waitValues.push_back(frameTimings.fenceWaitMs);
+
     ImGui::Text("FPS: %lu", mFPS);
     ImGui::SetNextItemWidth(-1);
     ImGui::PlotLines("##FPS", fpsValues.data(), fpsValues.size(), 0, nullptr, 0, 1000, ImVec2(0, 50));
@@ -2145,4 +2367,83 @@ void Editor::plotPerformanceGraphs()
     ImGui::Text("Frame time: %.2f ms", mFrametimeMs);
     ImGui::SetNextItemWidth(-1);
     ImGui::PlotLines("##Frametime", dtValues.data(), dtValues.size(),  0, nullptr, 0, 100, ImVec2(0, 50));
+    ImGui::Separator();
+
+    ImGui::Text("CPU: %.2f ms, GPU: %.2f ms, fence wait: %.2f ms (%lu frames in flight)",
+                frameTimings.cpuMs,
+                frameTimings.gpuMs,
+                frameTimings.fenceWaitMs,
+                mRenderer.mRenderDevice.framesInFlight);
+    ImGui::SetNextItemWidth(-1);
+    ImGui::PlotLines("##CPU", cpuValues.data(), cpuValues.size(), 0, "CPU", 0, 33, ImVec2(0, 40));
+    ImGui::SetNextItemWidth(-1);
+    ImGui::PlotLines("##GPU", gpuValues.data(), gpuValues.size(), 0, "GPU", 0, 33, ImVec2(0, 40));
+    ImGui::SetNextItemWidth(-1);
+    ImGui::PlotLines("##Wait", waitValues.data(), waitValues.size(), 0, "Wait", 0, 33, ImVec2(0, 40));
+    ImGui::Separator();
+
+    const CullingStats& cullingStats = mRenderer.mCullingStats;
+
+    ImGui::Text("Instances: %u visible, %u culled on the %s (%.3f ms)",
+                cullingStats.visibleInstances,
+                cullingStats.totalInstances - cullingStats.visibleInstances,
+                mRenderer.mGpuCulling? "GPU" : "CPU",
+                cullingStats.cullMs);
+
+    if (mRenderer.mValidateGpuCulling)
+        ImGui::Text("GPU culling: %u of %u mesh draws differ from the CPU", cullingStats.mismatchedMeshes, cullingStats.validatedMeshes);
+
+    static constexpr std::array<const char*, RenderQueuePassCount> renderQueuePassNames {
+        "Prepass", "SSAO Resources", "Forward", "Wireframe"
+    };
+
+    if (ImGui::TreeNode("RenderQueues", "Render queues (unsorted order in brackets)"))
+    {
+        for (uint32_t pass = 0; pass < RenderQueuePassCount; ++pass)
+        {
+            const RenderQueueStats& queueStats = mRenderer.mRenderQueueStats.at(pass);
+
+            ImGui::Text("%s: %u draw(s), %u raster state change(s) (%u), %u material change(s) (%u)",
+                        renderQueuePassNames.at(pass),
+                        queueStats.draws,
+                        queueStats.rasterStateChanges,
+                        queueStats.unsortedRasterStateChanges,
+                        queueStats.materialChanges,
+                        queueStats.unsortedMaterialChanges);
+        }
+
+        ImGui::TreePop();
+    }
+
+    const std::vector<ShadowViewStats>& shadowViewStats = mRenderer.mShadowViewStats;
+
+    uint32_t shadowDraws = 0;
+    uint32_t redrawnViews = 0;
+    for (const ShadowViewStats& viewStats : shadowViewStats)
+    {
+        shadowDraws += viewStats.draws;
+        redrawnViews += viewStats.update != ShadowViewUpdate::Skip? 1 : 0;
+    }
+
+    if (ImGui::TreeNode("ShadowViews", "Shadow draws: %u over %zu view(s), %u redrawn", shadowDraws, shadowViewStats.size(), redrawnViews))
+    {
+        for (const ShadowViewStats& viewStats : shadowViewStats)
+        {
+            switch (viewStats.lightType)
+            {
+                case LightType::Directional: ImGui::Text("Dir light %u, cascade %u:", viewStats.lightIndex, viewStats.face); break;
+                case LightType::Point: ImGui::Text("Point light %u, face %u:", viewStats.lightIndex, viewStats.face); break;
+                case LightType::Spot: ImGui::Text("Spot light %u:", viewStats.lightIndex); break;
+            }
+
+            ImGui::SameLine();
+            ImGui::Text("%u draw(s), %u instance(s), %u dynamic, %s",
+                        viewStats.draws,
+                        viewStats.instances,
+                        viewStats.dynamicInstances,
+                        toStr(viewStats.update));
+        }
+
+        ImGui::TreePop();
+    }
 }
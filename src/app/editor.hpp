@@ -18,6 +18,9 @@
 #include "../renderer/renderer.hpp"
 #include "../renderer/model.hpp"
 #include "../renderer/camera.hpp"
+#include "../vk/vulkan_upload_manager.hpp"
+#include "../vk/vulkan_memory_allocator.hpp"
+#include "../vk/vulkan_gpu_profiler.hpp"
 
 enum class CopyFlags;
 
@@ -38,6 +41,8 @@ private:
     void inspectorPanel();
     void viewPort();
     void debugPanel();
+    void gpuProfilerPanel();
+    void cpuProfilerPanel();
     void ssaoTextureDebugWin();
 
     void sceneNodeRecursive(GraphNode* node);
@@ -61,6 +66,7 @@ private:
     void dirLightInspector(GraphNode* node);
     void pointLightInspector(GraphNode* node);
     void spotLightInspector(GraphNode* node);
+    void shadowUpdateInspector(const char* label, std::span<const ShadowCache> caches);
     bool nodeTransform(GraphNode* node);
 
     void deleteSelectedObject();
@@ -0,0 +1,96 @@
+//
+// Created by Gianni on 16/10/2026.
+//
+
+#ifndef VULKANRENDERINGENGINE_UUID_MAP_HPP
+#define VULKANRENDERINGENGINE_UUID_MAP_HPP
+
+#include "types.hpp"
+
+// Sparse set keyed by uuid, lookups index a flat array instead of hashing or searching.
+// UUIDRegistry never hands out an id twice, so an id works as a generational handle: once its object
+// is erased the id stays dead and can't alias a newer object.
+// Values are kept packed, erasing moves the last value into the hole.
+template<typename T>
+class UuidMap
+{
+public:
+    void insert(uuid32_t id, const T& value)
+    {
+        if (id >= mSparse.size())
+            mSparse.resize(id + 1, InvalidIndex);
+
+        if (mSparse[id] != InvalidIndex)
+        {
+            mValues[mSparse[id]] = value;
+            return;
+        }
+
+        mSparse[id] = mKeys.size();
+        mKeys.push_back(id);
+        mValues.push_back(value);
+    }
+
+    void erase(uuid32_t id)
+    {
+        if (!contains(id))
+            return;
+
+        index_t index = mSparse[id];
+        index_t last = mKeys.size() - 1;
+
+        if (index != last)
+        {
+            mKeys[index] = mKeys[last];
+            mValues[index] = std::move(mValues[last]);
+            mSparse[mKeys[index]] = index;
+        }
+
+        mKeys.pop_back();
+        mValues.pop_back();
+        mSparse[id] = InvalidIndex;
+    }
+
+    void clear()
+    {
+        for (uuid32_t id : mKeys)
+            mSparse[id] = InvalidIndex;
+
+        mKeys.clear();
+        mValues.clear();
+    }
+
+    void reserve(size_t count)
+    {
+        mKeys.reserve(count);
+        mValues.reserve(count);
+    }
+
+    bool contains(uuid32_t id) const
+    {
+        return id < mSparse.size() && mSparse[id] != InvalidIndex;
+    }
+
+    T* find(uuid32_t id)
+    {
+        return contains(id)? &mValues[mSparse[id]] : nullptr;
+    }
+
+    const T* find(uuid32_t id) const
+    {
+        return contains(id)? &mValues[mSparse[id]] : nullptr;
+    }
+
+    size_t size() const { return mKeys.size(); }
+    const std::vector<uuid32_t>& keys() const { return mKeys; }
+    const std::vector<T>& values() const { return mValues; }
+
+private:
+    static constexpr index_t InvalidIndex = std::numeric_limits<index_t>::max();
+
+    std::vector<index_t> mSparse;
+    std::vector<uuid32_t> mKeys;
+    std::vector<T> mValues;
+};
+
+#endif //VULKANRENDERINGENGINE_UUID_MAP_HPP
@@ -1,7 +1,33 @@
 #include "app/application.hpp"
+#include "app/benchmark.hpp"
+#include "app/cpu_benchmarks.hpp"
 
-int main()
+int main(int argc, char** argv)
 {
+    // headless runs: Ypsilantis --benchmark <scene.json> | --cpu-benchmark <name|all>
+    std::string mode = argc == 3? argv[1] : "";
+
+    if (mode == "--benchmark" || mode == "--cpu-benchmark")
+    {
+        try
+        {
+            if (mode == "--benchmark")
+            {
+                Benchmark benchmark(argv[2]);
+                benchmark.run();
+            }
+            else
+                runCpuBenchmarks(argv[2]);
+        }
+        catch (const std::exception& unhandledException)
+        {
+            std::cerr << "Unhandled Exception: " << unhandledException.what() << '\n';
+            return 1;
+        }
+
+        return 0;
+    }
+
     try
     {
         Application application;
@@ -13,13 +13,18 @@
 #include <unordered_set>
 #include <deque>
 #include <set>
+#include <map>
 #include <string>
 #include <string_view>
+#include <span>
 #include <memory>
 #include <cstdint>
 #include <optional>
 #include <variant>
 #include <random>
+#include <numeric>
+#include <limits>
+#include <bit>
 
 #include <iostream>
 #include <format>
@@ -32,6 +37,9 @@
 
 #include <future>
 #include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
 
 #include <assert.h>
 #include <stdexcept>
@@ -73,6 +73,24 @@ void Camera::update(float dt)
     mPreviousMousePos.y = ImGui::GetMousePos().y;
 }
 
+void Camera::lookAt(const glm::vec3& position, const glm::vec3& target)
+{
+    glm::vec3 direction = target - position;
+
+    if (glm::length(direction) > 0.f)
+    {
+        // inverse of calculateBasis()
+        direction = -glm::normalize(direction);
+
+        mTheta = glm::degrees(glm::atan(direction.x, direction.z));
+        mPhi = glm::clamp(glm::degrees(glm::asin(direction.y)), -89.f, 89.f);
+    }
+
+    mPosition = position;
+
+    calculateViewProjection();
+}
+
 const glm::mat4 &Camera::viewProjection() const
 {
     return mViewProjection;
@@ -0,0 +1,183 @@
+//
+// Created by Gianni on 16/10/2026.
+//
+
+#include "frustum_culling.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+void BoundsArray::add(const Aabb &aabb)
+{
+    centerX.push_back(0.f);
+    centerY.push_back(0.f);
+    centerZ.push_back(0.f);
+    extentX.push_back(0.f);
+    extentY.push_back(0.f);
+    extentZ.push_back(0.f);
+
+    set(size() - 1, aabb);
+}
+
+void BoundsArray::set(index_t index, const Aabb &aabb)
+{
+    glm::vec3 center = (aabb.min + aabb.max) * 0.5f;
+    glm::vec3 extent = (aabb.max - aabb.min) * 0.5f;
+
+    centerX[index] = center.x;
+    centerY[index] = center.y;
+    centerZ[index] = center.z;
+    extentX[index] = extent.x;
+    extentY[index] = extent.y;
+    extentZ[index] = extent.z;
+}
+
+Aabb BoundsArray::get(index_t index) const
+{
+    glm::vec3 center(centerX[index], centerY[index], centerZ[index]);
+    glm::vec3 extent(extentX[index], extentY[index], extentZ[index]);
+
+    return {center - extent, center + extent};
+}
+
+void BoundsArray::remove(index_t index)
+{
+    for (std::vector<float>* component : {&centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ})
+    {
+        component->at(index) = component->back();
+        component->pop_back();
+    }
+}
+
+void BoundsArray::clear()
+{
+    for (std::vector<float>* component : {&centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ})
+        component->clear();
+}
+
+uint32_t BoundsArray::size() const
+{
+    return centerX.size();
+}
+
+Frustum extractFrustum(const glm::mat4 &viewProjection)
+{
+    glm::mat4 m = glm::transpose(viewProjection);
+
+    return {{
+        m[3] + m[0], // left
+        m[3] - m[0], // right
+        m[3] + m[1], // bottom
+        m[3] - m[1], // top
+        m[2],        // near
+        m[3] - m[2]  // far
+    }};
+}
+
+void extendFrustum(Frustum &frustum, const glm::vec3 &direction)
+{
+    // near and far are the last two planes, a plane of (0, 0, 0, 1) passes everything
+    for (uint32_t i = 4; i < 6; ++i)
+        if (glm::dot(glm::vec3(frustum.planes[i]), direction) > 0.f)
+            frustum.planes[i] = glm::vec4(0.f, 0.f, 0.f, 1.f);
+}
+
+Aabb transformAabb(const Aabb &aabb, const glm::mat4 &transform)
+{
+    glm::vec3 center = (aabb.min + aabb.max) * 0.5f;
+    glm::vec3 extent = (aabb.max - aabb.min) * 0.5f;
+
+    glm::vec3 worldCenter = glm::vec3(transform * glm::vec4(center, 1.f));
+    glm::vec3 worldExtent = glm::abs(glm::vec3(transform[0])) * extent.x
+                          + glm::abs(glm::vec3(transform[1])) * extent.y
+                          + glm::abs(glm::vec3(transform[2])) * extent.z;
+
+    return {worldCenter - worldExtent, worldCenter + worldExtent};
+}
+
+Aabb mergeAabbs(const Aabb &a, const Aabb &b)
+{
+    return {glm::min(a.min, b.min), glm::max(a.max, b.max)};
+}
+
+// a box is out once it's fully behind one of the planes
+static bool isVisible(const Frustum& frustum, const glm::vec3& center, const glm::vec3& extent)
+{
+    for (const glm::vec4& plane : frustum.planes)
+    {
+        float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+        float radius = glm::dot(glm::abs(glm::vec3(plane)), extent);
+
+        if (distance + radius < 0.f)
+            return false;
+    }
+
+    return true;
+}
+
+bool isVisible(const Frustum &frustum, const Aabb &aabb)
+{
+    return isVisible(frustum, (aabb.min + aabb.max) * 0.5f, (aabb.max - aabb.min) * 0.5f);
+}
+
+uint32_t cullBoxes(const Frustum &frustum, const BoundsArray &bounds, uint32_t* visibleIndices)
+{
+    uint32_t count = bounds.size();
+    uint32_t visibleCount = 0;
+    uint32_t i = 0;
+
+#if defined(__SSE2__)
+    __m128 planes[6][4];
+    __m128 absPlanes[6][3];
+
+    for (int p = 0; p < 6; ++p)
+    {
+        for (int c = 0; c < 4; ++c)
+            planes[p][c] = _mm_set1_ps(frustum.planes[p][c]);
+
+        for (int c = 0; c < 3; ++c)
+            absPlanes[p][c] = _mm_set1_ps(glm::abs(frustum.planes[p][c]));
+    }
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 centerX = _mm_loadu_ps(&bounds.centerX[i]);
+        __m128 centerY = _mm_loadu_ps(&bounds.centerY[i]);
+        __m128 centerZ = _mm_loadu_ps(&bounds.centerZ[i]);
+        __m128 extentX = _mm_loadu_ps(&bounds.extentX[i]);
+        __m128 extentY = _mm_loadu_ps(&bounds.extentY[i]);
+        __m128 extentZ = _mm_loadu_ps(&bounds.extentZ[i]);
+
+        __m128 outside = _mm_setzero_ps();
+
+        for (int p = 0; p < 6; ++p)
+        {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(planes[p][0], centerX),
+                                                               _mm_mul_ps(planes[p][1], centerY)),
+                                                    _mm_mul_ps(planes[p][2], centerZ)),
+                                         planes[p][3]);
+            __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absPlanes[p][0], extentX),
+                                                  _mm_mul_ps(absPlanes[p][1], extentY)),
+                                       _mm_mul_ps(absPlanes[p][2], extentZ));
+
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+        }
+
+        // compact the visible lanes
+        for (int visibleMask = ~_mm_movemask_ps(outside) & 0xf; visibleMask; visibleMask &= visibleMask - 1)
+            visibleIndices[visibleCount++] = i + std::countr_zero(static_cast<uint32_t>(visibleMask));
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        glm::vec3 center(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]);
+        glm::vec3 extent(bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i]);
+
+        if (isVisible(frustum, center, extent))
+            visibleIndices[visibleCount++] = i;
+    }
+
+    return visibleCount;
+}
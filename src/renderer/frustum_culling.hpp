@@ -0,0 +1,60 @@
+//
+// Created by Gianni on 16/10/2026.
+//
+
+#ifndef VULKANRENDERINGENGINE_FRUSTUM_CULLING_HPP
+#define VULKANRENDERINGENGINE_FRUSTUM_CULLING_HPP
+
+#include <glm/glm.hpp>
+#include "../app/types.hpp"
+
+struct Aabb
+{
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+// planes point inwards and aren't normalized, a point p is inside when dot(plane, vec4(p, 1)) >= 0 for all six
+struct Frustum
+{
+    std::array<glm::vec4, 6> planes;
+};
+
+// World space boxes as center and half extent, one array per component so the culling kernel loads four boxes at a time.
+struct BoundsArray
+{
+    std::vector<float> centerX;
+    std::vector<float> centerY;
+    std::vector<float> centerZ;
+    std::vector<float> extentX;
+    std::vector<float> extentY;
+    std::vector<float> extentZ;
+
+    void add(const Aabb& aabb);
+    void set(index_t index, const Aabb& aabb);
+    Aabb get(index_t index) const;
+    // moves the last box into index, like InstancedMesh does with its instances
+    void remove(index_t index);
+    void clear();
+    uint32_t size() const;
+};
+
+// works for any projection, depth is expected to go from 0 to 1
+Frustum extractFrustum(const glm::mat4& viewProjection);
+
+// drops whichever of the near and far planes faces along direction, so boxes between the light and the
+// volume still pass
+void extendFrustum(Frustum& frustum, const glm::vec3& direction);
+
+// bounds of the transformed box
+Aabb transformAabb(const Aabb& aabb, const glm::mat4& transform);
+
+Aabb mergeAabbs(const Aabb& a, const Aabb& b);
+
+bool isVisible(const Frustum& frustum, const Aabb& aabb);
+
+// writes the indices of the boxes that touch the frustum in ascending order, returns how many there are.
+// visibleIndices needs room for bounds.size() entries
+uint32_t cullBoxes(const Frustum& frustum, const BoundsArray& bounds, uint32_t* visibleIndices);
+
+#endif //VULKANRENDERINGENGINE_FRUSTUM_CULLING_HPP
@@ -7,101 +7,441 @@
 static constexpr uint32_t sInitialInstanceBufferCapacity = 32;
 static constexpr uint32_t sVertexSize = sizeof(Vertex);
 static constexpr uint32_t sInstanceSize = sizeof(InstancedMesh::InstanceData);
+static constexpr uint32_t sCullWorkGroupSize = 64;
+// frames an instance has to stay still for before it's baked into the cached shadow maps
+static constexpr uint32_t sStaticCasterFrames = 30;
+
+static bool isStaticCaster(uint32_t stillFrames)
+{
+    return stillFrames >= sStaticCasterFrames;
+}
+
+static uint32_t allFramesDirty(const VulkanRenderDevice& renderDevice)
+{
+    return (1u << renderDevice.framesInFlight) - 1;
+}
 
 InstancedMesh::InstancedMesh()
     : mRenderDevice()
-    , mInstanceCount()
-    , mInstanceBufferCapacity()
+    , mDirtyFrames()
+    , mBounds()
 {
 }
 
 InstancedMesh::InstancedMesh(const VulkanRenderDevice &renderDevice,
                              const std::vector<Vertex> &vertices,
-                             const std::vector<uint32_t> &indices)
+                             const std::vector<uint32_t> &indices,
+                             const Aabb& bounds)
     : mRenderDevice(&renderDevice)
     , mVertexBuffer(renderDevice, vertices.size() * sVertexSize, BufferType::Vertex, MemoryType::Device, vertices.data())
     , mIndexBuffer(renderDevice, indices.size() * sizeof(uint32_t), BufferType::Index, MemoryType::Device, indices.data())
-    , mInstanceBuffer(renderDevice, sInitialInstanceBufferCapacity * sInstanceSize, BufferType::Vertex, MemoryType::HostCoherent)
-    , mInstanceCount()
-    , mInstanceBufferCapacity(sInitialInstanceBufferCapacity)
+    , mInstanceBuffers(renderDevice.framesInFlight)
+    , mDirtyFrames()
+    , mBounds(bounds)
+    , mVisibleInstanceBuffers(renderDevice.framesInFlight)
+    , mVisibleInstanceCounts(renderDevice.framesInFlight)
+    , mCulledInstanceBuffers(renderDevice.framesInFlight)
+    , mDrawCommandBuffers(renderDevice.framesInFlight)
+    , mShadowInstanceBuffers(renderDevice.framesInFlight)
 {
+    mInstances.reserve(sInitialInstanceBufferCapacity);
+
+    for (VulkanBuffer& instanceBuffer : mInstanceBuffers)
+        instanceBuffer = {renderDevice, sInitialInstanceBufferCapacity * sInstanceSize, BufferType::Instance, MemoryType::HostCoherent};
+
+    for (VulkanBuffer& visibleInstanceBuffer : mVisibleInstanceBuffers)
+        visibleInstanceBuffer = {renderDevice, sInitialInstanceBufferCapacity * sInstanceSize, BufferType::Vertex, MemoryType::HostCoherent};
+
+    for (VulkanBuffer& culledInstanceBuffer : mCulledInstanceBuffers)
+        culledInstanceBuffer = {renderDevice, sInitialInstanceBufferCapacity * sInstanceSize, BufferType::Instance, MemoryType::Device};
+
+    for (VulkanBuffer& shadowInstanceBuffer : mShadowInstanceBuffers)
+        shadowInstanceBuffer = {renderDevice, sInitialInstanceBufferCapacity * sInstanceSize, BufferType::Vertex, MemoryType::HostCoherent};
+
+    for (uint32_t i = 0; i < renderDevice.framesInFlight; ++i)
+    {
+        mDrawCommandBuffers.at(i) = {renderDevice, sizeof(VkDrawIndexedIndirectCommand), BufferType::Indirect, MemoryType::HostCoherent};
+        resetDrawCommand(i);
+    }
 }
 
 void InstancedMesh::addInstance(uuid32_t id)
 {
-    checkResize();
-
-    ++mInstanceCount;
-
-    uint32_t instanceIndex = mInstanceCount - 1;
+    uint32_t instanceIndex = mInstances.size();
 
     check(mInstanceIdToIndexMap.emplace(id, instanceIndex).second, "Failed insert.");
     check(mInstanceIndexToIdMap.emplace(instanceIndex, id).second, "Failed insert.");
 
-    InstanceData instanceData {.id = id};
-    mInstanceBuffer.mapBufferMemory(instanceIndex * sInstanceSize, sInstanceSize, &instanceData);
+    mInstances.push_back({.id = id});
+    mInstanceBounds.add({});
+
+    // empty bounds, the first transform becomes the whole dirty region
+    mShadowCasterStates.push_back({
+        .dirtyBounds = {glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest())},
+        .stillFrames = 0,
+        .moved = true
+    });
+    mDirtyFrames = allFramesDirty(*mRenderDevice);
 }
 
 void InstancedMesh::updateInstance(uuid32_t id, const glm::mat4& transformation)
+{
+    setInstanceTransform(id, transformation, glm::inverseTranspose(glm::mat3(transformation)));
+    markInstancesDirty();
+}
+
+void InstancedMesh::setInstanceTransform(uuid32_t id, const glm::mat4 &transformation, const glm::mat3 &normalMatrix)
 {
     uint32_t instanceIndex = mInstanceIdToIndexMap.at(id);
 
-    InstanceData instanceData {
-        .modelMatrix = transformation,
-        .normalMatrix = glm::inverseTranspose(glm::mat3(transformation)),
-        .id = id,
-    };
+    InstanceData& instanceData = mInstances.at(instanceIndex);
+    instanceData.modelMatrix = transformation;
+    instanceData.normalMatrix = normalMatrix;
+
+    Aabb bounds = transformAabb(mBounds, transformation);
+    ShadowCasterState& casterState = mShadowCasterStates.at(instanceIndex);
 
-    mInstanceBuffer.mapBufferMemory(instanceIndex * sInstanceSize, sInstanceSize, &instanceData);
+    // the shadow maps have to forget where the instance was as well
+    if (!casterState.moved)
+        casterState.dirtyBounds = mInstanceBounds.get(instanceIndex);
+
+    casterState.dirtyBounds = mergeAabbs(casterState.dirtyBounds, bounds);
+    casterState.moved = true;
+
+    mInstanceBounds.set(instanceIndex, bounds);
+}
+
+void InstancedMesh::markInstancesDirty()
+{
+    mDirtyFrames = allFramesDirty(*mRenderDevice);
 }
 
 void InstancedMesh::removeInstance(uuid32_t id)
 {
     uint32_t removeIndex = mInstanceIdToIndexMap.at(id);
+    uint32_t lastIndex = mInstances.size() - 1;
 
     mInstanceIdToIndexMap.erase(id);
     mInstanceIndexToIdMap.erase(removeIndex);
 
-    if (removeIndex != mInstanceCount - 1)
+    const ShadowCasterState& casterState = mShadowCasterStates.at(removeIndex);
+    mRemovedCasterBounds.push_back(casterState.moved? casterState.dirtyBounds : mInstanceBounds.get(removeIndex));
+
+    if (removeIndex != lastIndex)
     {
-        uint32_t transferIndex = mInstanceCount - 1;
-        uint32_t transferIndexID = mInstanceIndexToIdMap.at(transferIndex);
+        uint32_t transferIndexID = mInstanceIndexToIdMap.at(lastIndex);
 
         mInstanceIdToIndexMap.at(transferIndexID) = removeIndex;
 
         mInstanceIndexToIdMap.emplace(removeIndex, transferIndexID);
-        mInstanceIndexToIdMap.erase(transferIndex);
+        mInstanceIndexToIdMap.erase(lastIndex);
+
+        mInstances.at(removeIndex) = mInstances.at(lastIndex);
+        mShadowCasterStates.at(removeIndex) = mShadowCasterStates.at(lastIndex);
+    }
+
+    mInstances.pop_back();
+    mShadowCasterStates.pop_back();
+    mInstanceBounds.remove(removeIndex);
+    mDirtyFrames = allFramesDirty(*mRenderDevice);
+}
+
+void InstancedMesh::syncInstanceBuffer(uint32_t frameIndex)
+{
+    uint32_t frameBit = 1u << frameIndex;
+
+    if (!(mDirtyFrames & frameBit))
+        return;
+
+    VulkanBuffer& instanceBuffer = mInstanceBuffers.at(frameIndex);
+    VkDeviceSize instanceDataSize = mInstances.size() * sInstanceSize;
+
+    // the frame that last read this buffer has retired, so it can be replaced without a device wait
+    if (instanceBuffer.getSize() < instanceDataSize)
+        instanceBuffer = {*mRenderDevice, mInstances.capacity() * sInstanceSize, BufferType::Instance, MemoryType::HostCoherent};
+
+    if (instanceDataSize)
+        memcpy(instanceBuffer.mapped<InstanceData>(), mInstances.data(), instanceDataSize);
+
+    mDirtyFrames &= ~frameBit;
+}
+
+void InstancedMesh::cull(const Frustum &frustum, uint32_t frameIndex)
+{
+    mVisibleIndices.resize(mInstances.size());
+    uint32_t visibleCount = cullBoxes(frustum, mInstanceBounds, mVisibleIndices.data());
+
+    VulkanBuffer& visibleInstanceBuffer = mVisibleInstanceBuffers.at(frameIndex);
+    VkDeviceSize visibleDataSize = visibleCount * sInstanceSize;
+
+    // same as the instance buffers, the frame that read this buffer has retired
+    if (visibleInstanceBuffer.getSize() < visibleDataSize)
+        visibleInstanceBuffer = {*mRenderDevice, mInstances.capacity() * sInstanceSize, BufferType::Vertex, MemoryType::HostCoherent};
+
+    InstanceData* visibleInstances = visibleInstanceBuffer.mapped<InstanceData>();
+    for (uint32_t i = 0; i < visibleCount; ++i)
+        visibleInstances[i] = mInstances[mVisibleIndices[i]];
+
+    mVisibleInstanceCounts.at(frameIndex) = visibleCount;
+}
+
+void InstancedMesh::resetDrawCommand(uint32_t frameIndex)
+{
+    VulkanBuffer& culledInstanceBuffer = mCulledInstanceBuffers.at(frameIndex);
+
+    if (culledInstanceBuffer.getSize() < mInstances.size() * sInstanceSize)
+        culledInstanceBuffer = {*mRenderDevice, mInstances.capacity() * sInstanceSize, BufferType::Instance, MemoryType::Device};
+
+    // the shader bumps instanceCount for every instance that passes
+    *mDrawCommandBuffers.at(frameIndex).mapped<VkDrawIndexedIndirectCommand>() = {
+        .indexCount = getIndexCount(mIndexBuffer),
+        .instanceCount = 0,
+        .firstIndex = 0,
+        .vertexOffset = 0,
+        .firstInstance = 0
+    };
+}
+
+void InstancedMesh::dispatchCull(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, uint32_t frameIndex) const
+{
+    if (mInstances.empty())
+        return;
+
+    std::array<VkDescriptorBufferInfo, 3> bufferInfos {{
+        {mInstanceBuffers.at(frameIndex).getBuffer(), 0, VK_WHOLE_SIZE},
+        {mCulledInstanceBuffers.at(frameIndex).getBuffer(), 0, VK_WHOLE_SIZE},
+        {mDrawCommandBuffers.at(frameIndex).getBuffer(), 0, VK_WHOLE_SIZE}
+    }};
+
+    std::array<VkWriteDescriptorSet, 3> writeDescriptorSets {};
+    for (uint32_t i = 0; i < writeDescriptorSets.size(); ++i)
+    {
+        writeDescriptorSets.at(i) = {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = VK_NULL_HANDLE,
+            .dstBinding = i,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo = &bufferInfos.at(i)
+        };
+    }
+
+    pfnCmdPushDescriptorSet(commandBuffer,
+                            VK_PIPELINE_BIND_POINT_COMPUTE,
+                            pipelineLayout,
+                            1,
+                            writeDescriptorSets.size(),
+                            writeDescriptorSets.data());
+
+    struct {
+        alignas(16) glm::vec4 boundsMin;
+        alignas(16) glm::vec4 boundsMax;
+        alignas(4) uint32_t instanceCount;
+    } pushConstants {
+        glm::vec4(mBounds.min, 0.f),
+        glm::vec4(mBounds.max, 0.f),
+        static_cast<uint32_t>(mInstances.size())
+    };
+
+    vkCmdPushConstants(commandBuffer,
+                       pipelineLayout,
+                       VK_SHADER_STAGE_COMPUTE_BIT,
+                       0, sizeof(pushConstants),
+                       &pushConstants);
+
+    vkCmdDispatch(commandBuffer, (mInstances.size() + sCullWorkGroupSize - 1) / sCullWorkGroupSize, 1, 1);
+}
+
+void InstancedMesh::clearShadowViews()
+{
+    mShadowInstances.clear();
+    mShadowViews.clear();
+}
+
+void InstancedMesh::updateShadowCasters()
+{
+    mShadowDirtyRegions.clear();
+
+    // a removed instance could be in any of the cached maps
+    for (const Aabb& bounds : mRemovedCasterBounds)
+        mShadowDirtyRegions.push_back({bounds, true});
+    mRemovedCasterBounds.clear();
+
+    for (index_t i = 0; i < mShadowCasterStates.size(); ++i)
+    {
+        ShadowCasterState& casterState = mShadowCasterStates[i];
+
+        if (casterState.moved)
+        {
+            // a static caster that starts moving has to come out of the cached maps
+            mShadowDirtyRegions.push_back({casterState.dirtyBounds, isStaticCaster(casterState.stillFrames)});
+            casterState.stillFrames = 0;
+            casterState.moved = false;
+        }
+        else if (!isStaticCaster(casterState.stillFrames) && isStaticCaster(++casterState.stillFrames))
+        {
+            // settled, it's part of the cached maps from now on
+            mShadowDirtyRegions.push_back({mInstanceBounds.get(i), true});
+        }
+    }
+}
+
+uint32_t InstancedMesh::cullShadowView(const Frustum &frustum)
+{
+    mVisibleIndices.resize(mInstances.size());
+    uint32_t visibleCount = cullBoxes(frustum, mInstanceBounds, mVisibleIndices.data());
+
+    mShadowViews.push_back({static_cast<uint32_t>(mShadowInstances.size()), 0, 0, ShadowViewChange::None});
+    ShadowView& view = mShadowViews.back();
+
+    for (uint32_t i = 0; i < visibleCount; ++i)
+    {
+        if (isStaticCaster(mShadowCasterStates[mVisibleIndices[i]].stillFrames))
+        {
+            mShadowInstances.push_back(mInstances[mVisibleIndices[i]]);
+            ++view.staticCount;
+        }
+    }
+
+    for (uint32_t i = 0; i < visibleCount; ++i)
+    {
+        if (!isStaticCaster(mShadowCasterStates[mVisibleIndices[i]].stillFrames))
+        {
+            mShadowInstances.push_back(mInstances[mVisibleIndices[i]]);
+            ++view.dynamicCount;
+        }
+    }
 
-        mInstanceBuffer.copyBuffer(mInstanceBuffer,
-                                   transferIndex * sInstanceSize,
-                                   removeIndex * sInstanceSize,
-                                   sInstanceSize);
+    for (const ShadowDirtyRegion& region : mShadowDirtyRegions)
+    {
+        if (isVisible(frustum, region.bounds))
+        {
+            ShadowViewChange change = region.staticCasters? ShadowViewChange::StaticCasters : ShadowViewChange::DynamicCasters;
+            view.change = std::max(view.change, change);
+        }
     }
 
-    --mInstanceCount;
+    return visibleCount;
+}
+
+void InstancedMesh::syncShadowInstances(uint32_t frameIndex)
+{
+    VulkanBuffer& shadowInstanceBuffer = mShadowInstanceBuffers.at(frameIndex);
+    VkDeviceSize shadowDataSize = mShadowInstances.size() * sInstanceSize;
+
+    if (shadowInstanceBuffer.getSize() < shadowDataSize)
+        shadowInstanceBuffer = {*mRenderDevice, mShadowInstances.capacity() * sInstanceSize, BufferType::Vertex, MemoryType::HostCoherent};
+
+    if (shadowDataSize)
+        memcpy(shadowInstanceBuffer.mapped<InstanceData>(), mShadowInstances.data(), shadowDataSize);
 }
 
 void InstancedMesh::setDebugName(const std::string &debugName)
 {
     mVertexBuffer.setDebugName(debugName);
     mIndexBuffer.setDebugName(debugName);
-    mIndexBuffer.setDebugName(debugName);
+
+    for (VulkanBuffer& instanceBuffer : mInstanceBuffers)
+        instanceBuffer.setDebugName(debugName);
+
+    for (VulkanBuffer& visibleInstanceBuffer : mVisibleInstanceBuffers)
+        visibleInstanceBuffer.setDebugName(debugName + " Visible");
+
+    for (VulkanBuffer& culledInstanceBuffer : mCulledInstanceBuffers)
+        culledInstanceBuffer.setDebugName(debugName + " Culled");
+
+    for (VulkanBuffer& drawCommandBuffer : mDrawCommandBuffers)
+        drawCommandBuffer.setDebugName(debugName + " Draw Command");
+
+    for (VulkanBuffer& shadowInstanceBuffer : mShadowInstanceBuffers)
+        shadowInstanceBuffer.setDebugName(debugName + " Shadow");
+}
+
+void InstancedMesh::render(VkCommandBuffer commandBuffer, uint32_t frameIndex) const
+{
+    if (mInstances.empty())
+        return;
+
+    VkBuffer buffers[2] {
+        mVertexBuffer.getBuffer(),
+        mInstanceBuffers.at(frameIndex).getBuffer()
+    };
+
+    VkDeviceSize offsets[2] {0, 0};
+    vkCmdBindVertexBuffers(commandBuffer, 0, 2, buffers, offsets);
+    vkCmdBindIndexBuffer(commandBuffer, mIndexBuffer.getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+    vkCmdDrawIndexed(commandBuffer, getIndexCount(mIndexBuffer), mInstances.size(), 0, 0, 0);
+}
+
+void InstancedMesh::renderVisible(VkCommandBuffer commandBuffer, uint32_t frameIndex) const
+{
+    uint32_t visibleCount = mVisibleInstanceCounts.at(frameIndex);
+
+    if (!visibleCount)
+        return;
+
+    VkBuffer buffers[2] {
+        mVertexBuffer.getBuffer(),
+        mVisibleInstanceBuffers.at(frameIndex).getBuffer()
+    };
+
+    VkDeviceSize offsets[2] {0, 0};
+    vkCmdBindVertexBuffers(commandBuffer, 0, 2, buffers, offsets);
+    vkCmdBindIndexBuffer(commandBuffer, mIndexBuffer.getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+    vkCmdDrawIndexed(commandBuffer, getIndexCount(mIndexBuffer), visibleCount, 0, 0, 0);
+}
+
+void InstancedMesh::renderIndirect(VkCommandBuffer commandBuffer, uint32_t frameIndex) const
+{
+    if (mInstances.empty())
+        return;
+
+    VkBuffer buffers[2] {
+        mVertexBuffer.getBuffer(),
+        mCulledInstanceBuffers.at(frameIndex).getBuffer()
+    };
+
+    VkDeviceSize offsets[2] {0, 0};
+    vkCmdBindVertexBuffers(commandBuffer, 0, 2, buffers, offsets);
+    vkCmdBindIndexBuffer(commandBuffer, mIndexBuffer.getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+    vkCmdDrawIndexedIndirect(commandBuffer,
+                             mDrawCommandBuffers.at(frameIndex).getBuffer(),
+                             0, 1,
+                             sizeof(VkDrawIndexedIndirectCommand));
 }
 
-void InstancedMesh::render(VkCommandBuffer commandBuffer) const
+void InstancedMesh::renderShadowView(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t view, ShadowCasters casters) const
 {
-    if (mInstanceCount == 0)
+    // meshes that aren't shadow casters have no views
+    if (view >= mShadowViews.size())
+        return;
+
+    const ShadowView& shadowView = mShadowViews[view];
+    uint32_t firstInstance = shadowView.firstInstance;
+    uint32_t instanceCount = shadowView.staticCount + shadowView.dynamicCount;
+
+    if (casters == ShadowCasters::Static)
+        instanceCount = shadowView.staticCount;
+
+    if (casters == ShadowCasters::Dynamic)
+    {
+        firstInstance += shadowView.staticCount;
+        instanceCount = shadowView.dynamicCount;
+    }
+
+    if (!instanceCount)
         return;
 
     VkBuffer buffers[2] {
         mVertexBuffer.getBuffer(),
-        mInstanceBuffer.getBuffer()
+        mShadowInstanceBuffers.at(frameIndex).getBuffer()
     };
 
     VkDeviceSize offsets[2] {0, 0};
     vkCmdBindVertexBuffers(commandBuffer, 0, 2, buffers, offsets);
     vkCmdBindIndexBuffer(commandBuffer, mIndexBuffer.getBuffer(), 0, VK_INDEX_TYPE_UINT32);
-    vkCmdDrawIndexed(commandBuffer, getIndexCount(mIndexBuffer), mInstanceCount, 0, 0, 0);
+    vkCmdDrawIndexed(commandBuffer, getIndexCount(mIndexBuffer), instanceCount, 0, 0, firstInstance);
 }
 
 VkBuffer InstancedMesh::getVertexBuffer()
@@ -114,9 +454,9 @@ VkBuffer InstancedMesh::getIndexBuffer()
     return mIndexBuffer.getBuffer();
 }
 
-VkBuffer InstancedMesh::getInstanceBuffer()
+VkBuffer InstancedMesh::getInstanceBuffer(uint32_t frameIndex)
 {
-    return mIndexBuffer.getBuffer();
+    return mInstanceBuffers.at(frameIndex).getBuffer();
 }
 
 std::vector<VkVertexInputBindingDescription> InstancedMesh::bindingDescriptions()
@@ -204,21 +544,51 @@ std::vector<VkVertexInputAttributeDescription> InstancedMesh::attributeDescripti
     };
 }
 
-void InstancedMesh::checkResize()
+uint32_t InstancedMesh::indexCount()
 {
-    if (mInstanceCount < mInstanceBufferCapacity)
-        return;
+    return getIndexCount(mIndexBuffer);
+}
 
-    uint32_t newCapacity = mInstanceCount * 2;
+uint32_t InstancedMesh::instanceCount() const
+{
+    return mInstances.size();
+}
+
+uint32_t InstancedMesh::visibleInstanceCount(uint32_t frameIndex) const
+{
+    return mVisibleInstanceCounts.at(frameIndex);
+}
 
-    VulkanBuffer newInstanceBuffer(*mRenderDevice, newCapacity * sInstanceSize, BufferType::Vertex, MemoryType::HostCoherent);
-    newInstanceBuffer.copyBuffer(mInstanceBuffer, 0, 0, mInstanceBufferCapacity * sInstanceSize);
-    newInstanceBuffer.swap(mInstanceBuffer);
+float InstancedMesh::nearestInstanceDistance(const glm::vec3 &position) const
+{
+    float nearest = FLT_MAX;
 
-    mInstanceBufferCapacity = newCapacity;
+    for (uint32_t i = 0; i < mInstanceBounds.size(); ++i)
+    {
+        glm::vec3 toCenter = glm::vec3(mInstanceBounds.centerX[i], mInstanceBounds.centerY[i], mInstanceBounds.centerZ[i]) - position;
+        nearest = glm::min(nearest, glm::dot(toCenter, toCenter));
+    }
+
+    return nearest == FLT_MAX? FLT_MAX : glm::sqrt(nearest);
 }
 
-uint32_t InstancedMesh::indexCount()
+uint32_t InstancedMesh::culledInstanceCount(uint32_t frameIndex) const
 {
-    return getIndexCount(mIndexBuffer);
+    return mDrawCommandBuffers.at(frameIndex).mapped<VkDrawIndexedIndirectCommand>()->instanceCount;
+}
+
+// meshes that aren't shadow casters have no views
+uint32_t InstancedMesh::shadowViewInstanceCount(uint32_t view) const
+{
+    return view < mShadowViews.size()? mShadowViews[view].staticCount + mShadowViews[view].dynamicCount : 0;
+}
+
+uint32_t InstancedMesh::shadowViewDynamicCount(uint32_t view) const
+{
+    return view < mShadowViews.size()? mShadowViews[view].dynamicCount : 0;
+}
+
+ShadowViewChange InstancedMesh::shadowViewChange(uint32_t view) const
+{
+    return view < mShadowViews.size()? mShadowViews[view].change : ShadowViewChange::None;
 }
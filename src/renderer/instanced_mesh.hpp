@@ -11,6 +11,22 @@
 #include "../vk/vulkan_buffer.hpp"
 #include "../app/types.hpp"
 #include "vertex.hpp"
+#include "frustum_culling.hpp"
+
+enum class ShadowCasters
+{
+    All,
+    Static,
+    Dynamic
+};
+
+// what moved inside a shadow view since the last frame, later values include the earlier ones
+enum class ShadowViewChange
+{
+    None,
+    DynamicCasters,
+    StaticCasters
+};
 
 class InstancedMesh
 {
@@ -26,35 +42,103 @@ public:
     InstancedMesh();
     InstancedMesh(const VulkanRenderDevice& renderDevice,
                   const std::vector<Vertex>& vertices,
-                  const std::vector<uint32_t>& indices);
+                  const std::vector<uint32_t>& indices,
+                  const Aabb& bounds);
 
     void addInstance(uuid32_t id);
     void updateInstance(uuid32_t id, const glm::mat4& transformation);
+    // writes the instance without flagging the instance buffers, different ids can be written from different threads
+    void setInstanceTransform(uuid32_t id, const glm::mat4& transformation, const glm::mat3& normalMatrix);
+    void markInstancesDirty();
     void removeInstance(uuid32_t id);
+    void syncInstanceBuffer(uint32_t frameIndex);
+    // copies the instances whose world bounds touch the frustum into the frame's visible instance buffer
+    void cull(const Frustum& frustum, uint32_t frameIndex);
+    // gpu culling: the cull shader compacts the visible instances and counts them into the frame's draw command
+    void resetDrawCommand(uint32_t frameIndex);
+    void dispatchCull(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, uint32_t frameIndex) const;
+    // shadow views append the instances inside their frustum to one list, each view draws its own range of it.
+    // instances that haven't moved for a while are static casters and come first in a view's range, so cached
+    // shadow maps only have to redraw the rest
+    void clearShadowViews();
+    // turns the instance moves since the last call into the regions the shadow views get checked against
+    void updateShadowCasters();
+    uint32_t cullShadowView(const Frustum& frustum);
+    void syncShadowInstances(uint32_t frameIndex);
     void setDebugName(const std::string& debugName);
-    void render(VkCommandBuffer commandBuffer) const;
+    void render(VkCommandBuffer commandBuffer, uint32_t frameIndex) const;
+    void renderVisible(VkCommandBuffer commandBuffer, uint32_t frameIndex) const;
+    void renderIndirect(VkCommandBuffer commandBuffer, uint32_t frameIndex) const;
+    void renderShadowView(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint32_t view, ShadowCasters casters) const;
     uint32_t indexCount();
+    uint32_t instanceCount() const;
+    uint32_t visibleInstanceCount(uint32_t frameIndex) const;
+    // distance from position to the closest instance's bounds center, FLT_MAX without instances
+    float nearestInstanceDistance(const glm::vec3& position) const;
+    // what the cull shader counted, only valid once the frame's fence has signaled
+    uint32_t culledInstanceCount(uint32_t frameIndex) const;
+    uint32_t shadowViewInstanceCount(uint32_t view) const;
+    uint32_t shadowViewDynamicCount(uint32_t view) const;
+    ShadowViewChange shadowViewChange(uint32_t view) const;
     VkBuffer getVertexBuffer();
     VkBuffer getIndexBuffer();
-    VkBuffer getInstanceBuffer();
+    VkBuffer getInstanceBuffer(uint32_t frameIndex);
 
     static std::vector<VkVertexInputBindingDescription> bindingDescriptions();
     static std::vector<VkVertexInputAttributeDescription> attributeDescriptions();
     static std::vector<VkVertexInputBindingDescription> bindingDescriptionsInstanced();
     static std::vector<VkVertexInputAttributeDescription> attributeDescriptionsInstanced();
 
-private:
-    void checkResize();
-
 private:
     const VulkanRenderDevice* mRenderDevice;
 
     VulkanBuffer mVertexBuffer;
     VulkanBuffer mIndexBuffer;
-    VulkanBuffer mInstanceBuffer;
+    // instance data lives on the cpu and is copied into the buffer of each frame in flight once it changes.
+    // the per frame vectors have one entry per frame in flight
+    std::vector<InstanceData> mInstances;
+    std::vector<VulkanBuffer> mInstanceBuffers;
+    uint32_t mDirtyFrames;
+
+    // world bounds of each instance, same order as mInstances
+    Aabb mBounds;
+    BoundsArray mInstanceBounds;
+    std::vector<uint32_t> mVisibleIndices;
+    std::vector<VulkanBuffer> mVisibleInstanceBuffers;
+    std::vector<uint32_t> mVisibleInstanceCounts;
+
+    std::vector<VulkanBuffer> mCulledInstanceBuffers;
+    std::vector<VulkanBuffer> mDrawCommandBuffers;
+
+    struct ShadowView
+    {
+        uint32_t firstInstance;
+        uint32_t staticCount;
+        uint32_t dynamicCount;
+        ShadowViewChange change;
+    };
+
+    // per instance, dirtyBounds covers everywhere the instance has been since the last updateShadowCasters
+    struct ShadowCasterState
+    {
+        Aabb dirtyBounds;
+        uint32_t stillFrames;
+        bool moved;
+    };
+
+    struct ShadowDirtyRegion
+    {
+        Aabb bounds;
+        bool staticCasters;
+    };
+
+    std::vector<InstanceData> mShadowInstances;
+    std::vector<ShadowView> mShadowViews;
+    std::vector<VulkanBuffer> mShadowInstanceBuffers;
 
-    uint32_t mInstanceCount;
-    uint32_t mInstanceBufferCapacity;
+    std::vector<ShadowCasterState> mShadowCasterStates;
+    std::vector<ShadowDirtyRegion> mShadowDirtyRegions;
+    std::vector<Aabb> mRemovedCasterBounds;
 
     std::unordered_map<uuid32_t, index_t> mInstanceIdToIndexMap;
     std::unordered_map<index_t, uuid32_t> mInstanceIndexToIdMap;
@@ -0,0 +1,263 @@
+//
+// Created by Gianni on 17/10/2026.
+//
+
+#include "light_clustering.hpp"
+
+// the clusters look down +z
+static glm::vec3 toClusterSpace(const glm::vec3& v)
+{
+    return {v.x, v.y, -v.z};
+}
+
+ClusterLight clusterLight(const PointLight &pointLight, uint32_t index, const glm::mat4 &view)
+{
+    glm::vec3 position = toClusterSpace(glm::vec3(view * glm::vec4(glm::vec3(pointLight.position), 1.f)));
+
+    return {
+        .sphere = glm::vec4(position, pointLight.range),
+        .cone = glm::vec4(0.f),
+        .coneSin = 0.f,
+        .zMin = position.z - pointLight.range,
+        .zMax = position.z + pointLight.range,
+        .light = index
+    };
+}
+
+ClusterLight clusterLight(const SpotLight &spotLight, uint32_t index, const glm::mat4 &view)
+{
+    glm::vec3 position = toClusterSpace(glm::vec3(view * glm::vec4(glm::vec3(spotLight.position), 1.f)));
+    glm::vec3 direction = toClusterSpace(glm::normalize(glm::mat3(view) * glm::vec3(spotLight.direction)));
+    float halfAngle = glm::radians(spotLight.outerAngle * 0.5f);
+
+    float zMin = position.z - spotLight.range;
+    float zMax = position.z + spotLight.range;
+
+    // the cone fits in the one capped by a disc at its range, which only gets tighter than the sphere for narrow cones
+    if (halfAngle < glm::radians(80.f))
+    {
+        glm::vec3 discCenter = position + direction * spotLight.range;
+        float discRadius = spotLight.range * glm::tan(halfAngle);
+        float discExtent = discRadius * glm::sqrt(glm::max(1.f - direction.z * direction.z, 0.f));
+
+        zMin = glm::max(zMin, glm::min(position.z, discCenter.z - discExtent));
+        zMax = glm::min(zMax, glm::max(position.z, discCenter.z + discExtent));
+    }
+
+    return {
+        .sphere = glm::vec4(position, spotLight.range),
+        .cone = glm::vec4(direction, glm::cos(halfAngle)),
+        .coneSin = glm::sin(halfAngle),
+        .zMin = zMin,
+        .zMax = zMax,
+        .light = index | ClusterSpotLightBit
+    };
+}
+
+void binClusterLights(std::vector<ClusterLight> &lights,
+                      const std::vector<Aabb> &clusters,
+                      const glm::uvec3 &gridSize,
+                      ClusterLightBins &bins)
+{
+    std::stable_sort(lights.begin(), lights.end(), [] (const ClusterLight& a, const ClusterLight& b) {
+        return a.zMin < b.zMin;
+    });
+
+    // the clusters of a row share their y range and the ones of a slice their z range, the union covers rounding
+    std::vector<glm::vec2> sliceDepths(gridSize.z, glm::vec2(FLT_MAX, -FLT_MAX));
+    std::vector<glm::vec2> rowHeights(gridSize.y * gridSize.z, glm::vec2(FLT_MAX, -FLT_MAX));
+
+    for (uint32_t cluster = 0; cluster < clusters.size(); ++cluster)
+    {
+        uint32_t row = cluster / gridSize.x;
+        uint32_t slice = row / gridSize.y;
+
+        sliceDepths.at(slice) = {glm::min(sliceDepths.at(slice).x, clusters[cluster].min.z), glm::max(sliceDepths.at(slice).y, clusters[cluster].max.z)};
+        rowHeights.at(row) = {glm::min(rowHeights.at(row).x, clusters[cluster].min.y), glm::max(rowHeights.at(row).y, clusters[cluster].max.y)};
+    }
+
+    // the gpu builds its own cluster boxes, a little slack keeps the bins from missing a light that grazes one
+    auto slack = [] (float min, float max) {
+        return 1e-4f * (glm::abs(min) + glm::abs(max));
+    };
+
+    auto overlaps = [&slack] (const glm::vec2& range, float min, float max) {
+        return min - slack(min, max) <= range.y && max + slack(min, max) >= range.x;
+    };
+
+    // light and bin pairs, lights in ascending order
+    std::vector<glm::uvec2> binnedLights;
+    bins.bins.assign(rowHeights.size(), {0, 0});
+
+    for (uint32_t i = 0; i < lights.size(); ++i)
+    {
+        const ClusterLight& light = lights[i];
+        float yMin = light.sphere.y - light.sphere.w;
+        float yMax = light.sphere.y + light.sphere.w;
+        float zSlack = slack(light.zMin, light.zMax);
+
+        // the slices get deeper with their index, so the ones the light reaches are a run starting at the first one
+        // that doesn't end in front of it
+        auto firstSlice = std::partition_point(sliceDepths.begin(), sliceDepths.end(), [&] (const glm::vec2& depths) {
+            return depths.y < light.zMin - zSlack;
+        });
+
+        for (uint32_t slice = firstSlice - sliceDepths.begin(); slice < gridSize.z; ++slice)
+        {
+            if (sliceDepths[slice].x > light.zMax + zSlack)
+                break;
+
+            for (uint32_t row = slice * gridSize.y; row < (slice + 1) * gridSize.y; ++row)
+            {
+                if (overlaps(rowHeights[row], yMin, yMax))
+                {
+                    binnedLights.emplace_back(i, row);
+                    ++bins.bins[row].count;
+                }
+            }
+        }
+    }
+
+    uint32_t offset = 0;
+    for (LightRange& bin : bins.bins)
+    {
+        bin.offset = offset;
+        offset += bin.count;
+        bin.count = 0;
+    }
+
+    bins.lightIndices.resize(binnedLights.size());
+    for (const glm::uvec2& binnedLight : binnedLights)
+    {
+        LightRange& bin = bins.bins[binnedLight.y];
+        bins.lightIndices[bin.offset + bin.count++] = binnedLight.x;
+    }
+}
+
+std::vector<Aabb> clusterBounds(const glm::mat4 &projection,
+                                const glm::uvec3 &gridSize,
+                                const glm::uvec2 &screenSize,
+                                float nearPlane,
+                                float farPlane)
+{
+    glm::mat4 inverseProjection = glm::inverse(projection);
+    glm::vec2 clusterSize = glm::vec2(screenSize) / glm::vec2(gridSize);
+
+    auto screenToView = [&] (const glm::vec2& screenCoords) {
+        glm::vec2 texCoords = screenCoords / glm::vec2(screenSize);
+        glm::vec4 viewCoord = inverseProjection * glm::vec4(glm::vec2(texCoords.x, 1.f - texCoords.y) * 2.f - 1.f, 1.f, 1.f);
+        return glm::vec3(viewCoord) / viewCoord.w;
+    };
+
+    // the line goes through the origin
+    auto lineIntersectPlane = [] (const glm::vec3& b, float zDistance) {
+        return b * (zDistance / b.z);
+    };
+
+    std::vector<Aabb> clusters;
+    clusters.reserve(gridSize.x * gridSize.y * gridSize.z);
+
+    for (uint32_t z = 0; z < gridSize.z; ++z)
+    {
+        float nearClusterPlane = nearPlane * glm::pow(farPlane / nearPlane, static_cast<float>(z) / static_cast<float>(gridSize.z));
+        float farClusterPlane = nearPlane * glm::pow(farPlane / nearPlane, static_cast<float>(z + 1) / static_cast<float>(gridSize.z));
+
+        for (uint32_t y = 0; y < gridSize.y; ++y)
+        {
+            for (uint32_t x = 0; x < gridSize.x; ++x)
+            {
+                glm::vec3 minPointVs = screenToView(glm::vec2(x, y) * clusterSize);
+                glm::vec3 maxPointVs = screenToView(glm::vec2(x + 1, y + 1) * clusterSize);
+
+                glm::vec3 minPointNear = lineIntersectPlane(minPointVs, nearClusterPlane);
+                glm::vec3 minPointFar = lineIntersectPlane(minPointVs, farClusterPlane);
+                glm::vec3 maxPointNear = lineIntersectPlane(maxPointVs, nearClusterPlane);
+                glm::vec3 maxPointFar = lineIntersectPlane(maxPointVs, farClusterPlane);
+
+                glm::vec3 minPoint = glm::min(glm::min(minPointNear, minPointFar), glm::min(maxPointNear, maxPointFar));
+                glm::vec3 maxPoint = glm::max(glm::max(minPointNear, minPointFar), glm::max(maxPointNear, maxPointFar));
+
+                // same x flip as the shader
+                float minX = -maxPoint.x;
+                maxPoint.x = -minPoint.x;
+                minPoint.x = minX;
+
+                clusters.push_back({minPoint, maxPoint});
+            }
+        }
+    }
+
+    return clusters;
+}
+
+bool lightIntersectsCluster(const ClusterLight &light, const Aabb &cluster)
+{
+    if (light.zMax < cluster.min.z || light.zMin > cluster.max.z)
+        return false;
+
+    glm::vec3 position(light.sphere);
+    glm::vec3 closestPoint = glm::clamp(position, cluster.min, cluster.max);
+    glm::vec3 toClosestPoint = closestPoint - position;
+
+    if (glm::dot(toClosestPoint, toClosestPoint) >= light.sphere.w * light.sphere.w)
+        return false;
+
+    if (!(light.light & ClusterSpotLightBit))
+        return true;
+
+    // the cluster's bounding sphere against the cone, the sphere test above already took care of the range
+    glm::vec3 center = (cluster.min + cluster.max) * 0.5f;
+    float radius = glm::length(cluster.max - center);
+
+    glm::vec3 toCenter = center - position;
+    float alongAxis = glm::dot(toCenter, glm::vec3(light.cone));
+    float fromAxis = glm::sqrt(glm::max(glm::dot(toCenter, toCenter) - alongAxis * alongAxis, 0.f));
+    float distanceToCone = light.cone.w * fromAxis - alongAxis * light.coneSin;
+
+    return distanceToCone < radius && alongAxis > -radius;
+}
+
+void assignLightsToClusters(const std::vector<ClusterLight> &lights,
+                            const std::vector<Aabb> &clusters,
+                            ClusterLightGrid &grid)
+{
+    grid.lightLists.resize(clusters.size());
+    grid.lightIndices.clear();
+
+    for (uint32_t cluster = 0; cluster < clusters.size(); ++cluster)
+    {
+        uint32_t offset = static_cast<uint32_t>(grid.lightIndices.size());
+
+        for (const ClusterLight& light : lights)
+            if (lightIntersectsCluster(light, clusters[cluster]))
+                grid.lightIndices.push_back(light.light);
+
+        grid.lightLists[cluster] = {offset, static_cast<uint32_t>(grid.lightIndices.size()) - offset};
+    }
+}
+
+void assignLightsToClusters(const std::vector<ClusterLight> &lights,
+                            const ClusterLightBins &bins,
+                            const glm::uvec3 &gridSize,
+                            const std::vector<Aabb> &clusters,
+                            ClusterLightGrid &grid)
+{
+    grid.lightLists.resize(clusters.size());
+    grid.lightIndices.clear();
+
+    for (uint32_t cluster = 0; cluster < clusters.size(); ++cluster)
+    {
+        const LightRange& bin = bins.bins.at(cluster / gridSize.x);
+        uint32_t offset = static_cast<uint32_t>(grid.lightIndices.size());
+
+        for (uint32_t i = bin.offset; i < bin.offset + bin.count; ++i)
+        {
+            const ClusterLight& light = lights[bins.lightIndices[i]];
+
+            if (lightIntersectsCluster(light, clusters[cluster]))
+                grid.lightIndices.push_back(light.light);
+        }
+
+        grid.lightLists[cluster] = {offset, static_cast<uint32_t>(grid.lightIndices.size()) - offset};
+    }
+}
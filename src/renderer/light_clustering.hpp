@@ -0,0 +1,81 @@
+//
+// Created by Gianni on 17/10/2026.
+//
+
+#ifndef VULKANRENDERINGENGINE_LIGHT_CLUSTERING_HPP
+#define VULKANRENDERINGENGINE_LIGHT_CLUSTERING_HPP
+
+#include <glm/glm.hpp>
+#include "frustum_culling.hpp"
+#include "lights.hpp"
+
+// set on the entries of a cluster's light list that are spot lights, the other bits are the light's index
+inline constexpr uint32_t ClusterSpotLightBit = 0x80000000;
+
+// A point or spot light in the space of the cluster boxes, x and y are view space and z is the distance in front
+// of the camera. Matches ClusterLight in assign_lights_to_clusters.comp.
+struct ClusterLight
+{
+    glm::vec4 sphere; // position and range
+    glm::vec4 cone; // direction and the cosine of half the outer angle, spot lights only
+    float coneSin;
+    float zMin;
+    float zMax;
+    uint32_t light; // index of the light, with ClusterSpotLightBit for spot lights
+};
+
+// a run of entries in a light index list, used for the bins and for the cluster lists
+struct LightRange
+{
+    uint32_t offset;
+    uint32_t count;
+
+    bool operator==(const LightRange& other) const = default;
+};
+
+// The lights that may reach a row of clusters in a depth slice, one bin per row and slice with the rows fastest.
+// The bins list indices into the sorted lights in ascending order.
+struct ClusterLightBins
+{
+    std::vector<LightRange> bins;
+    std::vector<uint32_t> lightIndices;
+};
+
+// per cluster light lists laid out like the gpu's, a range per cluster into one shared index list. the gpu hands
+// out the ranges in whichever order the clusters finish, here they follow the cluster order
+struct ClusterLightGrid
+{
+    std::vector<LightRange> lightLists;
+    std::vector<uint32_t> lightIndices;
+};
+
+ClusterLight clusterLight(const PointLight& pointLight, uint32_t index, const glm::mat4& view);
+ClusterLight clusterLight(const SpotLight& spotLight, uint32_t index, const glm::mat4& view);
+
+// sorts the lights by their nearest depth and bins them against the cluster boxes
+void binClusterLights(std::vector<ClusterLight>& lights,
+                      const std::vector<Aabb>& clusters,
+                      const glm::uvec3& gridSize,
+                      ClusterLightBins& bins);
+
+// the boxes gen_frustum_clusters.comp makes, x fastest, then y, then z
+std::vector<Aabb> clusterBounds(const glm::mat4& projection,
+                                const glm::uvec3& gridSize,
+                                const glm::uvec2& screenSize,
+                                float nearPlane,
+                                float farPlane);
+
+bool lightIntersectsCluster(const ClusterLight& light, const Aabb& cluster);
+
+// Cpu references of assign_lights_to_clusters.comp. The first tests every light against every cluster, the second
+// only the lights in the cluster's bin. Both keep the sorted order, so they write the same lists.
+void assignLightsToClusters(const std::vector<ClusterLight>& lights,
+                            const std::vector<Aabb>& clusters,
+                            ClusterLightGrid& grid);
+void assignLightsToClusters(const std::vector<ClusterLight>& lights,
+                            const ClusterLightBins& bins,
+                            const glm::uvec3& gridSize,
+                            const std::vector<Aabb>& clusters,
+                            ClusterLightGrid& grid);
+
+#endif //VULKANRENDERINGENGINE_LIGHT_CLUSTERING_HPP
@@ -7,6 +7,7 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtx/euler_angles.hpp>
+#include "shadow_atlas.hpp"
 
 enum class LightType
 {
@@ -48,6 +49,19 @@ enum class ShadowType : uint32_t
     SoftShadow
 };
 
+// what a shadow map face was last drawn with. the static shadow map or atlas next to each shadow map or atlas holds
+// the same faces with only the static casters in them
+struct ShadowCache
+{
+    glm::mat4 viewProj;
+    bool valid;
+    bool cached;
+    bool drawn; // the face's region holds nothing of this light before it's first drawn
+    bool dirty; // the dynamic casters changed while the face's update was put off
+    uint32_t age; // frames since the face was last drawn
+    uint32_t wait; // frames the face's update has been put off for
+};
+
 inline constexpr uint32_t MaxCascades = 9;
 struct alignas(16) DirShadowData
 {
@@ -63,17 +77,22 @@ struct alignas(16) DirShadowData
     float zScalar = 10.f;
 };
 
+// every cascade is a layer of the one framebuffer
 struct DirShadowMap
 {
     VulkanImage shadowMap;
-    std::vector<VkFramebuffer> framebuffers;
+    VulkanImage staticShadowMap;
+    VkFramebuffer framebuffer{};
+    std::vector<ShadowCache> caches;
 };
 
+// atlas rects are a tile's uv offset in xy, its uv size in z and its page in w. a size of 0 means no tile
 struct PointShadowData
 {
     glm::mat4 viewProj[6] {};
+    glm::vec4 atlasRects[6] {};
     ShadowType shadowType = ShadowType::NoShadow;
-    uint32_t resolution = 1024;
+    uint32_t resolution = 1024; // tile size at full importance
     float strength = 1;
     float biasSlope = 0.2f;
     float biasConstant = 0.01f;
@@ -81,17 +100,20 @@ struct PointShadowData
     uint32_t padding[2] {};
 };
 
+// the faces are tiles of the shadow atlas, they hold hardware depth
 struct PointShadowMap
 {
-    VulkanImage shadowMap;
-    VkFramebuffer framebuffers[6];
+    ShadowAtlasTile tiles[6] {};
+    ShadowCache caches[6] {};
+    float importance = 0.f;
 };
 
 struct SpotShadowData
 {
     glm::mat4 viewProj {};
+    glm::vec4 atlasRect {};
     ShadowType shadowType = ShadowType::NoShadow;
-    uint32_t resolution = 1024;
+    uint32_t resolution = 1024; // tile size at full importance
     float strength = 1;
     float biasSlope = 0.f;
     float biasConstant = 0.0002f;
@@ -101,8 +123,9 @@ struct SpotShadowData
 
 struct SpotShadowMap
 {
-    VulkanImage shadowMap;
-    VkFramebuffer framebuffer{};
+    ShadowAtlasTile tile{};
+    ShadowCache cache{};
+    float importance = 0.f;
 };
 
 inline const char* toStr(ShadowType shadowType)
@@ -208,9 +231,12 @@ inline std::vector<glm::vec2> calcCascadePlanes(float nearPlane, float farPlane,
     return cascadePlanes;
 }
 
+// the forward shader rebuilds the distance along a face's axis from the depth with the same near plane
+inline constexpr float PointShadowNearPlane = 0.1f;
+
 inline void calcMatrices(PointShadowData& shadowData, const PointLight& pointLight)
 {
-    glm::mat4 proj = glm::perspective(glm::half_pi<float>(), 1.f, 0.1f, pointLight.range);
+    glm::mat4 proj = glm::perspective(glm::half_pi<float>(), 1.f, PointShadowNearPlane, pointLight.range);
     glm::vec3 lightPos(pointLight.position);
 
     shadowData.viewProj[0] = proj * glm::lookAt(lightPos, lightPos + glm::vec3( 1, 0, 0), glm::vec3(0, -1, 0)); // +X
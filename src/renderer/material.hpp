@@ -14,7 +14,8 @@ enum class AlphaMode : uint32_t
     Blend
 };
 
-struct alignas(64) Material
+// laid out like an element of the std430 materials array in forward_pass.frag
+struct alignas(16) Material
 {
     alignas(4) int32_t baseColorTexIndex;
     alignas(4) int32_t metallicTexIndex;
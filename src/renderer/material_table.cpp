@@ -0,0 +1,205 @@
+//
+// Created by Gianni on 17/10/2026.
+//
+
+#include "material_table.hpp"
+
+MaterialTable::MaterialTable()
+    : mRenderDevice()
+    , mDirtyFrames()
+    , mTextureCount()
+    , mMaterialCount()
+{
+}
+
+MaterialTable::MaterialTable(const VulkanRenderDevice &renderDevice, VkDescriptorSetLayout dsLayout)
+    : mRenderDevice(&renderDevice)
+    , mMaterialsSSBOs(renderDevice.framesInFlight)
+    , mDs(renderDevice.framesInFlight)
+    , mDirtyFrames()
+    , mTextureCount()
+    , mMaterialCount()
+{
+    std::vector<VkDescriptorSetLayout> dsLayouts(renderDevice.framesInFlight, dsLayout);
+
+    VkDescriptorSetAllocateInfo dsAllocateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = renderDevice.descriptorPool,
+        .descriptorSetCount = static_cast<uint32_t>(dsLayouts.size()),
+        .pSetLayouts = dsLayouts.data()
+    };
+
+    VkResult result = vkAllocateDescriptorSets(renderDevice.device, &dsAllocateInfo, mDs.data());
+    vulkanCheck(result, "Failed to allocate material table descriptor sets.");
+
+    for (uint32_t i = 0; i < renderDevice.framesInFlight; ++i)
+    {
+        mMaterialsSSBOs.at(i) = VulkanBuffer(renderDevice,
+                                             sizeof(Material) * MaxMaterials,
+                                             BufferType::Storage,
+                                             MemoryType::HostCoherent);
+        mMaterialsSSBOs.at(i).setDebugName(std::format("MaterialTable::mMaterialsSSBOs.at({})", i));
+
+        setVulkanObjectDebugName(renderDevice,
+                                 VK_OBJECT_TYPE_DESCRIPTOR_SET,
+                                 std::format("MaterialTable::mDs.at({})", i),
+                                 mDs.at(i));
+
+        VkDescriptorBufferInfo bufferInfo {
+            .buffer = mMaterialsSSBOs.at(i).getBuffer(),
+            .offset = 0,
+            .range = VK_WHOLE_SIZE
+        };
+
+        VkWriteDescriptorSet dsWrite {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = mDs.at(i),
+            .dstBinding = 0,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo = &bufferInfo
+        };
+
+        vkUpdateDescriptorSets(renderDevice.device, 1, &dsWrite, 0, nullptr);
+    }
+
+    addTexture(defaultBaseColorTex);
+    addTexture(defaultMetallicTex);
+    addTexture(defaultRoughnessTex);
+    addTexture(defaultNormalTex);
+    addTexture(defaultAoTex);
+    addTexture(defaultEmissionTex);
+}
+
+MaterialTable::~MaterialTable()
+{
+    if (!mDs.empty())
+        vkFreeDescriptorSets(mRenderDevice->device, mRenderDevice->descriptorPool, mDs.size(), mDs.data());
+}
+
+MaterialTable::MaterialTable(MaterialTable &&other) noexcept
+    : MaterialTable()
+{
+    swap(other);
+}
+
+MaterialTable &MaterialTable::operator=(MaterialTable &&other) noexcept
+{
+    if (this != &other)
+        swap(other);
+    return *this;
+}
+
+uint32_t MaterialTable::addTexture(const VulkanTexture &texture)
+{
+    uint32_t slot;
+
+    if (!mFreeTextureSlots.empty())
+    {
+        slot = mFreeTextureSlots.back();
+        mFreeTextureSlots.pop_back();
+    }
+    else
+    {
+        check(mTextureCount < MaxMaterialTextures, "Material table is out of texture slots.");
+        slot = mTextureCount++;
+    }
+
+    writeTexture(slot, texture);
+
+    return slot;
+}
+
+void MaterialTable::releaseTexture(uint32_t slot)
+{
+    // the binding is partially bound, the stale descriptor is never sampled again
+    mFreeTextureSlots.push_back(slot);
+}
+
+uint32_t MaterialTable::addMaterial(const Material &material)
+{
+    uint32_t slot;
+
+    if (!mFreeMaterialSlots.empty())
+    {
+        slot = mFreeMaterialSlots.back();
+        mFreeMaterialSlots.pop_back();
+    }
+    else
+    {
+        check(mMaterialCount < MaxMaterials, "Material table is out of material slots.");
+        slot = mMaterialCount++;
+        mMaterials.emplace_back();
+    }
+
+    updateMaterial(slot, material);
+
+    return slot;
+}
+
+void MaterialTable::updateMaterial(uint32_t slot, const Material &material)
+{
+    mMaterials.at(slot) = material;
+    mDirtyFrames = (1u << mRenderDevice->framesInFlight) - 1;
+}
+
+void MaterialTable::releaseMaterial(uint32_t slot)
+{
+    mFreeMaterialSlots.push_back(slot);
+}
+
+void MaterialTable::sync(uint32_t frameIndex)
+{
+    // the frame that last read this frame's copy has retired, so it can be written without a device wait
+    uint32_t frameBit = 1u << frameIndex;
+
+    if (mDirtyFrames & frameBit)
+    {
+        std::copy(mMaterials.begin(), mMaterials.end(), mMaterialsSSBOs.at(frameIndex).mapped<Material>());
+        mDirtyFrames &= ~frameBit;
+    }
+}
+
+VkDescriptorSet MaterialTable::descriptorSet(uint32_t frameIndex) const
+{
+    return mDs.at(frameIndex);
+}
+
+void MaterialTable::swap(MaterialTable &other)
+{
+    std::swap(mRenderDevice, other.mRenderDevice);
+    std::swap(mMaterialsSSBOs, other.mMaterialsSSBOs);
+    std::swap(mDs, other.mDs);
+    std::swap(mMaterials, other.mMaterials);
+    std::swap(mDirtyFrames, other.mDirtyFrames);
+    std::swap(mTextureCount, other.mTextureCount);
+    std::swap(mMaterialCount, other.mMaterialCount);
+    std::swap(mFreeTextureSlots, other.mFreeTextureSlots);
+    std::swap(mFreeMaterialSlots, other.mFreeMaterialSlots);
+}
+
+void MaterialTable::writeTexture(uint32_t slot, const VulkanTexture &texture)
+{
+    VkDescriptorImageInfo imageInfo {
+        .sampler = texture.vulkanSampler.sampler,
+        .imageView = texture.imageView,
+        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+    };
+
+    std::vector<VkWriteDescriptorSet> dsWrites;
+    for (VkDescriptorSet ds : mDs)
+    {
+        dsWrites.push_back({
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = ds,
+            .dstBinding = 1,
+            .dstArrayElement = slot,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .pImageInfo = &imageInfo
+        });
+    }
+
+    vkUpdateDescriptorSets(mRenderDevice->device, dsWrites.size(), dsWrites.data(), 0, nullptr);
+}
@@ -0,0 +1,67 @@
+//
+// Created by Gianni on 17/10/2026.
+//
+
+#ifndef VULKANRENDERINGENGINE_MATERIAL_TABLE_HPP
+#define VULKANRENDERINGENGINE_MATERIAL_TABLE_HPP
+
+#include "../vk/vulkan_buffer.hpp"
+#include "../vk/vulkan_texture.hpp"
+#include "material.hpp"
+
+// sizes of the table's bindings, MaxMaterialTextures matches MAX_MATERIAL_TEXTURES in forward_pass.frag
+inline constexpr uint32_t MaxMaterials = 4096;
+inline constexpr uint32_t MaxMaterialTextures = 1024;
+
+// the default textures take the first slots, in the order of Material's texture indices
+inline constexpr uint32_t DefaultMaterialTextureCount = 6;
+
+// Every model's materials in one storage buffer and their textures in one sampler array, so draws only pick a
+// material by index. Texture indices in the table's materials are texture slots, -1 still means the default texture.
+// Material writes land in a cpu copy that sync puts into the frame's own storage buffer, so a frame in flight never
+// reads a half edited table. The descriptor sets aren't update after bind, texture slots can only be added while no
+// frame is using them.
+class MaterialTable
+{
+public:
+    MaterialTable();
+    MaterialTable(const VulkanRenderDevice& renderDevice, VkDescriptorSetLayout dsLayout);
+    ~MaterialTable();
+
+    MaterialTable(const MaterialTable&) = delete;
+    MaterialTable& operator=(const MaterialTable&) = delete;
+
+    MaterialTable(MaterialTable&& other) noexcept;
+    MaterialTable& operator=(MaterialTable&& other) noexcept;
+
+    uint32_t addTexture(const VulkanTexture& texture);
+    void releaseTexture(uint32_t slot);
+
+    uint32_t addMaterial(const Material& material);
+    void updateMaterial(uint32_t slot, const Material& material);
+    void releaseMaterial(uint32_t slot);
+
+    void sync(uint32_t frameIndex);
+
+    VkDescriptorSet descriptorSet(uint32_t frameIndex) const;
+    void swap(MaterialTable& other);
+
+private:
+    void writeTexture(uint32_t slot, const VulkanTexture& texture);
+
+private:
+    const VulkanRenderDevice* mRenderDevice;
+    std::vector<VulkanBuffer> mMaterialsSSBOs;
+    std::vector<VkDescriptorSet> mDs;
+
+    std::vector<Material> mMaterials;
+    uint32_t mDirtyFrames;
+
+    // slots past the high water marks have never been handed out
+    uint32_t mTextureCount;
+    uint32_t mMaterialCount;
+    std::vector<uint32_t> mFreeTextureSlots;
+    std::vector<uint32_t> mFreeMaterialSlots;
+};
+
+#endif //VULKANRENDERINGENGINE_MATERIAL_TABLE_HPP
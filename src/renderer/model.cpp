@@ -6,6 +6,7 @@
 
 Model::Model()
     : mRenderDevice()
+    , mMaterialTable()
     , id()
     , cullMode()
     , frontFace()
@@ -14,6 +15,7 @@ Model::Model()
 
 Model::Model(const VulkanRenderDevice& renderDevice)
     : mRenderDevice(&renderDevice)
+    , mMaterialTable()
     , id()
     , cullMode(VK_CULL_MODE_BACK_BIT)
     , frontFace(VK_FRONT_FACE_COUNTER_CLOCKWISE)
@@ -28,6 +30,15 @@ Model::~Model()
                              mRenderDevice->descriptorPool,
                              1, &texture.descriptorSet);
     }
+
+    if (mMaterialTable)
+    {
+        for (uint32_t slot : mTextureSlots)
+            mMaterialTable->releaseTexture(slot);
+
+        for (uint32_t slot : mMaterialSlots)
+            mMaterialTable->releaseMaterial(slot);
+    }
 }
 
 Model::Model(Model &&other) noexcept
@@ -43,16 +54,15 @@ Model &Model::operator=(Model &&other) noexcept
     return *this;
 }
 
-void Model::createMaterialsUBO()
+void Model::addToMaterialTable(MaterialTable &materialTable)
 {
-    mMaterialsUBO = VulkanBuffer(*mRenderDevice,
-                                 sizeof(Material) * materials.size(),
-                                 BufferType::Uniform,
-                                 MemoryType::HostCoherent,
-                                 materials.data());
-    mMaterialsUBO.setDebugName(name + " Material UBO");
+    mMaterialTable = &materialTable;
 
-    readBufferToVector<Material>(mRenderDevice->device, mMaterialsUBO.getMemory(), sizeof(Material));
+    for (const auto& texture : textures)
+        mTextureSlots.push_back(materialTable.addTexture(texture.vulkanTexture));
+
+    for (index_t i = 0; i < materials.size(); ++i)
+        mMaterialSlots.push_back(materialTable.addMaterial(tableMaterial(i)));
 }
 
 void Model::createTextureDescriptorSets(VkDescriptorSetLayout dsLayout)
@@ -89,13 +99,17 @@ void Model::createTextureDescriptorSets(VkDescriptorSetLayout dsLayout)
     }
 }
 
-Mesh* Model::getMesh(uuid32_t meshID)
+Mesh &Model::addMesh(Mesh &&mesh)
 {
-    for (auto& mesh : meshes)
-        if (mesh.meshID == meshID)
-            return &mesh;
+    mMeshIndices.insert(mesh.meshID, meshes.size());
+    meshes.push_back(std::move(mesh));
+    return meshes.back();
+}
 
-    return nullptr;
+Mesh* Model::getMesh(uuid32_t meshID)
+{
+    index_t* meshIndex = mMeshIndices.find(meshID);
+    return meshIndex? &meshes.at(*meshIndex) : nullptr;
 }
 
 void Model::swap(Model &other)
@@ -111,116 +125,39 @@ void Model::swap(Model &other)
     std::swap(cullMode, other.cullMode);
     std::swap(frontFace, other.frontFace);
     std::swap(mRenderDevice, other.mRenderDevice);
-    std::swap(mMaterialsUBO, other.mMaterialsUBO);
+    std::swap(mMaterialTable, other.mMaterialTable);
+    std::swap(mTextureSlots, other.mTextureSlots);
+    std::swap(mMaterialSlots, other.mMaterialSlots);
+    std::swap(mMeshIndices, other.mMeshIndices);
 }
 
 void Model::updateMaterial(index_t matIndex)
 {
-    mMaterialsUBO.mapBufferMemory(matIndex * sizeof(Material), sizeof(Material), &materials.at(matIndex));
+    mMaterialTable->updateMaterial(mMaterialSlots.at(matIndex), tableMaterial(matIndex));
 }
 
-void Model::bindMaterialUBO(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, uint32_t materialIndex, uint32_t matDsIndex) const
+uint32_t Model::materialSlot(uint32_t materialIndex) const
 {
-    VkDescriptorBufferInfo bufferInfo {
-        .buffer = mMaterialsUBO.getBuffer(),
-        .offset = materialIndex * sizeof(Material),
-        .range = sizeof(Material)
-    };
-
-    VkWriteDescriptorSet writeDescriptorSet {
-        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-        .dstSet = VK_NULL_HANDLE,
-        .dstBinding = 0,
-        .dstArrayElement = 0,
-        .descriptorCount = 1,
-        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-        .pBufferInfo = &bufferInfo
-    };
-
-    pfnCmdPushDescriptorSet(commandBuffer,
-                            VK_PIPELINE_BIND_POINT_GRAPHICS,
-                            pipelineLayout,
-                            matDsIndex,
-                            1,
-                            &writeDescriptorSet);
+    return mMaterialSlots.at(materialIndex);
 }
 
-void Model::bindTextures(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, uint32_t materialIndex, uint32_t matDsIndex) const
+Material Model::tableMaterial(index_t matIndex) const
 {
-    const Material& mat = materials.at(materialIndex);
-
-    int32_t baseColorTexIndex = mat.baseColorTexIndex;
-    int32_t metallicTexIndex = mat.metallicTexIndex;
-    int32_t roughnessTexIndex = mat.roughnessTexIndex;
-    int32_t normalTexIndex = mat.normalTexIndex;
-    int32_t aoTexIndex = mat.aoTexIndex;
-    int32_t emissionTexIndex = mat.emissionTexIndex;
+    Material material = materials.at(matIndex);
 
-    auto imageInfo = [this] (int32_t texIndex, const VulkanTexture& def) {
-        VkDescriptorImageInfo descriptorImageInfo {
-            .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-        };
-
-        if (texIndex == -1)
-        {
-            descriptorImageInfo.sampler = def.vulkanSampler.sampler;
-            descriptorImageInfo.imageView = def.imageView;
-
-            return descriptorImageInfo;
-        }
-
-        const auto& tex = textures.at(texIndex).vulkanTexture;
-
-        descriptorImageInfo.sampler = tex.vulkanSampler.sampler;
-        descriptorImageInfo.imageView = tex.imageView;
-
-        return descriptorImageInfo;
-    };
-
-    VkDescriptorImageInfo baseColorImageInfo = imageInfo(baseColorTexIndex, defaultBaseColorTex);
-    VkDescriptorImageInfo metallicImageInfo = imageInfo(metallicTexIndex, defaultMetallicTex);
-    VkDescriptorImageInfo roughnessImageInfo = imageInfo(roughnessTexIndex, defaultRoughnessTex);
-    VkDescriptorImageInfo normalImageInfo = imageInfo(normalTexIndex, defaultNormalTex);
-    VkDescriptorImageInfo aoImageInfo = imageInfo(aoTexIndex, defaultAoTex);
-    VkDescriptorImageInfo emissionImageInfo = imageInfo(emissionTexIndex, defaultEmissionTex);
-
-    VkWriteDescriptorSet prototypeWriteDescriptorSet {
-        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-        .dstSet = VK_NULL_HANDLE,
-        .dstBinding = 1,
-        .dstArrayElement = 0,
-        .descriptorCount = 1,
-        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-        .pImageInfo = nullptr
+    auto textureSlot = [this] (int32_t& texIndex) {
+        if (texIndex != -1)
+            texIndex = static_cast<int32_t>(mTextureSlots.at(texIndex));
     };
 
-    std::array<VkWriteDescriptorSet, 6> descriptorWrites;
-    descriptorWrites.fill(prototypeWriteDescriptorSet);
-
-    descriptorWrites.at(0).dstBinding = 1;
-    descriptorWrites.at(0).pImageInfo = &baseColorImageInfo;
-
-    descriptorWrites.at(1).dstBinding = 2;
-    descriptorWrites.at(1).pImageInfo = &metallicImageInfo;
-
-    descriptorWrites.at(2).dstBinding = 3;
-    descriptorWrites.at(2).pImageInfo = &roughnessImageInfo;
-
-    descriptorWrites.at(3).dstBinding = 4;
-    descriptorWrites.at(3).pImageInfo = &normalImageInfo;
-
-    descriptorWrites.at(4).dstBinding = 5;
-    descriptorWrites.at(4).pImageInfo = &aoImageInfo;
-
-    descriptorWrites.at(5).dstBinding = 6;
-    descriptorWrites.at(5).pImageInfo = &emissionImageInfo;
+    textureSlot(material.baseColorTexIndex);
+    textureSlot(material.metallicTexIndex);
+    textureSlot(material.roughnessTexIndex);
+    textureSlot(material.normalTexIndex);
+    textureSlot(material.aoTexIndex);
+    textureSlot(material.emissionTexIndex);
 
-    pfnCmdPushDescriptorSet(commandBuffer,
-                            VK_PIPELINE_BIND_POINT_GRAPHICS,
-                            pipelineLayout,
-                            matDsIndex,
-                            descriptorWrites.size(),
-                            descriptorWrites.data());
+    return material;
 }
 
 bool Model::drawOpaque(const Mesh &mesh) const
@@ -7,10 +7,11 @@
 
 #include <glm/glm.hpp>
 #include "../app/uuid_registry.hpp"
+#include "../app/uuid_map.hpp"
 #include "../vk/vulkan_texture.hpp"
 #include "../vk/vulkan_descriptor.hpp"
 #include "instanced_mesh.hpp"
-#include "material.hpp"
+#include "material_table.hpp"
 
 struct SceneNode
 {
@@ -29,6 +30,7 @@ struct Mesh
     InstancedMesh mesh;
     uint32_t materialIndex;
     glm::vec3 center;
+    Aabb bounds;
 };
 
 struct Texture
@@ -67,19 +69,28 @@ public:
 
     void updateMaterial(index_t matIndex);
 
-    void createMaterialsUBO();
+    // the model's slots are released again when it's destroyed
+    void addToMaterialTable(MaterialTable& materialTable);
     void createTextureDescriptorSets(VkDescriptorSetLayout dsLayout);
 
-    void bindMaterialUBO(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, uint32_t materialIndex, uint32_t matDsIndex) const;
-    void bindTextures(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, uint32_t materialIndex, uint32_t matDsIndex) const;
+    // index of the material in the material table
+    uint32_t materialSlot(uint32_t materialIndex) const;
 
     bool drawOpaque(const Mesh& mesh) const;
+    // meshes have to be added through here to be found by getMesh
+    Mesh& addMesh(Mesh&& mesh);
     Mesh* getMesh(uuid32_t meshID);
     void swap(Model& other);
 
+private:
+    Material tableMaterial(index_t matIndex) const;
+
 private:
     const VulkanRenderDevice* mRenderDevice;
-    VulkanBuffer mMaterialsUBO;
+    MaterialTable* mMaterialTable;
+    std::vector<uint32_t> mTextureSlots;
+    std::vector<uint32_t> mMaterialSlots;
+    UuidMap<index_t> mMeshIndices;
 };
 
 const char* toStr(VkCullModeFlags cullMode);
@@ -37,17 +37,18 @@ static constexpr int sRemovePrimitives
     aiPrimitiveType_LINE
 };
 
-static std::mutex sMutex; // keep due to stb state change
-
-ModelLoader::ModelLoader(const ModelImportData& importData)
+ModelLoader::ModelLoader(const ModelImportData& importData, ThreadPool* threadPool)
     : path(importData.path)
     , root()
+    , mFlipUVs(importData.flipUVs)
     , mSuccess()
 {
-    std::lock_guard<std::mutex> lock(sMutex);
+    PROFILE_ZONE("Import Model");
 
     debugLog("Loading model: " + path.string());
 
+    Timer timer;
+
     Assimp::Importer importer;
     importer.SetPropertyInteger(AI_CONFIG_PP_RVC_FLAGS, sRemoveComponents);
     importer.SetPropertyInteger(AI_CONFIG_PP_SBP_REMOVE, sRemovePrimitives);
@@ -55,7 +56,8 @@ ModelLoader::ModelLoader(const ModelImportData& importData)
 
     importer.ReadFile(path.string(), sImportFlags);
 
-    if (importData.flipUVs) stbi_set_flip_vertically_on_load(true);
+    // per thread so concurrent imports don't race on the flip flag
+    stbi_set_flip_vertically_on_load_thread(importData.flipUVs);
 
     const auto* scene = importer.GetScene();
 
@@ -63,6 +65,7 @@ ModelLoader::ModelLoader(const ModelImportData& importData)
     {
         debugLog("Failed to load model: " + path.string());
         debugLog("Importer error: " + std::string(importer.GetErrorString()));
+        stbi_set_flip_vertically_on_load_thread(false);
         return;
     }
 
@@ -73,7 +76,7 @@ ModelLoader::ModelLoader(const ModelImportData& importData)
 
         getTextureNames(*scene);
 
-        loadTextures(*scene);
+        loadTextures(*scene, threadPool);
         loadMaterials(*scene);
 
         mSuccess = true;
@@ -84,9 +87,12 @@ ModelLoader::ModelLoader(const ModelImportData& importData)
         debugLog("Exception caught: " + std::string(e.what()));
     }
 
-    debugLog("Successfully loaded: " + path.string());
+    stbi_set_flip_vertically_on_load_thread(false);
+
+    timer.end();
 
-    stbi_set_flip_vertically_on_load(false);
+    if (mSuccess)
+        debugLog(std::format("Successfully loaded: {} ({} ms)", path.string(), timer.ellapsedMilli()));
 }
 
 ModelLoader::ModelLoader(ModelLoader &&other) noexcept
@@ -112,6 +118,7 @@ void ModelLoader::swap(ModelLoader &other) noexcept
     std::swap(materialNames, other.materialNames);
     std::swap(mTextureNames, other.mTextureNames);
     std::swap(mInsertedTexIndex, other.mInsertedTexIndex);
+    std::swap(mFlipUVs, other.mFlipUVs);
     std::swap(mSuccess, other.mSuccess);
 }
 
@@ -139,34 +146,55 @@ void ModelLoader::loadMeshes(const aiScene& aiScene)
             .vertices = loadMeshVertices(aiMesh),
             .indices = loadMeshIndices(aiMesh),
             .materialIndex = aiMesh.mMaterialIndex,
-            .center = glm::make_vec3(&center.x)
+            .center = glm::make_vec3(&center.x),
+            .bounds = {glm::make_vec3(&aabb.mMin.x), glm::make_vec3(&aabb.mMax.x)}
         };
 
         meshes.push_back(std::move(meshData));
     }
 }
 
-void ModelLoader::loadTextures(const aiScene& aiScene)
+void ModelLoader::loadTextures(const aiScene& aiScene, ThreadPool* threadPool)
 {
-    for (const std::string& texName : mTextureNames)
+    PROFILE_ZONE("ModelLoader::loadTextures");
+
+    Timer timer;
+
+    std::vector<std::string> texNames(mTextureNames.begin(), mTextureNames.end());
+    std::vector<std::optional<ImageData>> decoded(texNames.size());
+
+    // this thread decodes too, so running on the pool that imports the model can't deadlock
+    parallelForEach(threadPool, static_cast<uint32_t>(texNames.size()), [&] (uint32_t i) {
+        PROFILE_ZONE("Decode Texture");
+
+        stbi_set_flip_vertically_on_load_thread(mFlipUVs);
+
+        const std::string& texName = texNames.at(i);
+
+        Timer texTimer;
+
+        decoded.at(i) = aiScene.GetEmbeddedTexture(texName.c_str())
+            ? loadEmbeddedImageData(aiScene, texName)
+            : loadImageData(texName);
+
+        texTimer.end();
+
+        debugLog(std::format("Decoded {} ({:.2f} ms)", texName, texTimer.ellapsedMicro() / 1000.0));
+    });
+
+    // gather in name order so texture indices don't depend on scheduling
+    for (size_t i = 0; i < decoded.size(); ++i)
     {
-        if (aiScene.GetEmbeddedTexture(texName.c_str()))
+        if (decoded.at(i))
         {
-            if (auto imageData = loadEmbeddedImageData(aiScene, texName))
-            {
-                mInsertedTexIndex.emplace(texName, images.size());
-                images.push_back(std::move(*imageData));
-            }
-        }
-        else
-        {
-            if (auto imageData = loadImageData(texName))
-            {
-                mInsertedTexIndex.emplace(texName, images.size());
-                images.push_back(std::move(*imageData));
-            }
+            mInsertedTexIndex.emplace(texNames.at(i), images.size());
+            images.push_back(std::move(*decoded.at(i)));
         }
     }
+
+    timer.end();
+
+    debugLog(std::format("Decoded {} texture(s) for {} in {} ms", images.size(), path.filename().string(), timer.ellapsedMilli()));
 }
 
 void ModelLoader::loadMaterials(const aiScene& aiScene)
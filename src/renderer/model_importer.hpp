@@ -16,6 +16,8 @@
 #include "../utils/loaded_image.hpp"
 #include "../utils/utils.hpp"
 #include "../utils/timer.hpp"
+#include "../utils/thread_pool.hpp"
+#include "../utils/cpu_profiler.hpp"
 #include "vertex.hpp"
 #include "model.hpp"
 
@@ -33,6 +35,7 @@ struct MeshData
     std::vector<uint32_t> indices;
     uint32_t materialIndex;
     glm::vec3 center;
+    Aabb bounds;
 };
 
 struct ImageData
@@ -59,7 +62,7 @@ public:
 
 public:
     ModelLoader() = default;
-    ModelLoader(const ModelImportData& importData);
+    ModelLoader(const ModelImportData& importData, ThreadPool* threadPool = nullptr);
     ~ModelLoader() = default;
 
     ModelLoader(const ModelLoader& other) = delete;
@@ -74,7 +77,7 @@ public:
 private:
     void createHierarchy(const aiScene& aiScene);
     void loadMeshes(const aiScene& aiScene);
-    void loadTextures(const aiScene& aiScene);
+    void loadTextures(const aiScene& aiScene, ThreadPool* threadPool);
     void loadMaterials(const aiScene& aiScene);
     void getTextureNames(const aiScene& aiScene);
 
@@ -101,6 +104,7 @@ private:
 private:
     std::unordered_set<std::string> mTextureNames;
     std::unordered_map<std::string, int32_t> mInsertedTexIndex;
+    bool mFlipUVs {};
     bool mSuccess {};
 };
 
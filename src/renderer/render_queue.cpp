@@ -0,0 +1,106 @@
+//
+// Created by Gianni on 17/10/2026.
+//
+
+#include "render_queue.hpp"
+
+static uint64_t packField(uint32_t value, uint32_t bits, uint32_t shift)
+{
+    return (static_cast<uint64_t>(value) & ((1ull << bits) - 1)) << shift;
+}
+
+static uint32_t unpackField(uint64_t key, uint32_t bits, uint32_t shift)
+{
+    return static_cast<uint32_t>((key >> shift) & ((1ull << bits) - 1));
+}
+
+uint64_t packDrawKey(const DrawKey &key)
+{
+    return packField(key.pass, DrawKeyPassBits, DrawKeyPassShift) |
+           packField(key.pipeline, DrawKeyPipelineBits, DrawKeyPipelineShift) |
+           packField(key.rasterState, DrawKeyRasterStateBits, DrawKeyRasterStateShift) |
+           packField(key.material, DrawKeyMaterialBits, DrawKeyMaterialShift) |
+           packField(key.mesh, DrawKeyMeshBits, DrawKeyMeshShift) |
+           packField(key.depth, DrawKeyDepthBits, 0);
+}
+
+DrawKey unpackDrawKey(uint64_t key)
+{
+    return {
+        .pass = unpackField(key, DrawKeyPassBits, DrawKeyPassShift),
+        .pipeline = unpackField(key, DrawKeyPipelineBits, DrawKeyPipelineShift),
+        .rasterState = unpackField(key, DrawKeyRasterStateBits, DrawKeyRasterStateShift),
+        .material = unpackField(key, DrawKeyMaterialBits, DrawKeyMaterialShift),
+        .mesh = unpackField(key, DrawKeyMeshBits, DrawKeyMeshShift),
+        .depth = unpackField(key, DrawKeyDepthBits, 0)
+    };
+}
+
+uint32_t quantizeDepth(float distance, float maxDistance)
+{
+    constexpr uint32_t MaxDepth = (1u << DrawKeyDepthBits) - 1;
+    float depth = glm::clamp(distance / maxDistance, 0.f, 1.f);
+
+    return static_cast<uint32_t>(depth * static_cast<float>(MaxDepth));
+}
+
+void RenderQueue::clear()
+{
+    mPackets.clear();
+}
+
+void RenderQueue::add(const DrawKey &key, uint32_t item)
+{
+    mPackets.push_back({packDrawKey(key), item});
+}
+
+void RenderQueue::sort()
+{
+    constexpr uint32_t DigitCount = sizeof(uint64_t);
+
+    // every digit's histogram in one read of the keys
+    std::array<std::array<uint32_t, 256>, DigitCount> histograms {};
+    for (const DrawPacket& packet : mPackets)
+        for (uint32_t digit = 0; digit < DigitCount; ++digit)
+            ++histograms[digit][(packet.key >> (digit * 8)) & 0xff];
+
+    mScratch.resize(mPackets.size());
+
+    for (uint32_t digit = 0; digit < DigitCount; ++digit)
+    {
+        std::array<uint32_t, 256>& histogram = histograms[digit];
+
+        // the fields a pass leaves at 0 put every key in one bucket
+        if (std::find(histogram.begin(), histogram.end(), mPackets.size()) != histogram.end())
+            continue;
+
+        uint32_t offset = 0;
+        for (uint32_t& count : histogram)
+        {
+            uint32_t bucketSize = count;
+            count = offset;
+            offset += bucketSize;
+        }
+
+        for (const DrawPacket& packet : mPackets)
+            mScratch[histogram[(packet.key >> (digit * 8)) & 0xff]++] = packet;
+
+        mPackets.swap(mScratch);
+    }
+}
+
+uint32_t RenderQueue::keyChanges(uint64_t mask) const
+{
+    uint32_t changes = 0;
+
+    for (size_t i = 0; i < mPackets.size(); ++i)
+        if (i == 0 || (mPackets[i].key & mask) != (mPackets[i - 1].key & mask))
+            ++changes;
+
+    return changes;
+}
+
+const std::vector<DrawPacket> &RenderQueue::packets() const
+{
+    return mPackets;
+}
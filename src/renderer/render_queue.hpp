@@ -0,0 +1,95 @@
+//
+// Created by Gianni on 17/10/2026.
+//
+
+#ifndef VULKANRENDERINGENGINE_RENDER_QUEUE_HPP
+#define VULKANRENDERINGENGINE_RENDER_QUEUE_HPP
+
+#include <glm/glm.hpp>
+
+// the passes that record their draws from a render queue, the first field of the sort key
+enum class RenderQueuePass : uint32_t
+{
+    Prepass,
+    SsaoResources,
+    ForwardOpaque,
+    Wireframe,
+    Count
+};
+
+inline constexpr uint32_t RenderQueuePassCount = static_cast<uint32_t>(RenderQueuePass::Count);
+
+// Fields of a draw's 64 bit sort key, most significant first. A pass leaves the fields it has no state for at 0, so
+// the next field down decides the order.
+struct DrawKey
+{
+    uint32_t pass;
+    uint32_t pipeline; // 0 while every pass binds its one pipeline itself
+    uint32_t rasterState; // cull mode and front face
+    uint32_t material; // slot in the material table
+    uint32_t mesh;
+    uint32_t depth; // from quantizeDepth
+};
+
+inline constexpr uint32_t DrawKeyDepthBits = 21;
+inline constexpr uint32_t DrawKeyMeshBits = 20;
+inline constexpr uint32_t DrawKeyMaterialBits = 12;
+inline constexpr uint32_t DrawKeyRasterStateBits = 3;
+inline constexpr uint32_t DrawKeyPipelineBits = 4;
+inline constexpr uint32_t DrawKeyPassBits = 4;
+
+inline constexpr uint32_t DrawKeyMeshShift = DrawKeyDepthBits;
+inline constexpr uint32_t DrawKeyMaterialShift = DrawKeyMeshShift + DrawKeyMeshBits;
+inline constexpr uint32_t DrawKeyRasterStateShift = DrawKeyMaterialShift + DrawKeyMaterialBits;
+inline constexpr uint32_t DrawKeyPipelineShift = DrawKeyRasterStateShift + DrawKeyRasterStateBits;
+inline constexpr uint32_t DrawKeyPassShift = DrawKeyPipelineShift + DrawKeyPipelineBits;
+
+inline constexpr uint64_t DrawKeyRasterStateMask = ((1ull << DrawKeyRasterStateBits) - 1) << DrawKeyRasterStateShift;
+inline constexpr uint64_t DrawKeyMaterialMask = ((1ull << DrawKeyMaterialBits) - 1) << DrawKeyMaterialShift;
+
+// fields wider than their bits are cut to them
+uint64_t packDrawKey(const DrawKey& key);
+DrawKey unpackDrawKey(uint64_t key);
+
+// distances past maxDistance all get the largest depth
+uint32_t quantizeDepth(float distance, float maxDistance);
+
+struct DrawPacket
+{
+    uint64_t key;
+    uint32_t item; // index into whatever the pass draws from
+};
+
+// the commands a pass recorded from its queue
+struct RenderQueueStats
+{
+    uint32_t draws;
+    uint32_t rasterStateChanges;
+    uint32_t materialChanges;
+    // what the same draws would have needed in the order they were added
+    uint32_t unsortedRasterStateChanges;
+    uint32_t unsortedMaterialChanges;
+};
+
+// A pass's draws for the frame. The packets and the sort's scratch space keep their memory between frames.
+class RenderQueue
+{
+public:
+    void clear();
+    void add(const DrawKey& key, uint32_t item);
+
+    // lsd radix sort, 8 bits at a time, skipping the digits every key has in common. stable, so draws with equal
+    // keys stay in the order they were added
+    void sort();
+
+    // how often the fields under mask differ from the previous packet's, the first packet counts as a change
+    uint32_t keyChanges(uint64_t mask) const;
+
+    const std::vector<DrawPacket>& packets() const;
+
+private:
+    std::vector<DrawPacket> mPackets;
+    std::vector<DrawPacket> mScratch;
+};
+
+#endif //VULKANRENDERINGENGINE_RENDER_QUEUE_HPP
@@ -9,14 +9,191 @@ namespace ImGuizmo
     void DecomposeMatrixToComponents(const float* matrix, float* translation, float* rotation, float* scale);
 }
 
+static uint32_t importThreadCount(const SaveData& saveData)
+{
+    uint32_t defaultCount = std::max(std::thread::hardware_concurrency() / 2, 1u);
+    return saveData.value("importThreads", defaultCount);
+}
+
+// the main thread works alongside the pool during the scene update
+static uint32_t sceneUpdateThreadCount(const SaveData& saveData)
+{
+    uint32_t defaultCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    return saveData.value("sceneUpdateThreads", defaultCount);
+}
+
+static uint32_t allFramesDirty(const VulkanRenderDevice& renderDevice)
+{
+    return (1u << renderDevice.framesInFlight) - 1;
+}
+
+// computing the normal matrix makes an instance a lot heavier than a transform
+static constexpr uint32_t sInstanceBatchSize = 256;
+// every caster is tested against every shadow view
+static constexpr uint32_t sShadowCasterBatchSize = 16;
+
+static VkImageMemoryBarrier shadowMapBarrier(const VulkanImage& image,
+                                             VkImageLayout oldLayout, VkImageLayout newLayout,
+                                             VkAccessFlags srcAccess, VkAccessFlags dstAccess)
+{
+    return {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = srcAccess,
+        .dstAccessMask = dstAccess,
+        .oldLayout = oldLayout,
+        .newLayout = newLayout,
+        .image = image.image,
+        .subresourceRange {
+            .aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT,
+            .baseMipLevel = 0,
+            .levelCount = 1,
+            .baseArrayLayer = 0,
+            .layerCount = image.layerCount
+        }
+    };
+}
+
+// the static shadow map has the same layout as the shadow map, so a face sits at the same place in both
+static VkImageCopy shadowCopyRegion(const ShadowViewTarget& target)
+{
+    return {
+        .srcSubresource = {VK_IMAGE_ASPECT_DEPTH_BIT, 0, target.layer, 1},
+        .srcOffset = {target.rect.offset.x, target.rect.offset.y, 0},
+        .dstSubresource = {VK_IMAGE_ASPECT_DEPTH_BIT, 0, target.layer, 1},
+        .dstOffset = {target.rect.offset.x, target.rect.offset.y, 0},
+        .extent = {target.rect.extent.width, target.rect.extent.height, 1}
+    };
+}
+
+// static shadow maps stay in transfer src, shadow maps go back to the layout the shadow passes leave them in.
+// faces share layers with other faces in the atlas, so the barriers keep the contents
+static void cacheStaticShadows(VkCommandBuffer commandBuffer,
+                               const VulkanImage& shadowMap,
+                               const VulkanImage& staticShadowMap,
+                               const std::vector<VkImageCopy>& regions)
+{
+    std::array<VkImageMemoryBarrier, 2> copyBarriers {
+        shadowMapBarrier(shadowMap,
+                         VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                         VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT),
+        shadowMapBarrier(staticShadowMap,
+                         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                         VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT)
+    };
+
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 0, nullptr, 0, nullptr,
+                         copyBarriers.size(), copyBarriers.data());
+
+    vkCmdCopyImage(commandBuffer,
+                   shadowMap.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                   staticShadowMap.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                   regions.size(), regions.data());
+
+    std::array<VkImageMemoryBarrier, 2> doneBarriers {
+        shadowMapBarrier(shadowMap,
+                         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+                         0, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT),
+        shadowMapBarrier(staticShadowMap,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                         VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT)
+    };
+
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 0, nullptr, 0, nullptr,
+                         doneBarriers.size(), doneBarriers.data());
+}
+
+static void restoreStaticShadows(VkCommandBuffer commandBuffer,
+                                 const VulkanImage& shadowMap,
+                                 const VulkanImage& staticShadowMap,
+                                 const std::vector<VkImageCopy>& regions)
+{
+    // the previous frame only has to be done sampling it
+    VkImageMemoryBarrier copyBarrier = shadowMapBarrier(shadowMap,
+                                                        VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                                        0, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 0, nullptr, 0, nullptr,
+                         1, &copyBarrier);
+
+    vkCmdCopyImage(commandBuffer,
+                   staticShadowMap.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                   shadowMap.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                   regions.size(), regions.data());
+
+    VkImageMemoryBarrier doneBarrier = shadowMapBarrier(shadowMap,
+                                                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+                                                        VK_ACCESS_TRANSFER_WRITE_BIT,
+                                                        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
+
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                         0, 0, nullptr, 0, nullptr,
+                         1, &doneBarrier);
+}
+
+// tile in texels to the rect the forward shader reads it with
+static glm::vec4 shadowAtlasRect(const ShadowAtlasTile& tile, uint32_t atlasResolution)
+{
+    float texelSize = 1.f / static_cast<float>(atlasResolution);
+
+    return {
+        static_cast<float>(tile.x) * texelSize,
+        static_cast<float>(tile.y) * texelSize,
+        static_cast<float>(tile.size) * texelSize,
+        static_cast<float>(tile.page)
+    };
+}
+
 Renderer::Renderer(const VulkanRenderDevice& renderDevice, SaveData& saveData)
     : mRenderDevice(renderDevice)
     , mSaveData(saveData)
     , mSceneGraph(std::make_shared<SceneGraph>())
     , mWidth(InitialViewportWidth)
     , mHeight(InitialViewportHeight)
-    , mCameraUBO(renderDevice, sizeof(CameraRenderData), BufferType::Uniform, MemoryType::HostCoherent)
+    , mFrameIndex()
+    , mFrameTimings()
+    , mCullingStats()
+    , mCameraUBOs(renderDevice.framesInFlight)
+    , mCullingReferenceReady(renderDevice.framesInFlight)
+    , mLightGridSSBOs(renderDevice.framesInFlight)
+    , mLightIndexSSBOs(renderDevice.framesInFlight)
+    , mClusterLightSSBOs(renderDevice.framesInFlight)
+    , mLightBinSSBOs(renderDevice.framesInFlight)
+    , mBinnedLightSSBOs(renderDevice.framesInFlight)
+    , mClusterFlagsSSBOs(renderDevice.framesInFlight)
+    , mActiveClustersSSBOs(renderDevice.framesInFlight)
+    , mCameraDs(renderDevice.framesInFlight)
+    , mLightsDs(renderDevice.framesInFlight)
+    , mAssignLightsToClustersDs(renderDevice.framesInFlight)
+    , mActiveClustersDs(renderDevice.framesInFlight)
+    , mForwardShadingDs(renderDevice.framesInFlight)
+    , mDirLightSSBOs(renderDevice.framesInFlight)
+    , mPointLightSSBOs(renderDevice.framesInFlight)
+    , mSpotLightSSBOs(renderDevice.framesInFlight)
+    , mLightsDirtyFrames(allFramesDirty(renderDevice))
+    , mShadowAtlasStats()
+    , mDirShadowDataSSBOs(renderDevice.framesInFlight)
+    , mPointShadowDataSSBOs(renderDevice.framesInFlight)
+    , mSpotShadowDataSSBOs(renderDevice.framesInFlight)
+    , mShadowDataDirtyFrames(allFramesDirty(renderDevice))
+    , mFirstPointShadowView()
+    , mFirstSpotShadowView()
+    , mSceneUpdateThreadPool(sceneUpdateThreadCount(saveData), "Scene Update")
+    , mImportThreadPool(importThreadCount(saveData), "Model Import")
+    , mImportTimer(false)
+    , mImportBatchSize()
     , mTonemap(Tonemap::ReinhardExtended)
+    , mShadowScheduleStats()
 {
     if (saveData.contains("viewport"))
     {
@@ -30,6 +207,7 @@ Renderer::Renderer(const VulkanRenderDevice& renderDevice, SaveData& saveData)
                      static_cast<float>(mHeight));
 
     createDefaultMaterialTextures(mRenderDevice);
+    createCameraUBOs();
 
     createColorTexture32MS();
     createDepthTextures();
@@ -45,29 +223,39 @@ Renderer::Renderer(const VulkanRenderDevice& renderDevice, SaveData& saveData)
     createOitResourcesDsLayout();
     createSingleInputAttachmentDsLayout();
     createLightsDsLayout();
+    createCullInstancesDsLayout();
     createFrustumClusterGenDsLayout();
     createAssignLightsToClustersDsLayout();
+    createActiveClustersDsLayout();
     createForwardShadingDsLayout();
     createPostProcessingDsLayout();
 
     createShadowMapBuffers();
     createShadowMapSamplers();
-    createSpotShadowRenderpass();
+    createShadowRenderpass();
+    createShadowAtlas();
     createSpotShadowPipeline();
-    createDirShadowRenderpass();
     createDirShadowPipeline();
-    createPointShadowRenderpass();
     createPointShadowPipeline();
 
     createPrepassRenderpass();
     createPrepassFramebuffer();
     createPrepassPipeline();
 
+    createCullInstancesPipelineLayout();
+    createCullInstancesPipeline();
+
     createVolumeClusterSSBO();
+    createClusterLightSSBOs();
+    createLightGridSSBO();
+    createLightIndexSSBO(mClusterGridSize.x * mClusterGridSize.y * mClusterGridSize.z * InitialLightsPerCluster);
+    createActiveClusterSSBOs();
     createFrustumClusterGenPipelineLayout();
     createFrustumClusterGenPipeline();
     createAssignLightsToClustersPipelineLayout();
     createAssignLightsToClustersPipeline();
+    createActiveClustersPipelineLayout();
+    createActiveClustersPipelines();
 
     createSkyboxRenderpass();
     createSkyboxFramebuffer();
@@ -152,11 +340,15 @@ Renderer::Renderer(const VulkanRenderDevice& renderDevice, SaveData& saveData)
     createSsaoDs();
     createLightsDs();
     createFrustumClusterGenDs();
+    createActiveClustersDs();
+    updateActiveClustersDs();
     createAssignLightsToClustersDs();
     createForwardShadingDs();
     updateForwardShadingDs();
     createPostProcessingDs();
 
+    mMaterialTable = MaterialTable(mRenderDevice, mMaterialsDsLayout);
+
     importModels();
 }
 
@@ -168,11 +360,16 @@ Renderer::~Renderer()
     vkDestroySampler(mRenderDevice.device, mPointShadowMapSampler.sampler, nullptr);
     vkDestroySampler(mRenderDevice.device, mSpotShadowMapSampler.sampler, nullptr);
 
+    vkDestroyPipeline(mRenderDevice.device, mCullInstancesPipeline, nullptr);
     vkDestroyPipeline(mRenderDevice.device, mFrustumClusterGenPipeline, nullptr);
     vkDestroyPipeline(mRenderDevice.device, mAssignLightsToClustersPipeline, nullptr);
+    vkDestroyPipeline(mRenderDevice.device, mFlagActiveClustersPipeline, nullptr);
+    vkDestroyPipeline(mRenderDevice.device, mCompactActiveClustersPipeline, nullptr);
 
+    vkDestroyPipelineLayout(mRenderDevice.device, mCullInstancesPipelineLayout, nullptr);
     vkDestroyPipelineLayout(mRenderDevice.device, mFrustumClusterGenPipelineLayout, nullptr);
     vkDestroyPipelineLayout(mRenderDevice.device, mAssignLightsToClustersPipelineLayout, nullptr);
+    vkDestroyPipelineLayout(mRenderDevice.device, mActiveClustersPipelineLayout, nullptr);
 
     vkDestroyFramebuffer(mRenderDevice.device, mPrepassFramebuffer, nullptr);
     vkDestroyFramebuffer(mRenderDevice.device, mSkyboxFramebuffer, nullptr);
@@ -196,13 +393,8 @@ Renderer::~Renderer()
     for (auto fb : mBloomUpsampleFramebuffers)
         vkDestroyFramebuffer(mRenderDevice.device, fb, nullptr);
     for (auto& shadowMap : mDirShadowMaps)
-        for (auto& fb : shadowMap.framebuffers)
-            vkDestroyFramebuffer(mRenderDevice.device, fb, nullptr);
-    for (auto& shadowMap : mPointShadowMaps)
-        for (auto & framebuffer : shadowMap.framebuffers)
-            vkDestroyFramebuffer(mRenderDevice.device, framebuffer, nullptr);
-    for (auto& shadowMap : mSpotShadowMaps)
         vkDestroyFramebuffer(mRenderDevice.device, shadowMap.framebuffer, nullptr);
+    vkDestroyFramebuffer(mRenderDevice.device, mShadowAtlasFramebuffer, nullptr);
 
     vkDestroyRenderPass(mRenderDevice.device, mPrepassRenderpass, nullptr);
     vkDestroyRenderPass(mRenderDevice.device, mSkyboxRenderpass, nullptr);
@@ -219,27 +411,47 @@ Renderer::~Renderer()
     vkDestroyRenderPass(mRenderDevice.device, mCaptureBrightPixelsRenderpass, nullptr);
     vkDestroyRenderPass(mRenderDevice.device, mBloomDownsampleRenderpass, nullptr);
     vkDestroyRenderPass(mRenderDevice.device, mBloomUpsampleRenderpass, nullptr);
-    vkDestroyRenderPass(mRenderDevice.device, mDirShadowRenderpass, nullptr);
-    vkDestroyRenderPass(mRenderDevice.device, mPointShadowRenderpass, nullptr);
-    vkDestroyRenderPass(mRenderDevice.device, mSpotShadowRenderpass, nullptr);
+    vkDestroyRenderPass(mRenderDevice.device, mShadowRenderpass, nullptr);
     vkDestroyRenderPass(mRenderDevice.device, mWireframeRenderpass, nullptr);
     vkDestroyRenderPass(mRenderDevice.device, mSsaoResourcesRenderpass, nullptr);
 }
 
 void Renderer::update()
 {
+    PROFILE_ZONE("Renderer::update");
+
     updateImports();
     updateCameraUBO();
     updateSceneGraph();
+    syncInstanceBuffers();
+    cullInstances();
     updateDirShadowsMaps();
+    allocateShadowAtlas();
+    cullShadowCasters();
+    scheduleShadowUpdates();
+    syncLightBuffers();
+    mMaterialTable.sync(mFrameIndex);
+    updateClusterLights();
     sortTransparentMeshes();
+    buildRenderQueues();
+}
+
+void Renderer::beginFrame(uint32_t frameIndex, float cpuMs, float fenceWaitMs)
+{
+    mFrameIndex = frameIndex;
+    mFrameTimings.cpuMs = cpuMs;
+    mFrameTimings.gpuMs = mRenderDevice.gpuProfiler->frameMs();
+    mFrameTimings.fenceWaitMs = fenceWaitMs;
 }
 
 void Renderer::render(VkCommandBuffer commandBuffer)
 {
+    PROFILE_ZONE("Renderer::render");
+
+    discardRenderTargets(commandBuffer);
+    executeCullInstancesRenderpass(commandBuffer);
     executeDirShadowRenderpass(commandBuffer);
-    executePointShadowRenderpass(commandBuffer);
-    executeSpotShadowRenderpass(commandBuffer);
+    executeShadowAtlasRenderpass(commandBuffer);
     setViewport(commandBuffer);
     executePrepass(commandBuffer);
     executeSkyboxRenderpass(commandBuffer);
@@ -247,6 +459,7 @@ void Renderer::render(VkCommandBuffer commandBuffer)
     executeSsaoRenderpass(commandBuffer);
     executeSsaoBlurRenderpass(commandBuffer);
     executeGenFrustumClustersRenderpass(commandBuffer);
+    executeActiveClustersRenderpass(commandBuffer);
     executeAssignLightsToClustersRenderpass(commandBuffer);
     executeForwardRenderpass(commandBuffer);
     executeBloomRenderpass(commandBuffer);
@@ -268,15 +481,25 @@ void Renderer::importModel(const ModelImportData& importData)
         return;
     }
 
-    auto future = std::async(std::launch::async, [importData] () {
-        return ModelLoader(importData);
+    if (mModelDataFutures.empty())
+    {
+        mImportTimer.begin();
+        mImportBatchSize = 0;
+    }
+
+    auto future = mImportThreadPool.submit([this, importData] () {
+        return ModelLoader(importData, &mImportThreadPool);
     });
 
     mModelDataFutures.push_back(std::move(future));
+    ++mImportBatchSize;
 }
 
 void Renderer::importEnvMap(const std::string& path)
 {
+    // the frames in flight still sample the current environment map
+    vkDeviceWaitIdle(mRenderDevice.device);
+
     createEquirectangularTexture(path);
     createEnvMap();
     createSkyboxDs();
@@ -292,6 +515,9 @@ void Renderer::importEnvMap(const std::string& path)
 
 void Renderer::resize(uint32_t width, uint32_t height)
 {
+    // render targets are about to be recreated under the frames in flight
+    vkDeviceWaitIdle(mRenderDevice.device);
+
     mWidth = width;
     mHeight = height;
 
@@ -334,26 +560,37 @@ void Renderer::resize(uint32_t width, uint32_t height)
     createSingleImageDescriptorSets();
     createSsaoDs();
     updateForwardShadingDs();
+    updateActiveClustersDs();
     createBloomMipChainDs();
     createPostProcessingDs();
 }
 
 void Renderer::addDirLight(uuid32_t id, const DirectionalLight& light, const DirShadowData& shadowData)
 {
-    addLight(mUuidToDirLightIndex, mDirLights, mDirLightSSBO, id, light);
+    // writes into the lights descriptor sets, which the frames in flight are bound to
+    vkDeviceWaitIdle(mRenderDevice.device);
+
+    addLight(mUuidToDirLightIndex, mDirLights, id, light);
     addDirShadowMap(shadowData);
+    mLightsDirtyFrames = allFramesDirty(mRenderDevice);
 }
 
 void Renderer::addPointLight(uuid32_t id, const PointLight& light, const PointShadowData& shadowData)
 {
-    addLight(mUuidToPointLightIndex, mPointLights, mPointLightSSBO, id, light);
+    vkDeviceWaitIdle(mRenderDevice.device);
+
+    addLight(mUuidToPointLightIndex, mPointLights, id, light);
     addPointShadowMap(shadowData);
+    mLightsDirtyFrames = allFramesDirty(mRenderDevice);
 }
 
 void Renderer::addSpotLight(uuid32_t id, const SpotLight& light, const SpotShadowData& shadowData)
 {
-    addLight(mUuidToSpotLightIndex, mSpotLights, mSpotLightSSBO, id, light);
+    vkDeviceWaitIdle(mRenderDevice.device);
+
+    addLight(mUuidToSpotLightIndex, mSpotLights, id, light);
     addSpotShadowMap(shadowData);
+    mLightsDirtyFrames = allFramesDirty(mRenderDevice);
 }
 
 DirectionalLight &Renderer::getDirLight(uuid32_t id)
@@ -373,331 +610,455 @@ SpotLight &Renderer::getSpotLight(uuid32_t id)
 
 void Renderer::updateDirLight(uuid32_t id)
 {
-    updateLight(mUuidToDirLightIndex, mDirLights, mDirLightSSBO, id);
+    mLightsDirtyFrames = allFramesDirty(mRenderDevice);
 }
 
 void Renderer::updatePointLight(uuid32_t id)
 {
-    updateLight(mUuidToPointLightIndex, mPointLights, mPointLightSSBO, id);
+    mLightsDirtyFrames = allFramesDirty(mRenderDevice);
 
-    // update shadow map
+    // update shadow map, the cached faces were drawn from the old position and range
     index_t i = mUuidToPointLightIndex.at(id);
     calcMatrices(mPointShadowData.at(i), mPointLights.at(i));
-    mPointShadowDataSSBO.update(i * sizeof(PointShadowData), sizeof(PointShadowData), &mPointShadowData.at(i));
+    mShadowDataDirtyFrames = allFramesDirty(mRenderDevice);
+
+    for (ShadowCache& cache : mPointShadowMaps.at(i).caches)
+        cache.valid = false;
 }
 
 void Renderer::updateSpotLight(uuid32_t id)
 {
-    updateLight(mUuidToSpotLightIndex, mSpotLights, mSpotLightSSBO, id);
+    mLightsDirtyFrames = allFramesDirty(mRenderDevice);
 
     // update shadow map
     index_t i = mUuidToSpotLightIndex.at(id);
     calcMatrices(mSpotShadowData.at(i), mSpotLights.at(i));
-    mSpotShadowDataSSBO.update(i * sizeof(SpotShadowData), sizeof(SpotShadowData), &mSpotShadowData.at(i));
+    mShadowDataDirtyFrames = allFramesDirty(mRenderDevice);
+
+    mSpotShadowMaps.at(i).cache.valid = false;
 }
 
 void Renderer::deleteDirLight(uuid32_t id)
 {
+    // the shadow map is destroyed and the lights descriptor sets rewritten
+    vkDeviceWaitIdle(mRenderDevice.device);
+
     deleteDirShadowMap(id);
-    deleteLight(mUuidToDirLightIndex, mDirLights, mDirLightSSBO, id);
+    deleteLight(mUuidToDirLightIndex, mDirLights, id);
+    mLightsDirtyFrames = allFramesDirty(mRenderDevice);
 }
 
 void Renderer::deletePointLight(uuid32_t id)
 {
+    vkDeviceWaitIdle(mRenderDevice.device);
+
     deletePointShadowMap(id);
-    deleteLight(mUuidToPointLightIndex, mPointLights, mPointLightSSBO, id);
+    deleteLight(mUuidToPointLightIndex, mPointLights, id);
+    mLightsDirtyFrames = allFramesDirty(mRenderDevice);
 }
 
 void Renderer::deleteSpotLight(uuid32_t id)
 {
+    vkDeviceWaitIdle(mRenderDevice.device);
+
     deleteSpotShadowMap(id);
-    deleteLight(mUuidToSpotLightIndex, mSpotLights, mSpotLightSSBO, id);
+    deleteLight(mUuidToSpotLightIndex, mSpotLights, id);
+    mLightsDirtyFrames = allFramesDirty(mRenderDevice);
+}
+
+// the render targets are shared by the frames in flight. the passes that draw into them first start from the
+// attachment layout, these barriers wait for the previous frame to be done with each target and discard it
+void Renderer::discardRenderTargets(VkCommandBuffer commandBuffer)
+{
+    auto discardBarrier = [] (const VulkanImage& image, bool depth) {
+        VkAccessFlags access = depth? VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT : VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+        return VkImageMemoryBarrier {
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .srcAccessMask = access,
+            .dstAccessMask = access,
+            .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .newLayout = depth? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            .image = image.image,
+            .subresourceRange {
+                .aspectMask = image.imageAspect,
+                .baseMipLevel = 0,
+                .levelCount = image.mipLevels,
+                .baseArrayLayer = 0,
+                .layerCount = image.layerCount
+            }
+        };
+    };
+
+    std::vector<VkImageMemoryBarrier> barriers {
+        discardBarrier(mDepthTextureMS, true),
+        discardBarrier(mColorTexture32MS, false),
+        discardBarrier(mNormalTexture, false),
+        discardBarrier(mViewPosTexture, false),
+        discardBarrier(mDepthTexture, true),
+        discardBarrier(mSsaoTexture, false),
+        discardBarrier(mSsaoBlurTexture1, false),
+        discardBarrier(mSsaoBlurTexture2, false),
+        discardBarrier(mColorTexture8U, false)
+    };
+
+    for (const VulkanTexture& mip : mBloomMipChain)
+        barriers.push_back(discardBarrier(mip, false));
+
+    // the targets are read as attachments, sampled by the fragment shaders and the depth by the active clusters pass
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                            VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+                            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                            VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+                            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                         0,
+                         0, nullptr,
+                         0, nullptr,
+                         static_cast<uint32_t>(barriers.size()), barriers.data());
 }
 
-void Renderer::executeDirShadowRenderpass(VkCommandBuffer commandBuffer)
+void Renderer::executeCullInstancesRenderpass(VkCommandBuffer commandBuffer)
 {
-    beginDebugLabel(commandBuffer, "Gen Dir Shadows Maps");
+    if (!mGpuCulling)
+        return;
 
-    constexpr VkClearValue depthClear {.depthStencil = {.depth = 1.f, .stencil = 0}};
-    for (uint32_t i = 0; i < mDirLights.size(); ++i)
-    {
-        const DirShadowData& dsd = mDirShadowData.at(i);
-        if (dsd.shadowType == ShadowType::NoShadow)
-            continue;
+    beginDebugLabel(commandBuffer, "Cull Instances");
 
-        uint32_t resolution = dsd.resolution;
-        VkRenderPassBeginInfo renderPassBeginInfo {
-            .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-            .renderPass = mDirShadowRenderpass,
-            .framebuffer = VK_NULL_HANDLE,
-            .renderArea = {
-                .offset = {.x = 0, .y = 0},
-                .extent = {
-                    .width = resolution,
-                    .height = resolution
-                }
-            },
-            .clearValueCount = 1,
-            .pClearValues = &depthClear
-        };
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mCullInstancesPipeline);
 
-        VkViewport viewport {
-            .x = 0.f,
-            .y = 0.f,
-            .width = static_cast<float>(resolution),
-            .height = static_cast<float>(resolution),
-            .minDepth = 0.f,
-            .maxDepth = 1.f
-        };
+    vkCmdBindDescriptorSets(commandBuffer,
+                            VK_PIPELINE_BIND_POINT_COMPUTE,
+                            mCullInstancesPipelineLayout,
+                            0, 1, &mCameraDs.at(mFrameIndex),
+                            0, nullptr);
 
-        VkRect2D scissor {
-            .offset = {.x = 0, .y = 0},
-            .extent = {
-                .width = resolution,
-                .height = resolution
-            }
-        };
+    for (const auto& [id, model] : mModels)
+        for (const auto& mesh : model.meshes)
+            mesh.mesh.dispatchCull(commandBuffer, mCullInstancesPipelineLayout, mFrameIndex);
 
-        for (uint32_t ii = 0; ii < dsd.cascadeCount; ++ii)
-        {
-            renderPassBeginInfo.framebuffer = mDirShadowMaps.at(i).framebuffers.at(ii);
+    // the host reads the instance counts back once the frame's fence signals
+    VkMemoryBarrier memoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_HOST_READ_BIT
+    };
 
-            std::string debugLabel = std::format("Shadow map {}, cascade {}", i, ii);
-            insertDebugLabel(commandBuffer, debugLabel.data());
-            vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-            vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
-            vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
-            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mDirShadowPipeline);
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+                         0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
 
-            vkCmdPushConstants(commandBuffer,
-                               mDirShadowPipeline,
-                               VK_SHADER_STAGE_VERTEX_BIT,
-                               0, sizeof(glm::mat4),
-                               glm::value_ptr(dsd.viewProj[ii]));
+    endDebugLabel(commandBuffer);
+}
 
-            for (const auto& [id, model] : mModels)
-            {
-                // cull front face to prevent peter panning
-                pfnCmdSetCullModeEXT(commandBuffer, VK_CULL_MODE_FRONT_BIT);
-                pfnCmdSetFrontFaceEXT(commandBuffer, model.frontFace);
+void Renderer::renderCulled(VkCommandBuffer commandBuffer, const InstancedMesh &mesh) const
+{
+    if (mGpuCulling)
+        mesh.renderIndirect(commandBuffer, mFrameIndex);
+    else
+        mesh.renderVisible(commandBuffer, mFrameIndex);
+}
 
-                for (const auto& mesh : model.meshes)
-                    if (model.drawOpaque(mesh))
-                        mesh.mesh.render(commandBuffer);
-            }
+void Renderer::recordRenderQueue(VkCommandBuffer commandBuffer,
+                                 RenderQueuePass pass,
+                                 VkPipelineLayout pipelineLayout,
+                                 std::optional<uint32_t> materialOffset)
+{
+    RenderQueueStats& stats = mRenderQueueStats.at(static_cast<uint32_t>(pass));
+    stats.draws = 0;
+    stats.rasterStateChanges = 0;
+    stats.materialChanges = 0;
+
+    std::optional<DrawKey> previous;
+
+    for (const DrawPacket& packet : mRenderQueues.at(static_cast<uint32_t>(pass)).packets())
+    {
+        DrawKey key = unpackDrawKey(packet.key);
+
+        if (!previous || key.rasterState != previous->rasterState)
+        {
+            pfnCmdSetCullModeEXT(commandBuffer, key.rasterState & 0x3);
+            pfnCmdSetFrontFaceEXT(commandBuffer, static_cast<VkFrontFace>(key.rasterState >> 2));
+            ++stats.rasterStateChanges;
+        }
 
-            vkCmdEndRenderPass(commandBuffer);
+        if (materialOffset && (!previous || key.material != previous->material))
+        {
+            vkCmdPushConstants(commandBuffer,
+                               pipelineLayout,
+                               VK_SHADER_STAGE_FRAGMENT_BIT,
+                               *materialOffset, sizeof(uint32_t),
+                               &key.material);
+            ++stats.materialChanges;
         }
-    }
 
-    endDebugLabel(commandBuffer);
+        renderCulled(commandBuffer, *mQueuedMeshes.at(packet.item));
+        ++stats.draws;
+
+        previous = key;
+    }
 }
 
-void Renderer::executePointShadowRenderpass(VkCommandBuffer commandBuffer)
+void Renderer::executeDirShadowRenderpass(VkCommandBuffer commandBuffer)
 {
-    beginDebugLabel(commandBuffer, "Gen Point Shadow Maps");
+    beginDebugLabel(commandBuffer, "Gen Dir Shadows Maps");
 
-    constexpr VkClearValue depthClear {.depthStencil = {.depth = 1.f, .stencil = 0}};
-    for (uint32_t i = 0; i < mPointLights.size(); ++i)
+    // the cascades of a light are next to each other in the views
+    for (uint32_t view = 0; view < mFirstPointShadowView;)
     {
-        const PointShadowData& psd = mPointShadowData.at(i);
-        if (psd.shadowType == ShadowType::NoShadow)
-            continue;
-
-        uint32_t resolution = psd.resolution;
-        VkRenderPassBeginInfo renderPassBeginInfo {
-            .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-            .renderPass = mPointShadowRenderpass,
-            .framebuffer = VK_NULL_HANDLE,
-            .renderArea = {
-                .offset = {.x = 0, .y = 0},
-                .extent = {
-                    .width = resolution,
-                    .height = resolution
-                }
-            },
-            .clearValueCount = 1,
-            .pClearValues = &depthClear
-        };
-
-        VkViewport viewport {
-            .x = 0.f,
-            .y = 0.f,
-            .width = static_cast<float>(resolution),
-            .height = static_cast<float>(resolution),
-            .minDepth = 0.f,
-            .maxDepth = 1.f
-        };
+        index_t i = mShadowViewStats.at(view).lightIndex;
+        const DirShadowData& dsd = mDirShadowData.at(i);
+        const DirShadowMap& shadowMap = mDirShadowMaps.at(i);
 
-        VkRect2D scissor {
+        VkRect2D rect {
             .offset = {.x = 0, .y = 0},
             .extent = {
-                .width = resolution,
-                .height = resolution
+                .width = dsd.resolution,
+                .height = dsd.resolution
             }
         };
 
-        for (uint32_t ii = 0; ii < 6; ++ii)
-        {
-            renderPassBeginInfo.framebuffer = mPointShadowMaps.at(i).framebuffers[ii];
-
-            std::string debugLabel = std::format("Shadow map {}, face {}", i, ii);
-            insertDebugLabel(commandBuffer, debugLabel.data());
-            vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-            vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
-            vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
-            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mPointShadowPipeline);
+        std::vector<ShadowViewTarget> targets;
+        for (uint32_t cascade = 0; cascade < dsd.cascadeCount; ++cascade, ++view)
+            targets.push_back({view, cascade, rect, dsd.viewProj[cascade], &mDirShadowPipeline});
+
+        std::string debugLabel = std::format("Shadow map {}", i);
+        insertDebugLabel(commandBuffer, debugLabel.data());
+        executeShadowMapUpdate(commandBuffer,
+                               shadowMap.shadowMap,
+                               shadowMap.staticShadowMap,
+                               shadowMap.framebuffer,
+                               dsd.resolution,
+                               targets);
+    }
 
-            vkCmdPushConstants(commandBuffer,
-                               mPointShadowPipeline,
-                               VK_SHADER_STAGE_VERTEX_BIT,
-                               0, sizeof(glm::mat4),
-                               glm::value_ptr(psd.viewProj[ii]));
-
-            struct {
-                glm::vec4 lightPos;
-                float nearPlane;
-                float farPlane;
-            } fragPushConst {
-                mPointLights.at(i).position,
-                0.1f,
-                mPointLights.at(i).range
-            };
+    endDebugLabel(commandBuffer);
+}
 
-            vkCmdPushConstants(commandBuffer,
-                               mPointShadowPipeline,
-                               VK_SHADER_STAGE_FRAGMENT_BIT,
-                               sizeof(glm::mat4), sizeof(fragPushConst),
-                               &fragPushConst);
+void Renderer::executeShadowAtlasRenderpass(VkCommandBuffer commandBuffer)
+{
+    beginDebugLabel(commandBuffer, "Gen Shadow Atlas");
 
-            for (const auto& [id, model] : mModels)
-            {
-                // cull front face to prevent peter panning
-                pfnCmdSetCullModeEXT(commandBuffer, VK_CULL_MODE_FRONT_BIT);
-                pfnCmdSetFrontFaceEXT(commandBuffer, model.frontFace);
+    auto tileRect = [] (const ShadowAtlasTile& tile) {
+        return VkRect2D {
+            .offset = {.x = static_cast<int32_t>(tile.x), .y = static_cast<int32_t>(tile.y)},
+            .extent = {.width = tile.size, .height = tile.size}
+        };
+    };
 
-                for (const auto& mesh : model.meshes)
-                    if (model.drawOpaque(mesh))
-                        mesh.mesh.render(commandBuffer);
-            }
+    // every point light face and spot light with a tile, all in one pass
+    std::vector<ShadowViewTarget> targets;
+    for (uint32_t view = mFirstPointShadowView; view < mShadowViewStats.size(); ++view)
+    {
+        const ShadowViewStats& viewStats = mShadowViewStats.at(view);
+        index_t i = viewStats.lightIndex;
 
-            vkCmdEndRenderPass(commandBuffer);
+        if (viewStats.lightType == LightType::Point)
+        {
+            const ShadowAtlasTile& tile = mPointShadowMaps.at(i).tiles[viewStats.face];
+            const glm::mat4& viewProj = mPointShadowData.at(i).viewProj[viewStats.face];
+            targets.push_back({view, tile.page, tileRect(tile), viewProj, &mPointShadowPipeline});
+        }
+        else
+        {
+            const ShadowAtlasTile& tile = mSpotShadowMaps.at(i).tile;
+            const glm::mat4& viewProj = mSpotShadowData.at(i).viewProj;
+            targets.push_back({view, tile.page, tileRect(tile), viewProj, &mSpotShadowPipeline});
         }
     }
 
+    executeShadowMapUpdate(commandBuffer,
+                           mShadowAtlas,
+                           mStaticShadowAtlas,
+                           mShadowAtlasFramebuffer,
+                           mShadowAtlasResolution,
+                           targets);
+
     endDebugLabel(commandBuffer);
 }
 
-void Renderer::executeSpotShadowRenderpass(VkCommandBuffer commandBuffer)
+// All the views of a shadow map or atlas are drawn in a single render pass, each into its own rect of the layer the
+// vertex shader picks. The pass loads the old contents so cached views survive, the redrawn ones are cleared in it.
+// Copies can't be recorded inside a render pass, so restoring the static casters happens before it and caching
+// them after it, with a second pass for the dynamic casters of the views that were cached.
+void Renderer::executeShadowMapUpdate(VkCommandBuffer commandBuffer,
+                                      const VulkanImage& shadowMap,
+                                      const VulkanImage& staticShadowMap,
+                                      VkFramebuffer framebuffer,
+                                      uint32_t resolution,
+                                      const std::vector<ShadowViewTarget>& targets)
 {
-    beginDebugLabel(commandBuffer, "Generate Spot Shadow Maps");
+    std::vector<VkImageCopy> restoreRegions;
+    std::vector<VkImageCopy> cacheRegions;
+    bool redraw = false;
+    bool drawDynamic = false;
 
-    constexpr VkClearValue depthClear {.depthStencil = {.depth = 1.f, .stencil = 0}};
-    for (uint32_t i = 0; i < mSpotLights.size(); ++i)
+    for (const ShadowViewTarget& target : targets)
     {
-        if (mSpotShadowData.at(i).shadowType == ShadowType::NoShadow)
-            continue;
+        const ShadowViewStats& viewStats = mShadowViewStats.at(target.view);
 
-        uint32_t resolution = mSpotShadowData.at(i).resolution;
+        if (viewStats.update == ShadowViewUpdate::Dynamic)
+            restoreRegions.push_back(shadowCopyRegion(target));
 
-        VkRenderPassBeginInfo renderPassBeginInfo {
-            .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-            .renderPass = mSpotShadowRenderpass,
-            .framebuffer = mSpotShadowMaps.at(i).framebuffer,
-            .renderArea = {
-                .offset = {.x = 0, .y = 0},
-                .extent = {
-                    .width = resolution,
-                    .height = resolution
-                }
-            },
-            .clearValueCount = 1,
-            .pClearValues = &depthClear
-        };
+        if (viewStats.update == ShadowViewUpdate::Cache)
+        {
+            cacheRegions.push_back(shadowCopyRegion(target));
+            drawDynamic |= viewStats.dynamicInstances > 0;
+        }
 
-        VkViewport viewport {
-            .x = 0.f,
-            .y = 0.f,
-            .width = static_cast<float>(resolution),
-            .height = static_cast<float>(resolution),
-            .minDepth = 0.f,
-            .maxDepth = 1.f
-        };
+        redraw |= viewStats.update != ShadowViewUpdate::Skip;
+    }
 
-        VkRect2D scissor {
+    if (!redraw)
+        return;
+
+    if (!restoreRegions.empty())
+        restoreStaticShadows(commandBuffer, shadowMap, staticShadowMap, restoreRegions);
+
+    VkRenderPassBeginInfo renderPassBeginInfo {
+        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+        .renderPass = mShadowRenderpass,
+        .framebuffer = framebuffer,
+        .renderArea = {
             .offset = {.x = 0, .y = 0},
             .extent = {
                 .width = resolution,
                 .height = resolution
             }
+        }
+    };
+
+    auto setTarget = [commandBuffer] (const ShadowViewTarget& target) {
+        VkViewport viewport {
+            .x = static_cast<float>(target.rect.offset.x),
+            .y = static_cast<float>(target.rect.offset.y),
+            .width = static_cast<float>(target.rect.extent.width),
+            .height = static_cast<float>(target.rect.extent.height),
+            .minDepth = 0.f,
+            .maxDepth = 1.f
         };
-        
-        vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+
         vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
-        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
-        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mSpotShadowPipeline);
+        vkCmdSetScissor(commandBuffer, 0, 1, &target.rect);
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, *target.pipeline);
+    };
 
-        vkCmdPushConstants(commandBuffer,
-                   mSpotShadowPipeline,
-                   VK_SHADER_STAGE_VERTEX_BIT,
-                   0, sizeof(glm::mat4),
-                   glm::value_ptr(mSpotShadowData.at(i).viewProj));
+    vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+    for (const ShadowViewTarget& target : targets)
+    {
+        ShadowViewUpdate update = mShadowViewStats.at(target.view).update;
+
+        if (update == ShadowViewUpdate::Skip)
+            continue;
 
-        for (const auto& [id, model] : mModels)
+        setTarget(target);
+
+        if (update != ShadowViewUpdate::Dynamic)
         {
-            // cull front face to prevent peter panning
-            pfnCmdSetCullModeEXT(commandBuffer, VK_CULL_MODE_FRONT_BIT);
-            pfnCmdSetFrontFaceEXT(commandBuffer, model.frontFace);
+            VkClearAttachment clearAttachment {
+                .aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT,
+                .colorAttachment = 0,
+                .clearValue = {.depthStencil = {.depth = 1.f, .stencil = 0}}
+            };
+
+            VkClearRect clearRect {
+                .rect = target.rect,
+                .baseArrayLayer = target.layer,
+                .layerCount = 1
+            };
 
-            for (const auto& mesh : model.meshes)
-                if (model.drawOpaque(mesh))
-                    mesh.mesh.render(commandBuffer);
+            vkCmdClearAttachments(commandBuffer, 1, &clearAttachment, 1, &clearRect);
         }
 
-        vkCmdEndRenderPass(commandBuffer);
+        ShadowCasters casters = ShadowCasters::All;
+        if (update == ShadowViewUpdate::Cache) casters = ShadowCasters::Static;
+        if (update == ShadowViewUpdate::Dynamic) casters = ShadowCasters::Dynamic;
+
+        drawShadowView(commandBuffer, target, casters);
     }
 
-    endDebugLabel(commandBuffer);
-}
+    vkCmdEndRenderPass(commandBuffer);
 
-void Renderer::executePrepass(VkCommandBuffer commandBuffer)
-{
-    VkClearValue depthClear {.depthStencil = {.depth = 1.f, .stencil = 0}};
-    VkRenderPassBeginInfo renderPassBeginInfo {
-        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-        .renderPass = mPrepassRenderpass,
-        .framebuffer = mPrepassFramebuffer,
-        .renderArea = {
-            .offset = {.x = 0, .y = 0},
-            .extent = {
-                .width = mWidth,
-                .height = mHeight
-            }
-        },
-        .clearValueCount = 1,
-        .pClearValues = &depthClear
-    };
+    if (cacheRegions.empty())
+        return;
+
+    cacheStaticShadows(commandBuffer, shadowMap, staticShadowMap, cacheRegions);
+
+    if (!drawDynamic)
+        return;
 
-    beginDebugLabel(commandBuffer, "Prepass");
     vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mPrepassPipeline);
 
-    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                            mPrepassPipeline,
-                            0, 1, &mCameraDs,
-                            0, nullptr);
+    for (const ShadowViewTarget& target : targets)
+    {
+        if (mShadowViewStats.at(target.view).update == ShadowViewUpdate::Cache)
+        {
+            setTarget(target);
+            drawShadowView(commandBuffer, target, ShadowCasters::Dynamic);
+        }
+    }
+
+    vkCmdEndRenderPass(commandBuffer);
+}
+
+void Renderer::drawShadowView(VkCommandBuffer commandBuffer, const ShadowViewTarget& target, ShadowCasters casters)
+{
+    struct {
+        glm::mat4 viewProj;
+        uint32_t layer;
+    } pushConstants {target.viewProj, target.layer};
+
+    vkCmdPushConstants(commandBuffer,
+                       *target.pipeline,
+                       VK_SHADER_STAGE_VERTEX_BIT,
+                       0, sizeof(pushConstants),
+                       &pushConstants);
 
     for (const auto& [id, model] : mModels)
     {
-        pfnCmdSetCullModeEXT(commandBuffer, model.cullMode);
+        // cull front face to prevent peter panning
+        pfnCmdSetCullModeEXT(commandBuffer, VK_CULL_MODE_FRONT_BIT);
         pfnCmdSetFrontFaceEXT(commandBuffer, model.frontFace);
 
         for (const auto& mesh : model.meshes)
-        {
             if (model.drawOpaque(mesh))
-                mesh.mesh.render(commandBuffer);
-        }
+                mesh.mesh.renderShadowView(commandBuffer, mFrameIndex, target.view, casters);
     }
+}
+
+void Renderer::executePrepass(VkCommandBuffer commandBuffer)
+{
+    VkClearValue depthClear {.depthStencil = {.depth = 1.f, .stencil = 0}};
+    VkRenderPassBeginInfo renderPassBeginInfo {
+        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+        .renderPass = mPrepassRenderpass,
+        .framebuffer = mPrepassFramebuffer,
+        .renderArea = {
+            .offset = {.x = 0, .y = 0},
+            .extent = {
+                .width = mWidth,
+                .height = mHeight
+            }
+        },
+        .clearValueCount = 1,
+        .pClearValues = &depthClear
+    };
+
+    beginDebugLabel(commandBuffer, "Prepass");
+    vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mPrepassPipeline);
+
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            mPrepassPipeline,
+                            0, 1, &mCameraDs.at(mFrameIndex),
+                            0, nullptr);
+
+    recordRenderQueue(commandBuffer, RenderQueuePass::Prepass, mPrepassPipeline);
 
     vkCmdEndRenderPass(commandBuffer);
     endDebugLabel(commandBuffer);
@@ -740,7 +1101,7 @@ void Renderer::executeSkyboxRenderpass(VkCommandBuffer commandBuffer)
 
         vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mSkyboxPipeline);
 
-        std::array<VkDescriptorSet, 2> descriptorSets {mCameraDs, mSkyboxDs};
+        std::array<VkDescriptorSet, 2> descriptorSets {mCameraDs.at(mFrameIndex), mSkyboxDs};
         vkCmdBindDescriptorSets(commandBuffer,
                                 VK_PIPELINE_BIND_POINT_GRAPHICS,
                                 mSkyboxPipeline,
@@ -789,20 +1150,10 @@ void Renderer::executeSsaoResourcesRenderpass(VkCommandBuffer commandBuffer)
 
     vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
                             mSsaoResourcesPipeline,
-                            0, 1, &mCameraDs,
+                            0, 1, &mCameraDs.at(mFrameIndex),
                             0, nullptr);
 
-    for (const auto& [id, model] : mModels)
-    {
-        pfnCmdSetCullModeEXT(commandBuffer, model.cullMode);
-        pfnCmdSetFrontFaceEXT(commandBuffer, model.frontFace);
-
-        for (const auto& mesh : model.meshes)
-        {
-            if (model.drawOpaque(mesh))
-                mesh.mesh.render(commandBuffer);
-        }
-    }
+    recordRenderQueue(commandBuffer, RenderQueuePass::SsaoResources, mSsaoResourcesPipeline);
 
     vkCmdEndRenderPass(commandBuffer);
     endDebugLabel(commandBuffer);
@@ -824,7 +1175,7 @@ void Renderer::executeSsaoRenderpass(VkCommandBuffer commandBuffer)
     };
 
     std::array<VkDescriptorSet, 2> descriptorSets {
-        mCameraDs,
+        mCameraDs.at(mFrameIndex),
         mSsaoDs
     };
 
@@ -942,6 +1293,12 @@ void Renderer::executeSsaoBlurRenderpass(VkCommandBuffer commandBuffer)
 
 void Renderer::executeGenFrustumClustersRenderpass(VkCommandBuffer commandBuffer)
 {
+    // the boxes only depend on the projection and the viewport
+    if (!mRegenerateClusters)
+        return;
+
+    mRegenerateClusters = false;
+
     beginDebugLabel(commandBuffer, "Gen Frustum Clusters");
 
     struct {
@@ -954,9 +1311,18 @@ void Renderer::executeGenFrustumClustersRenderpass(VkCommandBuffer commandBuffer
         glm::uvec2(mWidth, mHeight)
     };
 
+    // the boxes are shared by the frames in flight, the previous frame's light assignment may still be reading them
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0,
+                         0, nullptr,
+                         0, nullptr,
+                         0, nullptr);
+
     vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mFrustumClusterGenPipeline);
 
-    std::array<VkDescriptorSet, 2> ds {mCameraDs, mFrustumClusterGenDs};
+    std::array<VkDescriptorSet, 2> ds {mCameraDs.at(mFrameIndex), mFrustumClusterGenDs};
     vkCmdBindDescriptorSets(commandBuffer,
                             VK_PIPELINE_BIND_POINT_COMPUTE,
                             mFrustumClusterGenPipelineLayout,
@@ -991,49 +1357,200 @@ void Renderer::executeGenFrustumClustersRenderpass(VkCommandBuffer commandBuffer
     endDebugLabel(commandBuffer);
 }
 
-void Renderer::executeAssignLightsToClustersRenderpass(VkCommandBuffer commandBuffer)
+void Renderer::executeActiveClustersRenderpass(VkCommandBuffer commandBuffer)
 {
+    // transparent surfaces aren't in the depth texture, with any in the scene every cluster gets its lights
     struct {
         alignas(16) glm::uvec4 clusterGrid;
-        alignas(4) uint32_t pointLightCount;
+        alignas(8) glm::uvec2 screenSize;
+        alignas(4) uint32_t allClusters;
     } pushConstants {
         glm::uvec4(mClusterGridSize, 0),
-        static_cast<uint32_t>(mPointLights.size())
+        glm::uvec2(mWidth, mHeight),
+        !mSortedTransparentMeshes.empty()
     };
 
-    beginDebugLabel(commandBuffer, "Create Light List");
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mAssignLightsToClustersPipeline);
+    // one dispatch group in y and z, x is counted up by the compaction
+    std::array<uint32_t, 4> activeClustersHeader {0, 1, 1, 0};
+
+    VkBuffer clusterFlagsSSBO = mClusterFlagsSSBOs.at(mFrameIndex).getBuffer();
+    VkBuffer activeClustersSSBO = mActiveClustersSSBOs.at(mFrameIndex).getBuffer();
+
+    beginDebugLabel(commandBuffer, "Active Clusters");
+
+    // the lists are per frame, the last frame to use them retired before this one was recorded
+    vkCmdFillBuffer(commandBuffer, clusterFlagsSSBO, 0, VK_WHOLE_SIZE, 0);
+    vkCmdUpdateBuffer(commandBuffer, activeClustersSSBO, 0, sizeof(activeClustersHeader), activeClustersHeader.data());
+
+    // the depth texture is written by the ssao resources pass
+    std::array<VkMemoryBarrier, 2> memoryBarriers {{
+        {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+        },
+        {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT
+        }
+    }};
 
-    std::array<VkDescriptorSet, 2> ds {mCameraDs, mAssignLightsToClustersDs};
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0,
+                         memoryBarriers.size(), memoryBarriers.data(),
+                         0, nullptr,
+                         0, nullptr);
+
+    std::array<VkDescriptorSet, 2> ds {mCameraDs.at(mFrameIndex), mActiveClustersDs.at(mFrameIndex)};
     vkCmdBindDescriptorSets(commandBuffer,
                             VK_PIPELINE_BIND_POINT_COMPUTE,
-                            mAssignLightsToClustersPipelineLayout,
+                            mActiveClustersPipelineLayout,
                             0, ds.size(), ds.data(),
                             0, nullptr);
 
     vkCmdPushConstants(commandBuffer,
-                       mAssignLightsToClustersPipelineLayout,
+                       mActiveClustersPipelineLayout,
                        VK_SHADER_STAGE_COMPUTE_BIT,
                        0, sizeof(pushConstants),
                        &pushConstants);
 
-    vkCmdDispatch(commandBuffer, mClusterGridSize.x, mClusterGridSize.y, mClusterGridSize.z);
+    if (!pushConstants.allClusters)
+    {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mFlagActiveClustersPipeline);
+        vkCmdDispatch(commandBuffer, (mWidth + 15) / 16, (mHeight + 15) / 16, 1);
+
+        VkBufferMemoryBarrier flagsBarrier {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+            .buffer = clusterFlagsSSBO,
+            .offset = 0,
+            .size = VK_WHOLE_SIZE
+        };
 
-    VkBufferMemoryBarrier clustersBufferMemoryBarrier {
+        vkCmdPipelineBarrier(commandBuffer,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0,
+                             0, nullptr,
+                             1, &flagsBarrier,
+                             0, nullptr);
+    }
+
+    uint32_t clusterCount = mClusterGridSize.x * mClusterGridSize.y * mClusterGridSize.z;
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mCompactActiveClustersPipeline);
+    vkCmdDispatch(commandBuffer, (clusterCount + 63) / 64, 1, 1);
+
+    VkBufferMemoryBarrier activeClustersBarrier {
         .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
-        .srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
-        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
-        .buffer = mVolumeClustersSSBO.getBuffer(),
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
+        .buffer = activeClustersSSBO,
         .offset = 0,
         .size = VK_WHOLE_SIZE
     };
 
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0,
+                         0, nullptr,
+                         1, &activeClustersBarrier,
+                         0, nullptr);
+
+    endDebugLabel(commandBuffer);
+}
+
+void Renderer::executeAssignLightsToClustersRenderpass(VkCommandBuffer commandBuffer)
+{
+    struct {
+        alignas(16) glm::uvec4 clusterGrid;
+    } pushConstants {
+        glm::uvec4(mClusterGridSize, 0)
+    };
+
+    VkBuffer lightGridSSBO = mLightGridSSBOs.at(mFrameIndex).getBuffer();
+    VkBuffer lightIndexSSBO = mLightIndexSSBOs.at(mFrameIndex).getBuffer();
+
+    beginDebugLabel(commandBuffer, "Create Light List");
+
+    vkCmdFillBuffer(commandBuffer, lightIndexSSBO, 0, sizeof(uint32_t), 0);
+
+    // clusters left out of the assignment get empty lists
+    vkCmdFillBuffer(commandBuffer, lightGridSSBO, 0, VK_WHOLE_SIZE, 0);
+
+    std::array<VkBufferMemoryBarrier, 2> resetBarriers {{
+        {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+            .buffer = lightIndexSSBO,
+            .offset = 0,
+            .size = sizeof(uint32_t)
+        },
+        {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .buffer = lightGridSSBO,
+            .offset = 0,
+            .size = VK_WHOLE_SIZE
+        }
+    }};
+
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0,
+                         0, nullptr,
+                         resetBarriers.size(), resetBarriers.data(),
+                         0, nullptr);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mAssignLightsToClustersPipeline);
+
+    std::array<VkDescriptorSet, 2> ds {mCameraDs.at(mFrameIndex), mAssignLightsToClustersDs.at(mFrameIndex)};
+    vkCmdBindDescriptorSets(commandBuffer,
+                            VK_PIPELINE_BIND_POINT_COMPUTE,
+                            mAssignLightsToClustersPipelineLayout,
+                            0, ds.size(), ds.data(),
+                            0, nullptr);
+
+    vkCmdPushConstants(commandBuffer,
+                       mAssignLightsToClustersPipelineLayout,
+                       VK_SHADER_STAGE_COMPUTE_BIT,
+                       0, sizeof(pushConstants),
+                       &pushConstants);
+
+    vkCmdDispatchIndirect(commandBuffer, mActiveClustersSSBOs.at(mFrameIndex).getBuffer(), 0);
+
+    std::array<VkBufferMemoryBarrier, 2> lightListBarriers {{
+        {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+            .buffer = lightGridSSBO,
+            .offset = 0,
+            .size = VK_WHOLE_SIZE
+        },
+        {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+            .buffer = lightIndexSSBO,
+            .offset = 0,
+            .size = VK_WHOLE_SIZE
+        }
+    }};
+
     vkCmdPipelineBarrier(commandBuffer,
                          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
                          VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
                          0,
                          0, nullptr,
-                         1, &clustersBufferMemoryBarrier,
+                         lightListBarriers.size(), lightListBarriers.data(),
                          0, nullptr);
 
     endDebugLabel(commandBuffer);
@@ -1072,7 +1589,7 @@ void Renderer::executeForwardRenderpass(VkCommandBuffer commandBuffer)
         vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
         vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mOpaqueForwardPassPipeline);
 
-        std::array<VkDescriptorSet, 3> ds {mCameraDs, mForwardShadingDs, mLightsDs};
+        std::array<VkDescriptorSet, 4> ds {mCameraDs.at(mFrameIndex), mForwardShadingDs.at(mFrameIndex), mLightsDs.at(mFrameIndex), mMaterialTable.descriptorSet(mFrameIndex)};
         vkCmdBindDescriptorSets(commandBuffer,
                                 VK_PIPELINE_BIND_POINT_GRAPHICS,
                                 mOpaqueForwardPassPipeline,
@@ -1085,24 +1602,10 @@ void Renderer::executeForwardRenderpass(VkCommandBuffer commandBuffer)
                            0, sizeof(uint32_t) * pushConstants.size(),
                            pushConstants.data());
 
-        for (const auto& [id, model] : mModels)
-        {
-            pfnCmdSetCullModeEXT(commandBuffer, model.cullMode);
-            pfnCmdSetFrontFaceEXT(commandBuffer, model.frontFace);
-
-            for (const auto& mesh : model.meshes)
-            {
-                if (model.drawOpaque(mesh))
-                {
-                    uint32_t materialIndex = mesh.materialIndex;
-
-                    model.bindMaterialUBO(commandBuffer, mOpaqueForwardPassPipeline, materialIndex, 3);
-                    model.bindTextures(commandBuffer, mOpaqueForwardPassPipeline, materialIndex, 3);
-
-                    mesh.mesh.render(commandBuffer);
-                }
-            }
-        }
+        recordRenderQueue(commandBuffer,
+                          RenderQueuePass::ForwardOpaque,
+                          mOpaqueForwardPassPipeline,
+                          sizeof(uint32_t) * pushConstants.size());
 
         vkCmdEndRenderPass(commandBuffer);
     }
@@ -1111,7 +1614,7 @@ void Renderer::executeForwardRenderpass(VkCommandBuffer commandBuffer)
         vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
         vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mTransparentForwardPassPipeline);
 
-        std::array<VkDescriptorSet, 3> ds {mCameraDs, mForwardShadingDs, mLightsDs};
+        std::array<VkDescriptorSet, 4> ds {mCameraDs.at(mFrameIndex), mForwardShadingDs.at(mFrameIndex), mLightsDs.at(mFrameIndex), mMaterialTable.descriptorSet(mFrameIndex)};
         vkCmdBindDescriptorSets(commandBuffer,
                                 VK_PIPELINE_BIND_POINT_GRAPHICS,
                                 mTransparentForwardPassPipeline,
@@ -1132,8 +1635,13 @@ void Renderer::executeForwardRenderpass(VkCommandBuffer commandBuffer)
                                sizeof(glm::mat4), sizeof(glm::mat4),
                                glm::value_ptr(transparentMesh.model));
 
-            mModels.at(transparentMesh.modelID).bindMaterialUBO(commandBuffer, mTransparentForwardPassPipeline, transparentMesh.mesh->materialIndex, 3);
-            mModels.at(transparentMesh.modelID).bindTextures(commandBuffer, mTransparentForwardPassPipeline, transparentMesh.mesh->materialIndex, 3);
+            uint32_t materialSlot = mModels.at(transparentMesh.modelID).materialSlot(transparentMesh.mesh->materialIndex);
+
+            vkCmdPushConstants(commandBuffer,
+                               mTransparentForwardPassPipeline,
+                               VK_SHADER_STAGE_FRAGMENT_BIT,
+                               sizeof(uint32_t) * pushConstants.size(), sizeof(uint32_t),
+                               &materialSlot);
 
             VkDeviceSize offset = 0;
             VkBuffer vertexBuffer = transparentMesh.mesh->mesh.getVertexBuffer();
@@ -1450,7 +1958,7 @@ void Renderer::executeWireframeRenderpass(VkCommandBuffer commandBuffer)
 
     vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
                             mWireframePipeline,
-                            0, 1, &mCameraDs,
+                            0, 1, &mCameraDs.at(mFrameIndex),
                             0, nullptr);
 
     vkCmdPushConstants(commandBuffer,
@@ -1465,15 +1973,7 @@ void Renderer::executeWireframeRenderpass(VkCommandBuffer commandBuffer)
                        sizeof(glm::mat4), sizeof(pushConstants),
                        pushConstants);
 
-    for (const auto& [id, model] : mModels)
-    {
-        pfnCmdSetCullModeEXT(commandBuffer, model.cullMode);
-        pfnCmdSetFrontFaceEXT(commandBuffer, model.frontFace);
-
-        for (const auto& mesh : model.meshes)
-            if (model.drawOpaque(mesh))
-                mesh.mesh.render(commandBuffer);
-    }
+    recordRenderQueue(commandBuffer, RenderQueuePass::Wireframe, mWireframePipeline);
 
     vkCmdEndRenderPass(commandBuffer);
     endDebugLabel(commandBuffer);
@@ -1503,7 +2003,7 @@ void Renderer::executeGridRenderpass(VkCommandBuffer commandBuffer)
     vkCmdBindDescriptorSets(commandBuffer,
                             VK_PIPELINE_BIND_POINT_GRAPHICS,
                             mGridPipeline,
-                            0, 1, &mCameraDs,
+                            0, 1, &mCameraDs.at(mFrameIndex),
                             0, nullptr);
 
     vkCmdPushConstants(commandBuffer,
@@ -1542,7 +2042,7 @@ void Renderer::executeLightIconRenderpass(VkCommandBuffer commandBuffer)
     vkCmdBindDescriptorSets(commandBuffer,
                             VK_PIPELINE_BIND_POINT_GRAPHICS,
                             mLightIconPipeline,
-                            0, 1, &mCameraDs,
+                            0, 1, &mCameraDs.at(mFrameIndex),
                             0, nullptr);
 
     bindTexture(commandBuffer, mLightIconPipeline, mDepthTexture, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, 1, 1);
@@ -1584,10 +2084,18 @@ void Renderer::setViewport(VkCommandBuffer commandBuffer)
     vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 }
 
+void Renderer::createCameraUBOs()
+{
+    for (uint32_t i = 0; i < mRenderDevice.framesInFlight; ++i)
+    {
+        mCameraUBOs.at(i) = {mRenderDevice, sizeof(CameraRenderData), BufferType::Uniform, MemoryType::HostCoherent};
+        mCameraUBOs.at(i).setDebugName(std::format("Renderer::mCameraUBOs.at({})", i));
+    }
+}
+
 void Renderer::updateCameraUBO()
 {
-    CameraRenderData renderData(mCamera.renderData());
-    mCameraUBO.mapBufferMemory(0, sizeof(CameraRenderData), &renderData);
+    *mCameraUBOs.at(mFrameIndex).mapped<CameraRenderData>() = mCamera.renderData();
 }
 
 void Renderer::getLightIconRenderData()
@@ -1611,25 +2119,23 @@ void Renderer::getLightIconRenderData()
 
 void Renderer::sortTransparentMeshes()
 {
-    mSortedTransparentMeshes.clear();
+    PROFILE_ZONE("Renderer::sortTransparentMeshes");
 
-    std::vector<GraphNode*> stack(1, mSceneGraph->root());
+    mSortedTransparentMeshes.clear();
 
-    while (!stack.empty())
+    // the transform store already holds every node in a flat array, no need to walk the tree
+    for (GraphNode* node : mSceneGraph->transforms().nodes())
     {
-        GraphNode* node = stack.back();
-        stack.pop_back();
-
-        for (auto child : node->children())
-            stack.push_back(child);
-
         auto modelID = node->modelID();
         if (modelID.has_value() && !node->meshIDs().empty())
         {
-            uuid32_t meshID = node->meshIDs().front();
-            Mesh* mesh = mModels.at(*modelID).getMesh(meshID);
+            Model& model = mModels.at(*modelID);
+            Mesh* mesh = model.getMesh(node->meshIDs().front());
 
-            if (mModels.at(*modelID).drawOpaque(*mesh))
+            if (model.drawOpaque(*mesh))
+                continue;
+
+            if (!isVisible(mCameraFrustum, transformAabb(mesh->bounds, node->globalTransform())))
                 continue;
 
             glm::vec4 center = glm::vec4(mesh->center, 1.f);
@@ -1642,6 +2148,83 @@ void Renderer::sortTransparentMeshes()
     }
 }
 
+static uint32_t rasterState(VkCullModeFlags cullMode, VkFrontFace frontFace)
+{
+    return static_cast<uint32_t>(cullMode) | static_cast<uint32_t>(frontFace) << 2;
+}
+
+void Renderer::buildRenderQueues()
+{
+    PROFILE_ZONE("Renderer::buildRenderQueues");
+
+    mQueuedMeshes.clear();
+    for (RenderQueue& renderQueue : mRenderQueues)
+        renderQueue.clear();
+
+    glm::vec3 cameraPos = mCamera.position();
+    float farPlane = *mCamera.farPlane();
+
+    for (const auto& [id, model] : mModels)
+    {
+        uint32_t modelRasterState = rasterState(model.cullMode, model.frontFace);
+
+        for (const Mesh& mesh : model.meshes)
+        {
+            // cpu culling knows the visible count up front, meshes with nothing left aren't drawn at all
+            if (!model.drawOpaque(mesh) || (!mGpuCulling && !mesh.mesh.visibleInstanceCount(mFrameIndex)))
+                continue;
+
+            uint32_t item = static_cast<uint32_t>(mQueuedMeshes.size());
+            uint32_t depth = quantizeDepth(mesh.mesh.nearestInstanceDistance(cameraPos), farPlane);
+            mQueuedMeshes.push_back(&mesh.mesh);
+
+            // the depth only passes go front to back to reject more fragments early. the forward pass tests for
+            // equal depth, so it groups by material instead
+            mRenderQueues.at(static_cast<uint32_t>(RenderQueuePass::Prepass)).add({
+                .pass = static_cast<uint32_t>(RenderQueuePass::Prepass),
+                .rasterState = modelRasterState,
+                .depth = depth
+            }, item);
+
+            mRenderQueues.at(static_cast<uint32_t>(RenderQueuePass::SsaoResources)).add({
+                .pass = static_cast<uint32_t>(RenderQueuePass::SsaoResources),
+                .rasterState = modelRasterState,
+                .depth = depth
+            }, item);
+
+            mRenderQueues.at(static_cast<uint32_t>(RenderQueuePass::ForwardOpaque)).add({
+                .pass = static_cast<uint32_t>(RenderQueuePass::ForwardOpaque),
+                .rasterState = modelRasterState,
+                .material = model.materialSlot(mesh.materialIndex),
+                .mesh = mesh.meshID
+            }, item);
+
+            if (mWireframeOn)
+            {
+                mRenderQueues.at(static_cast<uint32_t>(RenderQueuePass::Wireframe)).add({
+                    .pass = static_cast<uint32_t>(RenderQueuePass::Wireframe),
+                    .rasterState = modelRasterState,
+                    .mesh = mesh.meshID
+                }, item);
+            }
+        }
+    }
+
+    for (uint32_t pass = 0; pass < RenderQueuePassCount; ++pass)
+    {
+        RenderQueue& renderQueue = mRenderQueues.at(pass);
+
+        // only the forward pass pushes materials
+        mRenderQueueStats.at(pass) = {
+            .unsortedRasterStateChanges = renderQueue.keyChanges(DrawKeyRasterStateMask),
+            .unsortedMaterialChanges = pass == static_cast<uint32_t>(RenderQueuePass::ForwardOpaque)?
+                renderQueue.keyChanges(DrawKeyMaterialMask) : 0
+        };
+
+        renderQueue.sort();
+    }
+}
+
 void Renderer::bindTexture(VkCommandBuffer commandBuffer,
                            VkPipelineLayout pipelineLayout,
                            const VulkanTexture &texture,
@@ -1670,6 +2253,8 @@ void Renderer::bindTexture(VkCommandBuffer commandBuffer,
 
 void Renderer::updateImports()
 {
+    PROFILE_ZONE("Renderer::updateImports");
+
     for (auto itr = mModelDataFutures.begin(); itr != mModelDataFutures.end();)
     {
         if (itr->wait_for(std::chrono::seconds(0)) == std::future_status::ready)
@@ -1686,6 +2271,18 @@ void Renderer::updateImports()
         else
             ++itr;
     }
+
+    if (mImportBatchSize && mModelDataFutures.empty())
+    {
+        mImportTimer.end();
+
+        debugLog(std::format("Imported {} model(s) in {} ms on {} thread(s)",
+                             mImportBatchSize,
+                             mImportTimer.ellapsedMilli(),
+                             mImportThreadPool.threadCount()));
+
+        mImportBatchSize = 0;
+    }
 }
 
 void Renderer::addModel(ModelLoader &modelData)
@@ -1702,7 +2299,10 @@ void Renderer::addModel(ModelLoader &modelData)
     addMeshes(model, modelData);
     addTextures(model, modelData);
 
-    model.createMaterialsUBO();
+    // new slots are written into the material table's descriptor set, which the frames in flight are bound to
+    vkDeviceWaitIdle(mRenderDevice.device);
+
+    model.addToMaterialTable(mMaterialTable);
     model.createTextureDescriptorSets(mSingleImageDsLayout);
 
     mModels.emplace(model.id, std::move(model));
@@ -1715,12 +2315,13 @@ void Renderer::addMeshes(Model &model, ModelLoader &modelData)
         Mesh mesh {
             .meshID = UUIDRegistry::generateMeshID(),
             .name = meshData.name,
-            .mesh {mRenderDevice, meshData.vertices, meshData.indices},
+            .mesh {mRenderDevice, meshData.vertices, meshData.indices, meshData.bounds},
             .materialIndex = meshData.materialIndex,
-            .center = meshData.center
+            .center = meshData.center,
+            .bounds = meshData.bounds
         };
 
-        model.meshes.push_back(std::move(mesh));
+        model.addMesh(std::move(mesh));
     }
 }
 
@@ -1761,100 +2362,607 @@ void Renderer::addTextures(Model &model, ModelLoader &modelData)
 
 void Renderer::updateSceneGraph()
 {
-    updateGraphNode(mSceneGraph->root()->type(), mSceneGraph->root());
-}
-
-void Renderer::updateGraphNode(NodeType type, GraphNode *node)
-{
-    if (!node) return;
+    PROFILE_ZONE("Renderer::updateSceneGraph");
 
-    switch (type)
-    {
-        case NodeType::Empty: updateEmptyNode(node); break;
-        case NodeType::Mesh: updateMeshNode(node); break;
-        case NodeType::DirectionalLight: updateDirLightNode(node); break;
-        case NodeType::PointLight: updatePointLightNode(node); break;
-        case NodeType::SpotLight: updateSpotLightNode(node); break;
-    }
+    const std::vector<GraphNode*>& updatedNodes = mSceneGraph->updateTransforms(&mSceneUpdateThreadPool);
 
-    for (auto* child : node->children())
-        updateGraphNode(child->type(), child);
-}
+    // every mesh node writes its own instances, only flagging the instance buffers is left for the main thread
+    parallelFor(&mSceneUpdateThreadPool, updatedNodes.size(), sInstanceBatchSize, [this, &updatedNodes] (uint32_t begin, uint32_t end) {
+        updateMeshInstances(std::span(updatedNodes).subspan(begin, end - begin));
+    });
 
-void Renderer::updateEmptyNode(GraphNode *node)
-{
-    node->updateGlobalTransform();
+    for (GraphNode* node : updatedNodes)
+        updateGraphNode(node->type(), node);
 }
 
-void Renderer::updateMeshNode(GraphNode *node)
+void Renderer::syncInstanceBuffers()
 {
-    if (node->updateGlobalTransform())
-    {
-        Model& model = mModels.at(node->modelID().value());
+    PROFILE_ZONE("Renderer::syncInstanceBuffers");
 
-        for (uint32_t meshID : node->meshIDs())
-        {
-            InstancedMesh& mesh = model.getMesh(meshID)->mesh;
-            mesh.updateInstance(node->id(), node->globalTransform());
-        }
-    }
+    for (auto& [id, model] : mModels)
+        for (Mesh& mesh : model.meshes)
+            mesh.mesh.syncInstanceBuffer(mFrameIndex);
 }
 
-void Renderer::updateDirLightNode(GraphNode *node)
+void Renderer::cullInstances()
 {
-    if (node->updateGlobalTransform())
-    {
-        index_t lightIndex = mUuidToDirLightIndex.at(node->id());
-        DirectionalLight& light = mDirLights.at(lightIndex);
-
-        glm::vec3 dummy;
-        glm::vec3 orientation;
-        ImGuizmo::DecomposeMatrixToComponents(glm::value_ptr(node->globalTransform()),
-                                              glm::value_ptr(dummy),
-                                              glm::value_ptr(orientation),
-                                              glm::value_ptr(dummy));
+    PROFILE_ZONE("Renderer::cullInstances");
 
-        light.direction = glm::vec4(calcLightDir(orientation), 0.0);
+    Timer timer;
 
-        updateDirLight(node->id());
-    }
-}
+    mCameraFrustum = extractFrustum(mCamera.viewProjection());
+    mCullingStats.visibleInstances = 0;
+    mCullingStats.totalInstances = 0;
 
-void Renderer::updatePointLightNode(GraphNode *node)
-{
-    if (node->updateGlobalTransform())
-    {
-        index_t lightIndex = mUuidToPointLightIndex.at(node->id());
-        PointLight& light = mPointLights.at(lightIndex);
-
-        glm::vec3 dummy;
-        ImGuizmo::DecomposeMatrixToComponents(glm::value_ptr(node->globalTransform()),
-                                              glm::value_ptr(light.position),
-                                              glm::value_ptr(dummy),
-                                              glm::value_ptr(dummy));
-        updatePointLight(node->id());
-    }
-}
+    bool compareReference = mGpuCulling && mValidateGpuCulling && mCullingReferenceReady.at(mFrameIndex);
 
-void Renderer::updateSpotLightNode(GraphNode *node)
-{
-    if (node->updateGlobalTransform())
+    // shadow passes still draw every instance, only the camera passes use the culled lists
+    for (auto& [id, model] : mModels)
     {
-        index_t lightIndex = mUuidToSpotLightIndex.at(node->id());
-        SpotLight& light = mSpotLights.at(lightIndex);
+        for (Mesh& mesh : model.meshes)
+        {
+            InstancedMesh& instancedMesh = mesh.mesh;
+            mCullingStats.totalInstances += instancedMesh.instanceCount();
 
-        glm::vec3 dummy;
-        glm::vec3 orientation;
-        ImGuizmo::DecomposeMatrixToComponents(glm::value_ptr(node->globalTransform()),
-                                              glm::value_ptr(light.position),
-                                              glm::value_ptr(orientation),
-                                              glm::value_ptr(dummy));
+            if (!mGpuCulling)
+            {
+                instancedMesh.cull(mCameraFrustum, mFrameIndex);
+                mCullingStats.visibleInstances += instancedMesh.visibleInstanceCount(mFrameIndex);
+                continue;
+            }
 
-        light.direction = glm::vec4(calcLightDir(orientation), 0.f);
+            // the frame that last used this slot has finished, so the gpu count lags by the frames in flight
+            uint32_t gpuCount = instancedMesh.culledInstanceCount(mFrameIndex);
+            mCullingStats.visibleInstances += gpuCount;
 
-        updateSpotLight(node->id());
-    }
-}
+            if (compareReference)
+            {
+                uint32_t cpuCount = instancedMesh.visibleInstanceCount(mFrameIndex);
+
+                ++mCullingStats.validatedMeshes;
+                if (gpuCount != cpuCount)
+                {
+                    ++mCullingStats.mismatchedMeshes;
+                    debugLog(std::format("Gpu culling kept {} instance(s) of {}, the cpu kept {}.", gpuCount, mesh.name, cpuCount));
+                }
+            }
+
+            instancedMesh.resetDrawCommand(mFrameIndex);
+
+            // cpu reference for this frame, compared with the gpu once the slot comes around again
+            if (mValidateGpuCulling)
+                instancedMesh.cull(mCameraFrustum, mFrameIndex);
+        }
+    }
+
+    mCullingReferenceReady.at(mFrameIndex) = mGpuCulling && mValidateGpuCulling;
+
+    timer.end();
+    mCullingStats.cullMs = timer.ellapsedMilli();
+}
+
+void Renderer::allocateShadowAtlas()
+{
+    PROFILE_ZONE("Renderer::allocateShadowAtlas");
+
+    float tanHalfFov = glm::tan(glm::radians(*mCamera.fov()) * 0.5f);
+
+    auto importance = [&] (ShadowType shadowType, const glm::vec3& position, float range) {
+        if (shadowType == ShadowType::NoShadow)
+            return 0.f;
+        return shadowImportance(mCameraFrustum, mCamera.position(), tanHalfFov, position, range);
+    };
+
+    // point lights, then spot lights
+    std::vector<ShadowAtlasRequest> requests;
+    for (index_t i = 0; i < mPointLights.size(); ++i)
+    {
+        PointShadowMap& shadowMap = mPointShadowMaps.at(i);
+        const PointShadowData& psd = mPointShadowData.at(i);
+
+        shadowMap.importance = importance(psd.shadowType, glm::vec3(mPointLights.at(i).position), mPointLights.at(i).range);
+        requests.push_back({shadowMap.importance, shadowTileSize(shadowMap.importance, psd.resolution, shadowMap.tiles[0].size), 6});
+    }
+
+    for (index_t i = 0; i < mSpotLights.size(); ++i)
+    {
+        SpotShadowMap& shadowMap = mSpotShadowMaps.at(i);
+        const SpotShadowData& ssd = mSpotShadowData.at(i);
+
+        shadowMap.importance = importance(ssd.shadowType, glm::vec3(mSpotLights.at(i).position), mSpotLights.at(i).range);
+        requests.push_back({shadowMap.importance, shadowTileSize(shadowMap.importance, ssd.resolution, shadowMap.tile.size), 1});
+    }
+
+    std::vector<ShadowAtlasTile> tiles = packShadowAtlas(requests, mShadowAtlasResolution, mShadowAtlasPages);
+
+    mShadowAtlasStats = {};
+    for (index_t i = 0; i < requests.size(); ++i)
+    {
+        mShadowAtlasStats.tiles += requests.at(i).size? requests.at(i).tileCount : 0;
+        mShadowAtlasStats.droppedLights += requests.at(i).importance > 0.f && !requests.at(i).size;
+        mShadowAtlasStats.usedTexels += static_cast<uint64_t>(requests.at(i).size) * requests.at(i).size * requests.at(i).tileCount;
+    }
+
+    // a tile that moved or resized doesn't hold what was cached in it anymore
+    auto assignTile = [this] (ShadowAtlasTile& tile, ShadowCache& cache, glm::vec4& atlasRect, const ShadowAtlasTile& newTile) {
+        glm::vec4 newAtlasRect = newTile.size? shadowAtlasRect(newTile, mShadowAtlasResolution) : glm::vec4(0.f);
+
+        if (tile == newTile && atlasRect == newAtlasRect)
+            return false;
+
+        tile = newTile;
+        cache = {};
+        atlasRect = newAtlasRect;
+        return true;
+    };
+
+    bool pointTilesChanged = false;
+    uint32_t tile = 0;
+    for (index_t i = 0; i < mPointLights.size(); ++i)
+    {
+        PointShadowMap& shadowMap = mPointShadowMaps.at(i);
+        PointShadowData& psd = mPointShadowData.at(i);
+
+        for (uint32_t face = 0; face < 6; ++face, ++tile)
+            pointTilesChanged |= assignTile(shadowMap.tiles[face], shadowMap.caches[face], psd.atlasRects[face], tiles.at(tile));
+    }
+
+    bool spotTilesChanged = false;
+    for (index_t i = 0; i < mSpotLights.size(); ++i, ++tile)
+    {
+        SpotShadowMap& shadowMap = mSpotShadowMaps.at(i);
+        spotTilesChanged |= assignTile(shadowMap.tile, shadowMap.cache, mSpotShadowData.at(i).atlasRect, tiles.at(tile));
+    }
+
+    if (pointTilesChanged || spotTilesChanged)
+        mShadowDataDirtyFrames = allFramesDirty(mRenderDevice);
+}
+
+void Renderer::cullShadowCasters()
+{
+    PROFILE_ZONE("Renderer::cullShadowCasters");
+
+    mShadowFrusta.clear();
+    mShadowViewStats.clear();
+    mShadowCaches.clear();
+    mShadowViewProjs.clear();
+
+    // the cache is only updated once the view is scheduled, a view that isn't keeps what it was drawn with
+    auto addView = [this] (glm::mat4& viewProj, LightType lightType, index_t lightIndex, uint32_t face, ShadowCache& cache) {
+        mShadowFrusta.push_back(extractFrustum(viewProj));
+        mShadowViewStats.push_back({lightType, lightIndex, face, 0, 0, 0, ShadowViewChange::None, ShadowViewUpdate::Skip});
+        mShadowCaches.push_back(&cache);
+        mShadowViewProjs.push_back(&viewProj);
+
+        if (cache.viewProj != viewProj || !cache.drawn || !mCacheShadowMaps)
+            mShadowViewStats.back().update = ShadowViewUpdate::Full;
+    };
+
+    // same order the shadow passes walk the lights in. lights without shadows don't see the casters move
+    for (index_t i = 0; i < mDirLights.size(); ++i)
+    {
+        DirShadowData& dsd = mDirShadowData.at(i);
+        DirShadowMap& shadowMap = mDirShadowMaps.at(i);
+
+        if (dsd.shadowType == ShadowType::NoShadow)
+        {
+            for (ShadowCache& cache : shadowMap.caches)
+                cache.valid = false;
+            continue;
+        }
+
+        for (uint32_t ii = 0; ii < dsd.cascadeCount; ++ii)
+        {
+            addView(dsd.viewProj[ii], LightType::Directional, i, ii, shadowMap.caches.at(ii));
+
+            // casters between the light and the cascade still shadow it
+            extendFrustum(mShadowFrusta.back(), mDirLights.at(i).direction);
+        }
+    }
+
+    mFirstPointShadowView = mShadowFrusta.size();
+    for (index_t i = 0; i < mPointLights.size(); ++i)
+    {
+        PointShadowData& psd = mPointShadowData.at(i);
+        PointShadowMap& shadowMap = mPointShadowMaps.at(i);
+
+        // lights that didn't get atlas tiles aren't drawn
+        if (psd.shadowType == ShadowType::NoShadow || !shadowMap.tiles[0].size)
+        {
+            for (ShadowCache& cache : shadowMap.caches)
+                cache.valid = false;
+            continue;
+        }
+
+        // last frame's views may have been put back to what the faces were drawn with
+        calcMatrices(psd, mPointLights.at(i));
+
+        for (uint32_t ii = 0; ii < 6; ++ii)
+            addView(psd.viewProj[ii], LightType::Point, i, ii, shadowMap.caches[ii]);
+    }
+
+    mFirstSpotShadowView = mShadowFrusta.size();
+    for (index_t i = 0; i < mSpotLights.size(); ++i)
+    {
+        SpotShadowData& ssd = mSpotShadowData.at(i);
+        SpotShadowMap& shadowMap = mSpotShadowMaps.at(i);
+
+        if (ssd.shadowType == ShadowType::NoShadow || !shadowMap.tile.size)
+        {
+            shadowMap.cache.valid = false;
+            continue;
+        }
+
+        calcMatrices(ssd, mSpotLights.at(i));
+        addView(ssd.viewProj, LightType::Spot, i, 0, shadowMap.cache);
+    }
+
+    std::vector<InstancedMesh*> shadowCasters;
+    for (auto& [id, model] : mModels)
+    {
+        for (Mesh& mesh : model.meshes)
+        {
+            mesh.mesh.clearShadowViews();
+
+            if (model.drawOpaque(mesh))
+                shadowCasters.push_back(&mesh.mesh);
+        }
+    }
+
+    // meshes that stopped or started casting are baked into the caches or missing from them
+    if (shadowCasters != mShadowCasters)
+    {
+        for (ShadowCache* cache : mShadowCaches)
+            cache->valid = false;
+    }
+
+    mShadowCasters = std::move(shadowCasters);
+
+    // meshes only touch their own shadow lists
+    parallelFor(&mSceneUpdateThreadPool, mShadowCasters.size(), sShadowCasterBatchSize, [this] (uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            mShadowCasters[i]->updateShadowCasters();
+
+            for (const Frustum& frustum : mShadowFrusta)
+                mShadowCasters[i]->cullShadowView(frustum);
+        }
+    });
+
+    // the shadow instance buffers may get reallocated, that stays on this thread
+    for (InstancedMesh* mesh : mShadowCasters)
+    {
+        mesh->syncShadowInstances(mFrameIndex);
+
+        for (uint32_t view = 0; view < mShadowViewStats.size(); ++view)
+        {
+            ShadowViewStats& viewStats = mShadowViewStats.at(view);
+            uint32_t instanceCount = mesh->shadowViewInstanceCount(view);
+
+            viewStats.draws += instanceCount? 1 : 0;
+            viewStats.instances += instanceCount;
+            viewStats.dynamicInstances += mesh->shadowViewDynamicCount(view);
+            viewStats.change = std::max(viewStats.change, mesh->shadowViewChange(view));
+        }
+    }
+
+    for (uint32_t view = 0; view < mShadowViewStats.size(); ++view)
+    {
+        ShadowViewStats& viewStats = mShadowViewStats.at(view);
+        const ShadowCache& cache = *mShadowCaches.at(view);
+
+        if (viewStats.update != ShadowViewUpdate::Full)
+        {
+            // the dynamic casters can only be redrawn over a cached copy of the static ones
+            if (!cache.valid || viewStats.change == ShadowViewChange::StaticCasters)
+                viewStats.update = ShadowViewUpdate::Cache;
+            else if (viewStats.change == ShadowViewChange::DynamicCasters || cache.dirty)
+                viewStats.update = cache.cached? ShadowViewUpdate::Dynamic : ShadowViewUpdate::Cache;
+        }
+    }
+}
+
+// Picks which of the views that need redrawing fit in the frame's budget. Views that have never been drawn and
+// the first cascade of every directional light always go, the rest are ranked by how long they've waited times
+// how much they matter: nearer cascades over farther ones and point and spot lights by their atlas importance.
+// Faces of the same light wait the same amount, so a point light's faces take turns. A view that's put off keeps
+// its old contents and the matrix it was drawn with, so it stays right for everything but the casters that moved.
+void Renderer::scheduleShadowUpdates()
+{
+    PROFILE_ZONE("Renderer::scheduleShadowUpdates");
+
+    struct Candidate
+    {
+        uint32_t view;
+        float priority;
+    };
+
+    std::vector<Candidate> candidates;
+    std::vector<bool> scheduled(mShadowViewStats.size(), false);
+    uint32_t requestedViews = 0;
+    uint32_t scheduledViews = 0;
+
+    for (uint32_t view = 0; view < mShadowViewStats.size(); ++view)
+    {
+        const ShadowViewStats& viewStats = mShadowViewStats.at(view);
+        const ShadowCache& cache = *mShadowCaches.at(view);
+
+        if (viewStats.update == ShadowViewUpdate::Skip)
+            continue;
+
+        ++requestedViews;
+
+        if (!cache.drawn || (viewStats.lightType == LightType::Directional && viewStats.face == 0) || !mShadowViewBudget)
+        {
+            scheduled.at(view) = true;
+            ++scheduledViews;
+            continue;
+        }
+
+        float weight = 0.f;
+        switch (viewStats.lightType)
+        {
+            case LightType::Directional: weight = 1.f / static_cast<float>(viewStats.face + 1); break;
+            case LightType::Point: weight = mPointShadowMaps.at(viewStats.lightIndex).importance; break;
+            case LightType::Spot: weight = mSpotShadowMaps.at(viewStats.lightIndex).importance; break;
+        }
+
+        // the light itself moved, its shadow is off until the view is redrawn
+        if (viewStats.lightType != LightType::Directional && *mShadowViewProjs.at(view) != cache.viewProj)
+            weight += 1.f;
+
+        candidates.push_back({view, weight * static_cast<float>(cache.wait + 1)});
+    }
+
+    std::stable_sort(candidates.begin(), candidates.end(), [] (const Candidate& a, const Candidate& b) {
+        return a.priority > b.priority;
+    });
+
+    for (const Candidate& candidate : candidates)
+    {
+        if (scheduledViews >= mShadowViewBudget)
+            break;
+
+        scheduled.at(candidate.view) = true;
+        ++scheduledViews;
+    }
+
+    mShadowScheduleStats = {requestedViews, scheduledViews, requestedViews - scheduledViews, 0};
+
+    // set when the shader's copy of a light's matrices no longer matches what its views are drawn with
+    bool dirViewsChanged = false;
+    bool pointViewsChanged = false;
+    bool spotViewsChanged = false;
+
+    for (uint32_t view = 0; view < mShadowViewStats.size(); ++view)
+    {
+        ShadowViewStats& viewStats = mShadowViewStats.at(view);
+        ShadowCache& cache = *mShadowCaches.at(view);
+        glm::mat4& viewProj = *mShadowViewProjs.at(view);
+
+        if (viewStats.update != ShadowViewUpdate::Skip && !scheduled.at(view))
+        {
+            // remember what changed for when the view gets its turn
+            if (viewStats.update == ShadowViewUpdate::Cache) cache.valid = false;
+            if (viewStats.update == ShadowViewUpdate::Dynamic) cache.dirty = true;
+
+            // the shader has to sample the view with what it was drawn with
+            if (viewProj != cache.viewProj)
+            {
+                viewProj = cache.viewProj;
+
+                dirViewsChanged |= viewStats.lightType == LightType::Directional;
+                pointViewsChanged |= viewStats.lightType == LightType::Point;
+                spotViewsChanged |= viewStats.lightType == LightType::Spot;
+            }
+
+            ++cache.age;
+            ++cache.wait;
+            mShadowScheduleStats.longestWait = std::max(mShadowScheduleStats.longestWait, cache.wait);
+            viewStats.update = ShadowViewUpdate::Skip;
+            continue;
+        }
+
+        if (viewStats.update == ShadowViewUpdate::Skip)
+        {
+            ++cache.age;
+            continue;
+        }
+
+        // point and spot matrices are recomputed every frame, a view drawn with a new one has to be uploaded even
+        // if nothing else changed the light
+        if (viewProj != cache.viewProj)
+        {
+            pointViewsChanged |= viewStats.lightType == LightType::Point;
+            spotViewsChanged |= viewStats.lightType == LightType::Spot;
+        }
+
+        // a view that moved this frame will likely move again, it isn't worth caching yet
+        if (viewStats.update == ShadowViewUpdate::Full)
+            cache = {viewProj, false, false};
+
+        cache.valid = true;
+        cache.cached |= viewStats.update == ShadowViewUpdate::Cache;
+        cache.drawn = true;
+        cache.dirty = false;
+        cache.age = 0;
+        cache.wait = 0;
+    }
+
+    if (dirViewsChanged || pointViewsChanged || spotViewsChanged)
+        mShadowDataDirtyFrames = allFramesDirty(mRenderDevice);
+}
+
+void Renderer::syncLightBuffers()
+{
+    PROFILE_ZONE("Renderer::syncLightBuffers");
+
+    // the frame that last read this frame's copies has retired, so they can be written without a device wait
+    uint32_t frameBit = 1u << mFrameIndex;
+
+    if (mLightsDirtyFrames & frameBit)
+    {
+        std::copy(mDirLights.begin(), mDirLights.end(), mDirLightSSBOs.at(mFrameIndex).mapped<DirectionalLight>());
+        std::copy(mPointLights.begin(), mPointLights.end(), mPointLightSSBOs.at(mFrameIndex).mapped<PointLight>());
+        std::copy(mSpotLights.begin(), mSpotLights.end(), mSpotLightSSBOs.at(mFrameIndex).mapped<SpotLight>());
+        mLightsDirtyFrames &= ~frameBit;
+    }
+
+    if (mShadowDataDirtyFrames & frameBit)
+    {
+        std::copy(mDirShadowData.begin(), mDirShadowData.end(), mDirShadowDataSSBOs.at(mFrameIndex).mapped<DirShadowData>());
+        std::copy(mPointShadowData.begin(), mPointShadowData.end(), mPointShadowDataSSBOs.at(mFrameIndex).mapped<PointShadowData>());
+        std::copy(mSpotShadowData.begin(), mSpotShadowData.end(), mSpotShadowDataSSBOs.at(mFrameIndex).mapped<SpotShadowData>());
+        mShadowDataDirtyFrames &= ~frameBit;
+    }
+}
+
+void Renderer::updateClusterLights()
+{
+    PROFILE_ZONE("Renderer::updateClusterLights");
+
+    // the cpu copy of the cluster boxes only changes with the projection
+    glm::uvec2 screenSize(mWidth, mHeight);
+    if (mClusterBounds.empty() || mClusterBoundsProjection != mCamera.projection() || mClusterBoundsScreenSize != screenSize)
+    {
+        mClusterBounds = clusterBounds(mCamera.projection(), mClusterGridSize, screenSize, *mCamera.nearPlane(), *mCamera.farPlane());
+        mClusterBoundsProjection = mCamera.projection();
+        mClusterBoundsScreenSize = screenSize;
+        mRegenerateClusters = true;
+    }
+
+    mClusterLights.clear();
+
+    for (index_t i = 0; i < mPointLights.size(); ++i)
+        mClusterLights.push_back(clusterLight(mPointLights.at(i), i, mCamera.view()));
+
+    for (index_t i = 0; i < mSpotLights.size(); ++i)
+        mClusterLights.push_back(clusterLight(mSpotLights.at(i), i, mCamera.view()));
+
+    binClusterLights(mClusterLights, mClusterBounds, mClusterGridSize, mClusterLightBins);
+
+    // a cluster can't get more lights than its bin has, grow the index list before it could run out
+    uint32_t maxLightIndexCount = 0;
+    for (const LightRange& bin : mClusterLightBins.bins)
+        maxLightIndexCount += bin.count * mClusterGridSize.x;
+
+    if (maxLightIndexCount > mLightIndexCapacity)
+    {
+        vkDeviceWaitIdle(mRenderDevice.device);
+
+        createLightIndexSSBO(std::bit_ceil(maxLightIndexCount));
+        createAssignLightsToClustersDs();
+        updateForwardShadingDs();
+    }
+
+    std::copy(mClusterLights.begin(), mClusterLights.end(), mClusterLightSSBOs.at(mFrameIndex).mapped<ClusterLight>());
+    std::copy(mClusterLightBins.bins.begin(), mClusterLightBins.bins.end(), mLightBinSSBOs.at(mFrameIndex).mapped<LightRange>());
+    std::copy(mClusterLightBins.lightIndices.begin(), mClusterLightBins.lightIndices.end(), mBinnedLightSSBOs.at(mFrameIndex).mapped<uint32_t>());
+}
+
+void Renderer::updateGraphNode(NodeType type, GraphNode *node)
+{
+    switch (type)
+    {
+        case NodeType::Empty: break;
+        case NodeType::Mesh: updateMeshNode(node); break;
+        case NodeType::DirectionalLight: updateDirLightNode(node); break;
+        case NodeType::PointLight: updatePointLightNode(node); break;
+        case NodeType::SpotLight: updateSpotLightNode(node); break;
+    }
+}
+
+void Renderer::updateMeshNode(GraphNode *node)
+{
+    Model& model = mModels.at(node->modelID().value());
+
+    for (uint32_t meshID : node->meshIDs())
+        model.getMesh(meshID)->mesh.markInstancesDirty();
+}
+
+void Renderer::updateMeshInstances(std::span<GraphNode* const> nodes)
+{
+    constexpr uint32_t BlockSize = 64;
+
+    GraphNode* meshNodes[BlockSize];
+    glm::mat4 transforms[BlockSize];
+    glm::mat3 normalMatrices[BlockSize];
+
+    // normal matrices are computed a block of mesh nodes at a time
+    size_t i = 0;
+
+    while (i < nodes.size())
+    {
+        uint32_t count = 0;
+
+        for (; i < nodes.size() && count < BlockSize; ++i)
+        {
+            if (nodes[i]->type() == NodeType::Mesh)
+            {
+                meshNodes[count] = nodes[i];
+                transforms[count] = nodes[i]->globalTransform();
+                ++count;
+            }
+        }
+
+        calcNormalMatrices(transforms, normalMatrices, count);
+
+        for (uint32_t j = 0; j < count; ++j)
+        {
+            Model& model = mModels.at(meshNodes[j]->modelID().value());
+
+            for (uint32_t meshID : meshNodes[j]->meshIDs())
+                model.getMesh(meshID)->mesh.setInstanceTransform(meshNodes[j]->id(), transforms[j], normalMatrices[j]);
+        }
+    }
+}
+
+void Renderer::updateDirLightNode(GraphNode *node)
+{
+    index_t lightIndex = mUuidToDirLightIndex.at(node->id());
+    DirectionalLight& light = mDirLights.at(lightIndex);
+
+    glm::vec3 dummy;
+    glm::vec3 orientation;
+    ImGuizmo::DecomposeMatrixToComponents(glm::value_ptr(node->globalTransform()),
+                                          glm::value_ptr(dummy),
+                                          glm::value_ptr(orientation),
+                                          glm::value_ptr(dummy));
+
+    light.direction = glm::vec4(calcLightDir(orientation), 0.0);
+
+    updateDirLight(node->id());
+}
+
+void Renderer::updatePointLightNode(GraphNode *node)
+{
+    index_t lightIndex = mUuidToPointLightIndex.at(node->id());
+    PointLight& light = mPointLights.at(lightIndex);
+
+    glm::vec3 dummy;
+    ImGuizmo::DecomposeMatrixToComponents(glm::value_ptr(node->globalTransform()),
+                                          glm::value_ptr(light.position),
+                                          glm::value_ptr(dummy),
+                                          glm::value_ptr(dummy));
+    updatePointLight(node->id());
+}
+
+void Renderer::updateSpotLightNode(GraphNode *node)
+{
+    index_t lightIndex = mUuidToSpotLightIndex.at(node->id());
+    SpotLight& light = mSpotLights.at(lightIndex);
+
+    glm::vec3 dummy;
+    glm::vec3 orientation;
+    ImGuizmo::DecomposeMatrixToComponents(glm::value_ptr(node->globalTransform()),
+                                          glm::value_ptr(light.position),
+                                          glm::value_ptr(orientation),
+                                          glm::value_ptr(dummy));
+
+    light.direction = glm::vec4(calcLightDir(orientation), 0.f);
+
+    updateSpotLight(node->id());
+}
 
 void Renderer::createColorTexture32MS()
 {
@@ -1894,7 +3002,8 @@ void Renderer::createColorTexture8U()
         .layerCount = 1,
         .imageViewType = VK_IMAGE_VIEW_TYPE_2D,
         .imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
-                      VK_IMAGE_USAGE_SAMPLED_BIT,
+                      VK_IMAGE_USAGE_SAMPLED_BIT |
+                      VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
         .imageAspect = VK_IMAGE_ASPECT_COLOR_BIT,
         .samples = VK_SAMPLE_COUNT_1_BIT,
         .magFilter = TextureMagFilter::Nearest,
@@ -2041,16 +3150,28 @@ void Renderer::createCameraRenderDataDsLayout()
 
 void Renderer::createMaterialsDsLayout()
 {
+    // the forward pass's fragment shader also has the shadow maps and a handful of other textures
+    const VkPhysicalDeviceLimits& limits = mRenderDevice.getDeviceProperties().limits;
+    uint32_t fragmentTextureCount = MaxMaterialTextures + MaxShadowMapsPerType + 16;
+    check(limits.maxPerStageDescriptorSamplers >= fragmentTextureCount &&
+          limits.maxPerStageDescriptorSampledImages >= fragmentTextureCount,
+          "The device doesn't have enough sampler descriptors for the material table.");
+
+    // the texture slots of released and not yet loaded models are left unwritten
+    std::array<VkDescriptorBindingFlags, 2> descriptorBindingFlags {};
+    descriptorBindingFlags.at(1) = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT;
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfoEXT descriptorSetLayoutBindingFlagsCreateInfoExt {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT,
+        .bindingCount = static_cast<uint32_t>(descriptorBindingFlags.size()),
+        .pBindingFlags = descriptorBindingFlags.data()
+    };
+
     DsLayoutSpecification specification {
-        .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR,
+        .pNext = &descriptorSetLayoutBindingFlagsCreateInfoExt,
         .bindings = {
-            binding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_FRAGMENT_BIT),
-            binding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT),
-            binding(2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT),
-            binding(3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT),
-            binding(4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT),
-            binding(5, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT),
-            binding(6, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT),
+            binding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_FRAGMENT_BIT),
+            binding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MaxMaterialTextures, VK_SHADER_STAGE_FRAGMENT_BIT),
         },
         .debugName = "Renderer::mMaterialsDsLayout"
     };
@@ -2101,10 +3222,8 @@ void Renderer::createSingleInputAttachmentDsLayout()
 
 void Renderer::createLightsDsLayout()
 {
-    std::array<VkDescriptorBindingFlags, 12> descriptorBindingFlags {};
+    std::array<VkDescriptorBindingFlags, 11> descriptorBindingFlags {};
     descriptorBindingFlags.at(9) = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT;
-    descriptorBindingFlags.at(10) = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT;
-    descriptorBindingFlags.at(11) = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT;
 
     VkDescriptorSetLayoutBindingFlagsCreateInfoEXT descriptorSetLayoutBindingFlagsCreateInfoExt {
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT,
@@ -2125,8 +3244,7 @@ void Renderer::createLightsDsLayout()
             binding(7, VK_DESCRIPTOR_TYPE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT),
             binding(8, VK_DESCRIPTOR_TYPE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT),
             binding(9, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, MaxShadowMapsPerType, VK_SHADER_STAGE_FRAGMENT_BIT),
-            binding(10, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, MaxShadowMapsPerType, VK_SHADER_STAGE_FRAGMENT_BIT),
-            binding(11, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, MaxShadowMapsPerType, VK_SHADER_STAGE_FRAGMENT_BIT),
+            binding(10, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, VK_SHADER_STAGE_FRAGMENT_BIT),
         },
         .debugName = "Renderer::mLightsDsLayout"
     };
@@ -2134,6 +3252,21 @@ void Renderer::createLightsDsLayout()
     mLightsDsLayout = {mRenderDevice, specification};
 }
 
+void Renderer::createCullInstancesDsLayout()
+{
+    DsLayoutSpecification specification {
+        .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR,
+        .bindings = {
+            binding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+            binding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+            binding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+        },
+        .debugName = "Renderer::mCullInstancesDsLayout"
+    };
+
+    mCullInstancesDsLayout = {mRenderDevice, specification};
+}
+
 void Renderer::createFrustumClusterGenDsLayout()
 {
     DsLayoutSpecification specification {
@@ -2153,6 +3286,11 @@ void Renderer::createAssignLightsToClustersDsLayout()
         .bindings = {
             binding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
             binding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+            binding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+            binding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+            binding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+            binding(5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+            binding(6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
         },
         .debugName = "Renderer::mAssignLightsToClustersDsLayout"
     };
@@ -2160,6 +3298,20 @@ void Renderer::createAssignLightsToClustersDsLayout()
     mAssignLightsToClustersDsLayout = {mRenderDevice, specification};
 }
 
+void Renderer::createActiveClustersDsLayout()
+{
+    DsLayoutSpecification specification {
+        .bindings = {
+            binding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+            binding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+            binding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+        },
+        .debugName = "Renderer::mActiveClustersDsLayout"
+    };
+
+    mActiveClustersDsLayout = {mRenderDevice, specification};
+}
+
 void Renderer::createForwardShadingDsLayout()
 {
     DsLayoutSpecification specification {
@@ -2170,6 +3322,7 @@ void Renderer::createForwardShadingDsLayout()
             binding(3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT),
             binding(4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT),
             binding(5, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT),
+            binding(6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_FRAGMENT_BIT),
         },
         .debugName = "Renderer::mForwardShadingDsLayout"
     };
@@ -2197,14 +3350,13 @@ void Renderer::addDirShadowMap(const DirShadowData& shadowData)
     mDirShadowMaps.emplace_back();
     createDirShadowMap(mDirShadowMaps.back(), mDirLights.size() - 1);
 
-    // update buffer
-    mDirShadowDataSSBO.update(0,
-                              sizeof(DirShadowData) * mDirShadowData.size(),
-                              mDirShadowData.data());
+    mShadowDataDirtyFrames = allFramesDirty(mRenderDevice);
 }
 
 void Renderer::updateDirShadowsMaps()
 {
+    PROFILE_ZONE("Renderer::updateDirShadowsMaps");
+
     for (auto [id, index] : mUuidToDirLightIndex)
     {
         DirShadowData& dsd = mDirShadowData.at(index);
@@ -2226,11 +3378,14 @@ void Renderer::updateDirShadowsMaps()
     }
 
     if (!mDirLights.empty())
-        mDirShadowDataSSBO.update(0, sizeof(DirShadowData) * mDirLights.size(), mDirShadowData.data());
+        mShadowDataDirtyFrames = allFramesDirty(mRenderDevice);
 }
 
 void Renderer::updateDirShadowMapImage(uuid32_t id)
 {
+    // the old shadow map may still be in use by the frames in flight
+    vkDeviceWaitIdle(mRenderDevice.device);
+
     index_t i = mUuidToDirLightIndex.at(id);
     createDirShadowMap(mDirShadowMaps.at(i), i);
 }
@@ -2249,40 +3404,55 @@ void Renderer::createDirShadowMap(DirShadowMap &shadowMap, index_t index)
         resolution,
         resolution,
         VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
-            VK_IMAGE_USAGE_SAMPLED_BIT,
+            VK_IMAGE_USAGE_SAMPLED_BIT |
+            VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+            VK_IMAGE_USAGE_TRANSFER_DST_BIT,
         VK_IMAGE_ASPECT_DEPTH_BIT,
         1, VK_SAMPLE_COUNT_1_BIT, cascadeCount
     };
 
-    shadowMap.shadowMap.createLayerImageViews(VK_IMAGE_VIEW_TYPE_2D);
+    shadowMap.staticShadowMap = {
+        mRenderDevice,
+        VK_IMAGE_VIEW_TYPE_2D_ARRAY,
+        VK_FORMAT_D32_SFLOAT,
+        resolution,
+        resolution,
+        VK_IMAGE_USAGE_SAMPLED_BIT |
+            VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+            VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+        VK_IMAGE_ASPECT_DEPTH_BIT,
+        1, VK_SAMPLE_COUNT_1_BIT, cascadeCount
+    };
 
-    // delete prev framebuffers
-    for (auto fb : shadowMap.framebuffers)
-        vkDestroyFramebuffer(mRenderDevice.device, fb, nullptr);
+    // the shadow pass loads the faces it doesn't redraw
+    shadowMap.shadowMap.transitionLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+                                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                                         0, VK_ACCESS_SHADER_READ_BIT);
+    shadowMap.staticShadowMap.transitionLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                               VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                               0, VK_ACCESS_TRANSFER_READ_BIT);
+    shadowMap.caches.assign(cascadeCount, {});
 
-    // create framebuffers
-    shadowMap.framebuffers.resize(cascadeCount);
-    for (uint32_t i = 0; i < cascadeCount; ++i)
-    {
-        VkFramebufferCreateInfo framebufferCreateInfo {
-            .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-            .renderPass = mDirShadowRenderpass,
-            .attachmentCount = 1,
-            .pAttachments = &shadowMap.shadowMap.layerImageViews.at(i),
-            .width = resolution,
-            .height = resolution,
-            .layers = 1
-        };
+    // one layer per cascade
+    vkDestroyFramebuffer(mRenderDevice.device, shadowMap.framebuffer, nullptr);
+    VkFramebufferCreateInfo framebufferCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+        .renderPass = mShadowRenderpass,
+        .attachmentCount = 1,
+        .pAttachments = &shadowMap.shadowMap.imageView,
+        .width = resolution,
+        .height = resolution,
+        .layers = cascadeCount
+    };
 
-        VkResult result = vkCreateFramebuffer(mRenderDevice.device,
-                                              &framebufferCreateInfo,
-                                              nullptr,
-                                              &shadowMap.framebuffers.at(i));
-        vulkanCheck(result, "Failed to create framebuffer");
-        setFramebufferDebugName(mRenderDevice,
-                                shadowMap.framebuffers.at(i),
-                                std::format("DirShadowMap::framebuffers.at({})", i));
-    }
+    VkResult result = vkCreateFramebuffer(mRenderDevice.device,
+                                          &framebufferCreateInfo,
+                                          nullptr,
+                                          &shadowMap.framebuffer);
+    vulkanCheck(result, "Failed to create framebuffer");
+    setFramebufferDebugName(mRenderDevice,
+                            shadowMap.framebuffer,
+                            "DirShadowMap::framebuffer");
 
     // update ds
     VkDescriptorImageInfo imageInfo {
@@ -2291,17 +3461,20 @@ void Renderer::createDirShadowMap(DirShadowMap &shadowMap, index_t index)
         .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
     };
 
-    VkWriteDescriptorSet writeDescriptorSet {
-        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-        .dstSet = mLightsDs,
-        .dstBinding = 9,
-        .dstArrayElement = index,
-        .descriptorCount = 1,
-        .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
-        .pImageInfo = &imageInfo
-    };
+    for (VkDescriptorSet lightsDs : mLightsDs)
+    {
+        VkWriteDescriptorSet writeDescriptorSet {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = lightsDs,
+            .dstBinding = 9,
+            .dstArrayElement = index,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            .pImageInfo = &imageInfo
+        };
 
-    vkUpdateDescriptorSets(mRenderDevice.device, 1, &writeDescriptorSet, 0, nullptr);
+        vkUpdateDescriptorSets(mRenderDevice.device, 1, &writeDescriptorSet, 0, nullptr);
+    }
 }
 
 void Renderer::deleteDirShadowMap(uuid32_t id)
@@ -2322,29 +3495,29 @@ void Renderer::deleteDirShadowMap(uuid32_t id)
             .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
         };
 
-        VkWriteDescriptorSet writeDs {
-            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-            .dstSet = mLightsDs,
-            .dstBinding = 9,
-            .dstArrayElement = removeIndex,
-            .descriptorCount = 1,
-            .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
-            .pImageInfo = &imageInfo
-        };
+        for (VkDescriptorSet lightsDs : mLightsDs)
+        {
+            VkWriteDescriptorSet writeDs {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = lightsDs,
+                .dstBinding = 9,
+                .dstArrayElement = removeIndex,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+                .pImageInfo = &imageInfo
+            };
 
-        vkUpdateDescriptorSets(mRenderDevice.device, 1, &writeDs, 0, nullptr);
+            vkUpdateDescriptorSets(mRenderDevice.device, 1, &writeDs, 0, nullptr);
+        }
     }
 
     // delete last index
-    for (auto& framebuffer : mDirShadowMaps.back().framebuffers)
-        vkDestroyFramebuffer(mRenderDevice.device, framebuffer, nullptr);
+    vkDestroyFramebuffer(mRenderDevice.device, mDirShadowMaps.back().framebuffer, nullptr);
 
     mDirShadowData.pop_back();
     mDirShadowMaps.pop_back();
 
-    // update ssbo
-    if (!mDirShadowData.empty())
-        mDirShadowDataSSBO.update(0, sizeof(DirShadowData) * mDirShadowData.size(), mDirShadowData.data());
+    mShadowDataDirtyFrames = allFramesDirty(mRenderDevice);
 }
 
 DirShadowData &Renderer::getDirShadowData(uuid32_t id)
@@ -2361,91 +3534,16 @@ DirShadowMap &Renderer::getDirShadowMap(uuid32_t id)
 
 void Renderer::addPointShadowMap(const PointShadowData& shadowData)
 {
-    // add resources
+    // add resources, the faces get their tiles once the atlas is allocated
     mPointShadowData.emplace_back(shadowData);
     mPointShadowMaps.emplace_back();
-    createPointShadowMap(mPointShadowMaps.back(), mPointLights.size() - 1, mPointShadowData.back().resolution);
 
-    // update buffer
-    mPointShadowDataSSBO.update(0,
-                               sizeof(PointShadowData) * mPointShadowData.size(),
-                               mPointShadowData.data());
+    mShadowDataDirtyFrames = allFramesDirty(mRenderDevice);
 }
 
 void Renderer::updatePointShadowMapData(uuid32_t id)
 {
-    index_t i = mUuidToPointLightIndex.at(id);
-    mPointShadowDataSSBO.update(sizeof(PointShadowData) * i, sizeof(PointShadowData), &mPointShadowData.at(i));
-}
-
-void Renderer::updatePointShadowMapImage(uuid32_t id)
-{
-    index_t i = mUuidToPointLightIndex.at(id);
-    uint32_t resolution =  mPointShadowData.at(i).resolution;
-
-    // create new image
-    createPointShadowMap(mPointShadowMaps.at(i), i, resolution);
-}
-
-void Renderer::createPointShadowMap(PointShadowMap &shadowMap, index_t index, uint32_t resolution)
-{
-    shadowMap.shadowMap = {
-        mRenderDevice,
-        VK_IMAGE_VIEW_TYPE_CUBE,
-        VK_FORMAT_D32_SFLOAT,
-        resolution,
-        resolution,
-        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
-            VK_IMAGE_USAGE_SAMPLED_BIT,
-        VK_IMAGE_ASPECT_DEPTH_BIT,
-        1, VK_SAMPLE_COUNT_1_BIT, 6,
-        VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT
-    };
-
-    shadowMap.shadowMap.createLayerImageViews(VK_IMAGE_VIEW_TYPE_2D);
-
-    // create framebuffers
-    for (uint32_t i = 0; i < 6; ++i)
-    {
-        vkDestroyFramebuffer(mRenderDevice.device, shadowMap.framebuffers[i], nullptr);
-        VkFramebufferCreateInfo framebufferCreateInfo {
-            .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-            .renderPass = mPointShadowRenderpass,
-            .attachmentCount = 1,
-            .pAttachments = &shadowMap.shadowMap.layerImageViews.at(i),
-            .width = resolution,
-            .height = resolution,
-            .layers = 1
-        };
-
-        VkResult result = vkCreateFramebuffer(mRenderDevice.device,
-                                              &framebufferCreateInfo,
-                                              nullptr,
-                                              &shadowMap.framebuffers[i]);
-        vulkanCheck(result, "Failed to create framebuffer");
-        setFramebufferDebugName(mRenderDevice,
-                                shadowMap.framebuffers[i],
-                                std::format("PointShadowMap::framebuffers[{}]", i));
-    }
-
-    // update ds
-    VkDescriptorImageInfo imageInfo {
-        .sampler = VK_NULL_HANDLE,
-        .imageView = shadowMap.shadowMap.imageView,
-        .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
-    };
-
-    VkWriteDescriptorSet writeDescriptorSet {
-        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-        .dstSet = mLightsDs,
-        .dstBinding = 10,
-        .dstArrayElement = index,
-        .descriptorCount = 1,
-        .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
-        .pImageInfo = &imageInfo
-    };
-
-    vkUpdateDescriptorSets(mRenderDevice.device, 1, &writeDescriptorSet, 0, nullptr);
+    mShadowDataDirtyFrames = allFramesDirty(mRenderDevice);
 }
 
 void Renderer::deletePointShadowMap(uuid32_t id)
@@ -2453,42 +3551,18 @@ void Renderer::deletePointShadowMap(uuid32_t id)
     index_t removeIndex = mUuidToPointLightIndex.at(id);
     index_t lastIndex = mPointLights.size() - 1;
 
+    // move options + atlas tiles
     if (removeIndex != lastIndex)
     {
-        // move options + shadow resources
         std::swap(mPointShadowData.at(removeIndex), mPointShadowData.at(lastIndex));
         std::swap(mPointShadowMaps.at(removeIndex), mPointShadowMaps.at(lastIndex));
-
-        // update ds
-        VkDescriptorImageInfo imageInfo {
-            .sampler = VK_NULL_HANDLE,
-            .imageView = mPointShadowMaps.at(removeIndex).shadowMap.imageView,
-            .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
-        };
-
-        VkWriteDescriptorSet writeDs {
-            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-            .dstSet = mLightsDs,
-            .dstBinding = 10,
-            .dstArrayElement = removeIndex,
-            .descriptorCount = 1,
-            .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
-            .pImageInfo = &imageInfo
-        };
-
-        vkUpdateDescriptorSets(mRenderDevice.device, 1, &writeDs, 0, nullptr);
     }
 
     // delete last index
-    for (auto & framebuffer : mPointShadowMaps.back().framebuffers)
-        vkDestroyFramebuffer(mRenderDevice.device, framebuffer, nullptr);
-
     mPointShadowData.pop_back();
     mPointShadowMaps.pop_back();
 
-    // update ssbo
-    if (!mPointShadowData.empty())
-        mPointShadowDataSSBO.update(0, sizeof(PointShadowData) * mPointShadowData.size(), mPointShadowData.data());
+    mShadowDataDirtyFrames = allFramesDirty(mRenderDevice);
 }
 
 PointShadowData &Renderer::getPointShadowData(uuid32_t id)
@@ -2505,124 +3579,35 @@ PointShadowMap &Renderer::getPointShadowMap(uuid32_t id)
 
 void Renderer::addSpotShadowMap(const SpotShadowData& shadowData)
 {
-    // add resources
+    // add resources, the tile is handed out once the atlas is allocated
     mSpotShadowData.emplace_back(shadowData);
     mSpotShadowMaps.emplace_back();
-    createSpotShadowMap(mSpotShadowMaps.back(), mSpotLights.size() - 1, mSpotShadowData.back().resolution);
 
-    // update buffer
-    mSpotShadowDataSSBO.update(0,
-                               sizeof(SpotShadowData) * mSpotShadowData.size(),
-                               mSpotShadowData.data());
+    mShadowDataDirtyFrames = allFramesDirty(mRenderDevice);
 }
 
 void Renderer::updateSpotShadowMapData(uuid32_t id)
 {
-    index_t i = mUuidToSpotLightIndex.at(id);
-    mSpotShadowDataSSBO.update(sizeof(SpotShadowData) * i, sizeof(SpotShadowData), &mSpotShadowData.at(i));
-}
-
-void Renderer::updateSpotShadowMapImage(uuid32_t id)
-{
-    index_t i = mUuidToSpotLightIndex.at(id);
-    uint32_t resolution =  mSpotShadowData.at(i).resolution;
-
-    // create new image
-    createSpotShadowMap(mSpotShadowMaps.at(i), i, resolution);
+    mShadowDataDirtyFrames = allFramesDirty(mRenderDevice);
 }
 
-void Renderer::createSpotShadowMap(SpotShadowMap& shadowMap, index_t index, uint32_t resolution)
-{
-    shadowMap.shadowMap = {
-        mRenderDevice,
-        VK_IMAGE_VIEW_TYPE_2D,
-        VK_FORMAT_D32_SFLOAT,
-        resolution,
-        resolution,
-        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
-            VK_IMAGE_USAGE_SAMPLED_BIT,
-        VK_IMAGE_ASPECT_DEPTH_BIT
-    };
-
-    vkDestroyFramebuffer(mRenderDevice.device, shadowMap.framebuffer, nullptr);
-    VkFramebufferCreateInfo framebufferCreateInfo {
-        .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-        .renderPass = mSpotShadowRenderpass,
-        .attachmentCount = 1,
-        .pAttachments = &shadowMap.shadowMap.imageView,
-        .width = resolution,
-        .height = resolution,
-        .layers = 1
-    };
-
-    VkResult result = vkCreateFramebuffer(mRenderDevice.device,
-                                          &framebufferCreateInfo,
-                                          nullptr,
-                                          &shadowMap.framebuffer);
-    vulkanCheck(result, "Failed to create framebuffer");
-    setFramebufferDebugName(mRenderDevice,
-                            shadowMap.framebuffer,
-                            "SpotShadowMap::framebuffer");
-
-    // update ds
-    VkDescriptorImageInfo imageInfo {
-        .sampler = VK_NULL_HANDLE,
-        .imageView = shadowMap.shadowMap.imageView,
-        .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
-    };
-
-    VkWriteDescriptorSet writeDescriptorSet {
-        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-        .dstSet = mLightsDs,
-        .dstBinding = 11,
-        .dstArrayElement = index,
-        .descriptorCount = 1,
-        .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
-        .pImageInfo = &imageInfo
-    };
-
-    vkUpdateDescriptorSets(mRenderDevice.device, 1, &writeDescriptorSet, 0, nullptr);
-}
-
-void Renderer::deleteSpotShadowMap(uuid32_t id)
-{
-    index_t removeIndex = mUuidToSpotLightIndex.at(id);
-    index_t lastIndex = mSpotLights.size() - 1;
-
-    if (removeIndex != lastIndex)
-    {
-        // move options + shadow resources
-        std::swap(mSpotShadowData.at(removeIndex), mSpotShadowData.at(lastIndex));
-        std::swap(mSpotShadowMaps.at(removeIndex), mSpotShadowMaps.at(lastIndex));
-
-        // update ds
-        VkDescriptorImageInfo imageInfo {
-            .sampler = VK_NULL_HANDLE,
-            .imageView = mSpotShadowMaps.at(removeIndex).shadowMap.imageView,
-            .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
-        };
-
-        VkWriteDescriptorSet writeDs {
-            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-            .dstSet = mLightsDs,
-            .dstBinding = 11,
-            .dstArrayElement = removeIndex,
-            .descriptorCount = 1,
-            .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
-            .pImageInfo = &imageInfo
-        };
-
-        vkUpdateDescriptorSets(mRenderDevice.device, 1, &writeDs, 0, nullptr);
+void Renderer::deleteSpotShadowMap(uuid32_t id)
+{
+    index_t removeIndex = mUuidToSpotLightIndex.at(id);
+    index_t lastIndex = mSpotLights.size() - 1;
+
+    // move options + atlas tile
+    if (removeIndex != lastIndex)
+    {
+        std::swap(mSpotShadowData.at(removeIndex), mSpotShadowData.at(lastIndex));
+        std::swap(mSpotShadowMaps.at(removeIndex), mSpotShadowMaps.at(lastIndex));
     }
 
     // delete last index
-    vkDestroyFramebuffer(mRenderDevice.device, mSpotShadowMaps.back().framebuffer, nullptr);
     mSpotShadowData.pop_back();
     mSpotShadowMaps.pop_back();
 
-    // update ssbo
-    if (!mSpotShadowData.empty())
-        mSpotShadowDataSSBO.update(0, sizeof(SpotShadowData) * mSpotShadowData.size(), mSpotShadowData.data());
+    mShadowDataDirtyFrames = allFramesDirty(mRenderDevice);
 }
 
 SpotShadowData &Renderer::getSpotShadowData(uuid32_t id)
@@ -2639,13 +3624,16 @@ SpotShadowMap &Renderer::getSpotShadowMap(uuid32_t id)
 
 void Renderer::createShadowMapBuffers()
 {
-    mDirShadowDataSSBO = {mRenderDevice, MaxDirLights * sizeof(DirShadowData), BufferType::Storage, MemoryType::Device};
-    mPointShadowDataSSBO = {mRenderDevice, MaxDirLights * sizeof(PointShadowData), BufferType::Storage, MemoryType::Device};
-    mSpotShadowDataSSBO = {mRenderDevice, MaxDirLights * sizeof(SpotShadowData), BufferType::Storage, MemoryType::Device};
+    for (uint32_t i = 0; i < mRenderDevice.framesInFlight; ++i)
+    {
+        mDirShadowDataSSBOs.at(i) = {mRenderDevice, MaxDirLights * sizeof(DirShadowData), BufferType::Storage, MemoryType::HostCoherent};
+        mPointShadowDataSSBOs.at(i) = {mRenderDevice, MaxPointLights * sizeof(PointShadowData), BufferType::Storage, MemoryType::HostCoherent};
+        mSpotShadowDataSSBOs.at(i) = {mRenderDevice, MaxSpotLights * sizeof(SpotShadowData), BufferType::Storage, MemoryType::HostCoherent};
 
-    mDirShadowDataSSBO.setDebugName("Renderer::mDirShadowDataSSBO");
-    mPointShadowDataSSBO.setDebugName("Renderer::mPointShadowDataSSBO");
-    mSpotShadowDataSSBO.setDebugName("Renderer::mSpotShadowDataSSBO");
+        mDirShadowDataSSBOs.at(i).setDebugName(std::format("Renderer::mDirShadowDataSSBOs.at({})", i));
+        mPointShadowDataSSBOs.at(i).setDebugName(std::format("Renderer::mPointShadowDataSSBOs.at({})", i));
+        mSpotShadowDataSSBOs.at(i).setDebugName(std::format("Renderer::mSpotShadowDataSSBOs.at({})", i));
+    }
 }
 
 void Renderer::createShadowMapSamplers()
@@ -2684,14 +3672,15 @@ void Renderer::createShadowMapSamplers()
                              mSpotShadowMapSampler.sampler);
 }
 
-void Renderer::createDirShadowRenderpass()
+// faces that aren't redrawn keep their contents, so the shadow pass loads and clears the redrawn faces itself
+void Renderer::createShadowRenderpass()
 {
     VkAttachmentDescription attachment {
         .format = VK_FORMAT_D32_SFLOAT,
         .samples = VK_SAMPLE_COUNT_1_BIT,
-        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .loadOp = VK_ATTACHMENT_LOAD_OP_LOAD,
         .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
-        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
         .finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
     };
 
@@ -2705,15 +3694,27 @@ void Renderer::createDirShadowRenderpass()
         .pDepthStencilAttachment = &attachmentRef
     };
 
-    VkSubpassDependency dependency {
-        .srcSubpass = 0,
-        .dstSubpass = VK_SUBPASS_EXTERNAL,
-        .srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
-        .dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-        .srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
-        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
-        .dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT
-    };
+    // the previous frame's forward pass may still be sampling the faces that get redrawn
+    std::array<VkSubpassDependency, 2> dependencies {{
+        {
+            .srcSubpass = VK_SUBPASS_EXTERNAL,
+            .dstSubpass = 0,
+            .srcStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+            .srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            .dependencyFlags = 0
+        },
+        {
+            .srcSubpass = 0,
+            .dstSubpass = VK_SUBPASS_EXTERNAL,
+            .srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            .srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+            .dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT
+        }
+    }};
 
     VkRenderPassCreateInfo renderPassCreateInfo {
         .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
@@ -2721,13 +3722,109 @@ void Renderer::createDirShadowRenderpass()
         .pAttachments = &attachment,
         .subpassCount = 1,
         .pSubpasses = &subpass,
-        .dependencyCount = 1,
-        .pDependencies = &dependency
+        .dependencyCount = static_cast<uint32_t>(dependencies.size()),
+        .pDependencies = dependencies.data()
     };
 
-    VkResult result = vkCreateRenderPass(mRenderDevice.device, &renderPassCreateInfo, nullptr, &mDirShadowRenderpass);
+    VkResult result = vkCreateRenderPass(mRenderDevice.device, &renderPassCreateInfo, nullptr, &mShadowRenderpass);
     vulkanCheck(result, "Failed to create renderpass.");
-    setRenderpassDebugName(mRenderDevice, mDirShadowRenderpass, "Renderer::mDirShadowRenderpass");
+    setRenderpassDebugName(mRenderDevice, mShadowRenderpass, "Renderer::mShadowRenderpass");
+}
+
+void Renderer::createShadowAtlas()
+{
+    mShadowAtlas = {
+        mRenderDevice,
+        VK_IMAGE_VIEW_TYPE_2D_ARRAY,
+        VK_FORMAT_D32_SFLOAT,
+        mShadowAtlasResolution,
+        mShadowAtlasResolution,
+        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+            VK_IMAGE_USAGE_SAMPLED_BIT |
+            VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+            VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+        VK_IMAGE_ASPECT_DEPTH_BIT,
+        1, VK_SAMPLE_COUNT_1_BIT, mShadowAtlasPages
+    };
+
+    mStaticShadowAtlas = {
+        mRenderDevice,
+        VK_IMAGE_VIEW_TYPE_2D_ARRAY,
+        VK_FORMAT_D32_SFLOAT,
+        mShadowAtlasResolution,
+        mShadowAtlasResolution,
+        VK_IMAGE_USAGE_SAMPLED_BIT |
+            VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+            VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+        VK_IMAGE_ASPECT_DEPTH_BIT,
+        1, VK_SAMPLE_COUNT_1_BIT, mShadowAtlasPages
+    };
+
+    mShadowAtlas.setDebugName("Renderer::mShadowAtlas");
+    mStaticShadowAtlas.setDebugName("Renderer::mStaticShadowAtlas");
+
+    mShadowAtlas.transitionLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+                                  VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                                  0, VK_ACCESS_SHADER_READ_BIT);
+    mStaticShadowAtlas.transitionLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                        0, VK_ACCESS_TRANSFER_READ_BIT);
+
+    // one layer per page
+    vkDestroyFramebuffer(mRenderDevice.device, mShadowAtlasFramebuffer, nullptr);
+    VkFramebufferCreateInfo framebufferCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+        .renderPass = mShadowRenderpass,
+        .attachmentCount = 1,
+        .pAttachments = &mShadowAtlas.imageView,
+        .width = mShadowAtlasResolution,
+        .height = mShadowAtlasResolution,
+        .layers = mShadowAtlasPages
+    };
+
+    VkResult result = vkCreateFramebuffer(mRenderDevice.device,
+                                          &framebufferCreateInfo,
+                                          nullptr,
+                                          &mShadowAtlasFramebuffer);
+    vulkanCheck(result, "Failed to create framebuffer");
+    setFramebufferDebugName(mRenderDevice,
+                            mShadowAtlasFramebuffer,
+                            "Renderer::mShadowAtlasFramebuffer");
+
+    // every tile has to be handed out and drawn again
+    for (PointShadowMap& shadowMap : mPointShadowMaps)
+        shadowMap = {};
+    for (SpotShadowMap& shadowMap : mSpotShadowMaps)
+        shadowMap = {};
+}
+
+void Renderer::updateShadowAtlasImage()
+{
+    // the old atlas may still be in use by the frames in flight
+    vkDeviceWaitIdle(mRenderDevice.device);
+
+    createShadowAtlas();
+
+    VkDescriptorImageInfo imageInfo {
+        .sampler = VK_NULL_HANDLE,
+        .imageView = mShadowAtlas.imageView,
+        .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+    };
+
+    for (VkDescriptorSet lightsDs : mLightsDs)
+    {
+        VkWriteDescriptorSet writeDescriptorSet {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = lightsDs,
+            .dstBinding = 10,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            .pImageInfo = &imageInfo
+        };
+
+        vkUpdateDescriptorSets(mRenderDevice.device, 1, &writeDescriptorSet, 0, nullptr);
+    }
 }
 
 void Renderer::createDirShadowPipeline()
@@ -2775,11 +3872,11 @@ void Renderer::createDirShadowPipeline()
                 {
                     .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
                     .offset = 0,
-                    .size = sizeof(glm::mat4)
+                    .size = sizeof(glm::mat4) + sizeof(uint32_t)
                 }
             }
         },
-        .renderPass = mDirShadowRenderpass,
+        .renderPass = mShadowRenderpass,
         .subpassIndex = 0,
         .debugName = "Renderer::mDirShadowPipeline"
     };
@@ -2787,52 +3884,6 @@ void Renderer::createDirShadowPipeline()
     mDirShadowPipeline = {mRenderDevice, specification};
 }
 
-void Renderer::createSpotShadowRenderpass()
-{
-    VkAttachmentDescription attachment {
-        .format = VK_FORMAT_D32_SFLOAT,
-        .samples = VK_SAMPLE_COUNT_1_BIT,
-        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
-        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
-        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-        .finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
-    };
-
-    VkAttachmentReference attachmentRef {
-        .attachment = 0,
-        .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
-    };
-
-    VkSubpassDescription subpass {
-        .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
-        .pDepthStencilAttachment = &attachmentRef
-    };
-
-    VkSubpassDependency dependency {
-        .srcSubpass = 0,
-        .dstSubpass = VK_SUBPASS_EXTERNAL,
-        .srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
-        .dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-        .srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
-        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
-        .dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT
-    };
-
-    VkRenderPassCreateInfo renderPassCreateInfo {
-        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
-        .attachmentCount = 1,
-        .pAttachments = &attachment,
-        .subpassCount = 1,
-        .pSubpasses = &subpass,
-        .dependencyCount = 1,
-        .pDependencies = &dependency
-    };
-
-    VkResult result = vkCreateRenderPass(mRenderDevice.device, &renderPassCreateInfo, nullptr, &mSpotShadowRenderpass);
-    vulkanCheck(result, "Failed to create renderpass.");
-    setRenderpassDebugName(mRenderDevice, mSpotShadowRenderpass, "Renderer::mSpotShadowRenderpass");
-}
-
 void Renderer::createSpotShadowPipeline()
 {
     PipelineSpecification specification {
@@ -2878,12 +3929,12 @@ void Renderer::createSpotShadowPipeline()
                 {
                     .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
                     .offset = 0,
-                    .size = sizeof(glm::mat4)
+                    .size = sizeof(glm::mat4) + sizeof(uint32_t)
                 }
 
             }
         },
-        .renderPass = mSpotShadowRenderpass,
+        .renderPass = mShadowRenderpass,
         .subpassIndex = 0,
         .debugName = "Renderer::mSpotShadowPipeline"
     };
@@ -2891,52 +3942,6 @@ void Renderer::createSpotShadowPipeline()
     mSpotShadowPipeline = {mRenderDevice, specification};
 }
 
-void Renderer::createPointShadowRenderpass()
-{
-    VkAttachmentDescription attachment {
-        .format = VK_FORMAT_D32_SFLOAT,
-        .samples = VK_SAMPLE_COUNT_1_BIT,
-        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
-        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
-        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-        .finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
-    };
-
-    VkAttachmentReference attachmentRef {
-        .attachment = 0,
-        .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
-    };
-
-    VkSubpassDescription subpass {
-        .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
-        .pDepthStencilAttachment = &attachmentRef
-    };
-
-    VkSubpassDependency dependency {
-        .srcSubpass = 0,
-        .dstSubpass = VK_SUBPASS_EXTERNAL,
-        .srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
-        .dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-        .srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
-        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
-        .dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT
-    };
-
-    VkRenderPassCreateInfo renderPassCreateInfo {
-        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
-        .attachmentCount = 1,
-        .pAttachments = &attachment,
-        .subpassCount = 1,
-        .pSubpasses = &subpass,
-        .dependencyCount = 1,
-        .pDependencies = &dependency
-    };
-
-    VkResult result = vkCreateRenderPass(mRenderDevice.device, &renderPassCreateInfo, nullptr, &mPointShadowRenderpass);
-    vulkanCheck(result, "Failed to create renderpass.");
-    setRenderpassDebugName(mRenderDevice, mPointShadowRenderpass, "Renderer::mPointShadowRenderpass");
-}
-
 void Renderer::createPointShadowPipeline()
 {
     PipelineSpecification specification {
@@ -2982,16 +3987,11 @@ void Renderer::createPointShadowPipeline()
                 {
                     .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
                     .offset = 0,
-                    .size = sizeof(glm::mat4)
-                },
-                {
-                    .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
-                    .offset = sizeof(glm::mat4),
-                    .size = sizeof(glm::vec4) + sizeof(float) * 2
+                    .size = sizeof(glm::mat4) + sizeof(uint32_t)
                 }
             }
         },
-        .renderPass = mSpotShadowRenderpass,
+        .renderPass = mShadowRenderpass,
         .subpassIndex = 0,
         .debugName = "Renderer::mPointShadowPipeline"
     };
@@ -3006,7 +4006,7 @@ void Renderer::createPrepassRenderpass()
         .samples = SampleCount,
         .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
         .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
-        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
         .finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
     };
 
@@ -3115,14 +4115,145 @@ void Renderer::createPrepassPipeline()
     mPrepassPipeline = VulkanGraphicsPipeline(mRenderDevice, specification);
 }
 
-void Renderer::createVolumeClusterSSBO()
-{
-    uint32_t clusterCount = mClusterGridSize.x * mClusterGridSize.y * mClusterGridSize.z;
-    mVolumeClustersSSBO = {mRenderDevice,
-                           sizeof(Cluster) * clusterCount,
-                           BufferType::Storage,
-                           MemoryType::Device};
-    mVolumeClustersSSBO.setDebugName("Renderer::mVolumeClustersSSBO");
+void Renderer::createVolumeClusterSSBO()
+{
+    uint32_t clusterCount = mClusterGridSize.x * mClusterGridSize.y * mClusterGridSize.z;
+    mVolumeClustersSSBO = {mRenderDevice,
+                           sizeof(Cluster) * clusterCount,
+                           BufferType::Storage,
+                           MemoryType::Device};
+    mVolumeClustersSSBO.setDebugName("Renderer::mVolumeClustersSSBO");
+}
+
+void Renderer::createLightGridSSBO()
+{
+    uint32_t clusterCount = mClusterGridSize.x * mClusterGridSize.y * mClusterGridSize.z;
+
+    for (uint32_t i = 0; i < mRenderDevice.framesInFlight; ++i)
+    {
+        mLightGridSSBOs.at(i) = {mRenderDevice,
+                                 sizeof(LightRange) * clusterCount,
+                                 BufferType::Storage,
+                                 MemoryType::Device};
+        mLightGridSSBOs.at(i).setDebugName(std::format("Renderer::mLightGridSSBOs.at({})", i));
+    }
+}
+
+void Renderer::createLightIndexSSBO(uint32_t capacity)
+{
+    mLightIndexCapacity = capacity;
+
+    for (uint32_t i = 0; i < mRenderDevice.framesInFlight; ++i)
+    {
+        mLightIndexSSBOs.at(i) = {mRenderDevice,
+                                  sizeof(uint32_t) * (capacity + 1),
+                                  BufferType::Storage,
+                                  MemoryType::Device};
+        mLightIndexSSBOs.at(i).setDebugName(std::format("Renderer::mLightIndexSSBOs.at({})", i));
+    }
+}
+
+void Renderer::createActiveClusterSSBOs()
+{
+    uint32_t clusterCount = mClusterGridSize.x * mClusterGridSize.y * mClusterGridSize.z;
+
+    for (uint32_t i = 0; i < mRenderDevice.framesInFlight; ++i)
+    {
+        mClusterFlagsSSBOs.at(i) = {mRenderDevice,
+                                    sizeof(uint32_t) * clusterCount,
+                                    BufferType::Storage,
+                                    MemoryType::Device};
+        mClusterFlagsSSBOs.at(i).setDebugName(std::format("Renderer::mClusterFlagsSSBOs.at({})", i));
+
+        // the indirect dispatch and the cluster count, then the clusters
+        mActiveClustersSSBOs.at(i) = {mRenderDevice,
+                                      sizeof(uint32_t) * (4 + clusterCount),
+                                      BufferType::Indirect,
+                                      MemoryType::Device};
+        mActiveClustersSSBOs.at(i).setDebugName(std::format("Renderer::mActiveClustersSSBOs.at({})", i));
+    }
+}
+
+void Renderer::createClusterLightSSBOs()
+{
+    // a light lands in at most every bin
+    uint32_t maxLights = MaxPointLights + MaxSpotLights;
+    uint32_t binCount = mClusterGridSize.y * mClusterGridSize.z;
+
+    for (uint32_t i = 0; i < mRenderDevice.framesInFlight; ++i)
+    {
+        mClusterLightSSBOs.at(i) = {mRenderDevice, maxLights * sizeof(ClusterLight), BufferType::Storage, MemoryType::HostCoherent};
+        mLightBinSSBOs.at(i) = {mRenderDevice, binCount * sizeof(LightRange), BufferType::Storage, MemoryType::HostCoherent};
+        mBinnedLightSSBOs.at(i) = {mRenderDevice, maxLights * binCount * sizeof(uint32_t), BufferType::Storage, MemoryType::HostCoherent};
+
+        mClusterLightSSBOs.at(i).setDebugName(std::format("Renderer::mClusterLightSSBOs.at({})", i));
+        mLightBinSSBOs.at(i).setDebugName(std::format("Renderer::mLightBinSSBOs.at({})", i));
+        mBinnedLightSSBOs.at(i).setDebugName(std::format("Renderer::mBinnedLightSSBOs.at({})", i));
+    }
+}
+
+void Renderer::createCullInstancesPipelineLayout()
+{
+    VkPushConstantRange pushConstantRange {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = sizeof(glm::vec4) * 3
+    };
+
+    std::array<VkDescriptorSetLayout, 2> setLayouts {
+        mCameraRenderDataDsLayout,
+        mCullInstancesDsLayout
+    };
+
+    VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = static_cast<uint32_t>(setLayouts.size()),
+        .pSetLayouts = setLayouts.data(),
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &pushConstantRange
+    };
+
+    VkResult result = vkCreatePipelineLayout(mRenderDevice.device,
+                                             &pipelineLayoutCreateInfo,
+                                             nullptr,
+                                             &mCullInstancesPipelineLayout);
+    vulkanCheck(result, "Failed to create pipeline layout.");
+
+    setVulkanObjectDebugName(mRenderDevice,
+                             VK_OBJECT_TYPE_PIPELINE_LAYOUT,
+                             "Renderer::mCullInstancesPipelineLayout",
+                             mCullInstancesPipelineLayout);
+}
+
+void Renderer::createCullInstancesPipeline()
+{
+    VulkanShaderModule shaderModule(mRenderDevice, "shaders/cull_instances.comp.spv");
+
+    VkPipelineShaderStageCreateInfo pipelineShaderStageCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+        .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+        .module = shaderModule,
+        .pName = "main"
+    };
+
+    VkComputePipelineCreateInfo computePipelineCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = pipelineShaderStageCreateInfo,
+        .layout = mCullInstancesPipelineLayout
+    };
+
+    VkResult result = vkCreateComputePipelines(mRenderDevice.device,
+                                               VK_NULL_HANDLE,
+                                               1,
+                                               &computePipelineCreateInfo,
+                                               nullptr,
+                                               &mCullInstancesPipeline);
+    vulkanCheck(result, "Failed to create compute pipeline.");
+
+    setVulkanObjectDebugName(mRenderDevice,
+                             VK_OBJECT_TYPE_PIPELINE,
+                             "Renderer::mCullInstancesPipeline",
+                             mCullInstancesPipeline);
 }
 
 void Renderer::createFrustumClusterGenPipelineLayout()
@@ -3253,6 +4384,89 @@ void Renderer::createAssignLightsToClustersPipeline()
                              mAssignLightsToClustersPipeline);
 }
 
+void Renderer::createActiveClustersPipelineLayout()
+{
+    VkPushConstantRange pushConstantRange {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = sizeof(glm::vec4) * 2
+    };
+
+    std::array<VkDescriptorSetLayout, 2> dsLayouts {
+        mCameraRenderDataDsLayout,
+        mActiveClustersDsLayout
+    };
+
+    VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = static_cast<uint32_t>(dsLayouts.size()),
+        .pSetLayouts = dsLayouts.data(),
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges = &pushConstantRange
+    };
+
+    VkResult result = vkCreatePipelineLayout(mRenderDevice.device,
+                                             &pipelineLayoutCreateInfo,
+                                             nullptr,
+                                             &mActiveClustersPipelineLayout);
+    vulkanCheck(result, "Failed to create pipeline layout.");
+
+    setVulkanObjectDebugName(mRenderDevice,
+                             VK_OBJECT_TYPE_PIPELINE_LAYOUT,
+                             "Renderer::mActiveClustersPipelineLayout",
+                             mActiveClustersPipelineLayout);
+}
+
+void Renderer::createActiveClustersPipelines()
+{
+    VulkanShaderModule flagShaderModule(mRenderDevice, "shaders/flag_active_clusters.comp.spv");
+    VulkanShaderModule compactShaderModule(mRenderDevice, "shaders/compact_active_clusters.comp.spv");
+
+    std::array<VkComputePipelineCreateInfo, 2> computePipelineCreateInfos {{
+        {
+            .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+            .stage = {
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+                .module = flagShaderModule,
+                .pName = "main"
+            },
+            .layout = mActiveClustersPipelineLayout
+        },
+        {
+            .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+            .stage = {
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+                .module = compactShaderModule,
+                .pName = "main"
+            },
+            .layout = mActiveClustersPipelineLayout
+        }
+    }};
+
+    std::array<VkPipeline, 2> pipelines;
+    VkResult result = vkCreateComputePipelines(mRenderDevice.device,
+                                               VK_NULL_HANDLE,
+                                               computePipelineCreateInfos.size(),
+                                               computePipelineCreateInfos.data(),
+                                               nullptr,
+                                               pipelines.data());
+    vulkanCheck(result, "Failed to create compute pipeline.");
+
+    mFlagActiveClustersPipeline = pipelines.at(0);
+    mCompactActiveClustersPipeline = pipelines.at(1);
+
+    setVulkanObjectDebugName(mRenderDevice,
+                             VK_OBJECT_TYPE_PIPELINE,
+                             "Renderer::mFlagActiveClustersPipeline",
+                             mFlagActiveClustersPipeline);
+    setVulkanObjectDebugName(mRenderDevice,
+                             VK_OBJECT_TYPE_PIPELINE,
+                             "Renderer::mCompactActiveClustersPipeline",
+                             mCompactActiveClustersPipeline);
+}
+
 void Renderer::createSkyboxRenderpass()
 {
     VkAttachmentDescription colorAttachment {
@@ -3260,7 +4474,7 @@ void Renderer::createSkyboxRenderpass()
         .samples = SampleCount,
         .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
         .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
-        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
         .finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
     };
 
@@ -3475,7 +4689,7 @@ void Renderer::createSsaoResourcesRenderpass()
         .samples = VK_SAMPLE_COUNT_1_BIT,
         .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
         .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
-        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
         .finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
     };
 
@@ -3484,7 +4698,7 @@ void Renderer::createSsaoResourcesRenderpass()
         .samples = VK_SAMPLE_COUNT_1_BIT,
         .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
         .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
-        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
         .finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
     };
 
@@ -3493,7 +4707,7 @@ void Renderer::createSsaoResourcesRenderpass()
         .samples = VK_SAMPLE_COUNT_1_BIT,
         .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
         .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
-        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
         .finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
     };
 
@@ -3640,7 +4854,7 @@ void Renderer::createSsaoRenderpass()
         .samples = VK_SAMPLE_COUNT_1_BIT,
         .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
         .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
-        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
         .finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
     };
 
@@ -3706,7 +4920,7 @@ void Renderer::createSsaoBlurRenderpass()
         .samples = VK_SAMPLE_COUNT_1_BIT,
         .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
         .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
-        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
         .finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
     };
 
@@ -3934,18 +5148,33 @@ void Renderer::createForwardRenderpass()
         .pDepthStencilAttachment = &depthAttachmentRef,
     };
 
-    VkSubpassDependency dependency {
-        .srcSubpass = 0,
-        .dstSubpass = VK_SUBPASS_EXTERNAL,
-        .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-        .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
-            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-        .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-        .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
-                             VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
-                             VK_ACCESS_SHADER_READ_BIT,
-        .dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT
-    };
+    // the resolve target is discarded every time the pass begins, which has to wait for the bloom and post
+    // processing passes of the previous frame to be done sampling it
+    std::array<VkSubpassDependency, 2> dependencies {{
+        {
+            .srcSubpass = VK_SUBPASS_EXTERNAL,
+            .dstSubpass = 0,
+            .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
+                                 VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+            .dependencyFlags = 0
+        },
+        {
+            .srcSubpass = 0,
+            .dstSubpass = VK_SUBPASS_EXTERNAL,
+            .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
+                                 VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                                 VK_ACCESS_SHADER_READ_BIT,
+            .dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT
+        }
+    }};
 
     VkRenderPassCreateInfo renderPassCreateInfo {
         .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
@@ -3953,8 +5182,8 @@ void Renderer::createForwardRenderpass()
         .pAttachments = attachments.data(),
         .subpassCount = 1,
         .pSubpasses = &subpass,
-        .dependencyCount = 1,
-        .pDependencies = &dependency
+        .dependencyCount = static_cast<uint32_t>(dependencies.size()),
+        .pDependencies = dependencies.data()
     };
 
     VkResult result = vkCreateRenderPass(mRenderDevice.device, &renderPassCreateInfo, nullptr, &mForwardRenderpass);
@@ -4131,7 +5360,7 @@ void Renderer::createPostProcessingRenderpass()
         .samples = VK_SAMPLE_COUNT_1_BIT,
         .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
         .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
-        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
         .finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
     };
 
@@ -4557,13 +5786,16 @@ void Renderer::createGridPipeline()
 
 void Renderer::createLightBuffers()
 {
-    mDirLightSSBO = {mRenderDevice, MaxDirLights * sizeof(DirectionalLight), BufferType::Storage, MemoryType::Device};
-    mSpotLightSSBO = {mRenderDevice, MaxSpotLights * sizeof(SpotLight), BufferType::Storage, MemoryType::Device};
-    mPointLightSSBO = {mRenderDevice, MaxPointLights * sizeof(PointLight), BufferType::Storage, MemoryType::Device};
+    for (uint32_t i = 0; i < mRenderDevice.framesInFlight; ++i)
+    {
+        mDirLightSSBOs.at(i) = {mRenderDevice, MaxDirLights * sizeof(DirectionalLight), BufferType::Storage, MemoryType::HostCoherent};
+        mSpotLightSSBOs.at(i) = {mRenderDevice, MaxSpotLights * sizeof(SpotLight), BufferType::Storage, MemoryType::HostCoherent};
+        mPointLightSSBOs.at(i) = {mRenderDevice, MaxPointLights * sizeof(PointLight), BufferType::Storage, MemoryType::HostCoherent};
 
-    mDirLightSSBO.setDebugName("Renderer::mDirLightSSBO");
-    mSpotLightSSBO.setDebugName("Renderer::mSpotLightSSBO");
-    mPointLightSSBO.setDebugName("Renderer::mPointLightSSBO");
+        mDirLightSSBOs.at(i).setDebugName(std::format("Renderer::mDirLightSSBOs.at({})", i));
+        mSpotLightSSBOs.at(i).setDebugName(std::format("Renderer::mSpotLightSSBOs.at({})", i));
+        mPointLightSSBOs.at(i).setDebugName(std::format("Renderer::mPointLightSSBOs.at({})", i));
+    }
 }
 
 void Renderer::createLightIconTextures()
@@ -5815,7 +7047,7 @@ void Renderer::createCaptureBrightPixelsRenderpass()
         .samples = VK_SAMPLE_COUNT_1_BIT,
         .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
         .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
-        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
         .finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
     };
 
@@ -5928,7 +7160,7 @@ void Renderer::createBloomDownsampleRenderpass()
         .samples = VK_SAMPLE_COUNT_1_BIT,
         .loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
         .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
-        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
         .finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
     };
 
@@ -6248,35 +7480,43 @@ void Renderer::createSingleImageDs(VkDescriptorSet &ds, const VulkanTexture &tex
 
 void Renderer::createCameraDs()
 {
-    VkDescriptorSetLayout dsLayout = mCameraRenderDataDsLayout;
+    std::vector<VkDescriptorSetLayout> dsLayouts(mRenderDevice.framesInFlight, mCameraRenderDataDsLayout);
 
     VkDescriptorSetAllocateInfo descriptorSetAllocateInfo {
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
         .descriptorPool = mRenderDevice.descriptorPool,
-        .descriptorSetCount = 1,
-        .pSetLayouts = &dsLayout
+        .descriptorSetCount = mRenderDevice.framesInFlight,
+        .pSetLayouts = dsLayouts.data()
     };
 
-    VkResult result = vkAllocateDescriptorSets(mRenderDevice.device, &descriptorSetAllocateInfo, &mCameraDs);
+    VkResult result = vkAllocateDescriptorSets(mRenderDevice.device, &descriptorSetAllocateInfo, mCameraDs.data());
     vulkanCheck(result, "Failed to allocate descriptor set.");
 
-    VkDescriptorBufferInfo bufferInfo {
-        .buffer = mCameraUBO.getBuffer(),
-        .offset = 0,
-        .range = sizeof(CameraRenderData)
-    };
+    for (uint32_t i = 0; i < mRenderDevice.framesInFlight; ++i)
+    {
+        setVulkanObjectDebugName(mRenderDevice,
+                                 VK_OBJECT_TYPE_DESCRIPTOR_SET,
+                                 std::format("Renderer::mCameraDs.at({})", i),
+                                 mCameraDs.at(i));
 
-    VkWriteDescriptorSet writeDescriptorSet {
-        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-        .dstSet = mCameraDs,
-        .dstBinding = 0,
-        .dstArrayElement = 0,
-        .descriptorCount = 1,
-        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-        .pBufferInfo = &bufferInfo
-    };
+        VkDescriptorBufferInfo bufferInfo {
+            .buffer = mCameraUBOs.at(i).getBuffer(),
+            .offset = 0,
+            .range = sizeof(CameraRenderData)
+        };
 
-    vkUpdateDescriptorSets(mRenderDevice.device, 1, &writeDescriptorSet, 0, nullptr);
+        VkWriteDescriptorSet writeDescriptorSet {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = mCameraDs.at(i),
+            .dstBinding = 0,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+            .pBufferInfo = &bufferInfo
+        };
+
+        vkUpdateDescriptorSets(mRenderDevice.device, 1, &writeDescriptorSet, 0, nullptr);
+    }
 }
 
 void Renderer::createSingleImageDescriptorSets()
@@ -6362,117 +7602,131 @@ void Renderer::createSsaoDs()
 
 void Renderer::createLightsDs()
 {
-    VkDescriptorSetLayout dsLayout = mLightsDsLayout;
+    std::vector<VkDescriptorSetLayout> dsLayouts(mRenderDevice.framesInFlight, mLightsDsLayout);
+
     VkDescriptorSetAllocateInfo descriptorSetAllocateInfo {
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
         .descriptorPool = mRenderDevice.descriptorPool,
-        .descriptorSetCount = 1,
-        .pSetLayouts = &dsLayout
+        .descriptorSetCount = mRenderDevice.framesInFlight,
+        .pSetLayouts = dsLayouts.data()
     };
 
-    VkResult result = vkAllocateDescriptorSets(mRenderDevice.device, &descriptorSetAllocateInfo, &mLightsDs);
+    VkResult result = vkAllocateDescriptorSets(mRenderDevice.device, &descriptorSetAllocateInfo, mLightsDs.data());
     vulkanCheck(result, "Failed to allocate descriptor set.");
 
-    setVulkanObjectDebugName(mRenderDevice,
-                             VK_OBJECT_TYPE_DESCRIPTOR_SET,
-                             "Renderer::mLightsDs",
-                             mLightsDs);
+    for (uint32_t i = 0; i < mRenderDevice.framesInFlight; ++i)
+    {
+        setVulkanObjectDebugName(mRenderDevice,
+                                 VK_OBJECT_TYPE_DESCRIPTOR_SET,
+                                 std::format("Renderer::mLightsDs.at({})", i),
+                                 mLightsDs.at(i));
 
-    VkDescriptorBufferInfo dirLightBufferInfo {
-        .buffer = mDirLightSSBO.getBuffer(),
-        .offset = 0,
-        .range = VK_WHOLE_SIZE
-    };
+        VkDescriptorBufferInfo dirLightBufferInfo {
+            .buffer = mDirLightSSBOs.at(i).getBuffer(),
+            .offset = 0,
+            .range = VK_WHOLE_SIZE
+        };
 
-    VkDescriptorBufferInfo pointLightBufferInfo {
-        .buffer = mPointLightSSBO.getBuffer(),
-        .offset = 0,
-        .range = VK_WHOLE_SIZE
-    };
+        VkDescriptorBufferInfo pointLightBufferInfo {
+            .buffer = mPointLightSSBOs.at(i).getBuffer(),
+            .offset = 0,
+            .range = VK_WHOLE_SIZE
+        };
 
-    VkDescriptorBufferInfo spotLightBufferInfo {
-        .buffer = mSpotLightSSBO.getBuffer(),
-        .offset = 0,
-        .range = VK_WHOLE_SIZE
-    };
+        VkDescriptorBufferInfo spotLightBufferInfo {
+            .buffer = mSpotLightSSBOs.at(i).getBuffer(),
+            .offset = 0,
+            .range = VK_WHOLE_SIZE
+        };
 
-    VkDescriptorBufferInfo dirShadowOptionsBufferInfo {
-        .buffer = mDirShadowDataSSBO.getBuffer(),
-        .offset = 0,
-        .range = VK_WHOLE_SIZE
-    };
+        VkDescriptorBufferInfo dirShadowOptionsBufferInfo {
+            .buffer = mDirShadowDataSSBOs.at(i).getBuffer(),
+            .offset = 0,
+            .range = VK_WHOLE_SIZE
+        };
 
-    VkDescriptorBufferInfo pointShadowOptionsBufferInfo {
-        .buffer = mPointShadowDataSSBO.getBuffer(),
-        .offset = 0,
-        .range = VK_WHOLE_SIZE
-    };
+        VkDescriptorBufferInfo pointShadowOptionsBufferInfo {
+            .buffer = mPointShadowDataSSBOs.at(i).getBuffer(),
+            .offset = 0,
+            .range = VK_WHOLE_SIZE
+        };
 
-    VkDescriptorBufferInfo spotShadowOptionsBufferInfo {
-        .buffer = mSpotShadowDataSSBO.getBuffer(),
-        .offset = 0,
-        .range = VK_WHOLE_SIZE
-    };
+        VkDescriptorBufferInfo spotShadowOptionsBufferInfo {
+            .buffer = mSpotShadowDataSSBOs.at(i).getBuffer(),
+            .offset = 0,
+            .range = VK_WHOLE_SIZE
+        };
 
-    VkDescriptorImageInfo dirShadowSamplerImageInfo {
-        .sampler = mDirShadowMapSampler.sampler,
-        .imageView = VK_NULL_HANDLE,
-    };
+        VkDescriptorImageInfo dirShadowSamplerImageInfo {
+            .sampler = mDirShadowMapSampler.sampler,
+            .imageView = VK_NULL_HANDLE,
+        };
 
-    VkDescriptorImageInfo pointShadowSamplerImageInfo {
-        .sampler = mPointShadowMapSampler.sampler,
-        .imageView = VK_NULL_HANDLE,
-    };
+        VkDescriptorImageInfo pointShadowSamplerImageInfo {
+            .sampler = mPointShadowMapSampler.sampler,
+            .imageView = VK_NULL_HANDLE,
+        };
 
-    VkDescriptorImageInfo spotShadowSamplerImageInfo {
-        .sampler = mSpotShadowMapSampler.sampler,
-        .imageView = VK_NULL_HANDLE,
-    };
+        VkDescriptorImageInfo spotShadowSamplerImageInfo {
+            .sampler = mSpotShadowMapSampler.sampler,
+            .imageView = VK_NULL_HANDLE,
+        };
 
-    VkWriteDescriptorSet prototype {
-        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-        .dstSet = mLightsDs,
-//        .dstBinding = x,
-        .dstArrayElement = 0,
-        .descriptorCount = 1,
-        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-//        .pBufferInfo = x
-    };
+        VkDescriptorImageInfo shadowAtlasImageInfo {
+            .sampler = VK_NULL_HANDLE,
+            .imageView = mShadowAtlas.imageView,
+            .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+        };
+
+        VkWriteDescriptorSet prototype {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = mLightsDs.at(i),
+//            .dstBinding = x,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+//            .pBufferInfo = x
+        };
 
-    std::array<VkWriteDescriptorSet, 9> writeDs {};
-    writeDs.fill(prototype);
+        std::array<VkWriteDescriptorSet, 10> writeDs {};
+        writeDs.fill(prototype);
 
-    writeDs.at(0).dstBinding = 0;
-    writeDs.at(0).pBufferInfo = &dirLightBufferInfo;
+        writeDs.at(0).dstBinding = 0;
+        writeDs.at(0).pBufferInfo = &dirLightBufferInfo;
 
-    writeDs.at(1).dstBinding = 1;
-    writeDs.at(1).pBufferInfo = &pointLightBufferInfo;
+        writeDs.at(1).dstBinding = 1;
+        writeDs.at(1).pBufferInfo = &pointLightBufferInfo;
 
-    writeDs.at(2).dstBinding = 2;
-    writeDs.at(2).pBufferInfo = &spotLightBufferInfo;
+        writeDs.at(2).dstBinding = 2;
+        writeDs.at(2).pBufferInfo = &spotLightBufferInfo;
 
-    writeDs.at(3).dstBinding = 3;
-    writeDs.at(3).pBufferInfo = &dirShadowOptionsBufferInfo;
+        writeDs.at(3).dstBinding = 3;
+        writeDs.at(3).pBufferInfo = &dirShadowOptionsBufferInfo;
 
-    writeDs.at(4).dstBinding = 4;
-    writeDs.at(4).pBufferInfo = &pointShadowOptionsBufferInfo;
+        writeDs.at(4).dstBinding = 4;
+        writeDs.at(4).pBufferInfo = &pointShadowOptionsBufferInfo;
 
-    writeDs.at(5).dstBinding = 5;
-    writeDs.at(5).pBufferInfo = &spotShadowOptionsBufferInfo;
+        writeDs.at(5).dstBinding = 5;
+        writeDs.at(5).pBufferInfo = &spotShadowOptionsBufferInfo;
 
-    writeDs.at(6).dstBinding = 6;
-    writeDs.at(6).descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
-    writeDs.at(6).pImageInfo = &dirShadowSamplerImageInfo;
+        writeDs.at(6).dstBinding = 6;
+        writeDs.at(6).descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+        writeDs.at(6).pImageInfo = &dirShadowSamplerImageInfo;
 
-    writeDs.at(7).dstBinding = 7;
-    writeDs.at(7).descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
-    writeDs.at(7).pImageInfo = &pointShadowSamplerImageInfo;
+        writeDs.at(7).dstBinding = 7;
+        writeDs.at(7).descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+        writeDs.at(7).pImageInfo = &pointShadowSamplerImageInfo;
 
-    writeDs.at(8).dstBinding = 8;
-    writeDs.at(8).descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
-    writeDs.at(8).pImageInfo = &spotShadowSamplerImageInfo;
+        writeDs.at(8).dstBinding = 8;
+        writeDs.at(8).descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+        writeDs.at(8).pImageInfo = &spotShadowSamplerImageInfo;
 
-    vkUpdateDescriptorSets(mRenderDevice.device, writeDs.size(), writeDs.data(), 0, nullptr);
+        writeDs.at(9).dstBinding = 10;
+        writeDs.at(9).descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        writeDs.at(9).pImageInfo = &shadowAtlasImageInfo;
+
+        vkUpdateDescriptorSets(mRenderDevice.device, writeDs.size(), writeDs.data(), 0, nullptr);
+    }
 }
 
 void Renderer::createFrustumClusterGenDs()
@@ -6513,57 +7767,128 @@ void Renderer::createFrustumClusterGenDs()
     vkUpdateDescriptorSets(mRenderDevice.device, 1, &writeDescriptorSet, 0, nullptr);
 }
 
-void Renderer::createAssignLightsToClustersDs()
+void Renderer::createActiveClustersDs()
 {
-    VkDescriptorSetLayout dsLayout = mAssignLightsToClustersDsLayout;
+    std::vector<VkDescriptorSetLayout> dsLayouts(mRenderDevice.framesInFlight, mActiveClustersDsLayout);
 
     VkDescriptorSetAllocateInfo descriptorSetAllocateInfo {
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
         .descriptorPool = mRenderDevice.descriptorPool,
-        .descriptorSetCount = 1,
-        .pSetLayouts = &dsLayout
+        .descriptorSetCount = mRenderDevice.framesInFlight,
+        .pSetLayouts = dsLayouts.data()
     };
 
-    VkResult result = vkAllocateDescriptorSets(mRenderDevice.device, &descriptorSetAllocateInfo, &mAssignLightsToClustersDs);
+    VkResult result = vkAllocateDescriptorSets(mRenderDevice.device, &descriptorSetAllocateInfo, mActiveClustersDs.data());
     vulkanCheck(result, "Failed to allocate descriptor set.");
 
-    setVulkanObjectDebugName(mRenderDevice,
-                             VK_OBJECT_TYPE_DESCRIPTOR_SET,
-                             "Renderer::mAssignLightsToClustersDs",
-                             mAssignLightsToClustersDs);
+    for (uint32_t i = 0; i < mRenderDevice.framesInFlight; ++i)
+    {
+        setVulkanObjectDebugName(mRenderDevice,
+                                 VK_OBJECT_TYPE_DESCRIPTOR_SET,
+                                 std::format("Renderer::mActiveClustersDs.at({})", i),
+                                 mActiveClustersDs.at(i));
+    }
+}
 
-    VkDescriptorBufferInfo clusterBufferInfo {
-        .buffer = mVolumeClustersSSBO.getBuffer(),
-        .offset = 0,
-        .range = VK_WHOLE_SIZE
+void Renderer::updateActiveClustersDs()
+{
+    VkDescriptorImageInfo depthImageInfo {
+        .sampler = mDepthTexture.vulkanSampler.sampler,
+        .imageView = mDepthTexture.imageView,
+        .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
     };
 
-    VkDescriptorBufferInfo pointLightBufferInfo {
-        .buffer = mPointLightSSBO.getBuffer(),
-        .offset = 0,
-        .range = VK_WHOLE_SIZE
-    };
+    for (uint32_t i = 0; i < mRenderDevice.framesInFlight; ++i)
+    {
+        std::array<VkDescriptorBufferInfo, 2> bufferInfos {{
+            {.buffer = mClusterFlagsSSBOs.at(i).getBuffer(), .offset = 0, .range = VK_WHOLE_SIZE},
+            {.buffer = mActiveClustersSSBOs.at(i).getBuffer(), .offset = 0, .range = VK_WHOLE_SIZE}
+        }};
 
-    VkWriteDescriptorSet prototypeWriteDescriptorSet {
-        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-        .dstSet = mAssignLightsToClustersDs,
-        .dstBinding = 0,
-        .dstArrayElement = 0,
-        .descriptorCount = 1,
-        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-        .pBufferInfo = nullptr
-    };
+        std::array<VkWriteDescriptorSet, 3> writeDs {{
+            {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = mActiveClustersDs.at(i),
+                .dstBinding = 0,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                .pImageInfo = &depthImageInfo
+            },
+            {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = mActiveClustersDs.at(i),
+                .dstBinding = 1,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pBufferInfo = &bufferInfos.at(0)
+            },
+            {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = mActiveClustersDs.at(i),
+                .dstBinding = 2,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pBufferInfo = &bufferInfos.at(1)
+            }
+        }};
+
+        vkUpdateDescriptorSets(mRenderDevice.device, writeDs.size(), writeDs.data(), 0, nullptr);
+    }
+}
+
+void Renderer::createAssignLightsToClustersDs()
+{
+    // recreated when the light index list grows
+    vkFreeDescriptorSets(mRenderDevice.device, mRenderDevice.descriptorPool, mRenderDevice.framesInFlight, mAssignLightsToClustersDs.data());
+
+    std::vector<VkDescriptorSetLayout> dsLayouts(mRenderDevice.framesInFlight, mAssignLightsToClustersDsLayout);
 
-    std::array<VkWriteDescriptorSet, 2> writeDs {};
-    writeDs.fill(prototypeWriteDescriptorSet);
+    VkDescriptorSetAllocateInfo descriptorSetAllocateInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = mRenderDevice.descriptorPool,
+        .descriptorSetCount = mRenderDevice.framesInFlight,
+        .pSetLayouts = dsLayouts.data()
+    };
 
-    writeDs.at(0).pBufferInfo = &clusterBufferInfo;
-    writeDs.at(0).dstBinding = 0;
+    VkResult result = vkAllocateDescriptorSets(mRenderDevice.device, &descriptorSetAllocateInfo, mAssignLightsToClustersDs.data());
+    vulkanCheck(result, "Failed to allocate descriptor set.");
 
-    writeDs.at(1).pBufferInfo = &pointLightBufferInfo;
-    writeDs.at(1).dstBinding = 1;
+    for (uint32_t i = 0; i < mRenderDevice.framesInFlight; ++i)
+    {
+        setVulkanObjectDebugName(mRenderDevice,
+                                 VK_OBJECT_TYPE_DESCRIPTOR_SET,
+                                 std::format("Renderer::mAssignLightsToClustersDs.at({})", i),
+                                 mAssignLightsToClustersDs.at(i));
+
+        std::array<VkDescriptorBufferInfo, 7> bufferInfos {{
+            {.buffer = mVolumeClustersSSBO.getBuffer(), .offset = 0, .range = VK_WHOLE_SIZE},
+            {.buffer = mClusterLightSSBOs.at(i).getBuffer(), .offset = 0, .range = VK_WHOLE_SIZE},
+            {.buffer = mLightBinSSBOs.at(i).getBuffer(), .offset = 0, .range = VK_WHOLE_SIZE},
+            {.buffer = mBinnedLightSSBOs.at(i).getBuffer(), .offset = 0, .range = VK_WHOLE_SIZE},
+            {.buffer = mLightGridSSBOs.at(i).getBuffer(), .offset = 0, .range = VK_WHOLE_SIZE},
+            {.buffer = mLightIndexSSBOs.at(i).getBuffer(), .offset = 0, .range = VK_WHOLE_SIZE},
+            {.buffer = mActiveClustersSSBOs.at(i).getBuffer(), .offset = 0, .range = VK_WHOLE_SIZE}
+        }};
+
+        std::array<VkWriteDescriptorSet, 7> writeDs {};
+        for (uint32_t binding = 0; binding < writeDs.size(); ++binding)
+        {
+            writeDs.at(binding) = {
+                .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet = mAssignLightsToClustersDs.at(i),
+                .dstBinding = binding,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pBufferInfo = &bufferInfos.at(binding)
+            };
+        }
 
-    vkUpdateDescriptorSets(mRenderDevice.device, writeDs.size(), writeDs.data(), 0, nullptr);
+        vkUpdateDescriptorSets(mRenderDevice.device, writeDs.size(), writeDs.data(), 0, nullptr);
+    }
 }
 
 void Renderer::createSkyboxDs()
@@ -6607,21 +7932,25 @@ void Renderer::createSkyboxDs()
 
 void Renderer::createForwardShadingDs()
 {
-    VkDescriptorSetLayout dsLayout = mForwardShadingDsLayout;
+    std::vector<VkDescriptorSetLayout> dsLayouts(mRenderDevice.framesInFlight, mForwardShadingDsLayout);
+
     VkDescriptorSetAllocateInfo descriptorSetAllocateInfo {
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
         .descriptorPool = mRenderDevice.descriptorPool,
-        .descriptorSetCount = 1,
-        .pSetLayouts = &dsLayout
+        .descriptorSetCount = mRenderDevice.framesInFlight,
+        .pSetLayouts = dsLayouts.data()
     };
 
-    VkResult result = vkAllocateDescriptorSets(mRenderDevice.device, &descriptorSetAllocateInfo, &mForwardShadingDs);
+    VkResult result = vkAllocateDescriptorSets(mRenderDevice.device, &descriptorSetAllocateInfo, mForwardShadingDs.data());
     vulkanCheck(result, "Failed to allocate descriptor set.");
 
-    setVulkanObjectDebugName(mRenderDevice,
-                             VK_OBJECT_TYPE_DESCRIPTOR_SET,
-                             "Renderer::mForwardShadingDs",
-                             mForwardShadingDs);
+    for (uint32_t i = 0; i < mRenderDevice.framesInFlight; ++i)
+    {
+        setVulkanObjectDebugName(mRenderDevice,
+                                 VK_OBJECT_TYPE_DESCRIPTOR_SET,
+                                 std::format("Renderer::mForwardShadingDs.at({})", i),
+                                 mForwardShadingDs.at(i));
+    }
 }
 
 void Renderer::updateForwardShadingDs()
@@ -6632,12 +7961,6 @@ void Renderer::updateForwardShadingDs()
         .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
     };
 
-    VkDescriptorBufferInfo clusterBufferInfo {
-        .buffer = mVolumeClustersSSBO.getBuffer(),
-        .offset = 0,
-        .range = VK_WHOLE_SIZE
-    };
-
     VkDescriptorImageInfo viewPosImageInfo {
         .sampler = mViewPosTexture.vulkanSampler.sampler,
         .imageView = mViewPosTexture.imageView,
@@ -6662,57 +7985,80 @@ void Renderer::updateForwardShadingDs()
         .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
     };
 
-    std::array<VkWriteDescriptorSet, 6> dsWrites {};
-
-    dsWrites.at(0).sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    dsWrites.at(0).dstSet = mForwardShadingDs;
-    dsWrites.at(0).dstBinding = 0;
-    dsWrites.at(0).dstArrayElement = 0;
-    dsWrites.at(0).descriptorCount = 1;
-    dsWrites.at(0).descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    dsWrites.at(0).pImageInfo = &ssaoImageInfo;
+    for (uint32_t i = 0; i < mRenderDevice.framesInFlight; ++i)
+    {
+        VkDescriptorBufferInfo lightGridBufferInfo {
+            .buffer = mLightGridSSBOs.at(i).getBuffer(),
+            .offset = 0,
+            .range = VK_WHOLE_SIZE
+        };
 
-    dsWrites.at(1).sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    dsWrites.at(1).dstSet = mForwardShadingDs;
-    dsWrites.at(1).dstBinding = 1;
-    dsWrites.at(1).dstArrayElement = 0;
-    dsWrites.at(1).descriptorCount = 1;
-    dsWrites.at(1).descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-    dsWrites.at(1).pBufferInfo = &clusterBufferInfo;
-
-    dsWrites.at(2).sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    dsWrites.at(2).dstSet = mForwardShadingDs;
-    dsWrites.at(2).dstBinding = 2;
-    dsWrites.at(2).dstArrayElement = 0;
-    dsWrites.at(2).descriptorCount = 1;
-    dsWrites.at(2).descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    dsWrites.at(2).pImageInfo = &viewPosImageInfo;
-
-    dsWrites.at(3).sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    dsWrites.at(3).dstSet = mForwardShadingDs;
-    dsWrites.at(3).dstBinding = 3;
-    dsWrites.at(3).dstArrayElement = 0;
-    dsWrites.at(3).descriptorCount = 1;
-    dsWrites.at(3).descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    dsWrites.at(3).pImageInfo = &irradianceMapImageInfo;
-
-    dsWrites.at(4).sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    dsWrites.at(4).dstSet = mForwardShadingDs;
-    dsWrites.at(4).dstBinding = 4;
-    dsWrites.at(4).dstArrayElement = 0;
-    dsWrites.at(4).descriptorCount = 1;
-    dsWrites.at(4).descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    dsWrites.at(4).pImageInfo = &prefilterMapImageInfo;
-
-    dsWrites.at(5).sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    dsWrites.at(5).dstSet = mForwardShadingDs;
-    dsWrites.at(5).dstBinding = 5;
-    dsWrites.at(5).dstArrayElement = 0;
-    dsWrites.at(5).descriptorCount = 1;
-    dsWrites.at(5).descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    dsWrites.at(5).pImageInfo = &brdfLutImageInfo;
+        VkDescriptorBufferInfo lightIndexBufferInfo {
+            .buffer = mLightIndexSSBOs.at(i).getBuffer(),
+            .offset = 0,
+            .range = VK_WHOLE_SIZE
+        };
 
-    vkUpdateDescriptorSets(mRenderDevice.device, dsWrites.size(), dsWrites.data(), 0, nullptr);
+        std::array<VkWriteDescriptorSet, 7> dsWrites {};
+
+        dsWrites.at(0).sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        dsWrites.at(0).dstSet = mForwardShadingDs.at(i);
+        dsWrites.at(0).dstBinding = 0;
+        dsWrites.at(0).dstArrayElement = 0;
+        dsWrites.at(0).descriptorCount = 1;
+        dsWrites.at(0).descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        dsWrites.at(0).pImageInfo = &ssaoImageInfo;
+
+        dsWrites.at(1).sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        dsWrites.at(1).dstSet = mForwardShadingDs.at(i);
+        dsWrites.at(1).dstBinding = 1;
+        dsWrites.at(1).dstArrayElement = 0;
+        dsWrites.at(1).descriptorCount = 1;
+        dsWrites.at(1).descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        dsWrites.at(1).pBufferInfo = &lightGridBufferInfo;
+
+        dsWrites.at(2).sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        dsWrites.at(2).dstSet = mForwardShadingDs.at(i);
+        dsWrites.at(2).dstBinding = 2;
+        dsWrites.at(2).dstArrayElement = 0;
+        dsWrites.at(2).descriptorCount = 1;
+        dsWrites.at(2).descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        dsWrites.at(2).pImageInfo = &viewPosImageInfo;
+
+        dsWrites.at(3).sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        dsWrites.at(3).dstSet = mForwardShadingDs.at(i);
+        dsWrites.at(3).dstBinding = 3;
+        dsWrites.at(3).dstArrayElement = 0;
+        dsWrites.at(3).descriptorCount = 1;
+        dsWrites.at(3).descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        dsWrites.at(3).pImageInfo = &irradianceMapImageInfo;
+
+        dsWrites.at(4).sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        dsWrites.at(4).dstSet = mForwardShadingDs.at(i);
+        dsWrites.at(4).dstBinding = 4;
+        dsWrites.at(4).dstArrayElement = 0;
+        dsWrites.at(4).descriptorCount = 1;
+        dsWrites.at(4).descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        dsWrites.at(4).pImageInfo = &prefilterMapImageInfo;
+
+        dsWrites.at(5).sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        dsWrites.at(5).dstSet = mForwardShadingDs.at(i);
+        dsWrites.at(5).dstBinding = 5;
+        dsWrites.at(5).dstArrayElement = 0;
+        dsWrites.at(5).descriptorCount = 1;
+        dsWrites.at(5).descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        dsWrites.at(5).pImageInfo = &brdfLutImageInfo;
+
+        dsWrites.at(6).sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        dsWrites.at(6).dstSet = mForwardShadingDs.at(i);
+        dsWrites.at(6).dstBinding = 6;
+        dsWrites.at(6).dstArrayElement = 0;
+        dsWrites.at(6).descriptorCount = 1;
+        dsWrites.at(6).descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        dsWrites.at(6).pBufferInfo = &lightIndexBufferInfo;
+
+        vkUpdateDescriptorSets(mRenderDevice.device, dsWrites.size(), dsWrites.data(), 0, nullptr);
+    }
 }
 
 void Renderer::createPostProcessingDs()
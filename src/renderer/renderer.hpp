@@ -6,13 +6,19 @@
 #define VULKANRENDERINGENGINE_RENDERER_HPP
 
 #include "../utils/utils.hpp"
+#include "../utils/thread_pool.hpp"
+#include "../utils/cpu_profiler.hpp"
 #include "../app/save_data.hpp"
 #include "../vk/vulkan_pipeline.hpp"
+#include "../vk/vulkan_gpu_profiler.hpp"
 #include "../scene_graph/scene_graph.hpp"
+#include "../scene_graph/transform_kernels.hpp"
 #include "camera.hpp"
 #include "model.hpp"
 #include "model_importer.hpp"
 #include "lights.hpp"
+#include "light_clustering.hpp"
+#include "render_queue.hpp"
 
 constexpr uint32_t InitialViewportWidth = 1000;
 constexpr uint32_t InitialViewportHeight = 700;
@@ -20,11 +26,76 @@ constexpr uint32_t MaxDirLights = 128;
 constexpr uint32_t MaxPointLights = 128;
 constexpr uint32_t MaxSpotLights = 128;
 constexpr uint32_t MaxShadowMapsPerType = 50;
+constexpr uint32_t MaxShadowAtlasPages = 8;
 constexpr uint32_t MaxSsaoKernelSamples = 128;
 constexpr uint32_t SsaoNoiseTextureSize = 4;
-constexpr uint32_t PerClusterCapacity = 32;
+constexpr uint32_t InitialLightsPerCluster = 16;
 constexpr VkSampleCountFlagBits SampleCount = VK_SAMPLE_COUNT_8_BIT;
 
+struct FrameTimings
+{
+    float cpuMs;
+    float gpuMs;
+    float fenceWaitMs;
+};
+
+struct CullingStats
+{
+    uint32_t visibleInstances;
+    uint32_t totalInstances;
+    float cullMs;
+    // gpu culling validation, counted since startup
+    uint32_t validatedMeshes;
+    uint32_t mismatchedMeshes;
+};
+
+// how a shadow view gets redrawn this frame
+enum class ShadowViewUpdate
+{
+    Skip,    // nothing it shows has changed
+    Dynamic, // static casters are copied from the static shadow map and the dynamic ones drawn over them
+    Cache,   // static casters are drawn and copied into the static shadow map, then the dynamic ones
+    Full     // the view is moving, everything is drawn and nothing cached
+};
+
+// face is the cascade for directional lights and the cube face for point lights
+struct ShadowViewStats
+{
+    LightType lightType;
+    index_t lightIndex;
+    uint32_t face;
+    uint32_t draws;
+    uint32_t instances;
+    uint32_t dynamicInstances;
+    ShadowViewChange change;
+    ShadowViewUpdate update;
+};
+
+// a shadow view and where it's drawn, layer is the cascade or the atlas page
+struct ShadowViewTarget
+{
+    uint32_t view;
+    uint32_t layer;
+    VkRect2D rect;
+    glm::mat4 viewProj;
+    const VulkanGraphicsPipeline* pipeline;
+};
+
+struct ShadowScheduleStats
+{
+    uint32_t requestedViews;
+    uint32_t scheduledViews;
+    uint32_t deferredViews;
+    uint32_t longestWait;
+};
+
+struct ShadowAtlasStats
+{
+    uint32_t tiles;
+    uint32_t droppedLights;
+    uint64_t usedTexels;
+};
+
 struct TransparentMesh;
 struct LightIconRenderData;
 struct Cluster;
@@ -36,6 +107,7 @@ public:
     Renderer(const VulkanRenderDevice& renderDevice, SaveData& saveData);
     ~Renderer();
 
+    void beginFrame(uint32_t frameIndex, float cpuMs, float fenceWaitMs);
     void update();
     void render(VkCommandBuffer commandBuffer);
 
@@ -57,15 +129,24 @@ public:
     void deleteSpotLight(uuid32_t id);
 
 private:
+    void discardRenderTargets(VkCommandBuffer commandBuffer);
+    void executeCullInstancesRenderpass(VkCommandBuffer commandBuffer);
     void executeDirShadowRenderpass(VkCommandBuffer commandBuffer);
-    void executePointShadowRenderpass(VkCommandBuffer commandBuffer);
-    void executeSpotShadowRenderpass(VkCommandBuffer commandBuffer);
+    void executeShadowAtlasRenderpass(VkCommandBuffer commandBuffer);
+    void executeShadowMapUpdate(VkCommandBuffer commandBuffer,
+                                const VulkanImage& shadowMap,
+                                const VulkanImage& staticShadowMap,
+                                VkFramebuffer framebuffer,
+                                uint32_t resolution,
+                                const std::vector<ShadowViewTarget>& targets);
+    void drawShadowView(VkCommandBuffer commandBuffer, const ShadowViewTarget& target, ShadowCasters casters);
     void executePrepass(VkCommandBuffer commandBuffer);
     void executeSkyboxRenderpass(VkCommandBuffer commandBuffer);
     void executeSsaoResourcesRenderpass(VkCommandBuffer commandBuffer);
     void executeSsaoRenderpass(VkCommandBuffer commandBuffer);
     void executeSsaoBlurRenderpass(VkCommandBuffer commandBuffer);
     void executeGenFrustumClustersRenderpass(VkCommandBuffer commandBuffer);
+    void executeActiveClustersRenderpass(VkCommandBuffer commandBuffer);
     void executeAssignLightsToClustersRenderpass(VkCommandBuffer commandBuffer);
     void executeForwardRenderpass(VkCommandBuffer commandBuffer);
     void executeBloomRenderpass(VkCommandBuffer commandBuffer);
@@ -74,9 +155,17 @@ private:
     void executeGridRenderpass(VkCommandBuffer commandBuffer);
     void executeLightIconRenderpass(VkCommandBuffer commandBuffer);
     void setViewport(VkCommandBuffer commandBuffer);
+    void createCameraUBOs();
     void updateCameraUBO();
     void getLightIconRenderData();
     void sortTransparentMeshes();
+    void buildRenderQueues();
+    // records the sorted draws of the pass and only sets the state that changes between them. passes that shade
+    // push the material slot at materialOffset in the fragment push constants
+    void recordRenderQueue(VkCommandBuffer commandBuffer,
+                           RenderQueuePass pass,
+                           VkPipelineLayout pipelineLayout,
+                           std::optional<uint32_t> materialOffset = std::nullopt);
     void bindTexture(VkCommandBuffer commandBuffer,
                      VkPipelineLayout pipelineLayout,
                      const VulkanTexture& texture,
@@ -90,9 +179,16 @@ private:
     void addTextures(Model& model, ModelLoader& modelData);
 
     void updateSceneGraph();
+    void syncInstanceBuffers();
+    void cullInstances();
+    void allocateShadowAtlas();
+    void cullShadowCasters();
+    void scheduleShadowUpdates();
+    void syncLightBuffers();
+    void updateClusterLights();
     void updateGraphNode(NodeType type, GraphNode* node);
-    void updateEmptyNode(GraphNode* node);
     void updateMeshNode(GraphNode* node);
+    void updateMeshInstances(std::span<GraphNode* const> nodes);
     void updateDirLightNode(GraphNode* node);
     void updatePointLightNode(GraphNode* node);
     void updateSpotLightNode(GraphNode* node);
@@ -111,8 +207,10 @@ private:
     void createOitResourcesDsLayout();
     void createSingleInputAttachmentDsLayout();
     void createLightsDsLayout();
+    void createCullInstancesDsLayout();
     void createFrustumClusterGenDsLayout();
     void createAssignLightsToClustersDsLayout();
+    void createActiveClustersDsLayout();
     void createForwardShadingDsLayout();
     void createPostProcessingDsLayout();
 
@@ -125,36 +223,42 @@ private:
     DirShadowMap& getDirShadowMap(uuid32_t id);
     void addPointShadowMap(const PointShadowData& shadowData); // point shadows
     void updatePointShadowMapData(uuid32_t id);
-    void updatePointShadowMapImage(uuid32_t id);
-    void createPointShadowMap(PointShadowMap& shadowMap, index_t index, uint32_t resolution);
     void deletePointShadowMap(uuid32_t id);
     PointShadowData& getPointShadowData(uuid32_t id);
     PointShadowMap& getPointShadowMap(uuid32_t id);
     void addSpotShadowMap(const SpotShadowData& shadowData); // spot shadows
     void updateSpotShadowMapData(uuid32_t id);
-    void updateSpotShadowMapImage(uuid32_t id);
-    void createSpotShadowMap(SpotShadowMap& shadowMap, index_t index, uint32_t resolution);
     void deleteSpotShadowMap(uuid32_t id);
     SpotShadowData& getSpotShadowData(uuid32_t id);
     SpotShadowMap& getSpotShadowMap(uuid32_t id);
     void createShadowMapBuffers();
     void createShadowMapSamplers();
-    void createDirShadowRenderpass();
+    void createShadowRenderpass();
+    void createShadowAtlas();
+    void updateShadowAtlasImage();
     void createDirShadowPipeline();
-    void createSpotShadowRenderpass();
     void createSpotShadowPipeline();
-    void createPointShadowRenderpass();
     void createPointShadowPipeline();
 
     void createPrepassRenderpass();
     void createPrepassFramebuffer();
     void createPrepassPipeline();
 
+    void createCullInstancesPipelineLayout();
+    void createCullInstancesPipeline();
+    void renderCulled(VkCommandBuffer commandBuffer, const InstancedMesh& mesh) const;
+
     void createVolumeClusterSSBO();
+    void createClusterLightSSBOs();
+    void createLightGridSSBO();
+    void createLightIndexSSBO(uint32_t capacity);
+    void createActiveClusterSSBOs();
     void createFrustumClusterGenPipelineLayout();
     void createFrustumClusterGenPipeline();
     void createAssignLightsToClustersPipelineLayout();
     void createAssignLightsToClustersPipeline();
+    void createActiveClustersPipelineLayout();
+    void createActiveClustersPipelines();
 
     void createSkyboxRenderpass();
     void createSkyboxFramebuffer();
@@ -246,6 +350,8 @@ private:
     void createLightsDs();
     void createFrustumClusterGenDs();
     void createAssignLightsToClustersDs();
+    void createActiveClustersDs();
+    void updateActiveClustersDs();
     void createSkyboxDs();
     void createForwardShadingDs();
     void updateForwardShadingDs();
@@ -261,9 +367,15 @@ private:
     uint32_t mWidth;
     uint32_t mHeight;
 
+    // frames in flight, the per frame vectors have one entry for each
+    uint32_t mFrameIndex;
+    FrameTimings mFrameTimings;
+    CullingStats mCullingStats;
+
     // camera
     Camera mCamera;
-    VulkanBuffer mCameraUBO;
+    Frustum mCameraFrustum;
+    std::vector<VulkanBuffer> mCameraUBOs;
 
     // render targets
     VulkanTexture mColorTexture32MS;
@@ -313,9 +425,7 @@ private:
     VulkanGraphicsPipeline mLightIconPipeline;
 
     // Shadow mapping
-    VkRenderPass mDirShadowRenderpass{};
-    VkRenderPass mPointShadowRenderpass{};
-    VkRenderPass mSpotShadowRenderpass{};
+    VkRenderPass mShadowRenderpass{};
     VulkanGraphicsPipeline mDirShadowPipeline;
     VulkanGraphicsPipeline mPointShadowPipeline;
     VulkanGraphicsPipeline mSpotShadowPipeline;
@@ -333,13 +443,39 @@ private:
     VulkanBuffer mSsaoKernelSSBO;
     VulkanTexture mSsaoNoiseTexture;
 
+    // gpu culling
+    VkPipelineLayout mCullInstancesPipelineLayout{};
+    VkPipeline mCullInstancesPipeline{};
+    std::vector<bool> mCullingReferenceReady;
+
     // forward+ rendering
     glm::uvec3 mClusterGridSize = glm::vec3(16, 16, 24);
     VulkanBuffer mVolumeClustersSSBO;
+    // an offset and count per cluster into one list the assignment pass hands out ranges of, the list starts with
+    // its allocation counter. the gpu rebuilds these every frame, so each frame in flight has its own
+    std::vector<VulkanBuffer> mLightGridSSBOs;
+    std::vector<VulkanBuffer> mLightIndexSSBOs;
+    uint32_t mLightIndexCapacity;
+    // point and spot lights sorted by depth and binned by cluster row on the cpu, the gpu only tests a cluster's bin
+    std::vector<ClusterLight> mClusterLights;
+    ClusterLightBins mClusterLightBins;
+    std::vector<Aabb> mClusterBounds;
+    glm::mat4 mClusterBoundsProjection;
+    glm::uvec2 mClusterBoundsScreenSize;
+    std::vector<VulkanBuffer> mClusterLightSSBOs;
+    std::vector<VulkanBuffer> mLightBinSSBOs;
+    std::vector<VulkanBuffer> mBinnedLightSSBOs;
     VkPipelineLayout mFrustumClusterGenPipelineLayout{};
     VkPipeline mFrustumClusterGenPipeline{};
     VkPipelineLayout mAssignLightsToClustersPipelineLayout{};
     VkPipeline mAssignLightsToClustersPipeline{};
+    // clusters with a depth sample in them, light assignment only runs over these
+    std::vector<VulkanBuffer> mClusterFlagsSSBOs;
+    std::vector<VulkanBuffer> mActiveClustersSSBOs;
+    VkPipelineLayout mActiveClustersPipelineLayout{};
+    VkPipeline mFlagActiveClustersPipeline{};
+    VkPipeline mCompactActiveClustersPipeline{};
+    bool mRegenerateClusters = true;
 
     // IBL
     VulkanTexture mIrradianceMap;
@@ -402,13 +538,15 @@ private:
     VulkanDsLayout mIconTextureDsLayout;
     VulkanDsLayout mSingleInputAttachmentDsLayout;
     VulkanDsLayout mLightsDsLayout;
+    VulkanDsLayout mCullInstancesDsLayout;
     VulkanDsLayout mFrustumClusterGenDsLayout;
     VulkanDsLayout mAssignLightsToClustersDsLayout;
+    VulkanDsLayout mActiveClustersDsLayout;
     VulkanDsLayout mForwardShadingDsLayout;
     VulkanDsLayout mPostProcessingDsLayout;
 
     // descriptor sets
-    VkDescriptorSet mCameraDs{};
+    std::vector<VkDescriptorSet> mCameraDs;
     VkDescriptorSet mSsaoDs{};
     VkDescriptorSet mSsaoTextureDs{};
     VkDescriptorSet mSsaoBlurTexture1Ds{};
@@ -417,10 +555,11 @@ private:
     VkDescriptorSet mSkyboxDs{};
     VkDescriptorSet mColorResolve32Ds{};
     VkDescriptorSet mColor8UDs{};
-    VkDescriptorSet mLightsDs{};
+    std::vector<VkDescriptorSet> mLightsDs;
     VkDescriptorSet mFrustumClusterGenDs{};
-    VkDescriptorSet mAssignLightsToClustersDs{};
-    VkDescriptorSet mForwardShadingDs{};
+    std::vector<VkDescriptorSet> mAssignLightsToClustersDs;
+    std::vector<VkDescriptorSet> mActiveClustersDs;
+    std::vector<VkDescriptorSet> mForwardShadingDs;
     VkDescriptorSet mPostProcessingDs{};
 
     // gizmo icons
@@ -436,11 +575,23 @@ private:
     VkDescriptorSet mGlobalIconDs{};
     VkDescriptorSet mLocalIconDs{};
 
+    ThreadPool mSceneUpdateThreadPool;
+
     // models
+    ThreadPool mImportThreadPool;
     std::vector<std::future<ModelLoader>> mModelDataFutures;
+    Timer mImportTimer;
+    uint32_t mImportBatchSize;
+    // declared before the models, which release their slots into it
+    MaterialTable mMaterialTable;
     std::unordered_map<uuid32_t, Model> mModels;
     std::multiset<TransparentMesh> mSortedTransparentMeshes;
 
+    // the opaque passes draw from these, a packet's item is an index into mQueuedMeshes
+    std::vector<const InstancedMesh*> mQueuedMeshes;
+    std::array<RenderQueue, RenderQueuePassCount> mRenderQueues;
+    std::array<RenderQueueStats, RenderQueuePassCount> mRenderQueueStats{};
+
     // lights
     std::vector<DirectionalLight> mDirLights;
     std::vector<PointLight> mPointLights;
@@ -450,9 +601,11 @@ private:
     std::unordered_map<uuid32_t, index_t> mUuidToPointLightIndex;
     std::unordered_map<uuid32_t, index_t> mUuidToSpotLightIndex;
 
-    VulkanBuffer mDirLightSSBO;
-    VulkanBuffer mPointLightSSBO;
-    VulkanBuffer mSpotLightSSBO;
+    // copies of the light and shadow data vectors, a frame's copy is refreshed before it's recorded if it's dirty
+    std::vector<VulkanBuffer> mDirLightSSBOs;
+    std::vector<VulkanBuffer> mPointLightSSBOs;
+    std::vector<VulkanBuffer> mSpotLightSSBOs;
+    uint32_t mLightsDirtyFrames;
 
     // Shadow data
     std::vector<DirShadowData> mDirShadowData;
@@ -463,9 +616,27 @@ private:
     std::vector<PointShadowMap> mPointShadowMaps;
     std::vector<SpotShadowMap> mSpotShadowMaps;
 
-    VulkanBuffer mDirShadowDataSSBO;
-    VulkanBuffer mPointShadowDataSSBO;
-    VulkanBuffer mSpotShadowDataSSBO;
+    // point and spot shadows are tiles in the atlas pages, sized by how much of the view each light covers
+    VulkanImage mShadowAtlas;
+    VulkanImage mStaticShadowAtlas;
+    VkFramebuffer mShadowAtlasFramebuffer{};
+    uint32_t mShadowAtlasResolution = 4096;
+    uint32_t mShadowAtlasPages = 1;
+    ShadowAtlasStats mShadowAtlasStats;
+
+    std::vector<VulkanBuffer> mDirShadowDataSSBOs;
+    std::vector<VulkanBuffer> mPointShadowDataSSBOs;
+    std::vector<VulkanBuffer> mSpotShadowDataSSBOs;
+    uint32_t mShadowDataDirtyFrames;
+
+    // shadow caster culling, the views go dir light cascades, point light faces, then spot lights
+    std::vector<Frustum> mShadowFrusta;
+    std::vector<ShadowViewStats> mShadowViewStats;
+    std::vector<InstancedMesh*> mShadowCasters;
+    std::vector<ShadowCache*> mShadowCaches;
+    std::vector<glm::mat4*> mShadowViewProjs;
+    uint32_t mFirstPointShadowView;
+    uint32_t mFirstSpotShadowView;
 
     // Light icons
     VulkanTexture mDirLightIcon;
@@ -494,9 +665,16 @@ private:
     bool mRenderGrid = true;
     bool mDebugNormals = false;
     bool mWireframeOn = false;
+    bool mGpuCulling = true;
+    bool mValidateGpuCulling = false;
+    bool mCacheShadowMaps = true;
+    // shadow views redrawn per frame on top of the ones that can't wait, 0 for no limit
+    uint32_t mShadowViewBudget = 48;
+    ShadowScheduleStats mShadowScheduleStats;
 
 private:
     friend class Editor;
+    friend class Benchmark;
 };
 
 struct TransparentMesh
@@ -522,8 +700,6 @@ struct Cluster
 {
     alignas(16) glm::vec4 minPoint;
     alignas(16) glm::vec4 maxPoint;
-    alignas(4) uint32_t lightCount;
-    alignas(16) uint32_t lightIndices[PerClusterCapacity];
 };
 
 enum class Tonemap
@@ -546,6 +722,18 @@ inline const char* toStr(Tonemap t)
     }
 }
 
+inline const char* toStr(ShadowViewUpdate update)
+{
+    switch (update)
+    {
+        case ShadowViewUpdate::Skip: return "Cached";
+        case ShadowViewUpdate::Dynamic: return "Dynamic Redrawn";
+        case ShadowViewUpdate::Cache: return "Recached";
+        case ShadowViewUpdate::Full: return "Fully Redrawn";
+        default: return "Unknown";
+    }
+}
+
 #include "renderer.inl"
 
 #endif //VULKANRENDERINGENGINE_RENDERER_HPP
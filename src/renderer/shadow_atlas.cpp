@@ -0,0 +1,150 @@
+//
+// Created by Gianni on 16/10/2026.
+//
+
+#include "shadow_atlas.hpp"
+
+static uint64_t requestArea(const ShadowAtlasRequest& request)
+{
+    return static_cast<uint64_t>(request.size) * request.size * request.tileCount;
+}
+
+// every other bit of a morton code
+static uint32_t compactBits(uint32_t v)
+{
+    v &= 0x55555555;
+    v = (v | (v >> 1)) & 0x33333333;
+    v = (v | (v >> 2)) & 0x0f0f0f0f;
+    v = (v | (v >> 4)) & 0x00ff00ff;
+    v = (v | (v >> 8)) & 0x0000ffff;
+    return v;
+}
+
+float shadowImportance(const Frustum &cameraFrustum,
+                       const glm::vec3 &cameraPos,
+                       float tanHalfFov,
+                       const glm::vec3 &lightPos,
+                       float radius)
+{
+    // the light doesn't reach anything on screen
+    if (!isVisible(cameraFrustum, {lightPos - radius, lightPos + radius}))
+        return 0.f;
+
+    float distance = glm::distance(cameraPos, lightPos);
+    if (distance <= radius)
+        return 1.f;
+
+    // the sphere's radius over half the height of the view at its distance
+    return glm::min(radius / (distance * tanHalfFov), 1.f);
+}
+
+uint32_t shadowTileSize(float importance, uint32_t maxSize, uint32_t currentSize)
+{
+    if (importance <= 0.f)
+        return 0;
+
+    float wantedSize = importance * static_cast<float>(maxSize);
+    uint32_t size = std::bit_ceil(std::max(static_cast<uint32_t>(glm::ceil(wantedSize)), MinShadowTileSize));
+
+    if (currentSize && size < currentSize && wantedSize > static_cast<float>(currentSize) * 0.375f)
+        size = currentSize;
+
+    return std::min(size, maxSize);
+}
+
+std::vector<ShadowAtlasTile> packShadowAtlas(std::vector<ShadowAtlasRequest> &requests,
+                                             uint32_t resolution,
+                                             uint32_t pageCount)
+{
+    uint64_t budget = static_cast<uint64_t>(resolution) * resolution * pageCount;
+    uint64_t usedArea = 0;
+
+    for (ShadowAtlasRequest& request : requests)
+    {
+        request.size = std::min(request.size, resolution);
+        usedArea += requestArea(request);
+    }
+
+    std::vector<ShadowAtlasRequest*> byImportance;
+    for (ShadowAtlasRequest& request : requests)
+        if (request.size)
+            byImportance.push_back(&request);
+
+    std::stable_sort(byImportance.begin(), byImportance.end(), [] (const ShadowAtlasRequest* a, const ShadowAtlasRequest* b) {
+        return a->importance < b->importance;
+    });
+
+    // the tile with the most texels for its light's importance is halved first, so everything scales down evenly.
+    // once all of them are at the smallest size the least important lights lose their tiles
+    while (usedArea > budget)
+    {
+        ShadowAtlasRequest* largest = nullptr;
+        for (ShadowAtlasRequest* request : byImportance)
+        {
+            if (request->size > MinShadowTileSize &&
+                (!largest || request->size / request->importance > largest->size / largest->importance))
+                largest = request;
+        }
+
+        if (!largest)
+            break;
+
+        usedArea -= requestArea(*largest);
+        largest->size /= 2;
+        usedArea += requestArea(*largest);
+    }
+
+    for (ShadowAtlasRequest* request : byImportance)
+    {
+        if (usedArea <= budget)
+            break;
+
+        usedArea -= requestArea(*request);
+        request->size = 0;
+    }
+
+    struct TileRef
+    {
+        uint32_t size;
+        uint32_t tile;
+    };
+
+    std::vector<ShadowAtlasTile> tiles;
+    std::vector<TileRef> tileRefs;
+    for (const ShadowAtlasRequest& request : requests)
+    {
+        for (uint32_t i = 0; i < request.tileCount; ++i)
+        {
+            if (request.size)
+                tileRefs.push_back({request.size, static_cast<uint32_t>(tiles.size())});
+            tiles.push_back({});
+        }
+    }
+
+    // largest first, every tile then starts on a multiple of its own area along the morton curve, which keeps it a
+    // square inside one page. the stable sort keeps the layout the same while the sizes are
+    std::stable_sort(tileRefs.begin(), tileRefs.end(), [] (const TileRef& a, const TileRef& b) {
+        return a.size > b.size;
+    });
+
+    uint32_t cellsPerSide = resolution / MinShadowTileSize;
+    uint64_t cellsPerPage = static_cast<uint64_t>(cellsPerSide) * cellsPerSide;
+    uint64_t cell = 0;
+
+    for (const TileRef& tileRef : tileRefs)
+    {
+        uint32_t tileCells = tileRef.size / MinShadowTileSize;
+        uint32_t pageCell = static_cast<uint32_t>(cell % cellsPerPage);
+
+        tiles.at(tileRef.tile) = {
+            .page = static_cast<uint32_t>(cell / cellsPerPage),
+            .x = compactBits(pageCell) * MinShadowTileSize,
+            .y = compactBits(pageCell >> 1) * MinShadowTileSize,
+            .size = tileRef.size
+        };
+
+        cell += static_cast<uint64_t>(tileCells) * tileCells;
+    }
+
+    return tiles;
+}
@@ -0,0 +1,51 @@
+//
+// Created by Gianni on 16/10/2026.
+//
+
+#ifndef VULKANRENDERINGENGINE_SHADOW_ATLAS_HPP
+#define VULKANRENDERINGENGINE_SHADOW_ATLAS_HPP
+
+#include <glm/glm.hpp>
+#include "frustum_culling.hpp"
+
+// a light whose tile would be smaller than this loses its shadow instead
+inline constexpr uint32_t MinShadowTileSize = 64;
+
+// a square region of one of the atlas pages in texels, size is 0 when the light didn't get one
+struct ShadowAtlasTile
+{
+    uint32_t page;
+    uint32_t x;
+    uint32_t y;
+    uint32_t size;
+
+    bool operator==(const ShadowAtlasTile& other) const = default;
+};
+
+// tileCount tiles of the same size, 6 for a point light and 1 for a spot light
+struct ShadowAtlasRequest
+{
+    float importance;
+    uint32_t size;
+    uint32_t tileCount;
+};
+
+// how much of the view the light's sphere covers, 1 with the camera inside it and 0 when it's out of view.
+// tanHalfFov is the tangent of half the camera's vertical field of view
+float shadowImportance(const Frustum& cameraFrustum,
+                       const glm::vec3& cameraPos,
+                       float tanHalfFov,
+                       const glm::vec3& lightPos,
+                       float radius);
+
+// power of two tile size for a light that wants maxSize texels at full importance. the current size is kept until the
+// light outgrows it or shrinks well below it, so lights sitting on a step don't get moved around every frame
+uint32_t shadowTileSize(float importance, uint32_t maxSize, uint32_t currentSize);
+
+// shrinks, then drops the least important requests until they fit in the pages and packs what's left.
+// returns the tiles in request order, resolution has to be a power of two
+std::vector<ShadowAtlasTile> packShadowAtlas(std::vector<ShadowAtlasRequest>& requests,
+                                             uint32_t resolution,
+                                             uint32_t pageCount);
+
+#endif //VULKANRENDERINGENGINE_SHADOW_ATLAS_HPP
@@ -14,7 +14,10 @@ GraphNode::GraphNode()
     , localR()
     , localS(1.f)
     , mDirty()
+    , mGlobalTransform(1.f)
     , mParent()
+    , mTransformStore()
+    , mTransformIndex(InvalidTransformIndex)
 {
 }
 
@@ -32,7 +35,10 @@ GraphNode::GraphNode(NodeType type, std::string  name,
     , localR(rotation)
     , localS(scale)
     , mDirty(true)
+    , mGlobalTransform(1.f)
     , mParent(parent)
+    , mTransformStore()
+    , mTransformIndex(InvalidTransformIndex)
 {
 }
 
@@ -40,17 +46,21 @@ GraphNode::~GraphNode()
 {
     for (GraphNode* node : mChildren)
         delete node;
+
+    ++sTopologyVersion;
 }
 
 void GraphNode::setParent(GraphNode *parent)
 {
     mParent = parent;
+    ++sTopologyVersion;
 }
 
 void GraphNode::addChild(GraphNode* child)
 {
     child->mParent = this;
     mChildren.push_back(child);
+    ++sTopologyVersion;
 }
 
 void GraphNode::removeChild(GraphNode *child)
@@ -60,6 +70,7 @@ void GraphNode::removeChild(GraphNode *child)
         if (mChildren.at(i) == child)
         {
             mChildren.erase(mChildren.begin() + i);
+            ++sTopologyVersion;
             break;
         }
     }
@@ -77,6 +88,14 @@ void GraphNode::orphan()
 void GraphNode::markDirty()
 {
     mDirty = true;
+
+    // the store's update pass carries the flag down to the children
+    if (mTransformStore && mTransformStore->node(mTransformIndex) == this)
+    {
+        mTransformStore->setLocal(mTransformIndex, localT, localR, localS);
+        return;
+    }
+
     for (auto child : mChildren)
         child->markDirty();
 }
@@ -120,15 +139,13 @@ bool GraphNode::updateGlobalTransform()
 {
     if (mDirty)
     {
-        calcLocalTransform();
-
         if (mParent)
         {
-            mGlobalTransform = mParent->mGlobalTransform * mLocalTransform;
+            mGlobalTransform = mParent->mGlobalTransform * localTransform();
         }
         else
         {
-            mGlobalTransform = mLocalTransform;
+            mGlobalTransform = localTransform();
         }
 
         mDirty = false;
@@ -139,26 +156,22 @@ bool GraphNode::updateGlobalTransform()
     return false;
 }
 
-void GraphNode::calcLocalTransform()
-{
-    glm::quat quat = glm::quat(glm::radians(localR));
-    glm::mat4 rot = glm::toMat4(quat);
-
-    mLocalTransform = glm::translate(glm::identity<glm::mat4>(), localT) * rot;
-    mLocalTransform = glm::scale(mLocalTransform, localS);
-}
-
 void GraphNode::setName(const std::string &name)
 {
     mName = name;
 }
 
-const glm::mat4 &GraphNode::localTransform() const
+glm::mat4 GraphNode::localTransform() const
 {
-    return mLocalTransform;
+    return composeTransform(localT, localR, localS);
 }
 
 const std::vector<uuid32_t> &GraphNode::meshIDs() const
 {
     return mMeshIDs;
 }
+
+uint32_t GraphNode::topologyVersion()
+{
+    return sTopologyVersion;
+}
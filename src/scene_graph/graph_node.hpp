@@ -12,6 +12,7 @@
 #include "../app/uuid_registry.hpp"
 #include "../renderer/instanced_mesh.hpp"
 #include "../utils/utils.hpp"
+#include "transform_store.hpp"
 
 enum class NodeType
 {
@@ -47,7 +48,7 @@ public:
     void markDirty();
 
     void setName(const std::string& name);
-    void calcLocalTransform();
+    // nodes outside a scene graph, the graph updates its own nodes through its transform store
     bool updateGlobalTransform();
 
     uuid32_t id() const;
@@ -56,10 +57,13 @@ public:
     std::optional<uuid32_t> modelID() const;
     GraphNode* parent() const;
     const glm::mat4& globalTransform() const;
-    const glm::mat4& localTransform() const;
+    glm::mat4 localTransform() const;
     const std::vector<uuid32_t>& meshIDs() const;
     const std::vector<GraphNode*>& children() const;
 
+    // bumped whenever a child list changes
+    static uint32_t topologyVersion();
+
 protected:
     uuid32_t mID;
     NodeType mType;
@@ -68,11 +72,18 @@ protected:
     std::vector<uuid32_t> mMeshIDs;
     bool mDirty;
 
-    glm::mat4 mLocalTransform;
     glm::mat4 mGlobalTransform;
 
     GraphNode* mParent;
     std::vector<GraphNode*> mChildren;
+
+    TransformStore* mTransformStore;
+    index_t mTransformIndex;
+
+    static inline uint32_t sTopologyVersion = 0;
+
+private:
+    friend class SceneGraph;
 };
 
 #endif //VULKANRENDERINGENGINE_SCENE_NODE_HPP
@@ -6,26 +6,17 @@
 
 SceneGraph::SceneGraph()
     : mRoot(NodeType::Empty, "RootNode", {}, {}, glm::vec3(1.f), nullptr)
+    , mTopologyVersion(GraphNode::topologyVersion() - 1)
 {
 }
 
 GraphNode *SceneGraph::searchNode(uuid32_t nodeID)
 {
-    std::vector<GraphNode*> stack(1, &mRoot);
+    if (mTopologyVersion != GraphNode::topologyVersion())
+        rebuildTransformStore();
 
-    while (!stack.empty())
-    {
-        GraphNode* node = stack.back();
-        stack.pop_back();
-
-        if (node->id() == nodeID)
-            return node;
-
-        for (auto child : node->children())
-            stack.push_back(child);
-    }
-
-    return nullptr;
+    GraphNode** node = mNodeMap.find(nodeID);
+    return node? *node : nullptr;
 }
 
 void SceneGraph::addNode(GraphNode *node)
@@ -44,6 +35,68 @@ bool SceneGraph::hasDescendant(GraphNode *current, GraphNode *descendant)
     return false;
 }
 
+const std::vector<GraphNode *> &SceneGraph::updateTransforms(ThreadPool* threadPool)
+{
+    if (mTopologyVersion != GraphNode::topologyVersion())
+        rebuildTransformStore();
+
+    const std::vector<index_t>& updated = mTransforms.update(threadPool);
+
+    mUpdatedNodes.resize(updated.size());
+
+    parallelFor(threadPool, updated.size(), TransformBatchSize, [this, &updated] (uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            GraphNode* node = mTransforms.node(updated[i]);
+
+            node->mGlobalTransform = mTransforms.globalTransform(updated[i]);
+            node->mDirty = false;
+
+            mUpdatedNodes[i] = node;
+        }
+    });
+
+    return mUpdatedNodes;
+}
+
+const TransformStore &SceneGraph::transforms() const
+{
+    return mTransforms;
+}
+
+void SceneGraph::rebuildTransformStore()
+{
+    size_t previousSize = mTransforms.size();
+
+    mTransforms.clear();
+    mTransforms.reserve(previousSize);
+    mNodeMap.clear();
+    mNodeMap.reserve(previousSize);
+
+    // breadth first keeps the levels contiguous, the queue position is the store index
+    std::vector<std::pair<GraphNode*, index_t>> queue(1, {&mRoot, InvalidTransformIndex});
+
+    for (size_t head = 0; head < queue.size(); ++head)
+    {
+        auto [node, parentIndex] = queue[head];
+
+        index_t index = mTransforms.add(parentIndex, node->localT, node->localR, node->localS, node);
+
+        // nodes that were already in the store keep their result unless something changed them
+        if (node->mTransformStore == &mTransforms && !node->mDirty)
+            mTransforms.setGlobalTransform(index, node->mGlobalTransform);
+
+        node->mTransformStore = &mTransforms;
+        node->mTransformIndex = index;
+        mNodeMap.insert(node->id(), node);
+
+        for (GraphNode* child : node->children())
+            queue.emplace_back(child, index);
+    }
+
+    mTopologyVersion = GraphNode::topologyVersion();
+}
+
 GraphNode *SceneGraph::root()
 {
     return &mRoot;
@@ -6,6 +6,7 @@
 #define VULKANRENDERINGENGINE_SCENE_GRAPH_HPP
 
 #include "graph_node.hpp"
+#include "../app/uuid_map.hpp"
 
 class SceneGraph
 {
@@ -13,14 +14,28 @@ public:
     SceneGraph();
 
     void addNode(GraphNode* node);
+    // constant time, the id index is rebuilt with the transform store
     GraphNode* searchNode(uuid32_t nodeID);
     bool hasDescendant(GraphNode* current, GraphNode* descendant);
 
+    // recomputes the dirty global transforms, returns the nodes that changed, parents before children.
+    // levels of the hierarchy are split across the pool's threads, the result is the same without one
+    const std::vector<GraphNode*>& updateTransforms(ThreadPool* threadPool = nullptr);
+    const TransformStore& transforms() const;
+
     GraphNode* root();
     std::vector<GraphNode*>& topLevelNodes();
 
+private:
+    void rebuildTransformStore();
+
 private:
     GraphNode mRoot;
+
+    TransformStore mTransforms;
+    uint32_t mTopologyVersion;
+    std::vector<GraphNode*> mUpdatedNodes;
+    UuidMap<GraphNode*> mNodeMap;
 };
 
 #endif //VULKANRENDERINGENGINE_SCENE_GRAPH_HPP
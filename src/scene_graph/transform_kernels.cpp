@@ -0,0 +1,255 @@
+//
+// Created by Gianni on 16/10/2026.
+//
+
+#include "transform_kernels.hpp"
+#include "transform_store.hpp"
+
+#if defined(__SSE2__)
+
+#include <emmintrin.h>
+
+// same operations in the same order as glm, only sin and cos differ (cephes polynomials, about 1 ulp).
+// AVX is left out on purpose: MinGW's gcc doesn't align the stack to 32 bytes for spilled ymm registers.
+
+static void sinCos(__m128 x, __m128& sinOut, __m128& cosOut)
+{
+    const __m128 signMask = _mm_set1_ps(-0.f);
+
+    __m128 sinSign = _mm_and_ps(x, signMask);
+    x = _mm_andnot_ps(signMask, x);
+
+    // octant, rounded up to even
+    __m128i octant = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.27323954473516f)));
+    octant = _mm_add_epi32(octant, _mm_set1_epi32(1));
+    octant = _mm_and_si128(octant, _mm_set1_epi32(~1));
+    __m128 y = _mm_cvtepi32_ps(octant);
+
+    __m128 sinSwap = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(octant, _mm_set1_epi32(4)), 29));
+    __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_andnot_si128(_mm_sub_epi32(octant, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+    __m128 polyMask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(octant, _mm_set1_epi32(2)), _mm_setzero_si128()));
+    sinSign = _mm_xor_ps(sinSign, sinSwap);
+
+    // extended precision x - octant * pi / 4
+    x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-0.78515625f)));
+    x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-2.4187564849853515625e-4f)));
+    x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-3.77489497744594108e-8f)));
+
+    __m128 z = _mm_mul_ps(x, x);
+
+    __m128 cosPoly = _mm_set1_ps(2.443315711809948e-5f);
+    cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, z), _mm_set1_ps(-1.388731625493765e-3f));
+    cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, z), _mm_set1_ps(4.166664568298827e-2f));
+    cosPoly = _mm_mul_ps(_mm_mul_ps(cosPoly, z), z);
+    cosPoly = _mm_sub_ps(cosPoly, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+    cosPoly = _mm_add_ps(cosPoly, _mm_set1_ps(1.f));
+
+    __m128 sinPoly = _mm_set1_ps(-1.9515295891e-4f);
+    sinPoly = _mm_add_ps(_mm_mul_ps(sinPoly, z), _mm_set1_ps(8.3321608736e-3f));
+    sinPoly = _mm_add_ps(_mm_mul_ps(sinPoly, z), _mm_set1_ps(-1.6666654611e-1f));
+    sinPoly = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sinPoly, z), x), x);
+
+    __m128 sinValue = _mm_or_ps(_mm_and_ps(polyMask, sinPoly), _mm_andnot_ps(polyMask, cosPoly));
+    __m128 cosValue = _mm_or_ps(_mm_and_ps(polyMask, cosPoly), _mm_andnot_ps(polyMask, sinPoly));
+
+    sinOut = _mm_xor_ps(sinValue, sinSign);
+    cosOut = _mm_xor_ps(cosValue, cosSign);
+}
+
+static void composeTransforms4(const glm::vec3* translations,
+                               const glm::vec3* rotations,
+                               const glm::vec3* scales,
+                               glm::mat4* transforms)
+{
+    auto lanes = [] (const glm::vec3* v, int component) {
+        return _mm_setr_ps(v[0][component], v[1][component], v[2][component], v[3][component]);
+    };
+
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 degToRad = _mm_set1_ps(glm::radians(1.f));
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 two = _mm_set1_ps(2.f);
+
+    __m128 sx, sy, sz, cx, cy, cz;
+    sinCos(_mm_mul_ps(_mm_mul_ps(lanes(rotations, 0), degToRad), half), sx, cx);
+    sinCos(_mm_mul_ps(_mm_mul_ps(lanes(rotations, 1), degToRad), half), sy, cy);
+    sinCos(_mm_mul_ps(_mm_mul_ps(lanes(rotations, 2), degToRad), half), sz, cz);
+
+    // glm::quat(euler)
+    __m128 qw = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(cx, cy), cz), _mm_mul_ps(_mm_mul_ps(sx, sy), sz));
+    __m128 qx = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(sx, cy), cz), _mm_mul_ps(_mm_mul_ps(cx, sy), sz));
+    __m128 qy = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(cx, sy), cz), _mm_mul_ps(_mm_mul_ps(sx, cy), sz));
+    __m128 qz = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(cx, cy), sz), _mm_mul_ps(_mm_mul_ps(sx, sy), cz));
+
+    // glm::mat3_cast
+    __m128 qxx = _mm_mul_ps(qx, qx);
+    __m128 qyy = _mm_mul_ps(qy, qy);
+    __m128 qzz = _mm_mul_ps(qz, qz);
+    __m128 qxz = _mm_mul_ps(qx, qz);
+    __m128 qxy = _mm_mul_ps(qx, qy);
+    __m128 qyz = _mm_mul_ps(qy, qz);
+    __m128 qwx = _mm_mul_ps(qw, qx);
+    __m128 qwy = _mm_mul_ps(qw, qy);
+    __m128 qwz = _mm_mul_ps(qw, qz);
+
+    __m128 scaleX = lanes(scales, 0);
+    __m128 scaleY = lanes(scales, 1);
+    __m128 scaleZ = lanes(scales, 2);
+
+    __m128 m00 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(qyy, qzz))), scaleX);
+    __m128 m01 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(qxy, qwz)), scaleX);
+    __m128 m02 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(qxz, qwy)), scaleX);
+    __m128 m10 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(qxy, qwz)), scaleY);
+    __m128 m11 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(qxx, qzz))), scaleY);
+    __m128 m12 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(qyz, qwx)), scaleY);
+    __m128 m20 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(qxz, qwy)), scaleZ);
+    __m128 m21 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(qyz, qwx)), scaleZ);
+    __m128 m22 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(qxx, qyy))), scaleZ);
+
+    __m128 tx = lanes(translations, 0);
+    __m128 ty = lanes(translations, 1);
+    __m128 tz = lanes(translations, 2);
+
+    // lanes back to one column per node, columns[column][node]
+    __m128 columns[4][4] {
+        {m00, m01, m02, _mm_setzero_ps()},
+        {m10, m11, m12, _mm_setzero_ps()},
+        {m20, m21, m22, _mm_setzero_ps()},
+        {tx, ty, tz, one}
+    };
+
+    for (auto& column : columns)
+        _MM_TRANSPOSE4_PS(column[0], column[1], column[2], column[3]);
+
+    for (int node = 0; node < 4; ++node)
+        for (int column = 0; column < 4; ++column)
+            _mm_storeu_ps(&transforms[node][column][0], columns[column][node]);
+}
+
+void composeTransforms(const glm::vec3* translations,
+                       const glm::vec3* rotations,
+                       const glm::vec3* scales,
+                       glm::mat4* transforms,
+                       uint32_t count)
+{
+    uint32_t i = 0;
+
+    for (; i + 4 <= count; i += 4)
+        composeTransforms4(translations + i, rotations + i, scales + i, transforms + i);
+
+    // the tail goes through the same path, padded
+    if (uint32_t tail = count - i)
+    {
+        glm::vec3 t[4] {}, r[4] {}, s[4] {};
+        glm::mat4 result[4];
+
+        std::copy_n(translations + i, tail, t);
+        std::copy_n(rotations + i, tail, r);
+        std::copy_n(scales + i, tail, s);
+
+        composeTransforms4(t, r, s, result);
+
+        std::copy_n(result, tail, transforms + i);
+    }
+}
+
+void multiplyTransforms(const glm::mat4* parents, const glm::mat4* locals, glm::mat4* results, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        __m128 a0 = _mm_loadu_ps(&parents[i][0][0]);
+        __m128 a1 = _mm_loadu_ps(&parents[i][1][0]);
+        __m128 a2 = _mm_loadu_ps(&parents[i][2][0]);
+        __m128 a3 = _mm_loadu_ps(&parents[i][3][0]);
+
+        for (int column = 0; column < 4; ++column)
+        {
+            __m128 b = _mm_loadu_ps(&locals[i][column][0]);
+
+            __m128 result = _mm_mul_ps(a0, _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 0, 0, 0)));
+            result = _mm_add_ps(result, _mm_mul_ps(a1, _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 1, 1, 1))));
+            result = _mm_add_ps(result, _mm_mul_ps(a2, _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 2, 2, 2))));
+            result = _mm_add_ps(result, _mm_mul_ps(a3, _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 3, 3, 3))));
+
+            _mm_storeu_ps(&results[i][column][0], result);
+        }
+    }
+}
+
+static __m128 cross(__m128 a, __m128 b)
+{
+    __m128 aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 aZXY = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2));
+    __m128 bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 bZXY = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2));
+
+    return _mm_sub_ps(_mm_mul_ps(aYZX, bZXY), _mm_mul_ps(aZXY, bYZX));
+}
+
+void calcNormalMatrices(const glm::mat4* transforms, glm::mat3* normalMatrices, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        __m128 a = _mm_loadu_ps(&transforms[i][0][0]);
+        __m128 b = _mm_loadu_ps(&transforms[i][1][0]);
+        __m128 c = _mm_loadu_ps(&transforms[i][2][0]);
+
+        // the cofactor columns are cross products of the other two columns, same terms as glm::inverseTranspose
+        __m128 column0 = cross(b, c);
+        __m128 column1 = cross(c, a);
+        __m128 column2 = cross(a, b);
+
+        __m128 products = _mm_mul_ps(a, column0);
+        __m128 determinant = _mm_add_ps(_mm_add_ps(_mm_shuffle_ps(products, products, _MM_SHUFFLE(0, 0, 0, 0)),
+                                                   _mm_shuffle_ps(products, products, _MM_SHUFFLE(1, 1, 1, 1))),
+                                        _mm_shuffle_ps(products, products, _MM_SHUFFLE(2, 2, 2, 2)));
+
+        column0 = _mm_div_ps(column0, determinant);
+        column1 = _mm_div_ps(column1, determinant);
+        column2 = _mm_div_ps(column2, determinant);
+
+        // the first two columns spill into the next one before it's written, the last one can't spill
+        float* normalMatrix = &normalMatrices[i][0][0];
+
+        _mm_storeu_ps(normalMatrix, column0);
+        _mm_storeu_ps(normalMatrix + 3, column1);
+        _mm_storel_pi(reinterpret_cast<__m64*>(normalMatrix + 6), column2);
+        _mm_store_ss(normalMatrix + 8, _mm_movehl_ps(column2, column2));
+    }
+}
+
+const char* transformKernelsPath()
+{
+    return "sse2";
+}
+
+#else
+
+void composeTransforms(const glm::vec3* translations,
+                       const glm::vec3* rotations,
+                       const glm::vec3* scales,
+                       glm::mat4* transforms,
+                       uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i)
+        transforms[i] = composeTransform(translations[i], rotations[i], scales[i]);
+}
+
+void multiplyTransforms(const glm::mat4* parents, const glm::mat4* locals, glm::mat4* results, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i)
+        results[i] = parents[i] * locals[i];
+}
+
+void calcNormalMatrices(const glm::mat4* transforms, glm::mat3* normalMatrices, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i)
+        normalMatrices[i] = glm::inverseTranspose(glm::mat3(transforms[i]));
+}
+
+const char* transformKernelsPath()
+{
+    return "scalar";
+}
+
+#endif
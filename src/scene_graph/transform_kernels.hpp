@@ -0,0 +1,29 @@
+//
+// Created by Gianni on 16/10/2026.
+//
+
+#ifndef VULKANRENDERINGENGINE_TRANSFORM_KERNELS_HPP
+#define VULKANRENDERINGENGINE_TRANSFORM_KERNELS_HPP
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+
+// Batch versions of the per node transform math, SSE2 on x86 and plain glm elsewhere.
+// Results match glm within float rounding and don't depend on where an element sits in the batch.
+
+// rotation is in euler angles (degrees), same as composeTransform
+void composeTransforms(const glm::vec3* translations,
+                       const glm::vec3* rotations,
+                       const glm::vec3* scales,
+                       glm::mat4* transforms,
+                       uint32_t count);
+
+// results[i] = parents[i] * locals[i], results can be locals
+void multiplyTransforms(const glm::mat4* parents, const glm::mat4* locals, glm::mat4* results, uint32_t count);
+
+// inverse transpose of each transform's upper 3x3
+void calcNormalMatrices(const glm::mat4* transforms, glm::mat3* normalMatrices, uint32_t count);
+
+const char* transformKernelsPath();
+
+#endif //VULKANRENDERINGENGINE_TRANSFORM_KERNELS_HPP
@@ -0,0 +1,182 @@
+//
+// Created by Gianni on 16/10/2026.
+//
+
+#include "transform_store.hpp"
+#include "transform_kernels.hpp"
+
+void TransformStore::clear()
+{
+    mTranslations.clear();
+    mRotations.clear();
+    mScales.clear();
+    mGlobalTransforms.clear();
+    mParents.clear();
+    mDirty.clear();
+    mNodes.clear();
+    mLevelOffsets.clear();
+    mUpdated.clear();
+    mHasDirty = false;
+}
+
+void TransformStore::reserve(size_t count)
+{
+    mTranslations.reserve(count);
+    mRotations.reserve(count);
+    mScales.reserve(count);
+    mGlobalTransforms.reserve(count);
+    mParents.reserve(count);
+    mDirty.reserve(count);
+    mNodes.reserve(count);
+}
+
+index_t TransformStore::add(index_t parent,
+                            const glm::vec3& translation,
+                            const glm::vec3& rotation,
+                            const glm::vec3& scale,
+                            GraphNode* node)
+{
+    index_t index = mParents.size();
+
+    // a parent on the last level starts the next one
+    if (mLevelOffsets.empty() || (parent != InvalidTransformIndex && parent >= mLevelOffsets.back()))
+        mLevelOffsets.push_back(index);
+
+    assert(parent == InvalidTransformIndex? mLevelOffsets.size() == 1 : parent < index);
+
+    mTranslations.push_back(translation);
+    mRotations.push_back(rotation);
+    mScales.push_back(scale);
+    mGlobalTransforms.push_back(glm::identity<glm::mat4>());
+    mParents.push_back(parent);
+    mDirty.push_back(true);
+    mNodes.push_back(node);
+    mHasDirty = true;
+
+    return index;
+}
+
+void TransformStore::setLocal(index_t index, const glm::vec3& translation, const glm::vec3& rotation, const glm::vec3& scale)
+{
+    mTranslations.at(index) = translation;
+    mRotations.at(index) = rotation;
+    mScales.at(index) = scale;
+    mDirty.at(index) = true;
+    mHasDirty = true;
+}
+
+void TransformStore::markDirty(index_t index)
+{
+    mDirty.at(index) = true;
+    mHasDirty = true;
+}
+
+void TransformStore::setGlobalTransform(index_t index, const glm::mat4& globalTransform)
+{
+    mGlobalTransforms.at(index) = globalTransform;
+    mDirty.at(index) = false;
+}
+
+const std::vector<index_t>& TransformStore::update(ThreadPool* threadPool)
+{
+    mUpdated.clear();
+
+    if (!mHasDirty)
+        return mUpdated;
+
+    for (size_t level = 0; level < mLevelOffsets.size(); ++level)
+    {
+        index_t levelBegin = mLevelOffsets[level];
+        index_t levelEnd = level + 1 < mLevelOffsets.size()? mLevelOffsets[level + 1] : mParents.size();
+
+        parallelFor(threadPool, levelEnd - levelBegin, TransformBatchSize, [this, levelBegin] (uint32_t begin, uint32_t end) {
+            updateRange(levelBegin + begin, levelBegin + end);
+        });
+    }
+
+    // the flags stay up during the pass so children can see them, whatever is still flagged got updated
+    index_t count = mParents.size();
+
+    for (index_t i = 0; i < count; ++i)
+    {
+        if (mDirty[i])
+        {
+            mUpdated.push_back(i);
+            mDirty[i] = false;
+        }
+    }
+
+    mHasDirty = false;
+
+    return mUpdated;
+}
+
+void TransformStore::updateRange(index_t begin, index_t end)
+{
+    constexpr uint32_t BlockSize = 64;
+
+    index_t indices[BlockSize];
+    glm::vec3 translations[BlockSize];
+    glm::vec3 rotations[BlockSize];
+    glm::vec3 scales[BlockSize];
+    glm::mat4 parentTransforms[BlockSize];
+    glm::mat4 localTransforms[BlockSize];
+
+    // dirty entries are gathered into blocks for the batch kernels
+    index_t i = begin;
+
+    while (i < end)
+    {
+        uint32_t count = 0;
+
+        for (; i < end && count < BlockSize; ++i)
+        {
+            index_t parent = mParents[i];
+
+            // the parent's level is already done
+            if (parent != InvalidTransformIndex && mDirty[parent])
+                mDirty[i] = true;
+
+            if (!mDirty[i])
+                continue;
+
+            indices[count] = i;
+            translations[count] = mTranslations[i];
+            rotations[count] = mRotations[i];
+            scales[count] = mScales[i];
+            parentTransforms[count] = parent != InvalidTransformIndex? mGlobalTransforms[parent] : glm::identity<glm::mat4>();
+            ++count;
+        }
+
+        composeTransforms(translations, rotations, scales, localTransforms, count);
+        multiplyTransforms(parentTransforms, localTransforms, localTransforms, count);
+
+        for (uint32_t j = 0; j < count; ++j)
+            mGlobalTransforms[indices[j]] = localTransforms[j];
+    }
+}
+
+size_t TransformStore::size() const
+{
+    return mParents.size();
+}
+
+index_t TransformStore::parent(index_t index) const
+{
+    return mParents.at(index);
+}
+
+GraphNode *TransformStore::node(index_t index) const
+{
+    return index < mNodes.size()? mNodes[index] : nullptr;
+}
+
+const std::vector<GraphNode *> &TransformStore::nodes() const
+{
+    return mNodes;
+}
+
+const glm::mat4 &TransformStore::globalTransform(index_t index) const
+{
+    return mGlobalTransforms.at(index);
+}
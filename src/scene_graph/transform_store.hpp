@@ -0,0 +1,75 @@
+//
+// Created by Gianni on 16/10/2026.
+//
+
+#ifndef VULKANRENDERINGENGINE_TRANSFORM_STORE_HPP
+#define VULKANRENDERINGENGINE_TRANSFORM_STORE_HPP
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/quaternion.hpp>
+#include "../app/types.hpp"
+#include "../utils/thread_pool.hpp"
+
+class GraphNode;
+
+constexpr index_t InvalidTransformIndex = std::numeric_limits<index_t>::max();
+// smallest slice of a hierarchy level handed to a worker, below that the threading overhead wins
+constexpr uint32_t TransformBatchSize = 1024;
+
+// rotation is in euler angles (degrees)
+inline glm::mat4 composeTransform(const glm::vec3& translation, const glm::vec3& rotation, const glm::vec3& scale)
+{
+    glm::mat4 transform = glm::translate(glm::identity<glm::mat4>(), translation) * glm::toMat4(glm::quat(glm::radians(rotation)));
+    return glm::scale(transform, scale);
+}
+
+// Flat copy of the scene hierarchy used by the per frame transform update.
+// Entries are stored level by level (breadth first), so every parent comes before its children and
+// the entries of one level don't depend on each other, which lets a level be split across threads.
+class TransformStore
+{
+public:
+    void clear();
+    void reserve(size_t count);
+
+    // entries have to be added level by level, new entries start dirty
+    index_t add(index_t parent,
+                const glm::vec3& translation,
+                const glm::vec3& rotation,
+                const glm::vec3& scale,
+                GraphNode* node = nullptr);
+
+    void setLocal(index_t index, const glm::vec3& translation, const glm::vec3& rotation, const glm::vec3& scale);
+    void markDirty(index_t index);
+    // restores a cached result and clears the dirty flag
+    void setGlobalTransform(index_t index, const glm::mat4& globalTransform);
+
+    // recomputes the dirty entries and their descendants, returns their indices in ascending order.
+    // the result doesn't depend on the thread pool or its size
+    const std::vector<index_t>& update(ThreadPool* threadPool = nullptr);
+
+    size_t size() const;
+    index_t parent(index_t index) const;
+    GraphNode* node(index_t index) const;
+    const std::vector<GraphNode*>& nodes() const;
+    const glm::mat4& globalTransform(index_t index) const;
+
+private:
+    void updateRange(index_t begin, index_t end);
+
+private:
+    std::vector<glm::vec3> mTranslations;
+    std::vector<glm::vec3> mRotations;
+    std::vector<glm::vec3> mScales;
+    std::vector<glm::mat4> mGlobalTransforms;
+    std::vector<index_t> mParents;
+    std::vector<uint8_t> mDirty;
+    std::vector<GraphNode*> mNodes;
+    std::vector<index_t> mLevelOffsets;
+    bool mHasDirty = false;
+
+    std::vector<index_t> mUpdated;
+};
+
+#endif //VULKANRENDERINGENGINE_TRANSFORM_STORE_HPP
@@ -0,0 +1,196 @@
+//
+// Created by Gianni on 16/10/2026.
+//
+
+#include <json/json.hpp>
+#include "cpu_profiler.hpp"
+
+static constexpr uint64_t sThreadBufferCapacity = 16384;
+static constexpr size_t sMaxCapturedEvents = 500000;
+
+namespace
+{
+    struct ThreadBuffer
+    {
+        uint32_t threadID;
+        std::string threadName;
+        std::array<CpuProfileEvent, sThreadBufferCapacity> events;
+        std::atomic_uint64_t head;
+        std::atomic_uint64_t tail;
+        std::atomic_uint64_t dropped;
+    };
+
+    struct CapturedEvent
+    {
+        CpuProfileEvent event;
+        uint32_t threadID;
+    };
+
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<ThreadBuffer>> threadBuffers;
+    };
+}
+
+static Registry& registry()
+{
+    static Registry sRegistry;
+    return sRegistry;
+}
+
+// touched by the main thread only
+static std::deque<CapturedEvent> sCapturedEvents;
+
+static ThreadBuffer& threadBuffer()
+{
+    // the registry keeps the buffer alive after its thread exits so collect() can still drain it
+    thread_local std::shared_ptr<ThreadBuffer> tThreadBuffer = [] () {
+        auto buffer = std::make_shared<ThreadBuffer>();
+
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+
+        buffer->threadID = reg.threadBuffers.size();
+        buffer->threadName = std::format("Thread {}", buffer->threadID);
+        reg.threadBuffers.push_back(buffer);
+
+        return buffer;
+    }();
+
+    return *tThreadBuffer;
+}
+
+void CpuProfiler::setEnabled(bool enabled)
+{
+    sEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void CpuProfiler::setThreadName(const std::string& name)
+{
+    ThreadBuffer& buffer = threadBuffer();
+
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    buffer.threadName = name;
+}
+
+void CpuProfiler::collect()
+{
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    for (auto& buffer : reg.threadBuffers)
+    {
+        uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+
+        for (uint64_t i = tail; i < head; ++i)
+            sCapturedEvents.push_back({buffer->events.at(i % sThreadBufferCapacity), buffer->threadID});
+
+        buffer->tail.store(head, std::memory_order_release);
+    }
+
+    while (sCapturedEvents.size() > sMaxCapturedEvents)
+        sCapturedEvents.pop_front();
+}
+
+void CpuProfiler::clear()
+{
+    collect();
+    sCapturedEvents.clear();
+}
+
+size_t CpuProfiler::capturedEventCount()
+{
+    return sCapturedEvents.size();
+}
+
+uint64_t CpuProfiler::droppedEventCount()
+{
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    uint64_t dropped = 0;
+    for (const auto& buffer : reg.threadBuffers)
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+
+    return dropped;
+}
+
+bool CpuProfiler::exportChromeTrace(const std::filesystem::path& path)
+{
+    collect();
+
+    std::ofstream file(path);
+
+    if (!file.is_open())
+        return false;
+
+    nlohmann::json traceEvents = nlohmann::json::array();
+
+    {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+
+        for (const auto& buffer : reg.threadBuffers)
+        {
+            traceEvents.push_back({
+                {"name", "thread_name"},
+                {"ph", "M"},
+                {"pid", 0},
+                {"tid", buffer->threadID},
+                {"args", {{"name", buffer->threadName}}}
+            });
+        }
+    }
+
+    int64_t originNs = std::numeric_limits<int64_t>::max();
+    for (const CapturedEvent& captured : sCapturedEvents)
+        originNs = std::min(originNs, captured.event.startNs);
+
+    for (const CapturedEvent& captured : sCapturedEvents)
+    {
+        traceEvents.push_back({
+            {"name", captured.event.name},
+            {"cat", "cpu"},
+            {"ph", "X"},
+            {"ts", static_cast<double>(captured.event.startNs - originNs) / 1000.0},
+            {"dur", static_cast<double>(captured.event.endNs - captured.event.startNs) / 1000.0},
+            {"pid", 0},
+            {"tid", captured.threadID}
+        });
+    }
+
+    nlohmann::json trace {
+        {"traceEvents", traceEvents},
+        {"displayTimeUnit", "ms"}
+    };
+
+    file << trace.dump();
+
+    return file.good();
+}
+
+int64_t CpuProfiler::now()
+{
+    auto time = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+}
+
+void CpuProfiler::record(const char* name, int64_t startNs, int64_t endNs)
+{
+    ThreadBuffer& buffer = threadBuffer();
+
+    // single producer: only this thread moves head, only collect() moves tail
+    uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    uint64_t tail = buffer.tail.load(std::memory_order_acquire);
+
+    if (head - tail == sThreadBufferCapacity)
+    {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    buffer.events.at(head % sThreadBufferCapacity) = {name, startNs, endNs};
+    buffer.head.store(head + 1, std::memory_order_release);
+}
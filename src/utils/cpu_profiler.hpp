@@ -0,0 +1,73 @@
+//
+// Created by Gianni on 16/10/2026.
+//
+
+#ifndef VULKANRENDERINGENGINE_CPU_PROFILER_HPP
+#define VULKANRENDERINGENGINE_CPU_PROFILER_HPP
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+// names must outlive the capture, use string literals
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+
+struct CpuProfileEvent
+{
+    const char* name;
+    int64_t startNs;
+    int64_t endNs;
+};
+
+// Collects scoped cpu zones from every thread for a Chrome trace / Perfetto capture.
+// Each thread writes into its own single producer ring, the main thread drains them once per frame.
+// A disabled profiler costs one relaxed atomic load per zone.
+class CpuProfiler
+{
+public:
+    static void setEnabled(bool enabled);
+    static bool enabled();
+    static void setThreadName(const std::string& name);
+
+    // main thread only
+    static void collect();
+    static void clear();
+    static size_t capturedEventCount();
+    static uint64_t droppedEventCount();
+    static bool exportChromeTrace(const std::filesystem::path& path);
+
+    static int64_t now();
+    static void record(const char* name, int64_t startNs, int64_t endNs);
+
+private:
+    static inline std::atomic_bool sEnabled = false;
+};
+
+class ProfileZone
+{
+public:
+    explicit ProfileZone(const char* name)
+        : mName(CpuProfiler::enabled()? name : nullptr)
+        , mStartNs(mName? CpuProfiler::now() : 0)
+    {
+    }
+
+    ~ProfileZone()
+    {
+        if (mName)
+            CpuProfiler::record(mName, mStartNs, CpuProfiler::now());
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* mName;
+    int64_t mStartNs;
+};
+
+inline bool CpuProfiler::enabled()
+{
+    return sEnabled.load(std::memory_order_relaxed);
+}
+
+#endif //VULKANRENDERINGENGINE_CPU_PROFILER_HPP
@@ -0,0 +1,58 @@
+//
+// Created by Gianni on 16/10/2026.
+//
+
+#include "thread_pool.hpp"
+#include "cpu_profiler.hpp"
+
+ThreadPool::ThreadPool(uint32_t threadCount, const std::string& name)
+    : mStop()
+{
+    threadCount = std::max(threadCount, 1u);
+
+    mWorkers.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; ++i)
+        mWorkers.emplace_back(&ThreadPool::workerLoop, this, std::format("{} {}", name, i));
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+
+    mCondition.notify_all();
+
+    for (std::thread& worker : mWorkers)
+        worker.join();
+}
+
+uint32_t ThreadPool::threadCount() const
+{
+    return mWorkers.size();
+}
+
+void ThreadPool::workerLoop(std::string threadName)
+{
+    CpuProfiler::setThreadName(threadName);
+
+    while (true)
+    {
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this] () { return mStop || !mTasks.empty(); });
+
+            // pending tasks are dropped on shutdown, their futures get a broken promise
+            if (mStop)
+                return;
+
+            task = std::move(mTasks.front());
+            mTasks.pop_front();
+        }
+
+        task();
+    }
+}
@@ -0,0 +1,148 @@
+//
+// Created by Gianni on 16/10/2026.
+//
+
+#ifndef VULKANRENDERINGENGINE_THREAD_POOL_HPP
+#define VULKANRENDERINGENGINE_THREAD_POOL_HPP
+
+class ThreadPool
+{
+public:
+    ThreadPool(uint32_t threadCount = std::thread::hardware_concurrency(), const std::string& name = "Worker");
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    template<typename F>
+    auto submit(F&& func) -> std::future<std::invoke_result_t<F>>;
+
+    uint32_t threadCount() const;
+
+private:
+    void workerLoop(std::string threadName);
+
+private:
+    std::vector<std::thread> mWorkers;
+    std::deque<std::function<void()>> mTasks;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mStop;
+};
+
+template<typename F>
+auto ThreadPool::submit(F&& func) -> std::future<std::invoke_result_t<F>>
+{
+    using Result = std::invoke_result_t<F>;
+
+    // std::function needs a copyable target
+    auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(func));
+    std::future<Result> future = task->get_future();
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTasks.emplace_back([task] () { (*task)(); });
+    }
+
+    mCondition.notify_one();
+
+    return future;
+}
+
+// Splits [0, count) into one batch per worker plus one for the calling thread, which runs its batch inline
+// and waits for the others. Batches are at least minBatchSize long, without a pool everything runs inline.
+// func(begin, end) must not touch data another batch writes.
+template<typename F>
+void parallelFor(ThreadPool* threadPool, uint32_t count, uint32_t minBatchSize, F&& func)
+{
+    uint32_t maxBatchCount = threadPool? threadPool->threadCount() + 1 : 1;
+    uint32_t batchCount = std::clamp(count / std::max(minBatchSize, 1u), 1u, maxBatchCount);
+
+    if (batchCount == 1)
+    {
+        func(0u, count);
+        return;
+    }
+
+    auto batchBegin = [count, batchCount] (uint32_t batch) {
+        return static_cast<uint32_t>(static_cast<uint64_t>(count) * batch / batchCount);
+    };
+
+    std::vector<std::future<void>> futures;
+    futures.reserve(batchCount - 1);
+
+    for (uint32_t batch = 1; batch < batchCount; ++batch)
+    {
+        uint32_t begin = batchBegin(batch);
+        uint32_t end = batchBegin(batch + 1);
+
+        futures.push_back(threadPool->submit([&func, begin, end] () { func(begin, end); }));
+    }
+
+    func(0u, batchBegin(1));
+
+    for (std::future<void>& future : futures)
+        future.get();
+}
+
+// Hands out [0, count) one index at a time to the pool and the calling thread. The caller only waits for indices
+// a worker has already picked up, so it is safe to call from a task running on the same pool even when every
+// worker is busy. Without a pool everything runs inline.
+template<typename F>
+void parallelForEach(ThreadPool* threadPool, uint32_t count, F&& func)
+{
+    if (!threadPool || count <= 1)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+            func(i);
+        return;
+    }
+
+    struct State
+    {
+        std::atomic<uint32_t> next;
+        std::atomic<uint32_t> done;
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::exception_ptr exception;
+    };
+
+    // helpers can start after the caller returned, they only touch the shared state and find nothing left to do
+    auto state = std::make_shared<State>();
+
+    auto work = [state, &func, count] () {
+        for (uint32_t i = state->next++; i < count; i = state->next++)
+        {
+            try
+            {
+                func(i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (!state->exception)
+                    state->exception = std::current_exception();
+            }
+
+            if (++state->done == count)
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->condition.notify_all();
+            }
+        }
+    };
+
+    uint32_t helperCount = std::min(threadPool->threadCount(), count - 1);
+    for (uint32_t i = 0; i < helperCount; ++i)
+        threadPool->submit(work);
+
+    work();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->condition.wait(lock, [&state, count] () { return state->done == count; });
+
+    if (state->exception)
+        std::rethrow_exception(state->exception);
+}
+
+#endif //VULKANRENDERINGENGINE_THREAD_POOL_HPP
@@ -5,8 +5,11 @@
 #include "utils.hpp"
 #include "../window/window.hpp"
 
+static std::mutex sLogMutex;
+
 void debugLog(const std::string& logMSG)
 {
+    std::lock_guard<std::mutex> lock(sLogMutex);
     std::cout << "[Debug Log] " << logMSG << std::endl;
 }
 
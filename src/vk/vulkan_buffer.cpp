@@ -3,17 +3,16 @@
 //
 
 #include "vulkan_buffer.hpp"
+#include "vulkan_upload_manager.hpp"
 
 static void mapBufferMemory(const VulkanRenderDevice* renderDevice,
-                            VkDeviceMemory memory,
+                            const MemoryAllocation& allocation,
                             VkDeviceSize offset,
                             VkDeviceSize size,
                             const void* data)
 {
-    void* dataPtr;
-    vkMapMemory(renderDevice->device, memory, offset, size, 0, &dataPtr);
-    memcpy(dataPtr, data, size);
-    vkUnmapMemory(renderDevice->device, memory);
+    memcpy(static_cast<uint8_t*>(allocation.mappedData) + offset, data, size);
+    renderDevice->memoryAllocator->flush(allocation, offset, size);
 }
 
 static void copyBuffer(VkCommandBuffer commandBuffer,
@@ -55,6 +54,16 @@ VkBufferUsageFlags toVkFlags(BufferType bufferType)
         case BufferType::Staging: return
                 VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
                 VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        case BufferType::Instance: return
+                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        case BufferType::Indirect: return
+                VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT;
         default: assert(false);
     }
 }
@@ -80,7 +89,7 @@ uint32_t getIndexCount(const VulkanBuffer &buffer)
 VulkanBuffer::VulkanBuffer()
     : mRenderDevice()
     , mBuffer()
-    , mMemory()
+    , mAllocation()
     , mSize()
 {
 }
@@ -92,7 +101,7 @@ VulkanBuffer::VulkanBuffer(const VulkanRenderDevice &renderDevice,
     : mRenderDevice(&renderDevice)
     , mSize(size)
     , mBuffer(createBuffer(bufferType))
-    , mMemory(allocateBufferMemory(memoryType, mBuffer))
+    , mAllocation(allocateBufferMemory(bufferType, memoryType, mBuffer))
     , mType(bufferType)
     , mMemoryType(memoryType)
 {
@@ -106,7 +115,7 @@ VulkanBuffer::VulkanBuffer(const VulkanRenderDevice &renderDevice,
     : mRenderDevice(&renderDevice)
     , mSize(size)
     , mBuffer(createBuffer(bufferType))
-    , mMemory(allocateBufferMemory(memoryType, mBuffer))
+    , mAllocation(allocateBufferMemory(bufferType, memoryType, mBuffer))
     , mType(bufferType)
     , mMemoryType(memoryType)
 {
@@ -118,16 +127,10 @@ VulkanBuffer::VulkanBuffer(const VulkanRenderDevice &renderDevice,
     }
     else
     {
-        VkBuffer stagingBuffer = createBuffer(BufferType::Staging);
-        VkDeviceMemory stagingBufferMemory = allocateBufferMemory(MemoryType::Host, stagingBuffer);
-        ::mapBufferMemory(mRenderDevice, stagingBufferMemory, 0, size, bufferData);
-
-        VkCommandBuffer commandBuffer = beginSingleTimeCommands(renderDevice);
-        ::copyBuffer(commandBuffer, stagingBuffer, mBuffer, 0, 0, size);
-        endSingleTimeCommands(renderDevice, commandBuffer);
+        VulkanUploadManager& uploadManager = *mRenderDevice->uploadManager;
 
-        vkDestroyBuffer(mRenderDevice->device, stagingBuffer, nullptr);
-        vkFreeMemory(mRenderDevice->device, stagingBufferMemory, nullptr);
+        StagingRegion staging = uploadManager.stage(bufferData, size);
+        ::copyBuffer(uploadManager.commandBuffer(), staging.buffer, mBuffer, staging.offset, 0, size);
     }
 }
 
@@ -136,7 +139,7 @@ VulkanBuffer::~VulkanBuffer()
     if (mRenderDevice)
     {
         vkDestroyBuffer(mRenderDevice->device, mBuffer, nullptr);
-        vkFreeMemory(mRenderDevice->device, mMemory, nullptr);
+        mRenderDevice->memoryAllocator->free(mAllocation);
         mSize = 0;
         mRenderDevice = nullptr;
     }
@@ -157,15 +160,39 @@ VulkanBuffer &VulkanBuffer::operator=(VulkanBuffer &&other) noexcept
 
 void VulkanBuffer::mapBufferMemory(VkDeviceSize offset, VkDeviceSize size, const void *data)
 {
-    ::mapBufferMemory(mRenderDevice, mMemory, offset, size, data);
+    ::mapBufferMemory(mRenderDevice, mAllocation, offset, size, data);
+}
+
+void VulkanBuffer::flush(VkDeviceSize offset, VkDeviceSize size) const
+{
+    mRenderDevice->memoryAllocator->flush(mAllocation, offset, size);
+}
+
+void VulkanBuffer::invalidate(VkDeviceSize offset, VkDeviceSize size) const
+{
+    mRenderDevice->memoryAllocator->invalidate(mAllocation, offset, size);
 }
 
 void VulkanBuffer::update(VkDeviceSize offset, VkDeviceSize size, const void *data)
 {
-    VkCommandBuffer commandBuffer = beginSingleTimeCommands(*mRenderDevice);
-    VulkanBuffer stagingBuffer(*mRenderDevice, size, BufferType::Staging, MemoryType::Host, data);
-    copyBuffer(commandBuffer, stagingBuffer, 0, offset, size);
-    endSingleTimeCommands(*mRenderDevice, commandBuffer);
+    VulkanUploadManager& uploadManager = *mRenderDevice->uploadManager;
+
+    StagingRegion staging = uploadManager.stage(data, size);
+    VkCommandBuffer commandBuffer = uploadManager.commandBuffer();
+
+    // the same range can be updated more than once per batch
+    VkMemoryBarrier memoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT
+    };
+
+    vkCmdPipelineBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+
+    ::copyBuffer(commandBuffer, staging.buffer, mBuffer, staging.offset, offset, size);
 }
 
 void VulkanBuffer::copyBuffer(VkCommandBuffer commandBuffer, const VulkanBuffer &other, VkDeviceSize srcOffset, VkDeviceSize dstOffset, VkDeviceSize size)
@@ -184,7 +211,7 @@ void VulkanBuffer::swap(VulkanBuffer &other) noexcept
 {
     std::swap(mRenderDevice, other.mRenderDevice);
     std::swap(mBuffer, other.mBuffer);
-    std::swap(mMemory, other.mMemory);
+    std::swap(mAllocation, other.mAllocation);
     std::swap(mSize, other.mSize);
     std::swap(mType, other.mType);
     std::swap(mMemoryType, other.mMemoryType);
@@ -207,35 +234,28 @@ VkBuffer VulkanBuffer::createBuffer(BufferType type)
     return buffer;
 }
 
-VkDeviceMemory VulkanBuffer::allocateBufferMemory(MemoryType type, VkBuffer buffer)
+MemoryAllocation VulkanBuffer::allocateBufferMemory(BufferType bufferType, MemoryType memoryType, VkBuffer buffer)
 {
-    VkDeviceMemory memory;
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(mRenderDevice->device, buffer, &memoryRequirements);
 
-    VkMemoryRequirements stagingBufferMemoryRequirements;
-    vkGetBufferMemoryRequirements(mRenderDevice->device, buffer, &stagingBufferMemoryRequirements);
+    // staging buffers are short lived, bump allocate them
+    AllocationStrategy strategy = bufferType == BufferType::Staging? AllocationStrategy::Linear : AllocationStrategy::FreeList;
 
-    uint32_t memoryTypeIndex = findSuitableMemoryType(mRenderDevice->getMemoryProperties(),
-                                                      stagingBufferMemoryRequirements.memoryTypeBits,
-                                                      toVkFlags(type)).value();
-
-    VkMemoryAllocateInfo memoryAllocateInfo {
-        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .allocationSize = stagingBufferMemoryRequirements.size,
-        .memoryTypeIndex = memoryTypeIndex
-    };
+    MemoryAllocation allocation = mRenderDevice->memoryAllocator->allocate(memoryRequirements,
+                                                                           toVkFlags(memoryType),
+                                                                           ResourceKind::Buffer,
+                                                                           strategy);
 
-    VkResult result = vkAllocateMemory(mRenderDevice->device, &memoryAllocateInfo, nullptr, &memory);
-    vulkanCheck(result, "Failed to allocate buffer memory.");
+    VkResult result = vkBindBufferMemory(mRenderDevice->device, buffer, allocation.memory, allocation.offset);
+    vulkanCheck(result, "Failed to bind buffer memory.");
 
-    vkBindBufferMemory(mRenderDevice->device, buffer, memory, 0);
-
-    return memory;
+    return allocation;
 }
 
 void VulkanBuffer::setDebugName(const std::string &debugName)
 {
     setVulkanObjectDebugName(*mRenderDevice, VK_OBJECT_TYPE_BUFFER, debugName, mBuffer);
-    setVulkanObjectDebugName(*mRenderDevice, VK_OBJECT_TYPE_DEVICE_MEMORY, debugName, mMemory);
 }
 
 VkDeviceSize VulkanBuffer::getSize() const
@@ -260,5 +280,15 @@ VkBuffer VulkanBuffer::getBuffer() const
 
 VkDeviceMemory VulkanBuffer::getMemory() const
 {
-    return mMemory;
+    return mAllocation.memory;
+}
+
+VkDeviceSize VulkanBuffer::getMemoryOffset() const
+{
+    return mAllocation.offset;
+}
+
+void* VulkanBuffer::getMappedData() const
+{
+    return mAllocation.mappedData;
 }
@@ -6,6 +6,7 @@
 #define VULKANRENDERINGENGINE_VULKAN_BUFFER_HPP
 
 #include "vulkan_render_device.hpp"
+#include "vulkan_memory_allocator.hpp"
 
 enum class BufferType
 {
@@ -13,7 +14,10 @@ enum class BufferType
     Index,
     Uniform,
     Storage,
-    Staging
+    Staging,
+    // vertex buffer that compute shaders can also read and write
+    Instance,
+    Indirect
 };
 
 enum class MemoryType
@@ -49,6 +53,14 @@ public:
     VulkanBuffer& operator=(VulkanBuffer&& other) noexcept;
 
     void mapBufferMemory(VkDeviceSize offset, VkDeviceSize size, const void* data);
+    void flush(VkDeviceSize offset, VkDeviceSize size) const;
+    void invalidate(VkDeviceSize offset, VkDeviceSize size) const;
+
+    // host visible buffers stay mapped for their lifetime. Host and HostCached writes need a flush.
+    template<typename T>
+    T* mapped(VkDeviceSize offset = 0) const;
+    template<typename T>
+    std::span<T> mappedSpan() const;
     void update(VkDeviceSize offset, VkDeviceSize size, const void* data);
     void copyBuffer(VkCommandBuffer commandBuffer, const VulkanBuffer& other, VkDeviceSize srcOffset, VkDeviceSize dstOffset, VkDeviceSize size);
     void copyBuffer(const VulkanBuffer& other, VkDeviceSize srcOffset, VkDeviceSize dstOffset, VkDeviceSize size);
@@ -58,20 +70,22 @@ public:
 
     VkBuffer getBuffer() const;
     VkDeviceMemory getMemory() const;
+    VkDeviceSize getMemoryOffset() const;
+    void* getMappedData() const;
     VkDeviceSize getSize() const;
     BufferType getBufferType() const;
     MemoryType getMemoryType() const;
 
 private:
     VkBuffer createBuffer(BufferType type);
-    VkDeviceMemory allocateBufferMemory(MemoryType type, VkBuffer buffer);
+    MemoryAllocation allocateBufferMemory(BufferType bufferType, MemoryType memoryType, VkBuffer buffer);
 
 private:
     const VulkanRenderDevice* mRenderDevice;
 
     VkDeviceSize mSize;
     VkBuffer mBuffer;
-    VkDeviceMemory mMemory;
+    MemoryAllocation mAllocation;
 
     BufferType mType;
     MemoryType mMemoryType;
@@ -79,4 +93,17 @@ private:
 
 uint32_t getIndexCount(const VulkanBuffer& buffer);
 
+template<typename T>
+T* VulkanBuffer::mapped(VkDeviceSize offset) const
+{
+    assert(mAllocation.mappedData);
+    return reinterpret_cast<T*>(static_cast<uint8_t*>(mAllocation.mappedData) + offset);
+}
+
+template<typename T>
+std::span<T> VulkanBuffer::mappedSpan() const
+{
+    return {mapped<T>(), static_cast<size_t>(mSize / sizeof(T))};
+}
+
 #endif //VULKANRENDERINGENGINE_VULKAN_BUFFER_HPP
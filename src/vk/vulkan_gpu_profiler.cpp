@@ -0,0 +1,306 @@
+//
+// Created by Gianni on 16/10/2026.
+//
+
+#include <json/json.hpp>
+#include "vulkan_gpu_profiler.hpp"
+
+static constexpr uint32_t sMaxQueriesPerFrame = 256;
+static constexpr uint32_t sInvalidQuery = std::numeric_limits<uint32_t>::max();
+static constexpr size_t sTraceFrameCount = 120;
+
+static VulkanGpuProfiler* sActiveProfiler = nullptr;
+
+VulkanGpuProfiler::VulkanGpuProfiler(const VulkanRenderDevice& renderDevice)
+    : mRenderDevice(renderDevice)
+    , mQueryPool()
+    , mTimestampPeriod(renderDevice.getDeviceProperties().limits.timestampPeriod)
+    , mEnabled(true)
+    , mFrames(renderDevice.framesInFlight)
+    , mCommandBuffer()
+    , mFrameIndex()
+    , mFrameMs()
+{
+    VkQueryPoolCreateInfo queryPoolCreateInfo {
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .queryType = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount = mRenderDevice.framesInFlight * sMaxQueriesPerFrame
+    };
+
+    VkResult result = vkCreateQueryPool(mRenderDevice.device, &queryPoolCreateInfo, nullptr, &mQueryPool);
+    vulkanCheck(result, "Failed to create query pool.");
+
+    pfnResetQueryPoolEXT(mRenderDevice.device, mQueryPool, 0, mRenderDevice.framesInFlight * sMaxQueriesPerFrame);
+
+    setVulkanObjectDebugName(mRenderDevice, VK_OBJECT_TYPE_QUERY_POOL, "VulkanGpuProfiler::mQueryPool", mQueryPool);
+
+    mTimestamps.resize(sMaxQueriesPerFrame);
+}
+
+VulkanGpuProfiler::~VulkanGpuProfiler()
+{
+    if (sActiveProfiler == this)
+        sActiveProfiler = nullptr;
+
+    vkDestroyQueryPool(mRenderDevice.device, mQueryPool, nullptr);
+}
+
+void VulkanGpuProfiler::collect(uint32_t frameIndex)
+{
+    FrameQueries& frame = mFrames.at(frameIndex);
+
+    if (frame.queryCount == 0)
+        return;
+
+    uint32_t firstQuery = frameIndex * sMaxQueriesPerFrame;
+
+    VkResult result = vkGetQueryPoolResults(mRenderDevice.device,
+                                            mQueryPool,
+                                            firstQuery, frame.queryCount,
+                                            frame.queryCount * sizeof(uint64_t), mTimestamps.data(),
+                                            sizeof(uint64_t),
+                                            VK_QUERY_RESULT_64_BIT);
+
+    if (result == VK_SUCCESS)
+    {
+        auto toMicro = [this] (uint64_t ticks) {
+            return static_cast<double>(ticks) * mTimestampPeriod / 1000.0;
+        };
+
+        if (frame.endQuery != sInvalidQuery)
+            mFrameMs = static_cast<float>(toMicro(mTimestamps.at(frame.endQuery) - mTimestamps.at(0)) / 1000.0);
+
+        for (GpuZoneStats& stats : mZoneStats)
+            stats.active = false;
+
+        std::vector<TraceEvent> traceEvents;
+        traceEvents.reserve(frame.zones.size());
+
+        for (const Zone& zone : frame.zones)
+        {
+            if (zone.beginQuery == sInvalidQuery || zone.endQuery == sInvalidQuery)
+                continue;
+
+            uint64_t begin = mTimestamps.at(zone.beginQuery);
+            uint64_t end = std::max(mTimestamps.at(zone.endQuery), begin);
+
+            addSample(zone, static_cast<float>(toMicro(end - begin) / 1000.0));
+            traceEvents.push_back({zone.name, zone.depth, toMicro(begin), toMicro(end - begin)});
+        }
+
+        mTraceFrames.push_back(std::move(traceEvents));
+        if (mTraceFrames.size() > sTraceFrameCount)
+            mTraceFrames.pop_front();
+    }
+
+    pfnResetQueryPoolEXT(mRenderDevice.device, mQueryPool, firstQuery, frame.queryCount);
+
+    frame.zones.clear();
+    frame.queryCount = 0;
+}
+
+void VulkanGpuProfiler::beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+{
+    if (!mEnabled)
+        return;
+
+    sActiveProfiler = this;
+    mCommandBuffer = commandBuffer;
+    mFrameIndex = frameIndex;
+    mZoneStack.clear();
+
+    FrameQueries& frame = mFrames.at(frameIndex);
+    frame.zones.clear();
+    frame.queryCount = 0;
+    frame.endQuery = sInvalidQuery;
+
+    writeTimestamp(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+}
+
+void VulkanGpuProfiler::endFrame()
+{
+    if (!mCommandBuffer)
+        return;
+
+    while (!mZoneStack.empty())
+        popZone();
+
+    mFrames.at(mFrameIndex).endQuery = writeTimestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+    sActiveProfiler = nullptr;
+    mCommandBuffer = VK_NULL_HANDLE;
+}
+
+void VulkanGpuProfiler::beginZone(VkCommandBuffer commandBuffer, const char* name)
+{
+    if (sActiveProfiler && sActiveProfiler->mCommandBuffer == commandBuffer)
+        sActiveProfiler->pushZone(name);
+}
+
+void VulkanGpuProfiler::endZone(VkCommandBuffer commandBuffer)
+{
+    if (sActiveProfiler && sActiveProfiler->mCommandBuffer == commandBuffer)
+        sActiveProfiler->popZone();
+}
+
+void VulkanGpuProfiler::setEnabled(bool enabled)
+{
+    mEnabled = enabled;
+
+    if (!enabled)
+        mFrameMs = 0.f;
+}
+
+bool VulkanGpuProfiler::enabled() const
+{
+    return mEnabled;
+}
+
+float VulkanGpuProfiler::frameMs() const
+{
+    return mFrameMs;
+}
+
+const std::vector<GpuZoneStats>& VulkanGpuProfiler::zoneStats() const
+{
+    return mZoneStats;
+}
+
+bool VulkanGpuProfiler::exportCsv(const std::filesystem::path& path) const
+{
+    std::ofstream file(path);
+
+    if (!file.is_open())
+        return false;
+
+    file << "zone,depth,last_ms,min_ms,avg_ms,max_ms\n";
+
+    for (const GpuZoneStats& stats : mZoneStats)
+    {
+        file << std::format("\"{}\",{},{:.4f},{:.4f},{:.4f},{:.4f}\n",
+                            stats.name,
+                            stats.depth,
+                            stats.lastMs,
+                            stats.minMs,
+                            stats.avgMs,
+                            stats.maxMs);
+    }
+
+    return file.good();
+}
+
+bool VulkanGpuProfiler::exportChromeTrace(const std::filesystem::path& path) const
+{
+    std::ofstream file(path);
+
+    if (!file.is_open())
+        return false;
+
+    nlohmann::json traceEvents = nlohmann::json::array();
+
+    traceEvents.push_back({
+        {"name", "thread_name"},
+        {"ph", "M"},
+        {"pid", 0},
+        {"tid", 0},
+        {"args", {{"name", "GPU"}}}
+    });
+
+    // timestamps share one gpu clock, so events keep their relative position across frames
+    double originUs = std::numeric_limits<double>::max();
+    for (const auto& events : mTraceFrames)
+        for (const TraceEvent& event : events)
+            originUs = std::min(originUs, event.startUs);
+
+    for (const auto& events : mTraceFrames)
+    {
+        for (const TraceEvent& event : events)
+        {
+            traceEvents.push_back({
+                {"name", event.name},
+                {"cat", "gpu"},
+                {"ph", "X"},
+                {"ts", event.startUs - originUs},
+                {"dur", event.durationUs},
+                {"pid", 0},
+                {"tid", 0},
+                {"args", {{"depth", event.depth}}}
+            });
+        }
+    }
+
+    nlohmann::json trace {
+        {"traceEvents", traceEvents},
+        {"displayTimeUnit", "ms"}
+    };
+
+    file << trace.dump();
+
+    return file.good();
+}
+
+uint32_t VulkanGpuProfiler::writeTimestamp(VkPipelineStageFlagBits stage)
+{
+    FrameQueries& frame = mFrames.at(mFrameIndex);
+
+    if (frame.queryCount == sMaxQueriesPerFrame)
+        return sInvalidQuery;
+
+    uint32_t query = frame.queryCount++;
+    vkCmdWriteTimestamp(mCommandBuffer, stage, mQueryPool, mFrameIndex * sMaxQueriesPerFrame + query);
+
+    return query;
+}
+
+void VulkanGpuProfiler::pushZone(const char* name)
+{
+    FrameQueries& frame = mFrames.at(mFrameIndex);
+
+    frame.zones.push_back({
+        .name = name,
+        .depth = static_cast<uint32_t>(mZoneStack.size()),
+        .beginQuery = writeTimestamp(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT),
+        .endQuery = sInvalidQuery
+    });
+
+    mZoneStack.push_back(frame.zones.size() - 1);
+}
+
+void VulkanGpuProfiler::popZone()
+{
+    if (mZoneStack.empty())
+        return;
+
+    uint32_t zoneIndex = mZoneStack.back();
+    mZoneStack.pop_back();
+
+    mFrames.at(mFrameIndex).zones.at(zoneIndex).endQuery = writeTimestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+}
+
+void VulkanGpuProfiler::addSample(const Zone& zone, float ms)
+{
+    auto itr = std::find_if(mZoneStats.begin(), mZoneStats.end(), [&zone] (const GpuZoneStats& stats) {
+        return stats.name == zone.name;
+    });
+
+    if (itr == mZoneStats.end())
+    {
+        mZoneStats.push_back({.name = zone.name, .depth = zone.depth});
+        itr = std::prev(mZoneStats.end());
+    }
+
+    GpuZoneStats& stats = *itr;
+    stats.active = true;
+    stats.depth = zone.depth;
+    stats.lastMs = ms;
+    stats.history.at(stats.historyNext) = ms;
+    stats.historyNext = (stats.historyNext + 1) % GpuZoneHistorySize;
+    stats.historyCount = std::min(stats.historyCount + 1, GpuZoneHistorySize);
+
+    auto samples = std::span(stats.history).first(stats.historyCount);
+    auto [minItr, maxItr] = std::minmax_element(samples.begin(), samples.end());
+
+    stats.minMs = *minItr;
+    stats.maxMs = *maxItr;
+    stats.avgMs = std::accumulate(samples.begin(), samples.end(), 0.f) / static_cast<float>(samples.size());
+}
@@ -0,0 +1,103 @@
+//
+// Created by Gianni on 16/10/2026.
+//
+
+#ifndef VULKANRENDERINGENGINE_VULKAN_GPU_PROFILER_HPP
+#define VULKANRENDERINGENGINE_VULKAN_GPU_PROFILER_HPP
+
+#include "vulkan_render_device.hpp"
+
+constexpr uint32_t GpuZoneHistorySize = 128;
+
+struct GpuZoneStats
+{
+    std::string name;
+    uint32_t depth;
+    bool active;
+    float lastMs;
+    float minMs;
+    float avgMs;
+    float maxMs;
+    std::array<float, GpuZoneHistorySize> history;
+    uint32_t historyCount;
+    uint32_t historyNext;
+};
+
+// Times the debug label scopes of the frame command buffer with timestamp queries.
+// Every frame in flight owns a range of the query pool, which is read back after that frame's fence
+// has signaled, so reading never stalls. Main thread only.
+class VulkanGpuProfiler
+{
+public:
+    VulkanGpuProfiler(const VulkanRenderDevice& renderDevice);
+    ~VulkanGpuProfiler();
+
+    VulkanGpuProfiler(const VulkanGpuProfiler&) = delete;
+    VulkanGpuProfiler& operator=(const VulkanGpuProfiler&) = delete;
+
+    // the fence of frameIndex has to be signaled
+    void collect(uint32_t frameIndex);
+    void beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+    void endFrame();
+
+    // called by beginDebugLabel / endDebugLabel
+    static void beginZone(VkCommandBuffer commandBuffer, const char* name);
+    static void endZone(VkCommandBuffer commandBuffer);
+
+    void setEnabled(bool enabled);
+    bool enabled() const;
+    float frameMs() const;
+    const std::vector<GpuZoneStats>& zoneStats() const;
+
+    bool exportCsv(const std::filesystem::path& path) const;
+    bool exportChromeTrace(const std::filesystem::path& path) const;
+
+private:
+    struct Zone
+    {
+        std::string name;
+        uint32_t depth;
+        uint32_t beginQuery;
+        uint32_t endQuery;
+    };
+
+    struct FrameQueries
+    {
+        std::vector<Zone> zones;
+        uint32_t queryCount;
+        uint32_t endQuery;
+    };
+
+    struct TraceEvent
+    {
+        std::string name;
+        uint32_t depth;
+        double startUs;
+        double durationUs;
+    };
+
+    uint32_t writeTimestamp(VkPipelineStageFlagBits stage);
+    void pushZone(const char* name);
+    void popZone();
+    void addSample(const Zone& zone, float ms);
+
+private:
+    const VulkanRenderDevice& mRenderDevice;
+
+    VkQueryPool mQueryPool;
+    double mTimestampPeriod;
+    bool mEnabled;
+
+    std::vector<FrameQueries> mFrames;
+    std::vector<uint64_t> mTimestamps;
+
+    VkCommandBuffer mCommandBuffer;
+    uint32_t mFrameIndex;
+    std::vector<uint32_t> mZoneStack;
+
+    float mFrameMs;
+    std::vector<GpuZoneStats> mZoneStats;
+    std::deque<std::vector<TraceEvent>> mTraceFrames;
+};
+
+#endif //VULKANRENDERINGENGINE_VULKAN_GPU_PROFILER_HPP
@@ -5,12 +5,13 @@
 #include "vulkan_image.hpp"
 #include "vulkan_utils.hpp"
 #include "vulkan_buffer.hpp"
+#include "vulkan_upload_manager.hpp"
 
 VulkanImage::VulkanImage()
     : mRenderDevice()
     , image()
     , imageView()
-    , memory()
+    , allocation()
     , width()
     , height()
     , mipLevels()
@@ -33,7 +34,7 @@ VulkanImage::VulkanImage(const VulkanRenderDevice &renderDevice,
     : mRenderDevice(&renderDevice)
     , image()
     , imageView()
-    , memory()
+    , allocation()
     , width(width)
     , height(height)
     , mipLevels(mipLevels)
@@ -67,22 +68,12 @@ VulkanImage::VulkanImage(const VulkanRenderDevice &renderDevice,
     VkMemoryRequirements imageMemoryRequirements;
     vkGetImageMemoryRequirements(renderDevice.device, image, &imageMemoryRequirements);
 
-    VkMemoryPropertyFlags memoryPropertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    allocation = renderDevice.memoryAllocator->allocate(imageMemoryRequirements,
+                                                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                                        ResourceKind::Image);
 
-    uint32_t imageMemoryTypeIndex = findSuitableMemoryType(renderDevice.getMemoryProperties(),
-                                                           imageMemoryRequirements.memoryTypeBits,
-                                                           memoryPropertyFlags).value();
-
-    VkMemoryAllocateInfo memoryAllocateInfo {
-        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .allocationSize = imageMemoryRequirements.size,
-        .memoryTypeIndex = imageMemoryTypeIndex
-    };
-
-    result = vkAllocateMemory(renderDevice.device, &memoryAllocateInfo, nullptr, &memory);
-    vulkanCheck(result, "Failed to allocate image memory.");
-
-    vkBindImageMemory(renderDevice.device, image, memory, 0);
+    result = vkBindImageMemory(renderDevice.device, image, allocation.memory, allocation.offset);
+    vulkanCheck(result, "Failed to bind image memory.");
 
     // create image view
     imageView = createImageView(*mRenderDevice, image, viewType, format, imageAspect, 0, mipLevels, 0, layerCount);
@@ -99,7 +90,7 @@ VulkanImage::~VulkanImage()
             vkDestroyImageView(mRenderDevice->device, iv, nullptr);
 
         vkDestroyImage(mRenderDevice->device, image, nullptr);
-        vkFreeMemory(mRenderDevice->device, memory, nullptr);
+        mRenderDevice->memoryAllocator->free(allocation);
 
         width = 0;
         height = 0;
@@ -129,7 +120,7 @@ void VulkanImage::swap(VulkanImage &other) noexcept
     std::swap(mRenderDevice, other.mRenderDevice);
     std::swap(image, other.image);
     std::swap(imageView, other.imageView);
-    std::swap(memory, other.memory);
+    std::swap(allocation, other.allocation);
     std::swap(width, other.width);
     std::swap(height, other.height);
     std::swap(mipLevels, other.mipLevels);
@@ -219,9 +210,14 @@ void VulkanImage::setDebugName(const std::string &debugName)
 }
 
 void VulkanImage::copyBuffer(VkCommandBuffer commandBuffer, const VulkanBuffer &buffer, uint32_t layerIndex)
+{
+    copyBuffer(commandBuffer, buffer.getBuffer(), 0, layerIndex);
+}
+
+void VulkanImage::copyBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize bufferOffset, uint32_t layerIndex)
 {
     VkBufferImageCopy copyRegion {
-        .bufferOffset = 0,
+        .bufferOffset = bufferOffset,
         .bufferRowLength = width,
         .bufferImageHeight = height,
         .imageSubresource {
@@ -239,7 +235,7 @@ void VulkanImage::copyBuffer(VkCommandBuffer commandBuffer, const VulkanBuffer &
     };
 
     vkCmdCopyBufferToImage(commandBuffer,
-                           buffer.getBuffer(),
+                           buffer,
                            image,
                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
                            1, &copyRegion);
@@ -252,15 +248,12 @@ void VulkanImage::uploadImageData(VkCommandBuffer commandBuffer, const VulkanBuf
 
 void VulkanImage::uploadImageData(const void *data, uint32_t layerIndex)
 {
-    VkCommandBuffer commandBuffer = beginSingleTimeCommands(*mRenderDevice);
+    VulkanUploadManager& uploadManager = *mRenderDevice->uploadManager;
 
     VkDeviceSize size = imageMemoryDeviceSize(width, height, format);
 
-    VulkanBuffer stagingBuffer(*mRenderDevice, size, BufferType::Staging, MemoryType::Host, data);
-
-    copyBuffer(commandBuffer, stagingBuffer, layerIndex);
-
-    endSingleTimeCommands(*mRenderDevice, commandBuffer);
+    StagingRegion staging = uploadManager.stage(data, size);
+    copyBuffer(uploadManager.commandBuffer(), staging.buffer, staging.offset, layerIndex);
 }
 
 VkImageView createImageView(const VulkanRenderDevice& renderDevice,
@@ -6,6 +6,7 @@
 #define VULKANRENDERINGENGINE_VULKAN_IMAGE_HPP
 
 #include "vulkan_render_device.hpp"
+#include "vulkan_memory_allocator.hpp"
 
 class VulkanBuffer;
 
@@ -14,7 +15,7 @@ class VulkanImage
 public:
     VkImage image;
     VkImageView imageView;
-    VkDeviceMemory memory;
+    MemoryAllocation allocation;
 
     uint32_t width;
     uint32_t height;
@@ -59,6 +60,7 @@ public:
                           VkAccessFlags srcAccess, VkAccessFlags dstAccess);
 
     void copyBuffer(VkCommandBuffer commandBuffer, const VulkanBuffer& buffer, uint32_t layerIndex = 0);
+    void copyBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize bufferOffset, uint32_t layerIndex = 0);
     void swap(VulkanImage& other) noexcept;
 
     void createLayerImageViews(VkImageViewType viewType);
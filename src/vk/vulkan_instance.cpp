@@ -4,12 +4,16 @@
 
 #include "vulkan_instance.hpp"
 
-VulkanInstance::VulkanInstance()
+VulkanInstance::VulkanInstance(bool headless)
 {
-    std::vector<const char*> instanceExtensions {
-        "VK_KHR_surface",
-        "VK_KHR_win32_surface"
-    };
+    std::vector<const char*> instanceExtensions;
+
+    // offscreen rendering never creates a surface
+    if (!headless)
+    {
+        instanceExtensions.push_back("VK_KHR_surface");
+        instanceExtensions.push_back("VK_KHR_win32_surface");
+    }
 
 #ifdef DEBUG_MODE
     instanceExtensions.push_back("VK_EXT_debug_utils");
@@ -16,7 +16,7 @@ public:
     VkDebugUtilsMessengerEXT debugMessenger;
 
 public:
-    VulkanInstance();
+    VulkanInstance(bool headless = false);
     ~VulkanInstance();
 
     static VkBool32 VKAPI_CALL debugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT severity,
@@ -0,0 +1,428 @@
+//
+// Created by Gianni on 16/10/2026.
+//
+
+#include "vulkan_memory_allocator.hpp"
+#include "vulkan_render_device.hpp"
+
+static constexpr VkDeviceSize sDeviceBlockSize = 128 * 1024 * 1024;
+static constexpr VkDeviceSize sHostBlockSize = 32 * 1024 * 1024;
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static VkDeviceSize alignDown(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return value / alignment * alignment;
+}
+
+// -- FreeListAllocator -- //
+
+FreeListAllocator::FreeListAllocator(VkDeviceSize size)
+    : mSize(size)
+{
+    if (size)
+        mFreeRanges.emplace(0, size);
+}
+
+std::optional<FreeListAllocator::Range> FreeListAllocator::allocate(VkDeviceSize size, VkDeviceSize alignment)
+{
+    auto best = mFreeRanges.end();
+
+    // best fit, ties go to the lowest offset
+    for (auto itr = mFreeRanges.begin(); itr != mFreeRanges.end(); ++itr)
+    {
+        VkDeviceSize offset = alignUp(itr->first, alignment);
+
+        if (offset + size > itr->first + itr->second)
+            continue;
+
+        if (best == mFreeRanges.end() || itr->second < best->second)
+            best = itr;
+    }
+
+    if (best == mFreeRanges.end())
+        return std::nullopt;
+
+    VkDeviceSize rangeOffset = best->first;
+    VkDeviceSize freeEnd = best->first + best->second;
+    VkDeviceSize offset = alignUp(rangeOffset, alignment);
+    VkDeviceSize rangeEnd = offset + size;
+
+    mFreeRanges.erase(best);
+
+    if (rangeEnd < freeEnd)
+        mFreeRanges.emplace(rangeEnd, freeEnd - rangeEnd);
+
+    return Range {
+        .rangeOffset = rangeOffset,
+        .rangeSize = rangeEnd - rangeOffset,
+        .offset = offset
+    };
+}
+
+void FreeListAllocator::free(VkDeviceSize rangeOffset, VkDeviceSize rangeSize)
+{
+    assert(rangeOffset + rangeSize <= mSize);
+
+    auto next = mFreeRanges.lower_bound(rangeOffset);
+    assert(next == mFreeRanges.end() || rangeOffset + rangeSize <= next->first);
+
+    // merge with the following free range
+    if (next != mFreeRanges.end() && rangeOffset + rangeSize == next->first)
+    {
+        rangeSize += next->second;
+        next = mFreeRanges.erase(next);
+    }
+
+    // merge with the preceding free range
+    if (next != mFreeRanges.begin())
+    {
+        auto prev = std::prev(next);
+        assert(prev->first + prev->second <= rangeOffset);
+
+        if (prev->first + prev->second == rangeOffset)
+        {
+            prev->second += rangeSize;
+            return;
+        }
+    }
+
+    mFreeRanges.emplace_hint(next, rangeOffset, rangeSize);
+}
+
+VkDeviceSize FreeListAllocator::freeBytes() const
+{
+    VkDeviceSize bytes = 0;
+    for (const auto& [offset, size] : mFreeRanges)
+        bytes += size;
+    return bytes;
+}
+
+VkDeviceSize FreeListAllocator::largestFreeRange() const
+{
+    VkDeviceSize largest = 0;
+    for (const auto& [offset, size] : mFreeRanges)
+        largest = std::max(largest, size);
+    return largest;
+}
+
+uint32_t FreeListAllocator::freeRangeCount() const
+{
+    return mFreeRanges.size();
+}
+
+// -- LinearAllocator -- //
+
+LinearAllocator::LinearAllocator(VkDeviceSize size)
+    : mSize(size)
+    , mHead()
+    , mAllocationCount()
+{
+}
+
+std::optional<FreeListAllocator::Range> LinearAllocator::allocate(VkDeviceSize size, VkDeviceSize alignment)
+{
+    VkDeviceSize offset = alignUp(mHead, alignment);
+
+    if (offset + size > mSize)
+        return std::nullopt;
+
+    FreeListAllocator::Range range {
+        .rangeOffset = mHead,
+        .rangeSize = offset + size - mHead,
+        .offset = offset
+    };
+
+    mHead = offset + size;
+    ++mAllocationCount;
+
+    return range;
+}
+
+void LinearAllocator::free()
+{
+    assert(mAllocationCount);
+
+    if (--mAllocationCount == 0)
+        mHead = 0;
+}
+
+VkDeviceSize LinearAllocator::head() const
+{
+    return mHead;
+}
+
+// -- VulkanMemoryAllocator -- //
+
+VulkanMemoryAllocator::VulkanMemoryAllocator(const VulkanRenderDevice& renderDevice)
+    : mRenderDevice(renderDevice)
+{
+}
+
+VulkanMemoryAllocator::~VulkanMemoryAllocator()
+{
+    uint32_t leakedAllocations = 0;
+
+    for (auto& block : mBlocks)
+    {
+        leakedAllocations += block->allocationCount;
+
+        if (block->mappedData)
+            vkUnmapMemory(mRenderDevice.device, block->memory);
+        vkFreeMemory(mRenderDevice.device, block->memory, nullptr);
+    }
+
+    if (leakedAllocations)
+        debugLog(std::format("VulkanMemoryAllocator: {} allocation(s) still alive on destruction", leakedAllocations));
+}
+
+MemoryAllocation VulkanMemoryAllocator::allocate(const VkMemoryRequirements& requirements,
+                                                 VkMemoryPropertyFlags properties,
+                                                 ResourceKind resourceKind,
+                                                 AllocationStrategy strategy)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    const VkPhysicalDeviceMemoryProperties& memoryProperties = mRenderDevice.getMemoryProperties();
+
+    std::optional<uint32_t> memoryTypeIndex = findSuitableMemoryType(memoryProperties,
+                                                                     requirements.memoryTypeBits,
+                                                                     properties);
+    check(memoryTypeIndex.has_value(), "Failed to find a suitable memory type.");
+
+    VkMemoryPropertyFlags typeFlags = memoryProperties.memoryTypes[*memoryTypeIndex].propertyFlags;
+
+    // keep non coherent allocations on separate atoms so flushes don't touch neighbours
+    VkDeviceSize alignment = requirements.alignment;
+    if ((typeFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && !(typeFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+        alignment = std::max(alignment, mRenderDevice.getDeviceProperties().limits.nonCoherentAtomSize);
+
+    VkDeviceSize blockSize = (typeFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)? sDeviceBlockSize : sHostBlockSize;
+
+    if (requirements.size > blockSize / 2)
+    {
+        MemoryBlock* block = createBlock(*memoryTypeIndex, requirements.size, resourceKind, strategy, true);
+        return allocateFromBlock(*block, requirements.size, alignment).value();
+    }
+
+    for (auto& block : mBlocks)
+    {
+        if (block->dedicated ||
+            block->memoryTypeIndex != *memoryTypeIndex ||
+            block->resourceKind != resourceKind ||
+            block->strategy != strategy)
+            continue;
+
+        if (auto allocation = allocateFromBlock(*block, requirements.size, alignment))
+            return *allocation;
+    }
+
+    MemoryBlock* block = createBlock(*memoryTypeIndex, blockSize, resourceKind, strategy, false);
+    return allocateFromBlock(*block, requirements.size, alignment).value();
+}
+
+void VulkanMemoryAllocator::free(MemoryAllocation& allocation)
+{
+    if (!allocation.block)
+        return;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    MemoryBlock& block = *allocation.block;
+
+    --block.allocationCount;
+    block.bytesUsed -= allocation.size;
+    block.bytesWasted -= allocation.rangeSize - allocation.size;
+
+    if (block.strategy == AllocationStrategy::FreeList)
+        block.freeList.free(allocation.rangeOffset, allocation.rangeSize);
+    else
+        block.linear.free();
+
+    if (block.dedicated)
+        destroyBlock(&block);
+
+    allocation = {};
+}
+
+void VulkanMemoryAllocator::flush(const MemoryAllocation& allocation, VkDeviceSize offset, VkDeviceSize size) const
+{
+    if (isCoherent(allocation))
+        return;
+
+    VkMappedMemoryRange range = mappedRange(allocation, offset, size);
+    vkFlushMappedMemoryRanges(mRenderDevice.device, 1, &range);
+}
+
+void VulkanMemoryAllocator::invalidate(const MemoryAllocation& allocation, VkDeviceSize offset, VkDeviceSize size) const
+{
+    if (isCoherent(allocation))
+        return;
+
+    VkMappedMemoryRange range = mappedRange(allocation, offset, size);
+    vkInvalidateMappedMemoryRanges(mRenderDevice.device, 1, &range);
+}
+
+bool VulkanMemoryAllocator::isCoherent(const MemoryAllocation& allocation) const
+{
+    const VkPhysicalDeviceMemoryProperties& memoryProperties = mRenderDevice.getMemoryProperties();
+    VkMemoryPropertyFlags typeFlags = memoryProperties.memoryTypes[allocation.block->memoryTypeIndex].propertyFlags;
+    return typeFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+}
+
+uint32_t VulkanMemoryAllocator::defragment()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    uint32_t releasedBlocks = 0;
+
+    for (auto itr = mBlocks.begin(); itr != mBlocks.end();)
+    {
+        MemoryBlock& block = **itr;
+
+        if (block.allocationCount == 0)
+        {
+            if (block.mappedData)
+                vkUnmapMemory(mRenderDevice.device, block.memory);
+            vkFreeMemory(mRenderDevice.device, block.memory, nullptr);
+
+            itr = mBlocks.erase(itr);
+            ++releasedBlocks;
+        }
+        else
+            ++itr;
+    }
+
+    return releasedBlocks;
+}
+
+MemoryStats VulkanMemoryAllocator::stats() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    MemoryStats memoryStats {};
+
+    for (const auto& block : mBlocks)
+    {
+        memoryStats.bytesReserved += block->size;
+        memoryStats.bytesUsed += block->bytesUsed;
+        memoryStats.bytesWasted += block->bytesWasted;
+        memoryStats.allocationCount += block->allocationCount;
+        ++memoryStats.blockCount;
+
+        if (block->dedicated)
+            ++memoryStats.dedicatedBlockCount;
+    }
+
+    return memoryStats;
+}
+
+MemoryBlock* VulkanMemoryAllocator::createBlock(uint32_t memoryTypeIndex,
+                                                VkDeviceSize size,
+                                                ResourceKind resourceKind,
+                                                AllocationStrategy strategy,
+                                                bool dedicated)
+{
+    VkMemoryAllocateInfo memoryAllocateInfo {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .allocationSize = size,
+        .memoryTypeIndex = memoryTypeIndex
+    };
+
+    VkDeviceMemory memory;
+    VkResult result = vkAllocateMemory(mRenderDevice.device, &memoryAllocateInfo, nullptr, &memory);
+    vulkanCheck(result, "Failed to allocate memory block.");
+
+    void* mappedData = nullptr;
+
+    const VkPhysicalDeviceMemoryProperties& memoryProperties = mRenderDevice.getMemoryProperties();
+    if (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    {
+        result = vkMapMemory(mRenderDevice.device, memory, 0, VK_WHOLE_SIZE, 0, &mappedData);
+        vulkanCheck(result, "Failed to map memory block.");
+    }
+
+    auto block = std::make_unique<MemoryBlock>(MemoryBlock {
+        .memory = memory,
+        .size = size,
+        .mappedData = mappedData,
+        .memoryTypeIndex = memoryTypeIndex,
+        .resourceKind = resourceKind,
+        .strategy = strategy,
+        .dedicated = dedicated,
+        .freeList = FreeListAllocator(size),
+        .linear = LinearAllocator(size),
+        .allocationCount = 0,
+        .bytesUsed = 0,
+        .bytesWasted = 0
+    });
+
+    mBlocks.push_back(std::move(block));
+
+    return mBlocks.back().get();
+}
+
+void VulkanMemoryAllocator::destroyBlock(MemoryBlock* block)
+{
+    auto itr = std::find_if(mBlocks.begin(), mBlocks.end(), [block] (const auto& b) {
+        return b.get() == block;
+    });
+
+    assert(itr != mBlocks.end());
+
+    if (block->mappedData)
+        vkUnmapMemory(mRenderDevice.device, block->memory);
+    vkFreeMemory(mRenderDevice.device, block->memory, nullptr);
+
+    mBlocks.erase(itr);
+}
+
+std::optional<MemoryAllocation> VulkanMemoryAllocator::allocateFromBlock(MemoryBlock& block,
+                                                                         VkDeviceSize size,
+                                                                         VkDeviceSize alignment)
+{
+    auto range = block.strategy == AllocationStrategy::FreeList?
+        block.freeList.allocate(size, alignment) :
+        block.linear.allocate(size, alignment);
+
+    if (!range)
+        return std::nullopt;
+
+    VkDeviceSize rangeOffset = range->rangeOffset;
+    VkDeviceSize rangeSize = range->rangeSize;
+    VkDeviceSize offset = range->offset;
+
+    ++block.allocationCount;
+    block.bytesUsed += size;
+    block.bytesWasted += rangeSize - size;
+
+    return MemoryAllocation {
+        .memory = block.memory,
+        .offset = offset,
+        .size = size,
+        .mappedData = block.mappedData? static_cast<uint8_t*>(block.mappedData) + offset : nullptr,
+        .block = &block,
+        .rangeOffset = rangeOffset,
+        .rangeSize = rangeSize
+    };
+}
+
+VkMappedMemoryRange VulkanMemoryAllocator::mappedRange(const MemoryAllocation& allocation,
+                                                       VkDeviceSize offset,
+                                                       VkDeviceSize size) const
+{
+    VkDeviceSize atomSize = mRenderDevice.getDeviceProperties().limits.nonCoherentAtomSize;
+
+    VkDeviceSize begin = alignDown(allocation.offset + offset, atomSize);
+    VkDeviceSize end = std::min(alignUp(allocation.offset + offset + size, atomSize), allocation.block->size);
+
+    return {
+        .sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+        .memory = allocation.memory,
+        .offset = begin,
+        .size = end - begin
+    };
+}
@@ -0,0 +1,147 @@
+//
+// Created by Gianni on 16/10/2026.
+//
+
+#ifndef VULKANRENDERINGENGINE_VULKAN_MEMORY_ALLOCATOR_HPP
+#define VULKANRENDERINGENGINE_VULKAN_MEMORY_ALLOCATOR_HPP
+
+class VulkanRenderDevice;
+struct MemoryBlock;
+
+enum class AllocationStrategy
+{
+    FreeList,
+    Linear
+};
+
+enum class ResourceKind
+{
+    Buffer,
+    Image
+};
+
+struct MemoryAllocation
+{
+    VkDeviceMemory memory;
+    VkDeviceSize offset;
+    VkDeviceSize size;
+    void* mappedData;
+    MemoryBlock* block;
+    VkDeviceSize rangeOffset;
+    VkDeviceSize rangeSize;
+};
+
+struct MemoryStats
+{
+    VkDeviceSize bytesReserved;
+    VkDeviceSize bytesUsed;
+    VkDeviceSize bytesWasted;
+    uint32_t blockCount;
+    uint32_t dedicatedBlockCount;
+    uint32_t allocationCount;
+};
+
+// offset bookkeeping for a single block, no Vulkan calls
+class FreeListAllocator
+{
+public:
+    struct Range
+    {
+        VkDeviceSize rangeOffset;
+        VkDeviceSize rangeSize;
+        VkDeviceSize offset;
+    };
+
+public:
+    FreeListAllocator(VkDeviceSize size = 0);
+
+    std::optional<Range> allocate(VkDeviceSize size, VkDeviceSize alignment);
+    void free(VkDeviceSize rangeOffset, VkDeviceSize rangeSize);
+
+    VkDeviceSize freeBytes() const;
+    VkDeviceSize largestFreeRange() const;
+    uint32_t freeRangeCount() const;
+
+private:
+    VkDeviceSize mSize;
+    std::map<VkDeviceSize, VkDeviceSize> mFreeRanges;
+};
+
+// bump allocation for a single block, space is only reclaimed once every allocation in it is freed. no Vulkan calls
+class LinearAllocator
+{
+public:
+    LinearAllocator(VkDeviceSize size = 0);
+
+    std::optional<FreeListAllocator::Range> allocate(VkDeviceSize size, VkDeviceSize alignment);
+    void free();
+
+    VkDeviceSize head() const;
+
+private:
+    VkDeviceSize mSize;
+    VkDeviceSize mHead;
+    uint32_t mAllocationCount;
+};
+
+struct MemoryBlock
+{
+    VkDeviceMemory memory;
+    VkDeviceSize size;
+    void* mappedData;
+    uint32_t memoryTypeIndex;
+    ResourceKind resourceKind;
+    AllocationStrategy strategy;
+    bool dedicated;
+
+    FreeListAllocator freeList;
+    LinearAllocator linear;
+
+    uint32_t allocationCount;
+    VkDeviceSize bytesUsed;
+    VkDeviceSize bytesWasted;
+};
+
+// Sub-allocates buffers and images out of large VkDeviceMemory blocks. Host visible blocks stay mapped.
+// Requests bigger than half a block get a dedicated block that is released with the allocation.
+class VulkanMemoryAllocator
+{
+public:
+    VulkanMemoryAllocator(const VulkanRenderDevice& renderDevice);
+    ~VulkanMemoryAllocator();
+
+    VulkanMemoryAllocator(const VulkanMemoryAllocator&) = delete;
+    VulkanMemoryAllocator& operator=(const VulkanMemoryAllocator&) = delete;
+
+    MemoryAllocation allocate(const VkMemoryRequirements& requirements,
+                              VkMemoryPropertyFlags properties,
+                              ResourceKind resourceKind,
+                              AllocationStrategy strategy = AllocationStrategy::FreeList);
+    void free(MemoryAllocation& allocation);
+
+    void flush(const MemoryAllocation& allocation, VkDeviceSize offset, VkDeviceSize size) const;
+    void invalidate(const MemoryAllocation& allocation, VkDeviceSize offset, VkDeviceSize size) const;
+    bool isCoherent(const MemoryAllocation& allocation) const;
+
+    // defragmentation hook, releases empty blocks. moving live allocations is left to the resource owners.
+    uint32_t defragment();
+
+    MemoryStats stats() const;
+
+private:
+    MemoryBlock* createBlock(uint32_t memoryTypeIndex,
+                             VkDeviceSize size,
+                             ResourceKind resourceKind,
+                             AllocationStrategy strategy,
+                             bool dedicated);
+    void destroyBlock(MemoryBlock* block);
+    std::optional<MemoryAllocation> allocateFromBlock(MemoryBlock& block, VkDeviceSize size, VkDeviceSize alignment);
+    VkMappedMemoryRange mappedRange(const MemoryAllocation& allocation, VkDeviceSize offset, VkDeviceSize size) const;
+
+private:
+    const VulkanRenderDevice& mRenderDevice;
+    std::vector<std::unique_ptr<MemoryBlock>> mBlocks;
+    mutable std::mutex mMutex;
+};
+
+#endif //VULKANRENDERINGENGINE_VULKAN_MEMORY_ALLOCATOR_HPP
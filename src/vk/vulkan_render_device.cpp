@@ -5,13 +5,19 @@
 #include "vulkan_render_device.hpp"
 #include "vulkan_utils.hpp"
 #include "vulkan_descriptor.hpp"
+#include "vulkan_memory_allocator.hpp"
+#include "vulkan_upload_manager.hpp"
+#include "vulkan_gpu_profiler.hpp"
+
+static constexpr VkDeviceSize sStagingRingSize = 64 * 1024 * 1024;
 
 static const std::vector<const char*> extensions {
     "VK_KHR_swapchain",
     "VK_EXT_extended_dynamic_state",
     "VK_EXT_host_query_reset",
     "VK_KHR_push_descriptor",
-    "VK_EXT_descriptor_indexing"
+    "VK_EXT_descriptor_indexing",
+    "VK_EXT_shader_viewport_index_layer"
 };
 
 static bool checkExtSupport(VkPhysicalDevice physicalDevice)
@@ -31,17 +37,28 @@ static bool checkExtSupport(VkPhysicalDevice physicalDevice)
     return extensionsSet.empty();
 }
 
-VulkanRenderDevice::VulkanRenderDevice(const VulkanInstance &instance)
+VulkanRenderDevice::VulkanRenderDevice(const VulkanInstance &instance, uint32_t framesInFlight)
+    : framesInFlight(framesInFlight)
 {
+    check(framesInFlight >= 1 && framesInFlight <= MaxFramesInFlight,
+          std::format("Frames in flight has to be between 1 and {}.", MaxFramesInFlight).c_str());
+
     pickPhysicalDevice(instance);
     findQueueFamilyIndices();
     createLogicalDevice();
     createCommandPool();
     createDescriptorPool();
+    createMemoryAllocator();
+    createUploadManager();
+    createGpuProfiler();
 }
 
 VulkanRenderDevice::~VulkanRenderDevice()
 {
+    gpuProfiler.reset();
+    uploadManager.reset();
+    memoryAllocator.reset();
+
     vkDestroyCommandPool(device, commandPool, nullptr);
     vkDestroyDescriptorPool(device, descriptorPool, nullptr);
     vkDestroyDevice(device, nullptr);
@@ -117,6 +134,8 @@ void VulkanRenderDevice::createLogicalDevice()
         .geometryShader = VK_TRUE,
         .samplerAnisotropy = VK_TRUE,
         .fragmentStoresAndAtomics = VK_TRUE,
+        // the material textures are picked by a material index that's the same for the whole draw
+        .shaderSampledImageArrayDynamicIndexing = VK_TRUE
     };
 
     VkDeviceCreateInfo deviceCreateInfo {
@@ -170,9 +189,9 @@ void VulkanRenderDevice::createDescriptorPool()
     uint32_t maxSets = 500;
 
     std::vector<VkDescriptorPoolSize> poolSizes {
-        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1000},
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 5000},
         {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 100},
-        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 100},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 300},
         {VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 100},
     };
 
@@ -207,3 +226,18 @@ uint32_t VulkanRenderDevice::getGraphicsQueueFamilyIndex() const
 {
     return mGraphicsQueueFamilyIndex;
 }
+
+void VulkanRenderDevice::createMemoryAllocator()
+{
+    memoryAllocator = std::make_unique<VulkanMemoryAllocator>(*this);
+}
+
+void VulkanRenderDevice::createUploadManager()
+{
+    uploadManager = std::make_unique<VulkanUploadManager>(*this, sStagingRingSize);
+}
+
+void VulkanRenderDevice::createGpuProfiler()
+{
+    gpuProfiler = std::make_unique<VulkanGpuProfiler>(*this);
+}
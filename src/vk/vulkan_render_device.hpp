@@ -8,6 +8,14 @@
 #include "vulkan_instance.hpp"
 #include "../utils/utils.hpp"
 
+class VulkanMemoryAllocator;
+class VulkanUploadManager;
+class VulkanGpuProfiler;
+
+// bounds of the frames in flight setting, per frame resources are sized by VulkanRenderDevice::framesInFlight
+constexpr uint32_t MaxFramesInFlight = 3;
+constexpr uint32_t DefaultFramesInFlight = 2;
+
 class VulkanRenderDevice
 {
 public:
@@ -16,9 +24,13 @@ public:
     VkQueue graphicsQueue;
     VkCommandPool commandPool;
     VkDescriptorPool descriptorPool;
+    std::unique_ptr<VulkanMemoryAllocator> memoryAllocator;
+    std::unique_ptr<VulkanUploadManager> uploadManager;
+    std::unique_ptr<VulkanGpuProfiler> gpuProfiler;
+    uint32_t framesInFlight;
 
 public:
-    VulkanRenderDevice(const VulkanInstance& instance);
+    VulkanRenderDevice(const VulkanInstance& instance, uint32_t framesInFlight = DefaultFramesInFlight);
     ~VulkanRenderDevice();
 
     const VkPhysicalDeviceProperties& getDeviceProperties() const;
@@ -31,6 +43,9 @@ private:
     void findQueueFamilyIndices();
     void createCommandPool();
     void createDescriptorPool();
+    void createMemoryAllocator();
+    void createUploadManager();
+    void createGpuProfiler();
 
 private:
     VkPhysicalDeviceProperties mDeviceProperties;
@@ -11,15 +11,13 @@ VulkanSwapchain::VulkanSwapchain(const VulkanInstance &instance, const VulkanRen
     createSurface();
     createSwapchain();
     createSwapchainImages();
-    createCommandBuffer();
+    createCommandBuffers();
     createSyncObjects();
 }
 
 VulkanSwapchain::~VulkanSwapchain()
 {
-    vkDestroyFence(mRenderDevice.device, inFlightFence, nullptr);
-    vkDestroySemaphore(mRenderDevice.device, imageReadySemaphore, nullptr);
-    vkDestroySemaphore(mRenderDevice.device, renderCompleteSemaphore, nullptr);
+    destroySyncObjects();
 
     for (size_t i = 0; i < 2; ++i)
     {
@@ -44,9 +42,7 @@ void VulkanSwapchain::recreate()
     createSwapchainImages();
 
     // sync objects
-    vkDestroyFence(mRenderDevice.device, inFlightFence, nullptr);
-    vkDestroySemaphore(mRenderDevice.device, imageReadySemaphore, nullptr);
-    vkDestroySemaphore(mRenderDevice.device, renderCompleteSemaphore, nullptr);
+    destroySyncObjects();
 
     createSyncObjects();
 }
@@ -129,27 +125,50 @@ void VulkanSwapchain::createSwapchainImages()
     }
 }
 
-void VulkanSwapchain::createCommandBuffer()
+void VulkanSwapchain::createCommandBuffers()
 {
     VkCommandBufferAllocateInfo commandBufferAllocateInfo {
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
         .commandPool = mRenderDevice.commandPool,
         .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-        .commandBufferCount = 1
+        .commandBufferCount = mRenderDevice.framesInFlight
     };
 
-    VkResult result = vkAllocateCommandBuffers(mRenderDevice.device, &commandBufferAllocateInfo, &commandBuffer);
+    commandBuffers.resize(mRenderDevice.framesInFlight);
+
+    VkResult result = vkAllocateCommandBuffers(mRenderDevice.device, &commandBufferAllocateInfo, commandBuffers.data());
     vulkanCheck(result, "Failed to allocate command buffers.");
 
-    setVulkanObjectDebugName(mRenderDevice,
-                             VK_OBJECT_TYPE_COMMAND_BUFFER,
-                             std::format("VulkanSwapchain::commandBuffer"),
-                             commandBuffer);
+    for (uint32_t i = 0; i < mRenderDevice.framesInFlight; ++i)
+    {
+        setVulkanObjectDebugName(mRenderDevice,
+                                 VK_OBJECT_TYPE_COMMAND_BUFFER,
+                                 std::format("VulkanSwapchain::commandBuffers.at({})", i),
+                                 commandBuffers.at(i));
+    }
 }
 
 void VulkanSwapchain::createSyncObjects()
 {
-    inFlightFence = createFence(mRenderDevice, false, "VulkanSwapchain::inFlightFence");
-    imageReadySemaphore = createSemaphore(mRenderDevice, "VulkanSwapchain::imageReadySemaphore");
-    renderCompleteSemaphore = createSemaphore(mRenderDevice, "VulkanSwapchain::renderCompleteSemaphore");
+    inFlightFences.resize(mRenderDevice.framesInFlight);
+    imageReadySemaphores.resize(mRenderDevice.framesInFlight);
+    renderCompleteSemaphores.resize(mRenderDevice.framesInFlight);
+
+    // fences start signaled so the first wait on each frame slot returns immediately
+    for (uint32_t i = 0; i < mRenderDevice.framesInFlight; ++i)
+    {
+        inFlightFences.at(i) = createFence(mRenderDevice, true, std::format("VulkanSwapchain::inFlightFences.at({})", i).c_str());
+        imageReadySemaphores.at(i) = createSemaphore(mRenderDevice, std::format("VulkanSwapchain::imageReadySemaphores.at({})", i).c_str());
+        renderCompleteSemaphores.at(i) = createSemaphore(mRenderDevice, std::format("VulkanSwapchain::renderCompleteSemaphores.at({})", i).c_str());
+    }
+}
+
+void VulkanSwapchain::destroySyncObjects()
+{
+    for (uint32_t i = 0; i < mRenderDevice.framesInFlight; ++i)
+    {
+        vkDestroyFence(mRenderDevice.device, inFlightFences.at(i), nullptr);
+        vkDestroySemaphore(mRenderDevice.device, imageReadySemaphores.at(i), nullptr);
+        vkDestroySemaphore(mRenderDevice.device, renderCompleteSemaphores.at(i), nullptr);
+    }
 }
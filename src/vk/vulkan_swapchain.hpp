@@ -17,11 +17,12 @@ public:
     VkSwapchainKHR swapchain;
     VkSurfaceKHR surface;
 
-    VkCommandBuffer commandBuffer;
+    // one per frame in flight
+    std::vector<VkCommandBuffer> commandBuffers;
 
-    VkFence inFlightFence;
-    VkSemaphore imageReadySemaphore;
-    VkSemaphore renderCompleteSemaphore;
+    std::vector<VkFence> inFlightFences;
+    std::vector<VkSemaphore> imageReadySemaphores;
+    std::vector<VkSemaphore> renderCompleteSemaphores;
 
     std::array<VkImage, 2> images;
     std::array<VkImageView, 2> imageViews;
@@ -39,8 +40,9 @@ private:
     void createSurface();
     void createSwapchain();
     void createSwapchainImages();
-    void createCommandBuffer();
+    void createCommandBuffers();
     void createSyncObjects();
+    void destroySyncObjects();
 
 private:
     const VulkanInstance& mInstance;
@@ -4,6 +4,7 @@
 
 #include "vulkan_texture.hpp"
 #include "vulkan_buffer.hpp"
+#include "vulkan_upload_manager.hpp"
 
 const char* toStr(TextureWrap wrapMode)
 {
@@ -71,10 +72,12 @@ VulkanTexture::VulkanTexture(const VulkanRenderDevice &renderDevice, const Textu
 VulkanTexture::VulkanTexture(const VulkanRenderDevice &renderDevice, const TextureSpecification &specification, const void *data)
     : VulkanTexture(renderDevice, specification)
 {
-    VkCommandBuffer commandBuffer = beginSingleTimeCommands(renderDevice);
+    VulkanUploadManager& uploadManager = *renderDevice.uploadManager;
 
     uint32_t bufferSize = width * height * formatSize(format);
-    VulkanBuffer stagingBuffer(renderDevice, bufferSize, BufferType::Staging, MemoryType::HostCached, data);
+    StagingRegion staging = uploadManager.stage(data, bufferSize);
+
+    VkCommandBuffer commandBuffer = uploadManager.commandBuffer();
 
     transitionLayout(commandBuffer,
                      VK_IMAGE_LAYOUT_UNDEFINED,
@@ -83,7 +86,7 @@ VulkanTexture::VulkanTexture(const VulkanRenderDevice &renderDevice, const Textu
                      VK_PIPELINE_STAGE_TRANSFER_BIT,
                      0, VK_ACCESS_TRANSFER_WRITE_BIT);
 
-    uploadImageData(commandBuffer, stagingBuffer);
+    copyBuffer(commandBuffer, staging.buffer, staging.offset);
 
     if (specification.generateMipMaps)
     {
@@ -115,8 +118,6 @@ VulkanTexture::VulkanTexture(const VulkanRenderDevice &renderDevice, const Textu
                          VK_ACCESS_TRANSFER_WRITE_BIT,
                          VK_ACCESS_SHADER_READ_BIT);
     }
-
-    endSingleTimeCommands(renderDevice, commandBuffer);
 }
 
 VulkanTexture::~VulkanTexture()
@@ -0,0 +1,224 @@
+//
+// Created by Gianni on 16/10/2026.
+//
+
+#include "vulkan_upload_manager.hpp"
+#include "../utils/cpu_profiler.hpp"
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+VulkanUploadManager::VulkanUploadManager(const VulkanRenderDevice& renderDevice, VkDeviceSize ringSize)
+    : mRenderDevice(renderDevice)
+    , mRingBuffer(renderDevice, ringSize, BufferType::Staging, MemoryType::HostCoherent)
+    , mRingData(static_cast<uint8_t*>(mRingBuffer.getMappedData()))
+    , mRingSize(ringSize)
+    , mRingHead()
+    , mRingTail()
+    , mRingUsed()
+    , mCommandBuffer()
+    , mPendingRingBytes()
+    , mBytesUploaded()
+    , mSubmitCount()
+{
+    mRingBuffer.setDebugName("VulkanUploadManager::mRingBuffer");
+}
+
+VulkanUploadManager::~VulkanUploadManager()
+{
+    waitIdle();
+}
+
+StagingRegion VulkanUploadManager::stage(const void* data, VkDeviceSize size, VkDeviceSize alignment)
+{
+    mBytesUploaded += size;
+
+    // too big for the ring, give it a buffer that lives as long as the batch
+    if (size + alignment > mRingSize)
+    {
+        mOverflowBuffers.emplace_back(mRenderDevice, size, BufferType::Staging, MemoryType::HostCoherent, data);
+        return {mOverflowBuffers.back().getBuffer(), 0};
+    }
+
+    std::optional<VkDeviceSize> offset = allocateRingRegion(size, alignment);
+
+    while (!offset)
+    {
+        // ring is full, submit what's recorded and wait for the oldest batch to free its region
+        flush();
+        retireBatches(true);
+        offset = allocateRingRegion(size, alignment);
+    }
+
+    memcpy(mRingData + *offset, data, size);
+
+    return {mRingBuffer.getBuffer(), *offset};
+}
+
+VkCommandBuffer VulkanUploadManager::commandBuffer()
+{
+    if (mCommandBuffer)
+        return mCommandBuffer;
+
+    VkCommandBufferAllocateInfo commandBufferAllocateInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool = mRenderDevice.commandPool,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = 1
+    };
+
+    VkResult result = vkAllocateCommandBuffers(mRenderDevice.device, &commandBufferAllocateInfo, &mCommandBuffer);
+    vulkanCheck(result, "Failed to allocate upload command buffer.");
+
+    VkCommandBufferBeginInfo commandBufferBeginInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+    };
+
+    vkBeginCommandBuffer(mCommandBuffer, &commandBufferBeginInfo);
+
+    // frames still in flight may be reading the resources this batch overwrites
+    VkMemoryBarrier memoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = 0,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT
+    };
+
+    vkCmdPipelineBarrier(mCommandBuffer,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+
+    return mCommandBuffer;
+}
+
+void VulkanUploadManager::flush()
+{
+    PROFILE_ZONE("VulkanUploadManager::flush");
+
+    retireBatches(false);
+
+    if (!mCommandBuffer)
+        return;
+
+    // make the transfers visible to everything submitted after this batch
+    VkMemoryBarrier memoryBarrier {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT
+    };
+
+    vkCmdPipelineBarrier(mCommandBuffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                         0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+
+    vkEndCommandBuffer(mCommandBuffer);
+
+    VkSubmitInfo submitInfo {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &mCommandBuffer
+    };
+
+    VkFence fence = createFence(mRenderDevice);
+
+    VkResult result = vkQueueSubmit(mRenderDevice.graphicsQueue, 1, &submitInfo, fence);
+    vulkanCheck(result, "Failed queue submit.");
+
+    mBatches.push_back({
+        .commandBuffer = mCommandBuffer,
+        .fence = fence,
+        .ringHead = mRingHead,
+        .ringBytes = mPendingRingBytes,
+        .overflowBuffers = std::move(mOverflowBuffers)
+    });
+
+    mCommandBuffer = VK_NULL_HANDLE;
+    mPendingRingBytes = 0;
+    mOverflowBuffers.clear();
+    ++mSubmitCount;
+}
+
+void VulkanUploadManager::waitIdle()
+{
+    flush();
+
+    while (!mBatches.empty())
+        retireBatches(true);
+}
+
+UploadStats VulkanUploadManager::stats() const
+{
+    return {
+        .bytesUploaded = mBytesUploaded,
+        .ringUsed = mRingUsed,
+        .ringSize = mRingSize,
+        .submitCount = mSubmitCount,
+        .pendingBatches = static_cast<uint32_t>(mBatches.size())
+    };
+}
+
+std::optional<VkDeviceSize> VulkanUploadManager::allocateRingRegion(VkDeviceSize size, VkDeviceSize alignment)
+{
+    if (mRingUsed == 0)
+    {
+        mRingHead = 0;
+        mRingTail = 0;
+    }
+
+    VkDeviceSize offset = alignUp(mRingHead, alignment);
+    VkDeviceSize consumed;
+
+    if (mRingHead > mRingTail || mRingUsed == 0)
+    {
+        // free space is [head, end) followed by [0, tail)
+        if (offset + size <= mRingSize)
+            consumed = offset + size - mRingHead;
+        else if (size <= mRingTail)
+        {
+            offset = 0;
+            consumed = mRingSize - mRingHead + size;
+        }
+        else
+            return std::nullopt;
+    }
+    else
+    {
+        // free space is [head, tail)
+        if (offset + size <= mRingTail)
+            consumed = offset + size - mRingHead;
+        else
+            return std::nullopt;
+    }
+
+    mRingHead = offset + size;
+    mRingUsed += consumed;
+    mPendingRingBytes += consumed;
+
+    return offset;
+}
+
+void VulkanUploadManager::retireBatches(bool waitForOldest)
+{
+    if (waitForOldest && !mBatches.empty())
+        vkWaitForFences(mRenderDevice.device, 1, &mBatches.front().fence, VK_TRUE, UINT64_MAX);
+
+    while (!mBatches.empty() && vkGetFenceStatus(mRenderDevice.device, mBatches.front().fence) == VK_SUCCESS)
+    {
+        Batch& batch = mBatches.front();
+
+        if (batch.ringBytes)
+        {
+            mRingTail = batch.ringHead;
+            mRingUsed -= batch.ringBytes;
+        }
+
+        vkDestroyFence(mRenderDevice.device, batch.fence, nullptr);
+        vkFreeCommandBuffers(mRenderDevice.device, mRenderDevice.commandPool, 1, &batch.commandBuffer);
+
+        mBatches.pop_front();
+    }
+}
@@ -0,0 +1,77 @@
+//
+// Created by Gianni on 16/10/2026.
+//
+
+#ifndef VULKANRENDERINGENGINE_VULKAN_UPLOAD_MANAGER_HPP
+#define VULKANRENDERINGENGINE_VULKAN_UPLOAD_MANAGER_HPP
+
+#include "vulkan_buffer.hpp"
+
+struct StagingRegion
+{
+    VkBuffer buffer;
+    VkDeviceSize offset;
+};
+
+struct UploadStats
+{
+    VkDeviceSize bytesUploaded;
+    VkDeviceSize ringUsed;
+    VkDeviceSize ringSize;
+    uint32_t submitCount;
+    uint32_t pendingBatches;
+};
+
+// Records uploads into a batch command buffer that is submitted once per frame without waiting.
+// Staging data lives in a persistently mapped ring buffer and is reclaimed when the batch fence signals.
+// Main thread only. Stage data before fetching the command buffer, staging may submit the current batch.
+class VulkanUploadManager
+{
+public:
+    VulkanUploadManager(const VulkanRenderDevice& renderDevice, VkDeviceSize ringSize);
+    ~VulkanUploadManager();
+
+    VulkanUploadManager(const VulkanUploadManager&) = delete;
+    VulkanUploadManager& operator=(const VulkanUploadManager&) = delete;
+
+    StagingRegion stage(const void* data, VkDeviceSize size, VkDeviceSize alignment = 16);
+    VkCommandBuffer commandBuffer();
+
+    void flush();
+    void waitIdle();
+
+    UploadStats stats() const;
+
+private:
+    struct Batch
+    {
+        VkCommandBuffer commandBuffer;
+        VkFence fence;
+        VkDeviceSize ringHead;
+        VkDeviceSize ringBytes;
+        std::vector<VulkanBuffer> overflowBuffers;
+    };
+
+    std::optional<VkDeviceSize> allocateRingRegion(VkDeviceSize size, VkDeviceSize alignment);
+    void retireBatches(bool waitForOldest);
+
+private:
+    const VulkanRenderDevice& mRenderDevice;
+
+    VulkanBuffer mRingBuffer;
+    uint8_t* mRingData;
+    VkDeviceSize mRingSize;
+    VkDeviceSize mRingHead;
+    VkDeviceSize mRingTail;
+    VkDeviceSize mRingUsed;
+
+    VkCommandBuffer mCommandBuffer;
+    VkDeviceSize mPendingRingBytes;
+    std::vector<VulkanBuffer> mOverflowBuffers;
+    std::deque<Batch> mBatches;
+
+    VkDeviceSize mBytesUploaded;
+    uint32_t mSubmitCount;
+};
+
+#endif //VULKANRENDERINGENGINE_VULKAN_UPLOAD_MANAGER_HPP
@@ -5,6 +5,8 @@
 #include "vulkan_utils.hpp"
 #include "vulkan_function_pointers.hpp"
 #include "vulkan_render_device.hpp"
+#include "vulkan_upload_manager.hpp"
+#include "vulkan_gpu_profiler.hpp"
 #include "../utils/utils.hpp"
 
 void vulkanCheck(VkResult result, const char* msg, std::source_location location)
@@ -32,6 +34,8 @@ void setVulkanObjectDebugName(const VulkanRenderDevice& renderDevice,
 
 void beginDebugLabel(VkCommandBuffer commandBuffer, const char* name)
 {
+    VulkanGpuProfiler::beginZone(commandBuffer, name);
+
 #ifdef DEBUG_MODE
     VkDebugUtilsLabelEXT debugUtilsLabel {
         .sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT,
@@ -45,6 +49,8 @@ void beginDebugLabel(VkCommandBuffer commandBuffer, const char* name)
 
 void endDebugLabel(VkCommandBuffer commandBuffer)
 {
+    VulkanGpuProfiler::endZone(commandBuffer);
+
 #ifdef DEBUG_MODE
     pfnCmdEndDebugUtilsLabelEXT(commandBuffer);
 #endif
@@ -79,6 +85,10 @@ std::optional<uint32_t> findSuitableMemoryType(const VkPhysicalDeviceMemoryPrope
 
 VkCommandBuffer beginSingleTimeCommands(const VulkanRenderDevice& renderDevice)
 {
+    // pending uploads have to reach the queue first
+    if (renderDevice.uploadManager)
+        renderDevice.uploadManager->flush();
+
     VkCommandBuffer commandBuffer;
 
     VkCommandBufferAllocateInfo commandBufferAllocateInfo {